@@ -1,5 +1,7 @@
 #include "mdv_client.h"
 #include "mdv_messages.h"
+#include <mdv_serialization.h>
+#include <mdv_packed_row.h>
 #include "mdv_channel.h"
 #include <mdv_version.h>
 #include <mdv_alloc.h>
@@ -12,6 +14,7 @@
 #include <mdv_socket.h>
 #include <mdv_mutex.h>
 #include <mdv_threads.h>
+#include <mdv_hashmap.h>
 #include <signal.h>
 
 
@@ -71,9 +74,27 @@ struct mdv_client
     mdv_mutex           mutex;              ///< Mutex for user guard
     mdv_channel        *channel;            ///< Connection context
     uint32_t            response_timeout;   ///< Temeout for responses (in milliseconds)
+    mdv_mutex           codecs_mutex;       ///< Mutex for row codecs guard
+    mdv_hashmap        *codecs;             ///< Row codecs compiled for the tables (table UUID and schema hash -> mdv_client_codec)
 };
 
 
+/// Row codec identifier
+typedef struct
+{
+    mdv_uuid            table;              ///< Table UUID
+    uint64_t            schema;             ///< Table fields hash
+} mdv_client_codec_id;
+
+
+/// Row codec compiled for the table
+typedef struct
+{
+    mdv_client_codec_id id;                 ///< Row codec identifier
+    mdv_row_codec      *codec;              ///< Row codec
+} mdv_client_codec;
+
+
 /// @endcond
 
 
@@ -277,9 +298,190 @@ static mdv_errno  mdv_client_row_info_handler(mdv_msg const * msg, mdv_msg_row_i
 }
 
 
+static mdv_errno mdv_client_snapshot_info_handler(mdv_msg const *msg, mdv_msg_snapshot_info *info)
+{
+    binn binn_msg;
+
+    if(!binn_load(msg->payload, &binn_msg))
+        return MDV_FAILED;
+
+    if (!mdv_unbinn_snapshot_info(&binn_msg, info))
+    {
+        MDV_LOGE("Invalid snapshot info");
+        binn_free(&binn_msg);
+        return MDV_FAILED;
+    }
+
+    binn_free(&binn_msg);
+
+    return MDV_OK;
+}
+
+
+static mdv_errno mdv_client_rowset_handler(mdv_msg const *msg,
+                                           mdv_row_codec const *codec,
+                                           uint64_t *next,
+                                           void *arg,
+                                           mdv_select_fn fn)
+{
+    binn binn_msg;
+
+    if(!binn_load(msg->payload, &binn_msg))
+        return MDV_FAILED;
+
+    mdv_msg_rowset rowset;
+
+    if (!mdv_unbinn_rowset(&binn_msg, &rowset))
+    {
+        MDV_LOGE("Invalid rowset");
+        binn_free(&binn_msg);
+        return MDV_FAILED;
+    }
+
+    *next = rowset.next;
+
+    mdv_errno err = MDV_OK;
+
+    int const count = binn_count(rowset.rows);
+
+    for(int i = 1; i <= count; ++i)
+    {
+        uint64 row_id = 0;
+        int packed_size = 0;
+        mdv_data packed = {};
+
+        if (!binn_list_get_uint64(rowset.ids, i, &row_id)
+            || !binn_list_get_blob(rowset.rows, i, &packed.ptr, &packed_size))
+        {
+            MDV_LOGE("Invalid rowset");
+            err = MDV_FAILED;
+            break;
+        }
+
+        packed.size = (uint32_t)packed_size;
+
+        mdv_row_base *row = mdv_row_codec_unpack(codec, &packed);
+
+        if (!row)
+        {
+            MDV_LOGE("Invalid row");
+            err = MDV_FAILED;
+            break;
+        }
+
+        bool const ret = fn(arg, row_id, row);
+
+        mdv_free(row, "row");
+
+        if (!ret)
+        {
+            *next = 0;
+            break;
+        }
+    }
+
+    binn_free(&binn_msg);
+
+    return err;
+}
+
+
+static void mdv_client_codecs_free(mdv_hashmap *codecs)
+{
+    mdv_hashmap_foreach(codecs, mdv_client_codec, entry)
+        mdv_row_codec_free(entry->codec);
+    mdv_hashmap_release(codecs);
+}
+
+
+static size_t mdv_client_codec_id_hash(mdv_client_codec_id const *id)
+{
+    return mdv_uuid_hash(&id->table) ^ id->schema;
+}
+
+
+static int mdv_client_codec_id_cmp(mdv_client_codec_id const *a, mdv_client_codec_id const *b)
+{
+    if (a->schema < b->schema)
+        return -1;
+    else if (a->schema > b->schema)
+        return 1;
+    return mdv_uuid_cmp(&a->table, &b->table);
+}
+
+
+/**
+ * @brief Calculates the hash of the fields types and limits. Names aren't used by the row codec.
+ */
+static uint64_t mdv_client_schema_hash(mdv_field const *fields, uint32_t count)
+{
+    static uint64_t const FNV_offset_basis = 0xcbf29ce484222325;
+    static uint64_t const FNV_prime = 0x100000001b3;
+
+    uint64_t hash = (FNV_offset_basis * FNV_prime) ^ count;
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        hash = (hash * FNV_prime) ^ fields[i].type;
+        hash = (hash * FNV_prime) ^ fields[i].limit;
+    }
+
+    return hash;
+}
+
+
+/**
+ * @brief Returns the row codec for the table. Codec is compiled once and cached until the client is closed.
+ * @details Codecs are identified by the table UUID and the fields hash, so the changed table
+ *          description gets new codec. Previous codecs aren't freed because they might be in use.
+ */
+static mdv_row_codec const * mdv_client_codec_get(mdv_client *client, mdv_uuid const *table_id, mdv_field const *fields, uint32_t count)
+{
+    mdv_client_codec_id const id =
+    {
+        .table = *table_id,
+        .schema = mdv_client_schema_hash(fields, count)
+    };
+
+    if (mdv_mutex_lock(&client->codecs_mutex) != MDV_OK)
+        return 0;
+
+    mdv_client_codec *entry = mdv_hashmap_find(client->codecs, &id);
+
+    mdv_row_codec *codec = entry ? entry->codec : 0;
+
+    if (!codec)
+    {
+        mdv_client_codec const new_entry =
+        {
+            .id = id,
+            .codec = mdv_row_codec_create(fields, count)
+        };
+
+        if (new_entry.codec && !mdv_hashmap_insert(client->codecs, &new_entry, sizeof new_entry))
+        {
+            MDV_LOGE("No memory for row codec");
+            mdv_row_codec_free(new_entry.codec);
+        }
+        else
+            codec = new_entry.codec;
+    }
+
+    mdv_mutex_unlock(&client->codecs_mutex);
+
+    if (codec && mdv_row_codec_fields_count(codec) != count)
+    {
+        MDV_LOGE("Invalid fields count");
+        return 0;
+    }
+
+    return codec;
+}
+
+
 mdv_client * mdv_client_connect(mdv_client_config const *config)
 {
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(4);
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(6);
 
     mdv_client_init();
 
@@ -314,6 +516,33 @@ mdv_client * mdv_client_connect(mdv_client_config const *config)
 
     mdv_rollbacker_push(rollbacker, mdv_mutex_free, &client->mutex);
 
+    // Row codecs
+    err = mdv_mutex_create(&client->codecs_mutex);
+
+    if (err != MDV_OK)
+    {
+        MDV_LOGE("Mutex creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &client->codecs_mutex);
+
+    client->codecs = mdv_hashmap_create(mdv_client_codec,
+                                        id,
+                                        8,
+                                        mdv_client_codec_id_hash,
+                                        mdv_client_codec_id_cmp);
+
+    if (!client->codecs)
+    {
+        MDV_LOGE("No memory for row codecs");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_client_codecs_free, client->codecs);
+
     // Channels manager
     mdv_chaman_config const chaman_config =
     {
@@ -393,6 +622,8 @@ void mdv_client_close(mdv_client *client)
     {
         mdv_chaman_free(client->chaman);
         mdv_channel_release(client->channel);
+        mdv_client_codecs_free(client->codecs);
+        mdv_mutex_free(&client->codecs_mutex);
         mdv_mutex_free(&client->mutex);
         mdv_free(client, "client");
         mdv_client_finalize();
@@ -521,18 +752,30 @@ mdv_errno mdv_get_topology(mdv_client *client, mdv_topology **topology)
 }
 
 
-mdv_errno mdv_insert_row(mdv_client *client, mdv_gobjid const *table_id, mdv_field const *fields, mdv_row_base const *row, mdv_gobjid *id)
+mdv_errno mdv_insert_row(mdv_client *client, mdv_uuid const *table_id, mdv_field const *fields, mdv_row_base const *row, mdv_gobjid *id)
 {
-    mdv_msg_insert_row row_msg;
+    mdv_row_codec const *codec = mdv_client_codec_get(client, table_id, fields, row->size);
+
+    if (!codec)
+        return MDV_FAILED;
 
-    row_msg.table = *table_id;
-    row_msg.row = row;
+    mdv_msg_insert_row row_msg =
+    {
+        .table = *table_id
+    };
+
+    if (!mdv_row_codec_pack(codec, row, &row_msg.row))
+        return MDV_FAILED;
 
     binn insert_row_msg;
 
-    if (!mdv_binn_insert_row(&row_msg, fields, &insert_row_msg))
+    if (!mdv_binn_insert_row(&row_msg, &insert_row_msg))
+    {
+        mdv_free(row_msg.row.ptr, "packed_row");
         return MDV_FAILED;
+    }
 
+    mdv_free(row_msg.row.ptr, "packed_row");
 
     mdv_msg req =
     {
@@ -554,7 +797,7 @@ mdv_errno mdv_insert_row(mdv_client *client, mdv_gobjid const *table_id, mdv_fie
     {
         switch(resp.hdr.id)
         {
-            case mdv_message_id(table_info):
+            case mdv_message_id(row_info):
             {
                 mdv_msg_row_info info;
                 err = mdv_client_row_info_handler(&resp, &info);
@@ -572,10 +815,361 @@ mdv_errno mdv_insert_row(mdv_client *client, mdv_gobjid const *table_id, mdv_fie
 
             default:
                 err = MDV_FAILED;
-                        MDV_LOGE("Unexpected response");
+                MDV_LOGE("Unexpected response");
                 break;
         }
 
         mdv_free_msg(&resp);
     }
+
+    return err;
+}
+
+
+mdv_errno mdv_select(mdv_client           *client,
+                     mdv_table_base const *table,
+                     uint32_t              size,
+                     uint32_t const       *projection,
+                     mdv_predicate const  *predicate,
+                     uint64_t              snapshot,
+                     void                 *arg,
+                     mdv_select_fn         fn)
+{
+    mdv_field *projected_fields = mdv_alloc(size * sizeof(mdv_field), "projected_fields");
+
+    if (!projected_fields)
+    {
+        MDV_LOGE("No memory for projected fields");
+        return MDV_NO_MEM;
+    }
+
+    for(uint32_t i = 0; i < size; ++i)
+    {
+        if (projection[i] >= table->size)
+        {
+            MDV_LOGE("Invalid projection field");
+            mdv_free(projected_fields, "projected_fields");
+            return MDV_INVALID_ARG;
+        }
+
+        projected_fields[i] = table->fields[projection[i]];
+    }
+
+    mdv_row_codec *codec = mdv_row_codec_create(projected_fields, size);
+
+    mdv_free(projected_fields, "projected_fields");
+
+    if (!codec)
+        return MDV_FAILED;
+
+    mdv_msg_select select_msg =
+    {
+        .table = table->id,
+        .first = 1,
+        .limit = 0,
+        .size = size,
+        .fields = (uint32_t *)projection,
+        .predicate = (mdv_predicate *)predicate,
+        .snapshot = snapshot
+    };
+
+    mdv_errno err = MDV_OK;
+
+    // Rows are fetched by batches until the server returns the last batch
+    while(err == MDV_OK && select_msg.first)
+    {
+        binn binn_msg;
+
+        if (!mdv_binn_select(&select_msg, &binn_msg))
+        {
+            err = MDV_FAILED;
+            break;
+        }
+
+        mdv_msg req =
+        {
+            .hdr =
+                {
+                    .id   = mdv_msg_select_id,
+                    .size = binn_size(&binn_msg)
+                },
+            .payload = binn_ptr(&binn_msg)
+        };
+
+        mdv_msg resp;
+
+        err = mdv_client_send(client, &req, &resp, client->response_timeout);
+
+        binn_free(&binn_msg);
+
+        if (err != MDV_OK)
+            break;
+
+        switch(resp.hdr.id)
+        {
+            case mdv_message_id(rowset):
+            {
+                err = mdv_client_rowset_handler(&resp, codec, &select_msg.first, arg, fn);
+                break;
+            }
+
+            case mdv_message_id(status):
+            {
+                if (mdv_client_status_handler(&resp, &err) == MDV_OK)
+                {
+                    if (err == MDV_OK)
+                        err = MDV_FAILED;
+                    break;
+                }
+                // fallthrough
+            }
+
+            default:
+                err = MDV_FAILED;
+                MDV_LOGE("Unexpected response");
+                break;
+        }
+
+        mdv_free_msg(&resp);
+    }
+
+    mdv_row_codec_free(codec);
+
+    return err;
+}
+
+
+mdv_errno mdv_aggregate_rows(mdv_client           *client,
+                             mdv_table_base const *table,
+                             uint32_t              groups_size,
+                             uint32_t const       *groups,
+                             uint32_t              size,
+                             mdv_aggregate const  *aggregates,
+                             mdv_predicate const  *predicate,
+                             uint64_t              snapshot,
+                             void                 *arg,
+                             mdv_select_fn         fn)
+{
+    mdv_field *result_fields = mdv_alloc((groups_size + size) * sizeof(mdv_field), "result_fields");
+
+    if (!result_fields)
+    {
+        MDV_LOGE("No memory for result fields");
+        return MDV_NO_MEM;
+    }
+
+    for(uint32_t i = 0; i < groups_size; ++i)
+    {
+        if (groups[i] >= table->size)
+        {
+            MDV_LOGE("Invalid grouping field");
+            mdv_free(result_fields, "result_fields");
+            return MDV_INVALID_ARG;
+        }
+
+        result_fields[i] = table->fields[groups[i]];
+    }
+
+    for(uint32_t i = 0; i < size; ++i)
+    {
+        if (!mdv_aggregate_field(table, aggregates + i, result_fields + groups_size + i))
+        {
+            MDV_LOGE("Invalid aggregate function");
+            mdv_free(result_fields, "result_fields");
+            return MDV_INVALID_ARG;
+        }
+    }
+
+    mdv_row_codec *codec = mdv_row_codec_create(result_fields, groups_size + size);
+
+    mdv_free(result_fields, "result_fields");
+
+    if (!codec)
+        return MDV_FAILED;
+
+    mdv_msg_aggregate const aggregate_msg =
+    {
+        .table = table->id,
+        .groups_size = groups_size,
+        .groups = (uint32_t *)groups,
+        .size = size,
+        .aggregates = (mdv_aggregate *)aggregates,
+        .predicate = (mdv_predicate *)predicate,
+        .snapshot = snapshot
+    };
+
+    mdv_errno err = MDV_FAILED;
+
+    binn binn_msg;
+
+    if (mdv_binn_aggregate(&aggregate_msg, &binn_msg))
+    {
+        mdv_msg req =
+        {
+            .hdr =
+                {
+                    .id   = mdv_msg_aggregate_id,
+                    .size = binn_size(&binn_msg)
+                },
+            .payload = binn_ptr(&binn_msg)
+        };
+
+        mdv_msg resp;
+
+        err = mdv_client_send(client, &req, &resp, client->response_timeout);
+
+        binn_free(&binn_msg);
+
+        if (err == MDV_OK)
+        {
+            switch(resp.hdr.id)
+            {
+                case mdv_message_id(rowset):
+                {
+                    // All groups are sent in the single rowset
+                    uint64_t next = 0;
+                    err = mdv_client_rowset_handler(&resp, codec, &next, arg, fn);
+                    break;
+                }
+
+                case mdv_message_id(status):
+                {
+                    if (mdv_client_status_handler(&resp, &err) == MDV_OK)
+                    {
+                        if (err == MDV_OK)
+                            err = MDV_FAILED;
+                        break;
+                    }
+                    // fallthrough
+                }
+
+                default:
+                    err = MDV_FAILED;
+                    MDV_LOGE("Unexpected response");
+                    break;
+            }
+
+            mdv_free_msg(&resp);
+        }
+    }
+
+    mdv_row_codec_free(codec);
+
+    return err;
+}
+
+
+mdv_errno mdv_create_snapshot(mdv_client *client, uint64_t *id)
+{
+    *id = 0;
+
+    mdv_msg_create_snapshot create_snapshot = {};
+
+    binn binn_msg;
+
+    if (!mdv_binn_create_snapshot(&create_snapshot, &binn_msg))
+        return MDV_FAILED;
+
+    mdv_msg req =
+    {
+        .hdr =
+        {
+            .id   = mdv_msg_create_snapshot_id,
+            .size = binn_size(&binn_msg)
+        },
+        .payload = binn_ptr(&binn_msg)
+    };
+
+    mdv_msg resp;
+
+    mdv_errno err = mdv_client_send(client, &req, &resp, client->response_timeout);
+
+    binn_free(&binn_msg);
+
+    if (err == MDV_OK)
+    {
+        switch(resp.hdr.id)
+        {
+            case mdv_message_id(snapshot_info):
+            {
+                mdv_msg_snapshot_info info;
+                err = mdv_client_snapshot_info_handler(&resp, &info);
+                if (err == MDV_OK)
+                    *id = info.id;
+                break;
+            }
+
+            case mdv_message_id(status):
+            {
+                if (mdv_client_status_handler(&resp, &err) == MDV_OK)
+                {
+                    if (err == MDV_OK)
+                        err = MDV_FAILED;
+                    break;
+                }
+                // fallthrough
+            }
+
+            default:
+                err = MDV_FAILED;
+                MDV_LOGE("Unexpected response");
+                break;
+        }
+
+        mdv_free_msg(&resp);
+    }
+
+    return err;
+}
+
+
+mdv_errno mdv_release_snapshot(mdv_client *client, uint64_t id)
+{
+    mdv_msg_release_snapshot const release_snapshot =
+    {
+        .id = id
+    };
+
+    binn binn_msg;
+
+    if (!mdv_binn_release_snapshot(&release_snapshot, &binn_msg))
+        return MDV_FAILED;
+
+    mdv_msg req =
+    {
+        .hdr =
+        {
+            .id   = mdv_msg_release_snapshot_id,
+            .size = binn_size(&binn_msg)
+        },
+        .payload = binn_ptr(&binn_msg)
+    };
+
+    mdv_msg resp;
+
+    mdv_errno err = mdv_client_send(client, &req, &resp, client->response_timeout);
+
+    binn_free(&binn_msg);
+
+    if (err == MDV_OK)
+    {
+        switch(resp.hdr.id)
+        {
+            case mdv_message_id(status):
+            {
+                if (mdv_client_status_handler(&resp, &err) == MDV_OK)
+                    break;
+                // fallthrough
+            }
+
+            default:
+                err = MDV_FAILED;
+                MDV_LOGE("Unexpected response");
+                break;
+        }
+
+        mdv_free_msg(&resp);
+    }
+
+    return err;
 }
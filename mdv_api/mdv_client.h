@@ -102,13 +102,118 @@ mdv_errno mdv_get_topology(mdv_client *client, mdv_topology **topology);
 /**
  * @brief Insert row to given table
  * @details This function implements insertion functionality.
+ *          The row is written to the transaction log of the server node and it is added to the table later,
+ *          so the returned identifier is the node UUID and the transaction log record identifier.
+ *          It isn't the row identifier which is passed to mdv_select_fn().
  *
  * @param client [in]    DB client
  * @param table_id [in]    The guid of table
+ * @param fields [in]    Table fields description
  * @param row [in]    Row description
- * @param id [out]    Row identifier
+ * @param id [out]    Transaction log record identifier of the inserted row
  *
  * @return On success, return MDV_OK.
  * @return On error, return non zero value
  */
-mdv_errno mdv_insert_row(mdv_client *client, mdv_gobjid const *table_id, mdv_field const *fields, mdv_row_base const *row, mdv_gobjid *id);
+mdv_errno mdv_insert_row(mdv_client *client, mdv_uuid const *table_id, mdv_field const *fields, mdv_row_base const *row, mdv_gobjid *id);
+
+
+/**
+ * @brief Selected rows handler
+ * @details Row identifier is the row position in the table. Positions are assigned when the rows
+ *          are applied from the transaction log, so they differ from the identifiers returned by mdv_insert_row().
+ *
+ * @param arg [in]      User defined argument which is passed to mdv_select()
+ * @param row_id [in]   Row identifier
+ * @param row [in]      Row with requested fields. Row is valid only during the handler call.
+ *
+ * @return true to continue rows fetching or false to stop
+ */
+typedef bool (*mdv_select_fn)(void *arg, uint64_t row_id, mdv_row_base const *row);
+
+
+/**
+ * @brief Select rows from given table
+ * @details Rows are filtered on the server side and only the requested fields are sent back.
+ *          Rows are fetched by batches, so big tables can be read without loading all rows at once.
+ *
+ * @param client [in]       DB client
+ * @param table [in]        Table description
+ * @param size [in]         Number of requested fields
+ * @param projection [in]   Requested fields indices
+ * @param predicate [in]    Rows filter. If NULL, all rows are selected.
+ * @param snapshot [in]     Read snapshot identifier created by mdv_create_snapshot(). If zero, the latest data is read.
+ * @param arg [in]          User defined argument which is passed to the handler
+ * @param fn [in]           Selected rows handler
+ *
+ * @return On success, return MDV_OK.
+ * @return On error, return non zero value
+ */
+mdv_errno mdv_select(mdv_client           *client,
+                     mdv_table_base const *table,
+                     uint32_t              size,
+                     uint32_t const       *projection,
+                     mdv_predicate const  *predicate,
+                     uint64_t              snapshot,
+                     void                 *arg,
+                     mdv_select_fn         fn);
+
+
+/**
+ * @brief Aggregate rows of given table
+ * @details Rows are filtered and aggregated on the server side, only the aggregation results are sent back.
+ *          Result rows contain the grouping fields followed by the aggregate functions results.
+ *          The handler is called for each group, the row identifier is the group ordinal number.
+ *
+ * @param client [in]       DB client
+ * @param table [in]        Table description
+ * @param groups_size [in]  Number of grouping fields. If zero, all rows are aggregated into the single group.
+ * @param groups [in]       Grouping fields indices
+ * @param size [in]         Number of aggregate functions
+ * @param aggregates [in]   Aggregate functions
+ * @param predicate [in]    Rows filter. If NULL, all rows are aggregated.
+ * @param snapshot [in]     Read snapshot identifier created by mdv_create_snapshot(). If zero, the latest data is read.
+ * @param arg [in]          User defined argument which is passed to the handler
+ * @param fn [in]           Result rows handler
+ *
+ * @return On success, return MDV_OK.
+ * @return On error, return non zero value
+ */
+mdv_errno mdv_aggregate_rows(mdv_client           *client,
+                             mdv_table_base const *table,
+                             uint32_t              groups_size,
+                             uint32_t const       *groups,
+                             uint32_t              size,
+                             mdv_aggregate const  *aggregates,
+                             mdv_predicate const  *predicate,
+                             uint64_t              snapshot,
+                             void                 *arg,
+                             mdv_select_fn         fn);
+
+
+/**
+ * @brief Create consistent read snapshot
+ * @details Snapshot pins the current state of all tables. Rows selections and aggregations
+ *          with the snapshot identifier don't see the changes committed after the snapshot creation,
+ *          so the snapshot can be held across several paged requests. Unused snapshot is released
+ *          by the server after the configured time to live.
+ *
+ * @param client [in]   DB client
+ * @param id [out]      Snapshot identifier
+ *
+ * @return On success, return MDV_OK.
+ * @return On error, return non zero value
+ */
+mdv_errno mdv_create_snapshot(mdv_client *client, uint64_t *id);
+
+
+/**
+ * @brief Release read snapshot created by mdv_create_snapshot()
+ *
+ * @param client [in]   DB client
+ * @param id [in]       Snapshot identifier
+ *
+ * @return On success, return MDV_OK.
+ * @return On error, return non zero value
+ */
+mdv_errno mdv_release_snapshot(mdv_client *client, uint64_t id);
@@ -1,19 +1,27 @@
 #include "mdv_messages.h"
 #include <mdv_log.h>
 #include <mdv_serialization.h>
+#include <mdv_alloc.h>
 
 
 char const * mdv_msg_name(uint32_t id)
 {
     switch(id)
     {
-        case mdv_message_id(hello):         return "HELLO";
-        case mdv_message_id(status):        return "STATUS";
-        case mdv_message_id(create_table):  return "CREATE TABLE";
-        case mdv_message_id(table_info):    return "TABLE INFO";
-        case mdv_message_id(get_topology):  return "GET TOPOLOGY";
-        case mdv_message_id(topology):      return "TOPOLOGY";
-        case mdv_message_id(insert_row):    return "INSERT ROW";
+        case mdv_message_id(hello):             return "HELLO";
+        case mdv_message_id(status):            return "STATUS";
+        case mdv_message_id(create_table):      return "CREATE TABLE";
+        case mdv_message_id(table_info):        return "TABLE INFO";
+        case mdv_message_id(get_topology):      return "GET TOPOLOGY";
+        case mdv_message_id(topology):          return "TOPOLOGY";
+        case mdv_message_id(insert_row):        return "INSERT ROW";
+        case mdv_message_id(row_info):          return "ROW INFO";
+        case mdv_message_id(select):            return "SELECT";
+        case mdv_message_id(rowset):            return "ROWSET";
+        case mdv_message_id(aggregate):         return "AGGREGATE";
+        case mdv_message_id(create_snapshot):   return "CREATE SNAPSHOT";
+        case mdv_message_id(snapshot_info):     return "SNAPSHOT INFO";
+        case mdv_message_id(release_snapshot):  return "RELEASE SNAPSHOT";
     }
     return "UNKOWN";
 }
@@ -184,27 +192,514 @@ mdv_topology * mdv_unbinn_topology(binn const *obj)
 }
 
 
-bool mdv_binn_insert_row(mdv_msg_insert_row const *msg, mdv_field const * fields, binn *obj)
+bool mdv_binn_insert_row(mdv_msg_insert_row const *msg, binn *obj)
 {
-    return  mdv_binn_row(fields, msg->row, obj);
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_insert_row failed");
+        return false;
+    }
+
+    if (0
+        || !binn_object_set_uint64(obj, "U0", msg->table.u64[0])
+        || !binn_object_set_uint64(obj, "U1", msg->table.u64[1])
+        || !binn_object_set_blob(obj, "R", msg->row.ptr, (int)msg->row.size))
+    {
+        binn_free(obj);
+        MDV_LOGE("binn_insert_row failed");
+        return false;
+    }
+
+    return true;
 }
 
 
-mdv_msg_insert_row * mdv_unbinn_insert_row(binn const *obj,  mdv_field const * fields)
+bool mdv_unbinn_insert_row(binn const *obj, mdv_msg_insert_row *msg)
 {
-    return (mdv_msg_insert_row *) mdv_unbinn_row(obj, fields);
+    int size = 0;
+
+    if (0
+        || !binn_object_get_uint64((void*)obj, "U0", (uint64 *)(msg->table.u64 + 0))
+        || !binn_object_get_uint64((void*)obj, "U1", (uint64 *)(msg->table.u64 + 1))
+        || !binn_object_get_blob((void*)obj, "R", &msg->row.ptr, &size))
+    {
+        MDV_LOGE("unbinn_insert_row failed");
+        return false;
+    }
+
+    msg->row.size = (uint32_t)size;
+
+    return true;
+}
+
+
+bool mdv_binn_row_info(mdv_msg_row_info const *msg, binn *obj)
+{
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_row_info failed");
+        return false;
+    }
+
+    if (0
+        || !binn_object_set_uint64(obj, "U0", msg->id.node.u64[0])
+        || !binn_object_set_uint64(obj, "U1", msg->id.node.u64[1])
+        || !binn_object_set_uint64(obj, "I", msg->id.id))
+    {
+        binn_free(obj);
+        MDV_LOGE("binn_row_info failed");
+        return false;
+    }
+
+    return true;
 }
 
 
 bool mdv_unbinn_row_info(binn const *obj, mdv_msg_row_info *msg)
 {
-    uint64 id;
-    if (!binn_object_get_uint64((void*)obj, "I", &id))
+    if (0
+        || !binn_object_get_uint64((void*)obj, "U0", (uint64 *)(msg->id.node.u64 + 0))
+        || !binn_object_get_uint64((void*)obj, "U1", (uint64 *)(msg->id.node.u64 + 1))
+        || !binn_object_get_uint64((void*)obj, "I", (uint64 *)&msg->id.id))
     {
         MDV_LOGE("unbinn_row_info failed");
         return false;
     }
-    msg->id.id = id;
+
+    return true;
+}
+
+
+bool mdv_binn_select(mdv_msg_select const *msg, binn *obj)
+{
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_select failed");
+        return false;
+    }
+
+    binn fields;
+
+    if (!binn_create_list(&fields))
+    {
+        binn_free(obj);
+        MDV_LOGE("binn_select failed");
+        return false;
+    }
+
+    for(uint32_t i = 0; i < msg->size; ++i)
+    {
+        if (!binn_list_add_uint32(&fields, msg->fields[i]))
+        {
+            binn_free(&fields);
+            binn_free(obj);
+            MDV_LOGE("binn_select failed");
+            return false;
+        }
+    }
+
+    if (0
+        || !binn_object_set_uint64(obj, "U0", msg->table.u64[0])
+        || !binn_object_set_uint64(obj, "U1", msg->table.u64[1])
+        || !binn_object_set_uint64(obj, "S", msg->first)
+        || !binn_object_set_uint32(obj, "L", msg->limit)
+        || !binn_object_set_uint64(obj, "N", msg->snapshot)
+        || !binn_object_set_list(obj, "F", &fields))
+    {
+        binn_free(&fields);
+        binn_free(obj);
+        MDV_LOGE("binn_select failed");
+        return false;
+    }
+
+    binn_free(&fields);
+
+    if (msg->predicate)
+    {
+        binn predicate;
+
+        if (!mdv_binn_predicate(msg->predicate, &predicate))
+        {
+            binn_free(obj);
+            return false;
+        }
+
+        if (!binn_object_set_object(obj, "P", &predicate))
+        {
+            binn_free(&predicate);
+            binn_free(obj);
+            MDV_LOGE("binn_select failed");
+            return false;
+        }
+
+        binn_free(&predicate);
+    }
+
+    return true;
+}
+
+
+bool mdv_unbinn_select(binn const *obj, mdv_msg_select *msg)
+{
+    void *fields = 0;
+
+    msg->fields = 0;
+    msg->predicate = 0;
+
+    if (0
+        || !binn_object_get_uint64((void*)obj, "U0", (uint64 *)(msg->table.u64 + 0))
+        || !binn_object_get_uint64((void*)obj, "U1", (uint64 *)(msg->table.u64 + 1))
+        || !binn_object_get_uint64((void*)obj, "S", (uint64 *)&msg->first)
+        || !binn_object_get_uint32((void*)obj, "L", &msg->limit)
+        || !binn_object_get_uint64((void*)obj, "N", (uint64 *)&msg->snapshot)
+        || !binn_object_get_list((void*)obj, "F", &fields))
+    {
+        MDV_LOGE("unbinn_select failed");
+        return false;
+    }
+
+    int const size = binn_count(fields);
+
+    if (size <= 0)
+    {
+        MDV_LOGE("unbinn_select failed");
+        return false;
+    }
+
+    msg->size = (uint32_t)size;
+    msg->fields = mdv_alloc(msg->size * sizeof(uint32_t), "select.fields");
+
+    if (!msg->fields)
+    {
+        MDV_LOGE("unbinn_select failed");
+        return false;
+    }
+
+    for(uint32_t i = 0; i < msg->size; ++i)
+    {
+        if (!binn_list_get_uint32(fields, i + 1, msg->fields + i))
+        {
+            MDV_LOGE("unbinn_select failed");
+            mdv_select_free(msg);
+            return false;
+        }
+    }
+
+    void *predicate = 0;
+
+    if (binn_object_get_object((void*)obj, "P", &predicate))
+    {
+        msg->predicate = mdv_unbinn_predicate(predicate);
+
+        if (!msg->predicate)
+        {
+            MDV_LOGE("unbinn_select failed");
+            mdv_select_free(msg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void mdv_select_free(mdv_msg_select *msg)
+{
+    mdv_free(msg->fields, "select.fields");
+    mdv_free(msg->predicate, "predicate");
+    msg->fields = 0;
+    msg->predicate = 0;
+}
+
+
+bool mdv_binn_rowset(mdv_msg_rowset const *msg, binn *obj)
+{
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_rowset failed");
+        return false;
+    }
+
+    if (0
+        || !binn_object_set_list(obj, "I", msg->ids)
+        || !binn_object_set_list(obj, "R", msg->rows)
+        || !binn_object_set_uint64(obj, "N", msg->next))
+    {
+        binn_free(obj);
+        MDV_LOGE("binn_rowset failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_unbinn_rowset(binn const *obj, mdv_msg_rowset *msg)
+{
+    if (0
+        || !binn_object_get_list((void*)obj, "I", (void**)&msg->ids)
+        || !binn_object_get_list((void*)obj, "R", (void**)&msg->rows)
+        || !binn_object_get_uint64((void*)obj, "N", (uint64 *)&msg->next))
+    {
+        MDV_LOGE("unbinn_rowset failed");
+        return false;
+    }
+
+    if (binn_count(msg->ids) != binn_count(msg->rows))
+    {
+        MDV_LOGE("unbinn_rowset failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_binn_aggregate(mdv_msg_aggregate const *msg, binn *obj)
+{
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_aggregate failed");
+        return false;
+    }
+
+    binn *groups = binn_list();
+    binn *aggregates = binn_list();
+
+    bool ret = groups && aggregates;
+
+    for(uint32_t i = 0; ret && i < msg->groups_size; ++i)
+        ret = binn_list_add_uint32(groups, msg->groups[i]);
+
+    for(uint32_t i = 0; ret && i < msg->size; ++i)
+    {
+        binn aggregate;
+
+        ret = binn_create_object(&aggregate);
+
+        if (!ret)
+            break;
+
+        ret = binn_object_set_uint32(&aggregate, "O", msg->aggregates[i].op)
+              && binn_object_set_uint32(&aggregate, "F", msg->aggregates[i].field)
+              && binn_list_add_object(aggregates, &aggregate);
+
+        binn_free(&aggregate);
+    }
+
+    ret = ret
+          && binn_object_set_uint64(obj, "U0", msg->table.u64[0])
+          && binn_object_set_uint64(obj, "U1", msg->table.u64[1])
+          && binn_object_set_uint64(obj, "N", msg->snapshot)
+          && binn_object_set_list(obj, "G", groups)
+          && binn_object_set_list(obj, "A", aggregates);
+
+    binn_free(groups);
+    binn_free(aggregates);
+
+    if (ret && msg->predicate)
+    {
+        binn predicate;
+
+        ret = mdv_binn_predicate(msg->predicate, &predicate);
+
+        if (ret)
+        {
+            ret = binn_object_set_object(obj, "P", &predicate);
+            binn_free(&predicate);
+        }
+    }
+
+    if (!ret)
+    {
+        binn_free(obj);
+        MDV_LOGE("binn_aggregate failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_unbinn_aggregate(binn const *obj, mdv_msg_aggregate *msg)
+{
+    void *groups = 0;
+    void *aggregates = 0;
+
+    msg->groups = 0;
+    msg->aggregates = 0;
+    msg->predicate = 0;
+
+    if (0
+        || !binn_object_get_uint64((void*)obj, "U0", (uint64 *)(msg->table.u64 + 0))
+        || !binn_object_get_uint64((void*)obj, "U1", (uint64 *)(msg->table.u64 + 1))
+        || !binn_object_get_uint64((void*)obj, "N", (uint64 *)&msg->snapshot)
+        || !binn_object_get_list((void*)obj, "G", &groups)
+        || !binn_object_get_list((void*)obj, "A", &aggregates))
+    {
+        MDV_LOGE("unbinn_aggregate failed");
+        return false;
+    }
+
+    int const groups_size = binn_count(groups);
+    int const size = binn_count(aggregates);
+
+    if (groups_size < 0 || size <= 0)
+    {
+        MDV_LOGE("unbinn_aggregate failed");
+        return false;
+    }
+
+    msg->groups_size = (uint32_t)groups_size;
+    msg->size = (uint32_t)size;
+
+    // Aggregate functions and grouping fields are allocated at once
+    msg->aggregates = mdv_alloc(msg->size * sizeof(mdv_aggregate)
+                                + msg->groups_size * sizeof(uint32_t),
+                                "aggregate");
+
+    if (!msg->aggregates)
+    {
+        MDV_LOGE("unbinn_aggregate failed");
+        return false;
+    }
+
+    msg->groups = (uint32_t *)(msg->aggregates + msg->size);
+
+    for(uint32_t i = 0; i < msg->groups_size; ++i)
+    {
+        if (!binn_list_get_uint32(groups, i + 1, msg->groups + i))
+        {
+            MDV_LOGE("unbinn_aggregate failed");
+            mdv_aggregate_free(msg);
+            return false;
+        }
+    }
+
+    for(uint32_t i = 0; i < msg->size; ++i)
+    {
+        void *aggregate = 0;
+        uint32_t op = 0;
+
+        if (!binn_list_get_object(aggregates, i + 1, &aggregate)
+            || !binn_object_get_uint32(aggregate, "O", &op)
+            || !binn_object_get_uint32(aggregate, "F", &msg->aggregates[i].field))
+        {
+            MDV_LOGE("unbinn_aggregate failed");
+            mdv_aggregate_free(msg);
+            return false;
+        }
+
+        msg->aggregates[i].op = (mdv_aggregate_op)op;
+    }
+
+    void *predicate = 0;
+
+    if (binn_object_get_object((void*)obj, "P", &predicate))
+    {
+        msg->predicate = mdv_unbinn_predicate(predicate);
+
+        if (!msg->predicate)
+        {
+            MDV_LOGE("unbinn_aggregate failed");
+            mdv_aggregate_free(msg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void mdv_aggregate_free(mdv_msg_aggregate *msg)
+{
+    mdv_free(msg->aggregates, "aggregate");
+    mdv_free(msg->predicate, "predicate");
+    msg->aggregates = 0;
+    msg->groups = 0;
+    msg->predicate = 0;
+}
+
+
+bool mdv_binn_create_snapshot(mdv_msg_create_snapshot const *msg, binn *obj)
+{
+    (void)msg;
+
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_create_snapshot failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_unbinn_create_snapshot(binn const *obj, mdv_msg_create_snapshot *msg)
+{
+    (void)obj;
+    (void)msg;
+    return true;
+}
+
+
+bool mdv_binn_snapshot_info(mdv_msg_snapshot_info const *msg, binn *obj)
+{
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_snapshot_info failed");
+        return false;
+    }
+
+    if (!binn_object_set_uint64(obj, "I", msg->id))
+    {
+        binn_free(obj);
+        MDV_LOGE("binn_snapshot_info failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_unbinn_snapshot_info(binn const *obj, mdv_msg_snapshot_info *msg)
+{
+    if (!binn_object_get_uint64((void*)obj, "I", (uint64 *)&msg->id))
+    {
+        MDV_LOGE("unbinn_snapshot_info failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_binn_release_snapshot(mdv_msg_release_snapshot const *msg, binn *obj)
+{
+    if (!binn_create_object(obj))
+    {
+        MDV_LOGE("binn_release_snapshot failed");
+        return false;
+    }
+
+    if (!binn_object_set_uint64(obj, "I", msg->id))
+    {
+        binn_free(obj);
+        MDV_LOGE("binn_release_snapshot failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_unbinn_release_snapshot(binn const *obj, mdv_msg_release_snapshot *msg)
+{
+    if (!binn_object_get_uint64((void*)obj, "I", (uint64 *)&msg->id))
+    {
+        MDV_LOGE("unbinn_release_snapshot failed");
+        return false;
+    }
 
     return true;
 }
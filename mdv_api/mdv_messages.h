@@ -19,6 +19,18 @@
      |                                  |
      | INSERT ROW >>>>>                 |
      |          <<<<< ROW INFO / STATUS |
+     |                                  |
+     | SELECT >>>>>                     |
+     |            <<<<< ROWSET / STATUS |
+     |                                  |
+     | AGGREGATE >>>>>                  |
+     |            <<<<< ROWSET / STATUS |
+     |                                  |
+     | CREATE SNAPSHOT >>>>>            |
+     |     <<<<< SNAPSHOT INFO / STATUS |
+     |                                  |
+     | RELEASE SNAPSHOT >>>>>           |
+     |                    <<<<< STATUS  |
  */
 
 
@@ -69,8 +81,8 @@ mdv_message_def(topology, 6,
 
 
 mdv_message_def(insert_row, 7,
-    mdv_gobjid          table;
-    mdv_row_base const *row;
+    mdv_uuid        table;          // Table identifier
+    mdv_data        row;            // Packed row (see mdv_packed_row.h)
 );
 
 
@@ -79,6 +91,49 @@ mdv_message_def(row_info, 8,
 );
 
 
+mdv_message_def(select, 9,
+    mdv_uuid        table;          // Table identifier
+    uint64_t        first;          // First row identifier
+    uint32_t        limit;          // Maximum number of rows (0 - not limited)
+    uint32_t        size;           // Number of requested fields
+    uint32_t       *fields;         // Requested fields indices
+    mdv_predicate  *predicate;      // Rows filter (NULL - all rows are selected)
+    uint64_t        snapshot;       // Read snapshot identifier (0 - the latest data is read)
+);
+
+
+mdv_message_def(rowset, 10,
+    binn       *ids;                // Rows identifiers (list of uint64)
+    binn       *rows;               // Rows with requested fields (list of packed rows)
+    uint64_t    next;               // Next row identifier. Zero if there are no more rows.
+);
+
+
+mdv_message_def(aggregate, 11,
+    mdv_uuid        table;          // Table identifier
+    uint32_t        groups_size;    // Number of grouping fields
+    uint32_t       *groups;         // Grouping fields indices
+    uint32_t        size;           // Number of aggregate functions
+    mdv_aggregate  *aggregates;     // Aggregate functions
+    mdv_predicate  *predicate;      // Rows filter (NULL - all rows are aggregated)
+    uint64_t        snapshot;       // Read snapshot identifier (0 - the latest data is read)
+);
+
+
+mdv_message_def(create_snapshot, 12,
+);
+
+
+mdv_message_def(snapshot_info, 13,
+    uint64_t        id;             // Snapshot identifier
+);
+
+
+mdv_message_def(release_snapshot, 14,
+    uint64_t        id;             // Snapshot identifier
+);
+
+
 char const *                mdv_msg_name                    (uint32_t id);
 
 
@@ -107,9 +162,35 @@ bool                        mdv_binn_topology               (mdv_msg_topology co
 mdv_topology              * mdv_unbinn_topology             (binn const *obj);
 
 
-bool                        mdv_binn_insert_row             (mdv_msg_insert_row const *msg,  mdv_field const * fields, binn *obj);
-mdv_msg_insert_row        * mdv_unbinn_insert_row           (binn const * obj, mdv_field const * fields);
+bool                        mdv_binn_insert_row             (mdv_msg_insert_row const *msg, binn *obj);
+bool                        mdv_unbinn_insert_row           (binn const *obj, mdv_msg_insert_row *msg);
 
 
 bool                        mdv_binn_row_info               (mdv_msg_row_info const *msg, binn *obj);
-bool                        mdv_unbinn_row_info             (binn const *obj, mdv_msg_row_info *msg);
\ No newline at end of file
+bool                        mdv_unbinn_row_info             (binn const *obj, mdv_msg_row_info *msg);
+
+
+bool                        mdv_binn_select                 (mdv_msg_select const *msg, binn *obj);
+bool                        mdv_unbinn_select               (binn const *obj, mdv_msg_select *msg);
+void                        mdv_select_free                 (mdv_msg_select *msg);
+
+
+bool                        mdv_binn_rowset                 (mdv_msg_rowset const *msg, binn *obj);
+bool                        mdv_unbinn_rowset               (binn const *obj, mdv_msg_rowset *msg);
+
+
+bool                        mdv_binn_aggregate              (mdv_msg_aggregate const *msg, binn *obj);
+bool                        mdv_unbinn_aggregate            (binn const *obj, mdv_msg_aggregate *msg);
+void                        mdv_aggregate_free              (mdv_msg_aggregate *msg);
+
+
+bool                        mdv_binn_create_snapshot        (mdv_msg_create_snapshot const *msg, binn *obj);
+bool                        mdv_unbinn_create_snapshot      (binn const *obj, mdv_msg_create_snapshot *msg);
+
+
+bool                        mdv_binn_snapshot_info          (mdv_msg_snapshot_info const *msg, binn *obj);
+bool                        mdv_unbinn_snapshot_info        (binn const *obj, mdv_msg_snapshot_info *msg);
+
+
+bool                        mdv_binn_release_snapshot       (mdv_msg_release_snapshot const *msg, binn *obj);
+bool                        mdv_unbinn_release_snapshot     (binn const *obj, mdv_msg_release_snapshot *msg);
\ No newline at end of file
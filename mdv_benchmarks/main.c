@@ -0,0 +1,120 @@
+#include <storage/mdv_filter_kernels.h>
+#include <mdv_alloc.h>
+#include <mdv_time.h>
+#include <stdio.h>
+#include <string.h>
+
+
+enum
+{
+    MDV_BENCH_VALUES    = 1024 * 1024,  ///< Values count in column
+    MDV_BENCH_TIME      = 200           ///< Minimal measurement time in milliseconds
+};
+
+
+/**
+ * @brief Measures the kernel throughput.
+ *
+ * @return Millions of values per second
+ */
+static double mdv_bench_kernel(mdv_filter_kernel kernel, void const *values, void const *value, uint32_t *bits)
+{
+    size_t iterations = 0;
+    size_t const start = mdv_gettime();
+    size_t elapsed = 0;
+
+    do
+    {
+        kernel(values, MDV_BENCH_VALUES, value, bits);
+        ++iterations;
+        elapsed = mdv_gettime() - start;
+    }
+    while(elapsed < MDV_BENCH_TIME);
+
+    return (double)iterations * MDV_BENCH_VALUES / ((double)elapsed * 1000.0);
+}
+
+
+static void mdv_bench_filter_kernels()
+{
+    static struct
+    {
+        mdv_field_type  type;
+        char const     *name;
+    } const types[] =
+    {
+        { MDV_FLD_TYPE_BOOL,    "bool" },
+        { MDV_FLD_TYPE_UINT8,   "uint8" },
+        { MDV_FLD_TYPE_INT16,   "int16" },
+        { MDV_FLD_TYPE_INT32,   "int32" },
+        { MDV_FLD_TYPE_UINT32,  "uint32" },
+        { MDV_FLD_TYPE_INT64,   "int64" },
+        { MDV_FLD_TYPE_FLOAT,   "float" },
+        { MDV_FLD_TYPE_DOUBLE,  "double" },
+    };
+
+    mdv_filter_isa const best = mdv_filter_isa_best();
+
+    uint8_t *values = mdv_alloc(MDV_BENCH_VALUES * sizeof(uint64_t), "bench.values");
+    uint32_t *bits = mdv_alloc(MDV_BENCH_VALUES / 8, "bench.bits");
+
+    if (!values || !bits)
+    {
+        fprintf(stderr, "No memory for benchmark\n");
+        mdv_free(values, "bench.values");
+        mdv_free(bits, "bench.bits");
+        return;
+    }
+
+    // Pseudo random bytes give about half of the values less than zero constant
+    uint32_t r = 42;
+
+    for(size_t i = 0; i < MDV_BENCH_VALUES * sizeof(uint64_t); ++i)
+    {
+        r = r * 1103515245u + 12345u;
+        values[i] = (uint8_t)(r >> 16);
+    }
+
+    uint64_t const zero = 0;
+
+    printf("Filter kernels (x < 0), %u values, best instruction set: %s\n",
+           MDV_BENCH_VALUES, mdv_filter_isa_name(best));
+    printf("%-8s %-8s %14s %8s\n", "type", "isa", "Mvalues/s", "speedup");
+
+    for(size_t t = 0; t < sizeof types / sizeof *types; ++t)
+    {
+        double scalar = 0;
+
+        for(int isa = MDV_FILTER_ISA_SCALAR; isa <= (int)best; ++isa)
+        {
+            mdv_filter_kernel kernel = mdv_filter_kernel_get(isa, types[t].type, MDV_PRED_LT);
+
+            double const speed = mdv_bench_kernel(kernel, values, &zero, bits);
+
+            if (isa == MDV_FILTER_ISA_SCALAR)
+                scalar = speed;
+
+            printf("%-8s %-8s %14.1f %7.1fx\n",
+                   types[t].name,
+                   mdv_filter_isa_name(isa),
+                   speed,
+                   speed / scalar);
+        }
+    }
+
+    mdv_free(values, "bench.values");
+    mdv_free(bits, "bench.bits");
+}
+
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+
+    mdv_alloc_initialize();
+    mdv_bench_filter_kernels();
+    mdv_alloc_finalize();
+
+    return 0;
+}
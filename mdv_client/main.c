@@ -169,6 +169,26 @@ static void mdv_show_topology(char const *args)
 }
 
 
+static bool mdv_test_scenario_row(void *arg, uint64_t row_id, mdv_row_base const *row)
+{
+    size_t *rows = arg;
+    ++*rows;
+    MDV_INF("Row %" PRIu64 ": '%.*s'\n", row_id, (int)row->fields[0].size, (char const *)row->fields[0].ptr);
+    return true;
+}
+
+
+static bool mdv_test_scenario_group(void *arg, uint64_t group, mdv_row_base const *row)
+{
+    (void)arg;
+    MDV_INF("Group %" PRIu64 ": Col3=%d, count=%" PRIu64 "\n",
+            group,
+            *(uint8_t const *)row->fields[0].ptr,
+            *(uint64_t const *)row->fields[1].ptr);
+    return true;
+}
+
+
 static void mdv_test_scenario(char const *args)
 {
     (void)args;
@@ -194,34 +214,94 @@ static void mdv_test_scenario(char const *args)
     else
     {
         MDV_INF("Table '%s' creation failed with error '%s' (%d)\n", table.name.ptr, mdv_strerror(err), err);
+        return;
+    }
+
+    mdv_gobjid row_id;
+
+    int int_value[] = { 42, 43 };
+    bool bool_value = true;
+
+    mdv_row(3) row =
+    {
+        .size = 3,
+        .fields =
+        {
+            { 5, "hello" },
+            { sizeof(int_value), int_value },
+            { 1, &bool_value }
+        }
+    };
+
+    err = mdv_insert_row(client, &table.id, table.fields, (mdv_row_base *)&row, &row_id);
+
+    if (err == MDV_OK)
+    {
+        MDV_INF("New row with ID '%" PRIu64 "' successfully inserted\n",  row_id.id);
+    }
+    else
+    {
+        MDV_INF("New row insertion failed with error '%s' (%d)\n", mdv_strerror(err), err);
+        return;
+    }
+
+    // Both queries read the same state of the table
+    uint64_t snapshot = 0;
+
+    err = mdv_create_snapshot(client, &snapshot);
+
+    if (err != MDV_OK)
+    {
+        MDV_INF("Snapshot creation failed with error '%s' (%d)\n", mdv_strerror(err), err);
+        return;
+    }
+
+    // SELECT Col1 FROM MyTable WHERE Col3 = true
+    uint32_t const projection[] = { 0 };
+
+    mdv_predicate const predicate =
+    {
+        .op = MDV_PRED_EQ,
+        .field = 2,
+        .value = { 1, &bool_value }
+    };
+
+    size_t rows = 0;
+
+    err = mdv_select(client, (mdv_table_base *)&table,
+                     sizeof projection / sizeof *projection, projection,
+                     &predicate, snapshot, &rows, &mdv_test_scenario_row);
+
+    if (err == MDV_OK)
+    {
+        MDV_INF("%zu rows selected\n", rows);
+    }
+    else
+    {
+        MDV_INF("Rows selection failed with error '%s' (%d)\n", mdv_strerror(err), err);
+        mdv_release_snapshot(client, snapshot);
+        return;
+    }
+
+    // SELECT Col3, COUNT(*) FROM MyTable GROUP BY Col3
+    uint32_t const groups[] = { 2 };
+
+    mdv_aggregate const aggregates[] =
+    {
+        { MDV_AGG_COUNT, 0 }
+    };
+
+    err = mdv_aggregate_rows(client, (mdv_table_base *)&table,
+                             sizeof groups / sizeof *groups, groups,
+                             sizeof aggregates / sizeof *aggregates, aggregates,
+                             0, snapshot, 0, &mdv_test_scenario_group);
+
+    if (err != MDV_OK)
+    {
+        MDV_INF("Rows aggregation failed with error '%s' (%d)\n", mdv_strerror(err), err);
     }
 
-//    mdv_gobjid row_id;
-//
-//    int int_value[] = { 42, 43 };
-//    bool bool_value = true;
-//
-//    mdv_row(3) row =
-//    {
-//        .size = 3,
-//        .fields =
-//        {
-//            { 5, "hello" },
-//            { sizeof(int_value), int_value },
-//            { 1, &bool_value }
-//        }
-//    };
-
-//    err = mdv_insert_row(client, &id, table.fields, (mdv_row_base *)&row, &row_id);
-
-//    if (err == MDV_OK)
-//    {
-//        MDV_INF("New row with ID '" PRIu64 "' successfully inserted\n",  row_id.id);
-//    }
-//    else
-//    {
-//        MDV_INF("New row insertion failed with error '%s' (%d)\n", mdv_strerror(err), err);
-//    }
+    mdv_release_snapshot(client, snapshot);
 }
 
 
@@ -1,6 +1,7 @@
 #include "mdv_table.h"
 #include "mdv_types.h"
 #include <mdv_alloc.h>
+#include <string.h>
 
 
 mdv_evt_create_table * mdv_evt_create_table_create(mdv_table_base **table)
@@ -44,3 +45,282 @@ uint32_t mdv_evt_create_table_release(mdv_evt_create_table *evt)
 
     return rc;
 }
+
+
+mdv_evt_insert_row * mdv_evt_insert_row_create(mdv_uuid const *table, mdv_data const *row)
+{
+    static mdv_ievent vtbl =
+    {
+        .retain = (mdv_event_retain_fn)mdv_evt_insert_row_retain,
+        .release = (mdv_event_release_fn)mdv_evt_insert_row_release
+    };
+
+    mdv_evt_insert_row *event = (mdv_evt_insert_row*)
+                                mdv_event_create(
+                                    MDV_EVT_INSERT_ROW,
+                                    sizeof(mdv_evt_insert_row) + row->size);
+
+    if (event)
+    {
+        event->base.vptr = &vtbl;
+        event->table = *table;
+        event->row_id = (mdv_gobjid){};
+        event->row.size = row->size;
+        event->row.ptr = event + 1;
+        memcpy(event->row.ptr, row->ptr, row->size);
+    }
+
+    return event;
+}
+
+
+mdv_evt_insert_row * mdv_evt_insert_row_retain(mdv_evt_insert_row *evt)
+{
+    return (mdv_evt_insert_row*)mdv_event_retain(&evt->base);
+}
+
+
+uint32_t mdv_evt_insert_row_release(mdv_evt_insert_row *evt)
+{
+    return mdv_event_release(&evt->base);
+}
+
+
+mdv_evt_create_index * mdv_evt_create_index_create(mdv_uuid const *table, uint32_t size, uint32_t const *fields)
+{
+    static mdv_ievent vtbl =
+    {
+        .retain = (mdv_event_retain_fn)mdv_evt_create_index_retain,
+        .release = (mdv_event_release_fn)mdv_evt_create_index_release
+    };
+
+    mdv_evt_create_index *event = (mdv_evt_create_index*)
+                                mdv_event_create(
+                                    MDV_EVT_CREATE_INDEX,
+                                    sizeof(mdv_evt_create_index) + size * sizeof *fields);
+
+    if (event)
+    {
+        event->base.vptr = &vtbl;
+        event->table = *table;
+        event->size = size;
+        event->fields = (uint32_t *)(event + 1);
+        memcpy(event->fields, fields, size * sizeof *fields);
+    }
+
+    return event;
+}
+
+
+mdv_evt_create_index * mdv_evt_create_index_retain(mdv_evt_create_index *evt)
+{
+    return (mdv_evt_create_index*)mdv_event_retain(&evt->base);
+}
+
+
+uint32_t mdv_evt_create_index_release(mdv_evt_create_index *evt)
+{
+    return mdv_event_release(&evt->base);
+}
+
+
+mdv_evt_select * mdv_evt_select_create(mdv_uuid const *table,
+                                       uint64_t        first,
+                                       uint32_t        limit,
+                                       uint32_t        size,
+                                       uint32_t const *fields,
+                                       mdv_predicate **predicate,
+                                       uint64_t        snapshot)
+{
+    static mdv_ievent vtbl =
+    {
+        .retain = (mdv_event_retain_fn)mdv_evt_select_retain,
+        .release = (mdv_event_release_fn)mdv_evt_select_release
+    };
+
+    mdv_evt_select *event = (mdv_evt_select*)
+                                mdv_event_create(
+                                    MDV_EVT_SELECT,
+                                    sizeof(mdv_evt_select) + size * sizeof *fields);
+
+    if (event)
+    {
+        event->base.vptr = &vtbl;
+        event->table = *table;
+        event->first = first;
+        event->limit = limit;
+        event->size = size;
+        event->fields = (uint32_t *)(event + 1);
+        event->predicate = *predicate;
+        event->snapshot = snapshot;
+        event->ids = 0;
+        event->rows = 0;
+        event->next = 0;
+        memcpy(event->fields, fields, size * sizeof *fields);
+        *predicate = 0;
+    }
+
+    return event;
+}
+
+
+mdv_evt_select * mdv_evt_select_retain(mdv_evt_select *evt)
+{
+    return (mdv_evt_select*)mdv_event_retain(&evt->base);
+}
+
+
+uint32_t mdv_evt_select_release(mdv_evt_select *evt)
+{
+    mdv_predicate *predicate = evt->predicate;
+    binn *ids = evt->ids;
+    binn *rows = evt->rows;
+
+    uint32_t rc = mdv_event_release(&evt->base);
+
+    if (!rc)
+    {
+        mdv_free(predicate, "predicate");
+        binn_free(ids);
+        binn_free(rows);
+    }
+
+    return rc;
+}
+
+
+mdv_evt_aggregate * mdv_evt_aggregate_create(mdv_uuid const      *table,
+                                             uint32_t             groups_size,
+                                             uint32_t const      *groups,
+                                             uint32_t             size,
+                                             mdv_aggregate const *aggregates,
+                                             mdv_predicate      **predicate,
+                                             uint64_t             snapshot)
+{
+    static mdv_ievent vtbl =
+    {
+        .retain = (mdv_event_retain_fn)mdv_evt_aggregate_retain,
+        .release = (mdv_event_release_fn)mdv_evt_aggregate_release
+    };
+
+    mdv_evt_aggregate *event = (mdv_evt_aggregate*)
+                                mdv_event_create(
+                                    MDV_EVT_AGGREGATE,
+                                    sizeof(mdv_evt_aggregate)
+                                    + size * sizeof *aggregates
+                                    + groups_size * sizeof *groups);
+
+    if (event)
+    {
+        event->base.vptr = &vtbl;
+        event->table = *table;
+        event->size = size;
+        event->aggregates = (mdv_aggregate *)(event + 1);
+        event->groups_size = groups_size;
+        event->groups = (uint32_t *)(event->aggregates + size);
+        event->predicate = *predicate;
+        event->snapshot = snapshot;
+        event->ids = 0;
+        event->rows = 0;
+        memcpy(event->aggregates, aggregates, size * sizeof *aggregates);
+        memcpy(event->groups, groups, groups_size * sizeof *groups);
+        *predicate = 0;
+    }
+
+    return event;
+}
+
+
+mdv_evt_aggregate * mdv_evt_aggregate_retain(mdv_evt_aggregate *evt)
+{
+    return (mdv_evt_aggregate*)mdv_event_retain(&evt->base);
+}
+
+
+uint32_t mdv_evt_aggregate_release(mdv_evt_aggregate *evt)
+{
+    mdv_predicate *predicate = evt->predicate;
+    binn *ids = evt->ids;
+    binn *rows = evt->rows;
+
+    uint32_t rc = mdv_event_release(&evt->base);
+
+    if (!rc)
+    {
+        mdv_free(predicate, "predicate");
+        binn_free(ids);
+        binn_free(rows);
+    }
+
+    return rc;
+}
+
+
+mdv_evt_create_snapshot * mdv_evt_create_snapshot_create()
+{
+    static mdv_ievent vtbl =
+    {
+        .retain = (mdv_event_retain_fn)mdv_evt_create_snapshot_retain,
+        .release = (mdv_event_release_fn)mdv_evt_create_snapshot_release
+    };
+
+    mdv_evt_create_snapshot *event = (mdv_evt_create_snapshot*)
+                                mdv_event_create(
+                                    MDV_EVT_CREATE_SNAPSHOT,
+                                    sizeof(mdv_evt_create_snapshot));
+
+    if (event)
+    {
+        event->base.vptr = &vtbl;
+        event->id = 0;
+    }
+
+    return event;
+}
+
+
+mdv_evt_create_snapshot * mdv_evt_create_snapshot_retain(mdv_evt_create_snapshot *evt)
+{
+    return (mdv_evt_create_snapshot*)mdv_event_retain(&evt->base);
+}
+
+
+uint32_t mdv_evt_create_snapshot_release(mdv_evt_create_snapshot *evt)
+{
+    return mdv_event_release(&evt->base);
+}
+
+
+mdv_evt_release_snapshot * mdv_evt_release_snapshot_create(uint64_t id)
+{
+    static mdv_ievent vtbl =
+    {
+        .retain = (mdv_event_retain_fn)mdv_evt_release_snapshot_retain,
+        .release = (mdv_event_release_fn)mdv_evt_release_snapshot_release
+    };
+
+    mdv_evt_release_snapshot *event = (mdv_evt_release_snapshot*)
+                                mdv_event_create(
+                                    MDV_EVT_RELEASE_SNAPSHOT,
+                                    sizeof(mdv_evt_release_snapshot));
+
+    if (event)
+    {
+        event->base.vptr = &vtbl;
+        event->id = id;
+    }
+
+    return event;
+}
+
+
+mdv_evt_release_snapshot * mdv_evt_release_snapshot_retain(mdv_evt_release_snapshot *evt)
+{
+    return (mdv_evt_release_snapshot*)mdv_event_retain(&evt->base);
+}
+
+
+uint32_t mdv_evt_release_snapshot_release(mdv_evt_release_snapshot *evt)
+{
+    return mdv_event_release(&evt->base);
+}
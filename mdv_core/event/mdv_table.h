@@ -12,6 +12,7 @@
 #include <mdv_ebus.h>
 #include <mdv_types.h>
 #include <mdv_uuid.h>
+#include <mdv_binn.h>
 
 
 typedef struct
@@ -23,3 +24,102 @@ typedef struct
 mdv_evt_create_table * mdv_evt_create_table_create(mdv_table_base **table);
 mdv_evt_create_table * mdv_evt_create_table_retain(mdv_evt_create_table *evt);
 uint32_t               mdv_evt_create_table_release(mdv_evt_create_table *evt);
+
+
+typedef struct
+{
+    mdv_event       base;
+    mdv_uuid        table;      ///< Table identifier
+    mdv_gobjid      row_id;     ///< Inserted row identifier (filled by the event handler)
+    mdv_data        row;        ///< Serialized row
+} mdv_evt_insert_row;
+
+mdv_evt_insert_row * mdv_evt_insert_row_create(mdv_uuid const *table, mdv_data const *row);
+mdv_evt_insert_row * mdv_evt_insert_row_retain(mdv_evt_insert_row *evt);
+uint32_t             mdv_evt_insert_row_release(mdv_evt_insert_row *evt);
+
+
+typedef struct
+{
+    mdv_event       base;
+    mdv_uuid        table;      ///< Table identifier
+    uint32_t        size;       ///< Number of indexed fields
+    uint32_t       *fields;     ///< Indexed fields indices
+} mdv_evt_create_index;
+
+mdv_evt_create_index * mdv_evt_create_index_create(mdv_uuid const *table, uint32_t size, uint32_t const *fields);
+mdv_evt_create_index * mdv_evt_create_index_retain(mdv_evt_create_index *evt);
+uint32_t               mdv_evt_create_index_release(mdv_evt_create_index *evt);
+
+
+typedef struct
+{
+    mdv_event       base;
+    mdv_uuid        table;      ///< Table identifier
+    uint64_t        first;      ///< First row identifier
+    uint32_t        limit;      ///< Maximum number of rows (0 - not limited)
+    uint32_t        size;       ///< Number of requested fields
+    uint32_t       *fields;     ///< Requested fields indices
+    mdv_predicate  *predicate;  ///< Rows filter (NULL - all rows are selected)
+    uint64_t        snapshot;   ///< Read snapshot identifier (0 - the latest data is read)
+    binn           *ids;        ///< Selected rows identifiers (filled by the event handler)
+    binn           *rows;       ///< Selected rows with requested fields (filled by the event handler)
+    uint64_t        next;       ///< Next row identifier for the following request (filled by the event handler). Zero if there are no more rows.
+} mdv_evt_select;
+
+mdv_evt_select * mdv_evt_select_create(mdv_uuid const *table,
+                                       uint64_t        first,
+                                       uint32_t        limit,
+                                       uint32_t        size,
+                                       uint32_t const *fields,
+                                       mdv_predicate **predicate,
+                                       uint64_t        snapshot);
+mdv_evt_select * mdv_evt_select_retain(mdv_evt_select *evt);
+uint32_t         mdv_evt_select_release(mdv_evt_select *evt);
+
+
+typedef struct
+{
+    mdv_event       base;
+    mdv_uuid        table;          ///< Table identifier
+    uint32_t        groups_size;    ///< Number of grouping fields
+    uint32_t       *groups;         ///< Grouping fields indices
+    uint32_t        size;           ///< Number of aggregate functions
+    mdv_aggregate  *aggregates;     ///< Aggregate functions
+    mdv_predicate  *predicate;      ///< Rows filter (NULL - all rows are aggregated)
+    uint64_t        snapshot;       ///< Read snapshot identifier (0 - the latest data is read)
+    binn           *ids;            ///< Groups numbers (filled by the event handler)
+    binn           *rows;           ///< Groups with aggregate functions results (filled by the event handler)
+} mdv_evt_aggregate;
+
+mdv_evt_aggregate * mdv_evt_aggregate_create(mdv_uuid const      *table,
+                                             uint32_t             groups_size,
+                                             uint32_t const      *groups,
+                                             uint32_t             size,
+                                             mdv_aggregate const *aggregates,
+                                             mdv_predicate      **predicate,
+                                             uint64_t             snapshot);
+mdv_evt_aggregate * mdv_evt_aggregate_retain(mdv_evt_aggregate *evt);
+uint32_t            mdv_evt_aggregate_release(mdv_evt_aggregate *evt);
+
+
+typedef struct
+{
+    mdv_event       base;
+    uint64_t        id;         ///< Snapshot identifier (filled by the event handler)
+} mdv_evt_create_snapshot;
+
+mdv_evt_create_snapshot * mdv_evt_create_snapshot_create();
+mdv_evt_create_snapshot * mdv_evt_create_snapshot_retain(mdv_evt_create_snapshot *evt);
+uint32_t                  mdv_evt_create_snapshot_release(mdv_evt_create_snapshot *evt);
+
+
+typedef struct
+{
+    mdv_event       base;
+    uint64_t        id;         ///< Snapshot identifier
+} mdv_evt_release_snapshot;
+
+mdv_evt_release_snapshot * mdv_evt_release_snapshot_create(uint64_t id);
+mdv_evt_release_snapshot * mdv_evt_release_snapshot_retain(mdv_evt_release_snapshot *evt);
+uint32_t                   mdv_evt_release_snapshot_release(mdv_evt_release_snapshot *evt);
@@ -2,37 +2,29 @@
 #include "mdv_types.h"
 
 
-mdv_evt_trlog_changed * mdv_evt_trlog_changed_create()
+mdv_evt_trlog_changed * mdv_evt_trlog_changed_create(mdv_uuid const *uuid)
 {
-    static mdv_ievent vtbl =
-    {
-        .retain = (mdv_event_retain_fn)mdv_evt_trlog_changed_retain,
-        .release = (mdv_event_release_fn)mdv_evt_trlog_changed_release
-    };
-
-    static mdv_evt_trlog_changed evt =
-    {
-        .base =
-        {
-            .vptr = &vtbl,
-            .type = MDV_EVT_TRLOG_CHANGED,
-            .rc = 1
-        }
-    };
-
-    return &evt;
+    mdv_evt_trlog_changed *event = (mdv_evt_trlog_changed*)
+                                mdv_event_create(
+                                    MDV_EVT_TRLOG_CHANGED,
+                                    sizeof(mdv_evt_trlog_changed));
+
+    if (event)
+        event->uuid = *uuid;
+
+    return event;
 }
 
 
 mdv_evt_trlog_changed * mdv_evt_trlog_changed_retain(mdv_evt_trlog_changed *evt)
 {
-    return evt;
+    return (mdv_evt_trlog_changed*)evt->base.vptr->retain(&evt->base);
 }
 
 
 uint32_t mdv_evt_trlog_changed_release(mdv_evt_trlog_changed *evt)
 {
-    return 1u;
+    return evt->base.vptr->release(&evt->base);
 }
 
 
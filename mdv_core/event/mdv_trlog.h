@@ -15,10 +15,11 @@
 
 typedef struct
 {
-    mdv_event    base;
+    mdv_event       base;
+    mdv_uuid        uuid;       ///< Changed transaction log UUID
 } mdv_evt_trlog_changed;
 
-mdv_evt_trlog_changed * mdv_evt_trlog_changed_create();
+mdv_evt_trlog_changed * mdv_evt_trlog_changed_create(mdv_uuid const *uuid);
 mdv_evt_trlog_changed * mdv_evt_trlog_changed_retain(mdv_evt_trlog_changed *evt);
 uint32_t                mdv_evt_trlog_changed_release(mdv_evt_trlog_changed *evt);
 
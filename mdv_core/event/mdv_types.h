@@ -22,6 +22,12 @@ enum
     MDV_EVT_CREATE_TABLE,
     MDV_EVT_TRLOG_CHANGED,
     MDV_EVT_TRLOG_APPLY,
+    MDV_EVT_INSERT_ROW,
+    MDV_EVT_CREATE_INDEX,
+    MDV_EVT_SELECT,
+    MDV_EVT_AGGREGATE,
+    MDV_EVT_CREATE_SNAPSHOT,
+    MDV_EVT_RELEASE_SNAPSHOT,
     MDV_EVT_COUNT
 };
 
@@ -10,6 +10,8 @@
 #include <mdv_uuid.h>
 #include <mdv_threads.h>
 #include <mdv_safeptr.h>
+#include <mdv_mutex.h>
+#include <mdv_hashmap.h>
 
 
 /// Data committer
@@ -23,9 +25,19 @@ struct mdv_committer
     atomic_bool     active;         ///< Status
     atomic_size_t   active_jobs;    ///< Active jobs counter
     mdv_safeptr    *topology;       ///< Current network topology
+    mdv_mutex       mutex;          ///< Mutex for scheduled storages guard
+    mdv_hashmap    *scheduled;      ///< Storages scheduled for applying (Storage UUID -> mdv_committer_storage)
 };
 
 
+/// Transaction log storage scheduled for applying
+typedef struct
+{
+    mdv_uuid        uuid;           ///< Storage UUID
+    bool            dirty;          ///< Storage was changed while it was applied
+} mdv_committer_storage;
+
+
 typedef struct mdv_committer_context
 {
     mdv_committer  *committer;      ///< Data committer
@@ -42,22 +54,74 @@ static bool mdv_committer_is_active(mdv_committer *committer)
 }
 
 
+/**
+ * @brief Marks the scheduled storage as clean before the applying.
+ */
+static void mdv_committer_clean(mdv_committer *committer, mdv_uuid const *storage)
+{
+    if (mdv_mutex_lock(&committer->mutex) == MDV_OK)
+    {
+        mdv_committer_storage *entry = mdv_hashmap_find(committer->scheduled, storage);
+
+        if (entry)
+            entry->dirty = false;
+
+        mdv_mutex_unlock(&committer->mutex);
+    }
+}
+
+
+/**
+ * @brief Finishes the storage applying.
+ *
+ * @return true if the storage was changed while it was applied and it should be applied once more
+ */
+static bool mdv_committer_done(mdv_committer *committer, mdv_uuid const *storage)
+{
+    bool dirty = false;
+
+    if (mdv_mutex_lock(&committer->mutex) == MDV_OK)
+    {
+        mdv_committer_storage *entry = mdv_hashmap_find(committer->scheduled, storage);
+
+        if (entry)
+        {
+            dirty = entry->dirty && mdv_committer_is_active(committer);
+
+            if (!dirty)
+                mdv_hashmap_erase(committer->scheduled, storage);
+        }
+
+        mdv_mutex_unlock(&committer->mutex);
+    }
+
+    return dirty;
+}
+
+
 static void mdv_committer_fn(mdv_job_base *job)
 {
     mdv_committer_context *ctx      = (mdv_committer_context *)job->data;
     mdv_committer         *committer = ctx->committer;
 
-    if (!mdv_committer_is_active(committer))
-        return;
+    // Changes which are made while the storage is applied are applied by the same job
+    do
+    {
+        if (!mdv_committer_is_active(committer))
+            break;
 
-    mdv_evt_trlog_apply *apply = mdv_evt_trlog_apply_create(&ctx->storage);
+        mdv_committer_clean(committer, &ctx->storage);
 
-    if (apply)
-    {
-        if (mdv_ebus_publish(committer->ebus, &apply->base, MDV_EVT_SYNC) != MDV_OK)
-            MDV_LOGE("Transaction log was not applied");
-        mdv_evt_trlog_apply_release(apply);
+        mdv_evt_trlog_apply *apply = mdv_evt_trlog_apply_create(&ctx->storage);
+
+        if (apply)
+        {
+            if (mdv_ebus_publish(committer->ebus, &apply->base, MDV_EVT_SYNC) != MDV_OK)
+                MDV_LOGE("Transaction log was not applied");
+            mdv_evt_trlog_apply_release(apply);
+        }
     }
+    while(mdv_committer_done(committer, &ctx->storage));
 }
 
 
@@ -71,14 +135,14 @@ static void mdv_committer_finalize(mdv_job_base *job)
 }
 
 
-static void mdv_committer_job_emit(mdv_committer *committer, mdv_uuid const *storage)
+static bool mdv_committer_job_emit(mdv_committer *committer, mdv_uuid const *storage)
 {
     mdv_committer_job *job = mdv_alloc(sizeof(mdv_committer_job), "committer_job");
 
     if (!job)
     {
         MDV_LOGE("No memory for data committer job");
-        return;
+        return false;
     }
 
     job->fn             = mdv_committer_fn;
@@ -91,16 +155,56 @@ static void mdv_committer_job_emit(mdv_committer *committer, mdv_uuid const *sto
     if (err != MDV_OK)
     {
         MDV_LOGE("Data committer job failed");
+        mdv_committer_release(committer);
         mdv_free(job, "committer_job");
+        return false;
     }
+
+    atomic_fetch_add_explicit(&committer->active_jobs, 1, memory_order_relaxed);
+
+    return true;
+}
+
+
+/**
+ * @brief Schedules the storage applying.
+ * @details Only one job is scheduled for the storage. If the storage is already scheduled,
+ *          it is marked as dirty and the running job applies it once more.
+ */
+static void mdv_committer_schedule(mdv_committer *committer, mdv_uuid const *storage)
+{
+    if (mdv_mutex_lock(&committer->mutex) != MDV_OK)
+        return;
+
+    bool emit = false;
+
+    mdv_committer_storage *entry = mdv_hashmap_find(committer->scheduled, storage);
+
+    if (entry)
+        entry->dirty = true;
     else
     {
-        atomic_fetch_add_explicit(&committer->active_jobs, 1, memory_order_relaxed);
+        mdv_committer_storage const new_entry =
+        {
+            .uuid = *storage,
+            .dirty = true
+        };
+
+        emit = mdv_hashmap_insert(committer->scheduled, &new_entry, sizeof new_entry) != 0;
+
+        if (!emit)
+            MDV_LOGE("No memory for scheduled storage");
     }
+
+    // Job is emitted under the lock, so the storage is removed from the scheduled set only by the job
+    if (emit && !mdv_committer_job_emit(committer, storage))
+        mdv_hashmap_erase(committer->scheduled, storage);
+
+    mdv_mutex_unlock(&committer->mutex);
 }
 
 
-// Main data commit thread generates asynchronous jobs for each peer.
+// Main data commit thread schedules all peers storages applying. It is used when the topology is changed.
 static void mdv_committer_main(mdv_committer *committer)
 {
     mdv_topology *topology = mdv_safeptr_get(committer->topology);
@@ -113,7 +217,7 @@ static void mdv_committer_main(mdv_committer *committer)
         {
             mdv_vector_foreach(nodes, mdv_toponode, node)
             {
-                mdv_committer_job_emit(committer, &node->uuid);
+                mdv_committer_schedule(committer, &node->uuid);
             }
 
             mdv_vector_release(nodes);
@@ -185,7 +289,14 @@ static mdv_errno mdv_committer_evt_topology(void *arg, mdv_event *event)
 {
     mdv_committer *committer = arg;
     mdv_evt_topology *topo = (mdv_evt_topology *)event;
-    return mdv_safeptr_set(committer->topology, topo->topology);
+
+    mdv_errno err = mdv_safeptr_set(committer->topology, topo->topology);
+
+    // New nodes transaction logs may contain not applied entries
+    if (err == MDV_OK)
+        mdv_committer_start(committer);
+
+    return err;
 }
 
 
@@ -193,8 +304,7 @@ static mdv_errno mdv_committer_evt_trlog_changed(void *arg, mdv_event *event)
 {
     mdv_committer *committer = arg;
     mdv_evt_trlog_changed *evt = (mdv_evt_trlog_changed *)event;
-    (void)evt;
-    mdv_committer_start(committer);
+    mdv_committer_schedule(committer, &evt->uuid);
     return MDV_OK;
 }
 
@@ -208,7 +318,7 @@ static const mdv_event_handler_type mdv_committer_handlers[] =
 
 mdv_committer * mdv_committer_create(mdv_ebus *ebus, mdv_jobber_config const *jconfig, mdv_topology *topology)
 {
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(5);
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(7);
 
     mdv_committer *committer = mdv_alloc(sizeof(mdv_committer), "committer");
 
@@ -240,6 +350,30 @@ mdv_committer * mdv_committer_create(mdv_ebus *ebus, mdv_jobber_config const *jc
 
     mdv_rollbacker_push(rollbacker, mdv_safeptr_free, committer->topology);
 
+    if (mdv_mutex_create(&committer->mutex) != MDV_OK)
+    {
+        MDV_LOGE("Mutex creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &committer->mutex);
+
+    committer->scheduled = mdv_hashmap_create(mdv_committer_storage,
+                                              uuid,
+                                              16,
+                                              mdv_uuid_hash,
+                                              mdv_uuid_cmp);
+
+    if (!committer->scheduled)
+    {
+        MDV_LOGE("No memory for scheduled storages");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_hashmap_release, committer->scheduled);
+
     committer->jobber = mdv_jobber_create(jconfig);
 
     if (!committer->jobber)
@@ -334,6 +468,8 @@ static void mdv_committer_free(mdv_committer *committer)
     mdv_eventfd_close(committer->start);
     mdv_ebus_release(committer->ebus);
     mdv_safeptr_free(committer->topology);
+    mdv_hashmap_release(committer->scheduled);
+    mdv_mutex_free(&committer->mutex);
     memset(committer, 0, sizeof(*committer));
     mdv_free(committer, "committer");
 }
@@ -21,6 +21,16 @@ static int mdv_cfg_handler(void* user, const char* section, const char* name, co
             return 0;                                                                           \
         }
 
+    #define MDV_CFG_DURABILITY(v)                                                               \
+        if (strcmp(value, "sync") == 0)             v = MDV_DURABILITY_SYNC;                    \
+        else if (strcmp(value, "metasync") == 0)    v = MDV_DURABILITY_METASYNC;                \
+        else if (strcmp(value, "async") == 0)       v = MDV_DURABILITY_ASYNC;                   \
+        else                                                                                    \
+        {                                                                                       \
+            MDV_LOGE("Invalid durability level %s:%s '%s'", section, name, value);              \
+            return 0;                                                                           \
+        }
+
     if (MDV_CFG_MATCH("server", "listen"))
     {
         config->server.listen = mdv_str_pdup(config->mempool, value);
@@ -39,6 +49,51 @@ static int mdv_cfg_handler(void* user, const char* section, const char* name, co
         MDV_CFG_CHECK(config->storage.path);
         MDV_LOGI("Storage path: %s", config->storage.path.ptr);
     }
+    else if (MDV_CFG_MATCH("storage", "map_size"))
+    {
+        config->storage.map_size = strtoull(value, 0, 10) * 1024 * 1024;
+        MDV_LOGI("Storage map size: %llu MB", (unsigned long long)(config->storage.map_size / (1024 * 1024)));
+    }
+    else if (MDV_CFG_MATCH("storage", "map_grow"))
+    {
+        config->storage.map_grow = strtoull(value, 0, 10) * 1024 * 1024;
+        MDV_LOGI("Storage map growth step: %llu MB", (unsigned long long)(config->storage.map_grow / (1024 * 1024)));
+    }
+    else if (MDV_CFG_MATCH("storage", "map_grow_wait"))
+    {
+        config->storage.map_grow_wait = atoi(value);
+        MDV_LOGI("Storage map growth wait: %u ms", config->storage.map_grow_wait);
+    }
+    else if (MDV_CFG_MATCH("storage", "max_readers"))
+    {
+        config->storage.max_readers = atoi(value);
+        MDV_LOGI("Storage max readers: %u", config->storage.max_readers);
+    }
+    else if (MDV_CFG_MATCH("storage", "durability"))
+    {
+        MDV_CFG_DURABILITY(config->storage.durability);
+        MDV_LOGI("Storage durability: %s", value);
+    }
+    else if (MDV_CFG_MATCH("storage", "trlog_durability"))
+    {
+        MDV_CFG_DURABILITY(config->storage.trlog_durability);
+        MDV_LOGI("Transaction log durability: %s", value);
+    }
+    else if (MDV_CFG_MATCH("storage", "flush_interval"))
+    {
+        config->storage.flush_interval = atoi(value);
+        MDV_LOGI("Storage flush interval: %u ms", config->storage.flush_interval);
+    }
+    else if (MDV_CFG_MATCH("storage", "flush_size"))
+    {
+        config->storage.flush_size = strtoull(value, 0, 10) * 1024;
+        MDV_LOGI("Storage flush size: %llu KB", (unsigned long long)(config->storage.flush_size / 1024));
+    }
+    else if (MDV_CFG_MATCH("storage", "bloom_snapshot"))
+    {
+        config->storage.bloom_snapshot = atoi(value);
+        MDV_LOGI("Storage bloom snapshot: %u", config->storage.bloom_snapshot);
+    }
 
     else if (MDV_CFG_MATCH("ebus", "workers"))
     {
@@ -66,6 +121,59 @@ static int mdv_cfg_handler(void* user, const char* section, const char* name, co
         config->committer.batch_size = atoi(value);
         MDV_LOGI("Committer batch size: %u", config->committer.batch_size);
     }
+    else if (MDV_CFG_MATCH("committer", "partitions"))
+    {
+        config->committer.partitions = atoi(value);
+        MDV_LOGI("Committer partitions: %u", config->committer.partitions);
+    }
+    else if (MDV_CFG_MATCH("committer", "pipeline"))
+    {
+        config->committer.pipeline = atoi(value);
+        MDV_LOGI("Committer pipeline workers: %u", config->committer.pipeline);
+    }
+    else if (MDV_CFG_MATCH("committer", "pipeline_wait"))
+    {
+        config->committer.pipeline_wait = atoi(value);
+        MDV_LOGI("Committer pipeline wait: %u ms", config->committer.pipeline_wait);
+    }
+
+    else if (MDV_CFG_MATCH("trlog", "batch_size"))
+    {
+        config->trlog.batch_size = atoi(value);
+        MDV_LOGI("TR log group commit batch size: %u", config->trlog.batch_size);
+    }
+    else if (MDV_CFG_MATCH("trlog", "linger"))
+    {
+        config->trlog.linger = atoi(value);
+        MDV_LOGI("TR log group commit linger: %u ms", config->trlog.linger);
+    }
+    else if (MDV_CFG_MATCH("trlog", "checkpoint_batch"))
+    {
+        config->trlog.checkpoint_batch = atoi(value);
+        MDV_LOGI("TR log checkpoint batch size: %u", config->trlog.checkpoint_batch);
+    }
+    else if (MDV_CFG_MATCH("trlog", "compression"))
+    {
+        config->trlog.compression = atoi(value);
+        MDV_LOGI("TR log compression threshold: %u bytes", config->trlog.compression);
+    }
+
+    else if (MDV_CFG_MATCH("indexer", "workers"))
+    {
+        config->indexer.workers = atoi(value);
+        MDV_LOGI("Indexer workers: %u", config->indexer.workers);
+    }
+    else if (MDV_CFG_MATCH("indexer", "batch_size"))
+    {
+        config->indexer.batch_size = atoi(value);
+        MDV_LOGI("Indexer batch size: %u", config->indexer.batch_size);
+    }
+
+    else if (MDV_CFG_MATCH("snapshot", "ttl"))
+    {
+        config->snapshot.ttl = atoi(value);
+        MDV_LOGI("Snapshot TTL: %u seconds", config->snapshot.ttl);
+    }
 
     else if (MDV_CFG_MATCH("log", "level"))
     {
@@ -79,6 +187,11 @@ static int mdv_cfg_handler(void* user, const char* section, const char* name, co
         config->datasync.batch_size = atoi(value);
         MDV_LOGI("Data sync batch size: %u", config->datasync.batch_size);
     }
+    else if (MDV_CFG_MATCH("datasync", "compression"))
+    {
+        config->datasync.compression = atoi(value);
+        MDV_LOGI("Data sync compression threshold: %u bytes", config->datasync.compression);
+    }
 
     else if (MDV_CFG_MATCH("cluster", "node"))
     {
@@ -122,6 +235,7 @@ static int mdv_cfg_handler(void* user, const char* section, const char* name, co
 
     #undef MDV_CFG_MATCH
     #undef MDV_CFG_CHECK
+    #undef MDV_CFG_DURABILITY
 
     return 1;
 }
@@ -140,6 +254,15 @@ static void mdv_set_config_defaults()
     MDV_CONFIG.connection.keep_interval     = 5;
 
     MDV_CONFIG.storage.path                 = mdv_str_static("./data");
+    MDV_CONFIG.storage.map_size             = 64ull * 1024 * 1024;
+    MDV_CONFIG.storage.map_grow             = 64ull * 1024 * 1024;
+    MDV_CONFIG.storage.map_grow_wait        = 5000;
+    MDV_CONFIG.storage.max_readers          = 126;
+    MDV_CONFIG.storage.durability           = MDV_DURABILITY_SYNC;
+    MDV_CONFIG.storage.trlog_durability     = MDV_DURABILITY_SYNC;
+    MDV_CONFIG.storage.flush_interval       = 100;
+    MDV_CONFIG.storage.flush_size           = 4ull * 1024 * 1024;
+    MDV_CONFIG.storage.bloom_snapshot       = 1;
 
     MDV_CONFIG.ebus.workers                 = 4;
     MDV_CONFIG.ebus.queues                  = 4;
@@ -147,8 +270,22 @@ static void mdv_set_config_defaults()
     MDV_CONFIG.committer.workers            = 4;
     MDV_CONFIG.committer.queues             = 4;
     MDV_CONFIG.committer.batch_size         = 32;
+    MDV_CONFIG.committer.partitions         = 4;
+    MDV_CONFIG.committer.pipeline           = 4;
+    MDV_CONFIG.committer.pipeline_wait      = 100;
+
+    MDV_CONFIG.trlog.batch_size             = 256;
+    MDV_CONFIG.trlog.linger                 = 0;
+    MDV_CONFIG.trlog.checkpoint_batch       = 1024;
+    MDV_CONFIG.trlog.compression            = 256;
+
+    MDV_CONFIG.indexer.workers              = 1;
+    MDV_CONFIG.indexer.batch_size           = 1024;
+
+    MDV_CONFIG.snapshot.ttl                 = 30;
 
     MDV_CONFIG.datasync.batch_size          = 256;
+    MDV_CONFIG.datasync.compression         = 256;
 
     MDV_CONFIG.cluster.size                 = 0;
 }
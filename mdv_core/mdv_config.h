@@ -16,6 +16,15 @@ enum
 };
 
 
+/// Storage durability levels
+typedef enum
+{
+    MDV_DURABILITY_SYNC,            ///< Data and metadata are flushed to disk on each commit
+    MDV_DURABILITY_METASYNC,        ///< Metadata flush is omitted. Last commit might be lost on system crash.
+    MDV_DURABILITY_ASYNC            ///< Commits aren't flushed. Background flusher flushes data periodically.
+} mdv_durability;
+
+
 /// Server configuration
 typedef struct
 {
@@ -41,6 +50,15 @@ typedef struct
     struct
     {
         mdv_string path;            ///< Directory where the database is placed
+        uint64_t   map_size;        ///< Initial memory map size (in bytes)
+        uint64_t   map_grow;        ///< Memory map growth step when the map is full (in bytes)
+        uint32_t   map_grow_wait;   ///< Time (in milliseconds) the map growth waits for pinned snapshots
+        uint32_t   max_readers;     ///< Maximum number of simultaneous read transactions
+        uint32_t   durability;      ///< Durability level for data storages (see mdv_durability)
+        uint32_t   trlog_durability;///< Durability level for transaction logs (see mdv_durability)
+        uint32_t   flush_interval;  ///< Interval between background flushes (in milliseconds)
+        uint64_t   flush_size;      ///< Amount of written data which triggers background flush (in bytes)
+        uint32_t   bloom_snapshot;  ///< Save removed objects Bloom filters on close
     } storage;                      ///< Storage settings
 
     struct
@@ -54,11 +72,34 @@ typedef struct
         uint32_t   workers;         ///< Number of thread pool workers for transaction log applying
         uint32_t   queues;          ///< Number of event queues
         uint32_t   batch_size;      ///< Batch size for data commit
+        uint32_t   partitions;      ///< Number of thread pool workers for parallel tables commit (0 - tables are committed sequentially)
+        uint32_t   pipeline;        ///< Number of thread pool workers for transaction log reading and decoding (0 - batches are applied sequentially)
+        uint32_t   pipeline_wait;   ///< Time (in milliseconds) to wait for the busy pipeline workers before the batches are applied sequentially
     } committer;
 
+    struct
+    {
+        uint32_t   batch_size;      ///< Maximum number of operations committed to the transaction log at once
+        uint32_t   linger;          ///< Time (in milliseconds) to wait for more operations before the group commit
+        uint32_t   checkpoint_batch;///< Number of applied records deleted from the transaction log at once (0 - never delete)
+        uint32_t   compression;     ///< Minimal operation size (in bytes) compressed in the transaction log (0 - no compression)
+    } trlog;                        ///< Transaction log settings
+
+    struct
+    {
+        uint32_t   workers;         ///< Number of thread pool workers for secondary indexes building
+        uint32_t   batch_size;      ///< Number of rows indexed by one write transaction
+    } indexer;                      ///< Secondary indexes builder settings
+
+    struct
+    {
+        uint32_t   ttl;             ///< Time (in seconds) an unused snapshot is kept
+    } snapshot;                     ///< Read snapshots settings
+
     struct
     {
         uint32_t   batch_size;      ///< Batch size for data synchronization
+        uint32_t   compression;     ///< Minimal operation size (in bytes) compressed in the synchronization messages (0 - no compression)
     } datasync;                     ///< Data synchronizer settings
 
     struct
@@ -106,7 +106,23 @@ mdv_core * mdv_core_create()
 
 
     // Tablespace
-    core->storage.tablespace = mdv_tablespace_open(&core->metainf.uuid.value, core->ebus);
+    mdv_jobber_config const indexer_config =
+    {
+        .threadpool =
+        {
+            .size = MDV_CONFIG.indexer.workers,
+            .thread_attrs =
+            {
+                .stack_size = MDV_THREAD_STACK_SIZE
+            }
+        },
+        .queue =
+        {
+            .count = 1
+        }
+    };
+
+    core->storage.tablespace = mdv_tablespace_open(&core->metainf.uuid.value, core->ebus, &indexer_config);
 
     if (!core->storage.tablespace)
     {
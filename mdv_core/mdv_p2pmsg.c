@@ -1,5 +1,9 @@
 #include "mdv_p2pmsg.h"
+#include "mdv_config.h"
 #include <mdv_log.h>
+#include <mdv_alloc.h>
+#include <mdv_lz.h>
+#include <mdv_limits.h>
 #include <mdv_serialization.h>
 
 
@@ -285,6 +289,12 @@ bool mdv_binn_p2p_cfslog_data(mdv_msg_p2p_cfslog_data const *msg, binn *obj)
 
     uint64_t data_size = 0;
 
+    uint32_t const threshold = MDV_CONFIG.datasync.compression;
+
+    // Buffer for compressed operations
+    void *buf = 0;
+    size_t buf_size = 0;
+
     mdv_list_foreach(msg->rows, mdv_cfslog_data, entry)
     {
         binn row;
@@ -292,16 +302,36 @@ bool mdv_binn_p2p_cfslog_data(mdv_msg_p2p_cfslog_data const *msg, binn *obj)
         if (!binn_create_object(&row))
         {
             MDV_LOGE("binn_p2p_cfslog_data failed");
+            mdv_free(buf, "cfslog_data_buf");
             binn_free(&rows);
             return false;
         }
 
+        size_t packed_size = 0;
+
+        if (threshold
+            && entry->op.size >= threshold
+            && entry->op.size <= MDV_MSG_SIZE_MAX)
+        {
+            // Compressed operation must be smaller than the original one
+            if (buf_size < entry->op.size
+                && mdv_realloc2(&buf, entry->op.size, "cfslog_data_buf"))
+                buf_size = entry->op.size;
+
+            if (buf_size >= entry->op.size)
+                packed_size = mdv_lz_compress(entry->op.ptr, entry->op.size, buf, entry->op.size - 1);
+        }
+
         if (0
             || !binn_object_set_uint64(&row, "I", entry->row_id)
-            || !binn_object_set_blob(&row, "O", entry->op.ptr, entry->op.size)
+            || (packed_size
+                ? (!binn_object_set_uint32(&row, "Z", entry->op.size)
+                    || !binn_object_set_blob(&row, "O", buf, packed_size))
+                : !binn_object_set_blob(&row, "O", entry->op.ptr, entry->op.size))
             || !binn_list_add_object(&rows, &row))
         {
             MDV_LOGE("binn_p2p_cfslog_data failed");
+            mdv_free(buf, "cfslog_data_buf");
             binn_free(&row);
             binn_free(&rows);
             return false;
@@ -312,6 +342,8 @@ bool mdv_binn_p2p_cfslog_data(mdv_msg_p2p_cfslog_data const *msg, binn *obj)
         binn_free(&row);
     }
 
+    mdv_free(buf, "cfslog_data_buf");
+
     if (!binn_create_object(obj))
     {
         MDV_LOGE("binn_p2p_cfslog_data failed");
@@ -421,6 +453,7 @@ bool mdv_unbinn_p2p_cfslog_data_rows(binn const *obj, mdv_list *rows)
         uint64_t row_id = 0;
         void *ptr = 0;
         int size = 0;
+        uint32_t unpacked_size = 0;
 
         if (!binn_object_get_uint64((void*)&value, "I", (uint64*)&row_id)
             || !binn_object_get_blob((void*)&value, "O", &ptr, &size))
@@ -430,7 +463,19 @@ bool mdv_unbinn_p2p_cfslog_data_rows(binn const *obj, mdv_list *rows)
             break;
         }
 
-        mdv_cfslog_data_list_entry *op = mdv_alloc(sizeof(mdv_cfslog_data_list_entry) + size, "cfstorage_op_list_entry");
+        // Compressed operations have the original size
+        bool const packed = binn_object_get_uint32((void*)&value, "Z", &unpacked_size);
+
+        if (!packed)
+            unpacked_size = size;
+        else if (unpacked_size > MDV_MSG_SIZE_MAX)
+        {
+            ret = false;
+            MDV_LOGE("TR log entry is corrupted");
+            break;
+        }
+
+        mdv_cfslog_data_list_entry *op = mdv_alloc(sizeof(mdv_cfslog_data_list_entry) + unpacked_size, "cfstorage_op_list_entry");
 
         if (!op)
         {
@@ -440,10 +485,18 @@ bool mdv_unbinn_p2p_cfslog_data_rows(binn const *obj, mdv_list *rows)
         }
 
         op->data.row_id = row_id;
-        op->data.op.size = size;
+        op->data.op.size = unpacked_size;
         op->data.op.ptr = op + 1;
 
-        memcpy(op->data.op.ptr, ptr, size);
+        if (!packed)
+            memcpy(op->data.op.ptr, ptr, size);
+        else if (mdv_lz_decompress(ptr, size, op->data.op.ptr, unpacked_size) != unpacked_size)
+        {
+            ret = false;
+            MDV_LOGE("TR log entry is corrupted");
+            mdv_free(op, "cfstorage_op_list_entry");
+            break;
+        }
 
         mdv_list_emplace_back(rows, (mdv_list_entry_base *)op);
     }
@@ -108,6 +108,32 @@ static mdv_errno mdv_user_table_info_reply(mdv_user *user, uint16_t id, mdv_msg_
 }
 
 
+static mdv_errno mdv_user_row_info_reply(mdv_user *user, uint16_t id, mdv_msg_row_info const *msg)
+{
+    binn row_info;
+
+    if (!mdv_binn_row_info(msg, &row_info))
+        return MDV_FAILED;
+
+    mdv_msg message =
+    {
+        .hdr =
+        {
+            .id = mdv_msg_row_info_id,
+            .number = id,
+            .size = binn_size(&row_info)
+        },
+        .payload = binn_ptr(&row_info)
+    };
+
+    mdv_errno err = mdv_user_reply(user, &message);
+
+    binn_free(&row_info);
+
+    return err;
+}
+
+
 static mdv_errno mdv_user_topology_reply(mdv_user *user, uint16_t id, mdv_msg_topology const *msg)
 {
     binn obj;
@@ -134,6 +160,32 @@ static mdv_errno mdv_user_topology_reply(mdv_user *user, uint16_t id, mdv_msg_to
 }
 
 
+static mdv_errno mdv_user_rowset_reply(mdv_user *user, uint16_t id, mdv_msg_rowset const *msg)
+{
+    binn rowset;
+
+    if (!mdv_binn_rowset(msg, &rowset))
+        return MDV_FAILED;
+
+    mdv_msg message =
+    {
+        .hdr =
+        {
+            .id = mdv_msg_rowset_id,
+            .number = id,
+            .size = binn_size(&rowset)
+        },
+        .payload = binn_ptr(&rowset)
+    };
+
+    mdv_errno err = mdv_user_reply(user, &message);
+
+    binn_free(&rowset);
+
+    return err;
+}
+
+
 static mdv_errno mdv_user_wave_handler(mdv_msg const *msg, void *arg)
 {
     MDV_LOGI("<<<<< '%s'", mdv_msg_name(msg->hdr.id));
@@ -236,6 +288,315 @@ static mdv_errno mdv_user_create_table_handler(mdv_msg const *msg, void *arg)
 }
 
 
+static mdv_errno mdv_user_insert_row_handler(mdv_msg const *msg, void *arg)
+{
+    MDV_LOGI("<<<<< '%s'", mdv_msg_name(msg->hdr.id));
+
+    mdv_user *user = arg;
+
+    binn binn_msg;
+
+    if(!binn_load(msg->payload, &binn_msg))
+    {
+        MDV_LOGW("Message '%s' reading failed", mdv_msg_name(msg->hdr.id));
+        return MDV_FAILED;
+    }
+
+    mdv_msg_insert_row insert_row;
+
+    mdv_errno err = MDV_FAILED;
+
+    if (mdv_unbinn_insert_row(&binn_msg, &insert_row))
+    {
+        mdv_evt_insert_row *evt = mdv_evt_insert_row_create(&insert_row.table, &insert_row.row);
+
+        if (evt)
+        {
+            err = mdv_ebus_publish(user->ebus, &evt->base, MDV_EVT_SYNC);
+
+            if (err == MDV_OK)
+            {
+                mdv_msg_row_info const row_info =
+                {
+                    .id = evt->row_id
+                };
+
+                err = mdv_user_row_info_reply(user, msg->hdr.number, &row_info);
+            }
+
+            mdv_evt_insert_row_release(evt);
+        }
+    }
+    else
+        MDV_LOGE("Invalid '%s' message", mdv_msg_name(mdv_msg_insert_row_id));
+
+    binn_free(&binn_msg);
+
+    if (err != MDV_OK)
+    {
+        mdv_msg_status const status =
+        {
+            .err = err,
+            .message = ""
+        };
+
+        err = mdv_user_status_reply(user, msg->hdr.number, &status);
+    }
+
+    return err;
+}
+
+static mdv_errno mdv_user_snapshot_info_reply(mdv_user *user, uint16_t id, mdv_msg_snapshot_info const *msg)
+{
+    binn snapshot_info;
+
+    if (!mdv_binn_snapshot_info(msg, &snapshot_info))
+        return MDV_FAILED;
+
+    mdv_msg message =
+    {
+        .hdr =
+        {
+            .id = mdv_msg_snapshot_info_id,
+            .number = id,
+            .size = binn_size(&snapshot_info)
+        },
+        .payload = binn_ptr(&snapshot_info)
+    };
+
+    mdv_errno err = mdv_user_reply(user, &message);
+
+    binn_free(&snapshot_info);
+
+    return err;
+}
+
+
+static mdv_errno mdv_user_select_handler(mdv_msg const *msg, void *arg)
+{
+    MDV_LOGI("<<<<< '%s'", mdv_msg_name(msg->hdr.id));
+
+    mdv_user *user = arg;
+
+    binn binn_msg;
+
+    if(!binn_load(msg->payload, &binn_msg))
+    {
+        MDV_LOGW("Message '%s' reading failed", mdv_msg_name(msg->hdr.id));
+        return MDV_FAILED;
+    }
+
+    mdv_msg_select select;
+
+    mdv_errno err = MDV_FAILED;
+
+    if (mdv_unbinn_select(&binn_msg, &select))
+    {
+        mdv_evt_select *evt = mdv_evt_select_create(&select.table,
+                                                    select.first,
+                                                    select.limit,
+                                                    select.size,
+                                                    select.fields,
+                                                    &select.predicate,
+                                                    select.snapshot);
+
+        if (evt)
+        {
+            err = mdv_ebus_publish(user->ebus, &evt->base, MDV_EVT_SYNC);
+
+            if (err == MDV_OK)
+            {
+                mdv_msg_rowset const rowset =
+                {
+                    .ids = evt->ids,
+                    .rows = evt->rows,
+                    .next = evt->next
+                };
+
+                err = mdv_user_rowset_reply(user, msg->hdr.number, &rowset);
+            }
+
+            mdv_evt_select_release(evt);
+        }
+
+        mdv_select_free(&select);
+    }
+    else
+        MDV_LOGE("Invalid '%s' message", mdv_msg_name(mdv_msg_select_id));
+
+    binn_free(&binn_msg);
+
+    if (err != MDV_OK)
+    {
+        mdv_msg_status const status =
+        {
+            .err = err,
+            .message = ""
+        };
+
+        err = mdv_user_status_reply(user, msg->hdr.number, &status);
+    }
+
+    return err;
+}
+
+
+static mdv_errno mdv_user_aggregate_handler(mdv_msg const *msg, void *arg)
+{
+    MDV_LOGI("<<<<< '%s'", mdv_msg_name(msg->hdr.id));
+
+    mdv_user *user = arg;
+
+    binn binn_msg;
+
+    if(!binn_load(msg->payload, &binn_msg))
+    {
+        MDV_LOGW("Message '%s' reading failed", mdv_msg_name(msg->hdr.id));
+        return MDV_FAILED;
+    }
+
+    mdv_msg_aggregate aggregate;
+
+    mdv_errno err = MDV_FAILED;
+
+    if (mdv_unbinn_aggregate(&binn_msg, &aggregate))
+    {
+        mdv_evt_aggregate *evt = mdv_evt_aggregate_create(&aggregate.table,
+                                                          aggregate.groups_size,
+                                                          aggregate.groups,
+                                                          aggregate.size,
+                                                          aggregate.aggregates,
+                                                          &aggregate.predicate,
+                                                          aggregate.snapshot);
+
+        if (evt)
+        {
+            err = mdv_ebus_publish(user->ebus, &evt->base, MDV_EVT_SYNC);
+
+            if (err == MDV_OK)
+            {
+                mdv_msg_rowset const rowset =
+                {
+                    .ids = evt->ids,
+                    .rows = evt->rows,
+                    .next = 0
+                };
+
+                err = mdv_user_rowset_reply(user, msg->hdr.number, &rowset);
+            }
+
+            mdv_evt_aggregate_release(evt);
+        }
+
+        mdv_aggregate_free(&aggregate);
+    }
+    else
+        MDV_LOGE("Invalid '%s' message", mdv_msg_name(mdv_msg_aggregate_id));
+
+    binn_free(&binn_msg);
+
+    if (err != MDV_OK)
+    {
+        mdv_msg_status const status =
+        {
+            .err = err,
+            .message = ""
+        };
+
+        err = mdv_user_status_reply(user, msg->hdr.number, &status);
+    }
+
+    return err;
+}
+
+
+static mdv_errno mdv_user_create_snapshot_handler(mdv_msg const *msg, void *arg)
+{
+    MDV_LOGI("<<<<< '%s'", mdv_msg_name(msg->hdr.id));
+
+    mdv_user *user = arg;
+
+    mdv_errno err = MDV_NO_MEM;
+
+    mdv_evt_create_snapshot *evt = mdv_evt_create_snapshot_create();
+
+    if (evt)
+    {
+        err = mdv_ebus_publish(user->ebus, &evt->base, MDV_EVT_SYNC);
+
+        if (err == MDV_OK)
+        {
+            mdv_msg_snapshot_info const snapshot_info =
+            {
+                .id = evt->id
+            };
+
+            err = mdv_user_snapshot_info_reply(user, msg->hdr.number, &snapshot_info);
+        }
+
+        mdv_evt_create_snapshot_release(evt);
+    }
+
+    if (err != MDV_OK)
+    {
+        mdv_msg_status const status =
+        {
+            .err = err,
+            .message = "Snapshot creation failed"
+        };
+
+        err = mdv_user_status_reply(user, msg->hdr.number, &status);
+    }
+
+    return err;
+}
+
+
+static mdv_errno mdv_user_release_snapshot_handler(mdv_msg const *msg, void *arg)
+{
+    MDV_LOGI("<<<<< '%s'", mdv_msg_name(msg->hdr.id));
+
+    mdv_user *user = arg;
+
+    binn binn_msg;
+
+    if(!binn_load(msg->payload, &binn_msg))
+    {
+        MDV_LOGW("Message '%s' reading failed", mdv_msg_name(msg->hdr.id));
+        return MDV_FAILED;
+    }
+
+    mdv_msg_release_snapshot release_snapshot;
+
+    mdv_errno err = MDV_FAILED;
+
+    if (mdv_unbinn_release_snapshot(&binn_msg, &release_snapshot))
+    {
+        mdv_evt_release_snapshot *evt = mdv_evt_release_snapshot_create(release_snapshot.id);
+
+        if (evt)
+        {
+            err = mdv_ebus_publish(user->ebus, &evt->base, MDV_EVT_SYNC);
+            mdv_evt_release_snapshot_release(evt);
+        }
+        else
+            err = MDV_NO_MEM;
+    }
+    else
+        MDV_LOGE("Invalid '%s' message", mdv_msg_name(mdv_msg_release_snapshot_id));
+
+    binn_free(&binn_msg);
+
+    mdv_msg_status const status =
+    {
+        .err = err,
+        .message = ""
+    };
+
+    return mdv_user_status_reply(user, msg->hdr.number, &status);
+}
+
+
 static mdv_errno mdv_user_get_topology_handler(mdv_msg const *msg, void *arg)
 {
     MDV_LOGI("<<<<< '%s'", mdv_msg_name(msg->hdr.id));
@@ -339,9 +700,14 @@ mdv_user * mdv_user_create(mdv_descriptor fd, mdv_ebus *ebus, mdv_topology *topo
 
     mdv_dispatcher_handler const handlers[] =
     {
-        { mdv_message_id(hello),         &mdv_user_wave_handler,         user },
-        { mdv_message_id(create_table),  &mdv_user_create_table_handler, user },
-        { mdv_message_id(get_topology),  &mdv_user_get_topology_handler, user },
+        { mdv_message_id(hello),             &mdv_user_wave_handler,             user },
+        { mdv_message_id(create_table),      &mdv_user_create_table_handler,     user },
+        { mdv_message_id(get_topology),      &mdv_user_get_topology_handler,     user },
+        { mdv_message_id(insert_row),        &mdv_user_insert_row_handler,       user },
+        { mdv_message_id(select),            &mdv_user_select_handler,           user },
+        { mdv_message_id(aggregate),         &mdv_user_aggregate_handler,        user },
+        { mdv_message_id(create_snapshot),   &mdv_user_create_snapshot_handler,  user },
+        { mdv_message_id(release_snapshot),  &mdv_user_release_snapshot_handler, user },
     };
 
     for(size_t i = 0; i < sizeof handlers / sizeof *handlers; ++i)
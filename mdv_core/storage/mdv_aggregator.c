@@ -0,0 +1,903 @@
+#include "mdv_aggregator.h"
+#include "mdv_filter_kernels.h"
+#include "mdv_simd.h"
+#include <mdv_alloc.h>
+#include <mdv_hash.h>
+#include <mdv_log.h>
+#include <string.h>
+
+
+/// Sum of values. Integers are summed with wrap around as 64 bit values.
+typedef union
+{
+    uint64_t    u;          ///< Sum of integers
+    int64_t     i;          ///< Sum of signed integers
+    double      f;          ///< Sum of floating point values
+} mdv_aggregator_sum;
+
+
+/**
+ * @brief Sum kernel
+ *
+ * @param values [in]   Packed values. Values might be unaligned.
+ * @param count [in]    Values count
+ * @param bits [in]     Selection bitmap (NULL - all values are summed)
+ * @param sum [in,out]  Sum
+ */
+typedef void (*mdv_aggregator_sum_fn)(void const *values, uint32_t count, uint32_t const *bits, mdv_aggregator_sum *sum);
+
+
+/// Aggregate function state
+typedef struct
+{
+    uint64_t            count;      ///< Number of aggregated values
+    mdv_aggregator_sum  sum;        ///< Sum of values (for SUM and AVG)
+    union
+    {
+        uint64_t        u64;
+        uint8_t         bytes[8];
+    } value;                        ///< Minimal or maximal value (for MIN and MAX)
+} mdv_aggregator_state;
+
+
+/// Aggregate function
+typedef struct
+{
+    mdv_aggregate_op        op;         ///< Aggregate function
+    mdv_field_type          type;       ///< Field type
+    uint32_t                column;     ///< Column segment index in mdv_aggregator_columns()
+    mdv_aggregator_sum_fn   sum;        ///< Sum kernel (for SUM and AVG)
+} mdv_aggregator_item;
+
+
+/// Hash table slot
+typedef struct
+{
+    uint32_t    hash;       ///< Group key hash
+    uint32_t    group;      ///< Group index + 1. Zero for empty slot.
+} mdv_aggregator_slot;
+
+
+/// Group key location in keys buffer
+typedef struct
+{
+    uint32_t    offset;     ///< Key offset
+    uint32_t    size;       ///< Key size
+} mdv_aggregator_key;
+
+
+/// Rows aggregator
+struct mdv_aggregator
+{
+    uint32_t                 groups_size;       ///< Number of grouping fields
+    uint32_t                *groups;            ///< Column segments indices for grouping fields
+    uint32_t                 size;              ///< Number of aggregate functions
+    mdv_aggregator_item     *items;             ///< Aggregate functions
+    uint32_t                 count;             ///< Number of required columns
+    uint32_t                *columns;           ///< Required columns
+    mdv_field               *fields;            ///< Result fields
+
+    uint32_t                 capacity;          ///< Hash table capacity (power of 2)
+    mdv_aggregator_slot     *slots;             ///< Hash table slots
+    uint32_t                 groups_count;      ///< Number of groups
+    uint32_t                 groups_capacity;   ///< Groups capacity
+    mdv_aggregator_key      *keys;              ///< Groups keys
+    mdv_aggregator_state    *states;            ///< Aggregate functions states (groups_capacity * size)
+    uint8_t                 *keys_buf;          ///< Keys buffer
+    size_t                   keys_size;         ///< Keys buffer size
+    size_t                   keys_capacity;     ///< Keys buffer capacity
+    uint8_t                 *key;               ///< Current row key
+    size_t                   key_capacity;      ///< Current row key capacity
+};
+
+
+enum
+{
+    MDV_AGGREGATOR_SLOTS    = 64,               ///< Initial hash table capacity
+    MDV_AGGREGATOR_GROUPS   = 32                ///< Initial groups capacity
+};
+
+
+/*
+ * Scalar sum kernels
+ */
+#define MDV_AGGREGATOR_SUM(T, N, CAST, ACC, FIELD)                          \
+    static void mdv_aggregator_sum_##T(void const *values, uint32_t count, uint32_t const *bits, mdv_aggregator_sum *sum) \
+    {                                                                       \
+        uint8_t const *p = values;                                          \
+        ACC s = 0;                                                          \
+        for(uint32_t i = 0; i < count; ++i, p += sizeof(T))                 \
+        {                                                                   \
+            if (!bits || ((bits[i / 32] >> (i % 32)) & 1))                  \
+                s += (ACC)(CAST)mdv_ld_##N(p);                              \
+        }                                                                   \
+        sum->FIELD += s;                                                    \
+    }
+
+MDV_AGGREGATOR_SUM(int8_t,   i8,  int64_t,  uint64_t, u)
+MDV_AGGREGATOR_SUM(uint8_t,  u8,  uint64_t, uint64_t, u)
+MDV_AGGREGATOR_SUM(int16_t,  i16, int64_t,  uint64_t, u)
+MDV_AGGREGATOR_SUM(uint16_t, u16, uint64_t, uint64_t, u)
+MDV_AGGREGATOR_SUM(int32_t,  i32, int64_t,  uint64_t, u)
+MDV_AGGREGATOR_SUM(uint32_t, u32, uint64_t, uint64_t, u)
+MDV_AGGREGATOR_SUM(int64_t,  i64, int64_t,  uint64_t, u)
+MDV_AGGREGATOR_SUM(uint64_t, u64, uint64_t, uint64_t, u)
+MDV_AGGREGATOR_SUM(float,    f32, double,   double,   f)
+MDV_AGGREGATOR_SUM(double,   f64, double,   double,   f)
+
+#undef MDV_AGGREGATOR_SUM
+
+
+#ifdef MDV_SIMD_X86
+
+/*
+ * AVX2 sum kernels. Words of the selection bitmap with all rows selected are summed
+ * by vectors, other words and the rest values are summed by the scalar code.
+ */
+#define MDV_AGGREGATOR_SUM_AVX2(T, N, CAST, ACC, FIELD, VEC, ZERO, BLOCK, HSUM) \
+    MDV_AVX2 static void mdv_aggregator_sum_avx2_##T(void const *values, uint32_t count, uint32_t const *bits, mdv_aggregator_sum *sum) \
+    {                                                                       \
+        uint8_t const *p = values;                                          \
+        VEC acc = ZERO();                                                   \
+        ACC s = 0;                                                          \
+        uint32_t const words = count / 32;                                  \
+        for(uint32_t w = 0; w < words; ++w, p += 32 * sizeof(T))            \
+        {                                                                   \
+            uint32_t const mask = bits ? bits[w] : ~0u;                     \
+            if (mask == ~0u)                                                \
+                acc = BLOCK(acc, p);                                        \
+            else                                                            \
+            {                                                               \
+                for(uint32_t m = mask; m; m &= m - 1)                       \
+                    s += (ACC)(CAST)mdv_ld_##N(p + __builtin_ctz(m) * sizeof(T)); \
+            }                                                               \
+        }                                                                   \
+        sum->FIELD += s + HSUM(acc);                                        \
+        if (count % 32)                                                     \
+            mdv_aggregator_sum_##T(p, count % 32, bits ? bits + words : 0, sum); \
+    }
+
+
+MDV_AVX2 static inline uint64_t mdv_avx2_hsum_epi64(__m256i v)
+{
+    __m128i const s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return (uint64_t)_mm_cvtsi128_si64(s) + (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(s, s));
+}
+
+
+MDV_AVX2 static inline double mdv_avx2_hsum_pd(__m256d v)
+{
+    __m128d const s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+
+MDV_AVX2 static inline __m256i mdv_avx2_sum_i32(__m256i acc, uint8_t const *p)
+{
+    for(int i = 0; i < 4; ++i, p += 32)
+    {
+        __m256i const v = _mm256_loadu_si256((__m256i const *)p);
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    return acc;
+}
+
+
+MDV_AVX2 static inline __m256i mdv_avx2_sum_u32(__m256i acc, uint8_t const *p)
+{
+    for(int i = 0; i < 4; ++i, p += 32)
+    {
+        __m256i const v = _mm256_loadu_si256((__m256i const *)p);
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+        acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    return acc;
+}
+
+
+MDV_AVX2 static inline __m256i mdv_avx2_sum_i64(__m256i acc, uint8_t const *p)
+{
+    for(int i = 0; i < 8; ++i, p += 32)
+        acc = _mm256_add_epi64(acc, _mm256_loadu_si256((__m256i const *)p));
+    return acc;
+}
+
+
+MDV_AVX2 static inline __m256d mdv_avx2_sum_f32(__m256d acc, uint8_t const *p)
+{
+    for(int i = 0; i < 4; ++i, p += 32)
+    {
+        __m256 const v = _mm256_loadu_ps((float const *)p);
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+    return acc;
+}
+
+
+MDV_AVX2 static inline __m256d mdv_avx2_sum_f64(__m256d acc, uint8_t const *p)
+{
+    for(int i = 0; i < 8; ++i, p += 32)
+        acc = _mm256_add_pd(acc, _mm256_loadu_pd((double const *)p));
+    return acc;
+}
+
+
+MDV_AGGREGATOR_SUM_AVX2(int32_t,  i32, int64_t,  uint64_t, u, __m256i, _mm256_setzero_si256, mdv_avx2_sum_i32, mdv_avx2_hsum_epi64)
+MDV_AGGREGATOR_SUM_AVX2(uint32_t, u32, uint64_t, uint64_t, u, __m256i, _mm256_setzero_si256, mdv_avx2_sum_u32, mdv_avx2_hsum_epi64)
+MDV_AGGREGATOR_SUM_AVX2(int64_t,  i64, int64_t,  uint64_t, u, __m256i, _mm256_setzero_si256, mdv_avx2_sum_i64, mdv_avx2_hsum_epi64)
+MDV_AGGREGATOR_SUM_AVX2(uint64_t, u64, uint64_t, uint64_t, u, __m256i, _mm256_setzero_si256, mdv_avx2_sum_i64, mdv_avx2_hsum_epi64)
+MDV_AGGREGATOR_SUM_AVX2(float,    f32, double,   double,   f, __m256d, _mm256_setzero_pd,    mdv_avx2_sum_f32, mdv_avx2_hsum_pd)
+MDV_AGGREGATOR_SUM_AVX2(double,   f64, double,   double,   f, __m256d, _mm256_setzero_pd,    mdv_avx2_sum_f64, mdv_avx2_hsum_pd)
+
+#undef MDV_AGGREGATOR_SUM_AVX2
+
+#endif // MDV_SIMD_X86
+
+
+static mdv_aggregator_sum_fn mdv_aggregator_sum_kernel(mdv_field_type type)
+{
+#ifdef MDV_SIMD_X86
+    if (mdv_filter_isa_best() >= MDV_FILTER_ISA_AVX2)
+    {
+        switch(type)
+        {
+            case MDV_FLD_TYPE_INT32:    return mdv_aggregator_sum_avx2_int32_t;
+            case MDV_FLD_TYPE_UINT32:   return mdv_aggregator_sum_avx2_uint32_t;
+            case MDV_FLD_TYPE_INT64:    return mdv_aggregator_sum_avx2_int64_t;
+            case MDV_FLD_TYPE_UINT64:   return mdv_aggregator_sum_avx2_uint64_t;
+            case MDV_FLD_TYPE_FLOAT:    return mdv_aggregator_sum_avx2_float;
+            case MDV_FLD_TYPE_DOUBLE:   return mdv_aggregator_sum_avx2_double;
+            default:
+                break;
+        }
+    }
+#endif
+
+    switch(type)
+    {
+        case MDV_FLD_TYPE_INT8:     return mdv_aggregator_sum_int8_t;
+        case MDV_FLD_TYPE_UINT8:    return mdv_aggregator_sum_uint8_t;
+        case MDV_FLD_TYPE_INT16:    return mdv_aggregator_sum_int16_t;
+        case MDV_FLD_TYPE_UINT16:   return mdv_aggregator_sum_uint16_t;
+        case MDV_FLD_TYPE_INT32:    return mdv_aggregator_sum_int32_t;
+        case MDV_FLD_TYPE_UINT32:   return mdv_aggregator_sum_uint32_t;
+        case MDV_FLD_TYPE_INT64:    return mdv_aggregator_sum_int64_t;
+        case MDV_FLD_TYPE_UINT64:   return mdv_aggregator_sum_uint64_t;
+        case MDV_FLD_TYPE_FLOAT:    return mdv_aggregator_sum_float;
+        case MDV_FLD_TYPE_DOUBLE:   return mdv_aggregator_sum_double;
+        default:
+            break;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Adds single value to the sum.
+ */
+static void mdv_aggregator_accumulate(mdv_field_type type, mdv_aggregator_sum *sum, uint8_t const *ptr)
+{
+    switch(type)
+    {
+        case MDV_FLD_TYPE_INT8:     sum->u += (uint64_t)(int64_t)mdv_ld_i8(ptr);   break;
+        case MDV_FLD_TYPE_UINT8:    sum->u += mdv_ld_u8(ptr);                      break;
+        case MDV_FLD_TYPE_INT16:    sum->u += (uint64_t)(int64_t)mdv_ld_i16(ptr);  break;
+        case MDV_FLD_TYPE_UINT16:   sum->u += mdv_ld_u16(ptr);                     break;
+        case MDV_FLD_TYPE_INT32:    sum->u += (uint64_t)(int64_t)mdv_ld_i32(ptr);  break;
+        case MDV_FLD_TYPE_UINT32:   sum->u += mdv_ld_u32(ptr);                     break;
+        case MDV_FLD_TYPE_INT64:    sum->u += (uint64_t)mdv_ld_i64(ptr);           break;
+        case MDV_FLD_TYPE_UINT64:   sum->u += mdv_ld_u64(ptr);                     break;
+        case MDV_FLD_TYPE_FLOAT:    sum->f += mdv_ld_f32(ptr);                     break;
+        case MDV_FLD_TYPE_DOUBLE:   sum->f += mdv_ld_f64(ptr);                     break;
+        default:
+            break;
+    }
+}
+
+
+/**
+ * @brief Compares two values of the given type. Values might be unaligned.
+ */
+static int mdv_aggregator_cmp(mdv_field_type type, uint8_t const *a, uint8_t const *b)
+{
+#define MDV_AGGREGATOR_CMP(T, N)                \
+    {                                           \
+        T const x = mdv_ld_##N(a);              \
+        T const y = mdv_ld_##N(b);              \
+        return (x > y) - (x < y);               \
+    }
+
+    switch(type)
+    {
+        case MDV_FLD_TYPE_BOOL:     return (*a != 0) - (*b != 0);
+        case MDV_FLD_TYPE_CHAR:
+        case MDV_FLD_TYPE_BYTE:
+        case MDV_FLD_TYPE_UINT8:    MDV_AGGREGATOR_CMP(uint8_t, u8);
+        case MDV_FLD_TYPE_INT8:     MDV_AGGREGATOR_CMP(int8_t, i8);
+        case MDV_FLD_TYPE_INT16:    MDV_AGGREGATOR_CMP(int16_t, i16);
+        case MDV_FLD_TYPE_UINT16:   MDV_AGGREGATOR_CMP(uint16_t, u16);
+        case MDV_FLD_TYPE_INT32:    MDV_AGGREGATOR_CMP(int32_t, i32);
+        case MDV_FLD_TYPE_UINT32:   MDV_AGGREGATOR_CMP(uint32_t, u32);
+        case MDV_FLD_TYPE_INT64:    MDV_AGGREGATOR_CMP(int64_t, i64);
+        case MDV_FLD_TYPE_UINT64:   MDV_AGGREGATOR_CMP(uint64_t, u64);
+        case MDV_FLD_TYPE_FLOAT:    MDV_AGGREGATOR_CMP(float, f32);
+        case MDV_FLD_TYPE_DOUBLE:   MDV_AGGREGATOR_CMP(double, f64);
+    }
+
+#undef MDV_AGGREGATOR_CMP
+
+    return 0;
+}
+
+
+/**
+ * @brief Updates MIN or MAX state by the value.
+ * @details State count should be incremented before.
+ */
+static void mdv_aggregator_minmax(mdv_aggregator_item const *item, mdv_aggregator_state *state, uint8_t const *ptr)
+{
+    if (state->count > 1)
+    {
+        int const res = mdv_aggregator_cmp(item->type, ptr, state->value.bytes);
+
+        if (item->op == MDV_AGG_MIN ? res >= 0 : res <= 0)
+            return;
+    }
+
+    memcpy(state->value.bytes, ptr, mdv_field_type_size(item->type));
+}
+
+
+static void mdv_aggregator_update(mdv_aggregator_item const *item, mdv_aggregator_state *state, uint8_t const *ptr)
+{
+    state->count++;
+
+    switch(item->op)
+    {
+        case MDV_AGG_SUM:
+        case MDV_AGG_AVG:
+            mdv_aggregator_accumulate(item->type, &state->sum, ptr);
+            break;
+
+        case MDV_AGG_MIN:
+        case MDV_AGG_MAX:
+            mdv_aggregator_minmax(item, state, ptr);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+static uint32_t mdv_aggregator_column(mdv_aggregator *aggregator, uint32_t field)
+{
+    for(uint32_t i = 0; i < aggregator->count; ++i)
+    {
+        if (aggregator->columns[i] == field)
+            return i;
+    }
+
+    aggregator->columns[aggregator->count] = field;
+
+    return aggregator->count++;
+}
+
+
+static bool mdv_aggregator_slots_grow(mdv_aggregator *aggregator)
+{
+    uint32_t const capacity = aggregator->capacity * 2;
+
+    mdv_aggregator_slot *slots = mdv_alloc(capacity * sizeof(mdv_aggregator_slot), "aggregator.slots");
+
+    if (!slots)
+    {
+        MDV_LOGE("No memory for aggregator hash table");
+        return false;
+    }
+
+    memset(slots, 0, capacity * sizeof(mdv_aggregator_slot));
+
+    uint32_t const mask = capacity - 1;
+
+    for(uint32_t i = 0; i < aggregator->capacity; ++i)
+    {
+        mdv_aggregator_slot const *slot = aggregator->slots + i;
+
+        if (!slot->group)
+            continue;
+
+        uint32_t n = slot->hash & mask;
+
+        while(slots[n].group)
+            n = (n + 1) & mask;
+
+        slots[n] = *slot;
+    }
+
+    mdv_free(aggregator->slots, "aggregator.slots");
+
+    aggregator->slots = slots;
+    aggregator->capacity = capacity;
+
+    return true;
+}
+
+
+static bool mdv_aggregator_groups_grow(mdv_aggregator *aggregator)
+{
+    uint32_t const capacity = aggregator->groups_capacity
+                                ? aggregator->groups_capacity * 2
+                                : MDV_AGGREGATOR_GROUPS;
+
+    if (!mdv_realloc2((void**)&aggregator->keys, capacity * sizeof(mdv_aggregator_key), "aggregator.keys")
+        || !mdv_realloc2((void**)&aggregator->states, capacity * aggregator->size * sizeof(mdv_aggregator_state), "aggregator.states"))
+    {
+        MDV_LOGE("No memory for aggregator groups");
+        return false;
+    }
+
+    aggregator->groups_capacity = capacity;
+
+    return true;
+}
+
+
+/**
+ * @brief Finds the group by key or creates new one.
+ *
+ * @return Group index or UINT32_MAX on error
+ */
+static uint32_t mdv_aggregator_group(mdv_aggregator *aggregator, uint8_t const *key, uint32_t size)
+{
+    uint32_t const hash = mdv_hash_murmur2a(key, size, 0);
+
+    uint32_t mask = aggregator->capacity - 1;
+    uint32_t n = hash & mask;
+
+    for(; aggregator->slots[n].group; n = (n + 1) & mask)
+    {
+        mdv_aggregator_slot const *slot = aggregator->slots + n;
+
+        if (slot->hash != hash)
+            continue;
+
+        mdv_aggregator_key const *group_key = aggregator->keys + slot->group - 1;
+
+        if (group_key->size == size
+            && memcmp(aggregator->keys_buf + group_key->offset, key, size) == 0)
+            return slot->group - 1;
+    }
+
+    // New group. Hash table load factor is kept below 1/2.
+    if ((aggregator->groups_count + 1) * 2 > aggregator->capacity)
+    {
+        if (!mdv_aggregator_slots_grow(aggregator))
+            return UINT32_MAX;
+
+        mask = aggregator->capacity - 1;
+
+        for(n = hash & mask; aggregator->slots[n].group; n = (n + 1) & mask);
+    }
+
+    if (aggregator->groups_count == aggregator->groups_capacity
+        && !mdv_aggregator_groups_grow(aggregator))
+        return UINT32_MAX;
+
+    if (aggregator->keys_size + size > aggregator->keys_capacity)
+    {
+        size_t capacity = aggregator->keys_capacity ? aggregator->keys_capacity : 256;
+
+        while(capacity < aggregator->keys_size + size)
+            capacity *= 2;
+
+        if (!mdv_realloc2((void**)&aggregator->keys_buf, capacity, "aggregator.keys_buf"))
+        {
+            MDV_LOGE("No memory for aggregator group key");
+            return UINT32_MAX;
+        }
+
+        aggregator->keys_capacity = capacity;
+    }
+
+    uint32_t const group = aggregator->groups_count++;
+
+    memcpy(aggregator->keys_buf + aggregator->keys_size, key, size);
+
+    aggregator->keys[group].offset = (uint32_t)aggregator->keys_size;
+    aggregator->keys[group].size = size;
+    aggregator->keys_size += size;
+
+    memset(aggregator->states + group * aggregator->size, 0, aggregator->size * sizeof(mdv_aggregator_state));
+
+    aggregator->slots[n].hash = hash;
+    aggregator->slots[n].group = group + 1;
+
+    return group;
+}
+
+
+/**
+ * @brief Builds the group key for the row.
+ * @details Key contains the grouping fields values. Each value is prefixed by 8 bytes header
+ *          with value size and padded by zeros to 8 bytes, so the values in keys buffer are aligned.
+ *
+ * @return Key size or UINT32_MAX on error
+ */
+static uint32_t mdv_aggregator_key_build(mdv_aggregator *aggregator, mdv_column const *columns, uint32_t idx)
+{
+    size_t size = 0;
+
+    for(uint32_t i = 0; i < aggregator->groups_size; ++i)
+    {
+        mdv_data const value = mdv_column_value(columns + aggregator->groups[i], idx);
+        size += sizeof(uint64_t) + ((value.size + 7u) & ~7u);
+    }
+
+    if (size > aggregator->key_capacity)
+    {
+        if (!mdv_realloc2((void**)&aggregator->key, size, "aggregator.key"))
+        {
+            MDV_LOGE("No memory for aggregator group key");
+            return UINT32_MAX;
+        }
+
+        aggregator->key_capacity = size;
+    }
+
+    memset(aggregator->key, 0, size);
+
+    uint8_t *ptr = aggregator->key;
+
+    for(uint32_t i = 0; i < aggregator->groups_size; ++i)
+    {
+        mdv_data const value = mdv_column_value(columns + aggregator->groups[i], idx);
+        memcpy(ptr, &value.size, sizeof value.size);
+        memcpy(ptr + sizeof(uint64_t), value.ptr, value.size);
+        ptr += sizeof(uint64_t) + ((value.size + 7u) & ~7u);
+    }
+
+    return (uint32_t)size;
+}
+
+
+mdv_aggregator * mdv_aggregator_create(mdv_table_base const *table,
+                                       uint32_t              groups_size,
+                                       uint32_t const       *groups,
+                                       uint32_t              size,
+                                       mdv_aggregate const  *aggregates)
+{
+    if (!size)
+    {
+        MDV_LOGE("No aggregate functions");
+        return 0;
+    }
+
+    for(uint32_t i = 0; i < groups_size; ++i)
+    {
+        if (groups[i] >= table->size)
+        {
+            MDV_LOGE("Invalid grouping field: %u", groups[i]);
+            return 0;
+        }
+    }
+
+    // At least one column is required to count the rows
+    uint32_t const columns_capacity = groups_size + size + 1;
+
+    mdv_aggregator *aggregator = mdv_alloc(sizeof(mdv_aggregator)
+                                           + (groups_size + size) * sizeof(mdv_field)
+                                           + size * sizeof(mdv_aggregator_item)
+                                           + groups_size * sizeof(uint32_t)
+                                           + columns_capacity * sizeof(uint32_t),
+                                           "aggregator");
+
+    if (!aggregator)
+    {
+        MDV_LOGE("No memory for aggregator");
+        return 0;
+    }
+
+    memset(aggregator, 0, sizeof *aggregator);
+
+    aggregator->groups_size = groups_size;
+    aggregator->size = size;
+    aggregator->fields = (mdv_field *)(aggregator + 1);
+    aggregator->items = (mdv_aggregator_item *)(aggregator->fields + groups_size + size);
+    aggregator->groups = (uint32_t *)(aggregator->items + size);
+    aggregator->columns = aggregator->groups + groups_size;
+
+    for(uint32_t i = 0; i < groups_size; ++i)
+    {
+        aggregator->fields[i] = table->fields[groups[i]];
+        aggregator->groups[i] = mdv_aggregator_column(aggregator, groups[i]);
+    }
+
+    for(uint32_t i = 0; i < size; ++i)
+    {
+        mdv_aggregate const *aggregate = aggregates + i;
+        mdv_aggregator_item *item = aggregator->items + i;
+
+        if (!mdv_aggregate_field(table, aggregate, aggregator->fields + groups_size + i))
+        {
+            MDV_LOGE("Invalid aggregate function %u for field %u", aggregate->op, aggregate->field);
+            mdv_aggregator_free(aggregator);
+            return 0;
+        }
+
+        item->op = aggregate->op;
+
+        if (aggregate->op == MDV_AGG_COUNT)
+            continue;
+
+        item->type = table->fields[aggregate->field].type;
+        item->column = mdv_aggregator_column(aggregator, aggregate->field);
+
+        if (aggregate->op == MDV_AGG_SUM || aggregate->op == MDV_AGG_AVG)
+            item->sum = mdv_aggregator_sum_kernel(item->type);
+    }
+
+    if (!aggregator->count)
+    {
+        // Fixed size columns are cheaper to read
+        uint32_t field = 0;
+
+        for(uint32_t i = 0; i < table->size; ++i)
+        {
+            if (table->fields[i].limit == 1)
+            {
+                field = i;
+                break;
+            }
+        }
+
+        mdv_aggregator_column(aggregator, field);
+    }
+
+    aggregator->capacity = MDV_AGGREGATOR_SLOTS;
+    aggregator->slots = mdv_alloc(aggregator->capacity * sizeof(mdv_aggregator_slot), "aggregator.slots");
+
+    if (!aggregator->slots)
+    {
+        MDV_LOGE("No memory for aggregator hash table");
+        mdv_aggregator_free(aggregator);
+        return 0;
+    }
+
+    memset(aggregator->slots, 0, aggregator->capacity * sizeof(mdv_aggregator_slot));
+
+    // Without grouping all rows are aggregated into the single group with empty key
+    static uint8_t const empty_key = 0;
+
+    if (!groups_size
+        && mdv_aggregator_group(aggregator, &empty_key, 0) == UINT32_MAX)
+    {
+        mdv_aggregator_free(aggregator);
+        return 0;
+    }
+
+    return aggregator;
+}
+
+
+void mdv_aggregator_free(mdv_aggregator *aggregator)
+{
+    if (aggregator)
+    {
+        mdv_free(aggregator->slots, "aggregator.slots");
+        mdv_free(aggregator->keys, "aggregator.keys");
+        mdv_free(aggregator->states, "aggregator.states");
+        mdv_free(aggregator->keys_buf, "aggregator.keys_buf");
+        mdv_free(aggregator->key, "aggregator.key");
+        mdv_free(aggregator, "aggregator");
+    }
+}
+
+
+uint32_t mdv_aggregator_columns(mdv_aggregator const *aggregator, uint32_t const **columns)
+{
+    *columns = aggregator->columns;
+    return aggregator->count;
+}
+
+
+uint32_t mdv_aggregator_fields(mdv_aggregator const *aggregator, mdv_field const **fields)
+{
+    *fields = aggregator->fields;
+    return aggregator->groups_size + aggregator->size;
+}
+
+
+/**
+ * @brief Aggregates the column segments without grouping.
+ */
+static void mdv_aggregator_add_all(mdv_aggregator *aggregator, mdv_column const *columns, mdv_bitset const *selection)
+{
+    uint32_t const rows = columns[0].count;
+
+    uint32_t const *bits = selection
+                            ? mdv_bitset_data((mdv_bitset *)selection)
+                            : 0;
+
+    uint64_t const selected = selection
+                                ? mdv_bitset_count(selection)
+                                : rows;
+
+    for(uint32_t i = 0; i < aggregator->size; ++i)
+    {
+        mdv_aggregator_item const *item = aggregator->items + i;
+        mdv_aggregator_state *state = aggregator->states + i;
+        mdv_column const *column = columns + item->column;
+
+        switch(item->op)
+        {
+            case MDV_AGG_SUM:
+            case MDV_AGG_AVG:
+            {
+                item->sum(column->values, rows, bits, &state->sum);
+                state->count += selected;
+                break;
+            }
+
+            case MDV_AGG_MIN:
+            case MDV_AGG_MAX:
+            {
+                uint32_t const type_size = mdv_field_type_size(item->type);
+
+                for(uint32_t idx = 0; idx < rows; ++idx)
+                {
+                    if (bits && !((bits[idx / 32] >> (idx % 32)) & 1))
+                        continue;
+
+                    state->count++;
+                    mdv_aggregator_minmax(item, state, column->values + idx * type_size);
+                }
+
+                break;
+            }
+
+            default:
+                state->count += selected;
+                break;
+        }
+    }
+}
+
+
+bool mdv_aggregator_add(mdv_aggregator *aggregator, mdv_column const *columns, mdv_bitset const *selection)
+{
+    if (!aggregator->groups_size)
+    {
+        mdv_aggregator_add_all(aggregator, columns, selection);
+        return true;
+    }
+
+    uint32_t const rows = columns[0].count;
+
+    for(uint32_t idx = 0; idx < rows; ++idx)
+    {
+        if (selection && !mdv_bitset_test(selection, idx))
+            continue;
+
+        uint32_t const key_size = mdv_aggregator_key_build(aggregator, columns, idx);
+
+        if (key_size == UINT32_MAX)
+            return false;
+
+        uint32_t const group = mdv_aggregator_group(aggregator, aggregator->key, key_size);
+
+        if (group == UINT32_MAX)
+            return false;
+
+        mdv_aggregator_state *states = aggregator->states + group * aggregator->size;
+
+        for(uint32_t i = 0; i < aggregator->size; ++i)
+        {
+            mdv_aggregator_item const *item = aggregator->items + i;
+
+            uint8_t const *ptr = item->op == MDV_AGG_COUNT
+                                    ? 0
+                                    : mdv_column_value(columns + item->column, idx).ptr;
+
+            mdv_aggregator_update(item, states + i, ptr);
+        }
+    }
+
+    return true;
+}
+
+
+bool mdv_aggregator_result(mdv_aggregator *aggregator, void *arg, mdv_aggregator_fn fn)
+{
+    uint32_t const fields_count = aggregator->groups_size + aggregator->size;
+
+    mdv_row_base *row = mdv_alloc(offsetof(mdv_row_base, fields)
+                                  + fields_count * sizeof(mdv_data)
+                                  + aggregator->size * sizeof(uint64_t),
+                                  "aggregator.row");
+
+    if (!row)
+    {
+        MDV_LOGE("No memory for aggregation result");
+        return false;
+    }
+
+    row->size = fields_count;
+
+    uint64_t *values = (uint64_t *)(row->fields + fields_count);
+
+    bool ret = true;
+
+    for(uint32_t group = 0; group < aggregator->groups_count && ret; ++group)
+    {
+        uint8_t *ptr = aggregator->keys_buf + aggregator->keys[group].offset;
+
+        for(uint32_t i = 0; i < aggregator->groups_size; ++i)
+        {
+            uint32_t size;
+            memcpy(&size, ptr, sizeof size);
+            row->fields[i].size = size;
+            row->fields[i].ptr = ptr + sizeof(uint64_t);
+            ptr += sizeof(uint64_t) + ((size + 7u) & ~7u);
+        }
+
+        mdv_aggregator_state *states = aggregator->states + group * aggregator->size;
+
+        for(uint32_t i = 0; i < aggregator->size; ++i)
+        {
+            mdv_aggregator_item const *item = aggregator->items + i;
+            mdv_aggregator_state *state = states + i;
+            mdv_data *field = row->fields + aggregator->groups_size + i;
+
+            field->size = sizeof(uint64_t);
+            field->ptr = values + i;
+
+            switch(item->op)
+            {
+                case MDV_AGG_COUNT:
+                    values[i] = state->count;
+                    break;
+
+                case MDV_AGG_SUM:
+                    values[i] = state->sum.u;
+                    break;
+
+                case MDV_AGG_AVG:
+                {
+                    double avg = 0;
+
+                    if (state->count)
+                    {
+                        double const sum = item->type == MDV_FLD_TYPE_FLOAT || item->type == MDV_FLD_TYPE_DOUBLE
+                                            ? state->sum.f
+                                            : item->type == MDV_FLD_TYPE_INT8
+                                              || item->type == MDV_FLD_TYPE_INT16
+                                              || item->type == MDV_FLD_TYPE_INT32
+                                              || item->type == MDV_FLD_TYPE_INT64
+                                                ? (double)state->sum.i
+                                                : (double)state->sum.u;
+                        avg = sum / state->count;
+                    }
+
+                    memcpy(values + i, &avg, sizeof avg);
+                    break;
+                }
+
+                case MDV_AGG_MIN:
+                case MDV_AGG_MAX:
+                    field->size = mdv_field_type_size(item->type);
+                    field->ptr = state->value.bytes;
+                    break;
+            }
+        }
+
+        ret = fn(arg, row);
+    }
+
+    mdv_free(row, "aggregator.row");
+
+    return ret;
+}
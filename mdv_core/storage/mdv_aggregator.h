@@ -0,0 +1,109 @@
+/**
+ * @file
+ * @brief Streaming aggregation of the table rows.
+ * @details Aggregator consumes the column segments one by one (see mdv_rowdata_scan())
+ *          and keeps only the aggregate functions states for each group, so the
+ *          memory usage depends on the number of groups but not on the number of rows.
+ *
+ *          Groups are kept in the open addressing hash table with linear probing. Group
+ *          keys are stored in a single buffer and the aggregate states in the plain
+ *          array, so there are no allocations per group.
+ *
+ *          Without grouping, sums are calculated by vectorized kernels over
+ *          the whole column segment.
+*/
+#pragma once
+#include "mdv_column.h"
+#include <mdv_types.h>
+#include <mdv_bitset.h>
+
+
+/// Rows aggregator
+typedef struct mdv_aggregator mdv_aggregator;
+
+
+/**
+ * @brief Creates new rows aggregator.
+ *
+ * @param table [in]        Table description
+ * @param groups_size [in]  Number of grouping fields (0 - all rows are aggregated into the single group)
+ * @param groups [in]       Grouping fields indices
+ * @param size [in]         Number of aggregate functions
+ * @param aggregates [in]   Aggregate functions
+ *
+ * @return On success, return non-null pointer to the aggregator
+ * @return On error or if the aggregate functions are invalid for the table, return NULL
+ */
+mdv_aggregator * mdv_aggregator_create(mdv_table_base const *table,
+                                       uint32_t              groups_size,
+                                       uint32_t const       *groups,
+                                       uint32_t              size,
+                                       mdv_aggregate const  *aggregates);
+
+
+/**
+ * @brief Frees the aggregator created by mdv_aggregator_create().
+ */
+void mdv_aggregator_free(mdv_aggregator *aggregator);
+
+
+/**
+ * @brief Returns the columns which are required for the aggregation.
+ * @details Column segments passed to mdv_aggregator_add() should be in the same order.
+ *
+ * @param aggregator [in]   Rows aggregator
+ * @param columns [out]     Columns indices
+ *
+ * @return Number of columns
+ */
+uint32_t mdv_aggregator_columns(mdv_aggregator const *aggregator, uint32_t const **columns);
+
+
+/**
+ * @brief Returns the description of the result rows fields.
+ * @details Result rows contain the grouping fields followed by the aggregate functions results.
+ *
+ * @param aggregator [in]   Rows aggregator
+ * @param fields [out]      Fields descriptions
+ *
+ * @return Number of fields
+ */
+uint32_t mdv_aggregator_fields(mdv_aggregator const *aggregator, mdv_field const **fields);
+
+
+/**
+ * @brief Aggregates the rows of the column segments.
+ *
+ * @param aggregator [in]   Rows aggregator
+ * @param columns [in]      Column segments for the columns returned by mdv_aggregator_columns()
+ * @param selection [in]    Rows selection (NULL - all rows are aggregated)
+ *
+ * @return On success, return true
+ * @return On error, return false
+ */
+bool mdv_aggregator_add(mdv_aggregator *aggregator, mdv_column const *columns, mdv_bitset const *selection);
+
+
+/**
+ * @brief Result rows handler
+ *
+ * @param arg [in]      User defined argument which is passed to mdv_aggregator_result()
+ * @param row [in]      Row with grouping fields and aggregate functions results. Row is valid only during the handler call.
+ *
+ * @return true to continue or false to stop
+ */
+typedef bool (*mdv_aggregator_fn)(void *arg, mdv_row_base const *row);
+
+
+/**
+ * @brief Iterates over the aggregation results.
+ * @details Without grouping, there is always one row even if no rows were aggregated.
+ *          MIN, MAX and AVG of the empty group are zero.
+ *
+ * @param aggregator [in]   Rows aggregator
+ * @param arg [in]          User defined argument which is passed to the handler
+ * @param fn [in]           Result rows handler
+ *
+ * @return true if all groups are processed
+ */
+bool mdv_aggregator_result(mdv_aggregator *aggregator, void *arg, mdv_aggregator_fn fn);
@@ -11,8 +11,10 @@
 #include <mdv_binn.h>
 #include <mdv_types.h>
 #include <mdv_mutex.h>
+#include <mdv_bloom.h>
 #include <stdatomic.h>
 #include <stddef.h>
+#include <string.h>
 
 
 /// @cond Doxygen_Suppress
@@ -24,6 +26,10 @@ struct mdv_cfstorage
     mdv_storage            *data;               ///< data storage
     mdv_storage            *tr_log;             ///< transaction log storage
     mdv_idmap              *applied;            ///< transaction logs applied positions
+    mdv_map_handle          removed;            ///< removed objects map
+    mdv_map_handle          removed_bloom;      ///< removed objects Bloom filter snapshot map
+    mdv_bloom              *bloom;              ///< removed objects Bloom filter (guarded by the write transaction)
+    mdv_map_handle         *tr_logs;            ///< transaction logs maps (one per node)
     atomic_uint_fast64_t    id_generator;       ///< transaction log identifiers generator
     atomic_uint_fast64_t    top[1];             ///< transaction logs last insertion positions
 };
@@ -32,16 +38,33 @@ struct mdv_cfstorage
 typedef mdv_list_entry(mdv_cfstorage_op) mdv_cfstorage_op_list_entry;
 
 
+/// Minimal capacity of removed objects Bloom filter
+enum { MDV_CFSTORAGE_BLOOM_CAPACITY = 1024 };
+
+
+/// Probability of false positives for removed objects Bloom filter
+static const double MDV_CFSTORAGE_BLOOM_ERR = 0.01;
+
+
+/// Removed objects Bloom filter snapshot key
+static const uint32_t MDV_CFSTORAGE_BLOOM_KEY = 0;
+
+
 static void mdv_cfstorage_log_top(mdv_cfstorage *cfstorage, size_t size, atomic_uint_fast64_t *arr);
+static bool mdv_cfstorage_bloom_init(mdv_cfstorage *cfstorage);
+static void mdv_cfstorage_bloom_save(mdv_cfstorage *cfstorage);
 
 /// @endcond
 
 
 mdv_cfstorage * mdv_cfstorage_open(mdv_uuid const *uuid, uint32_t nodes_num)
 {
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(5);
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(6);
 
-    mdv_cfstorage *cfstorage = (mdv_cfstorage *)mdv_alloc(offsetof(mdv_cfstorage, top) + sizeof(atomic_uint_fast64_t) * nodes_num, "cfstorage");
+    mdv_cfstorage *cfstorage = (mdv_cfstorage *)mdv_alloc(offsetof(mdv_cfstorage, top)
+                                                            + sizeof(atomic_uint_fast64_t) * nodes_num
+                                                            + sizeof(mdv_map_handle) * nodes_num,
+                                                           "cfstorage");
 
     if (!cfstorage)
     {
@@ -55,6 +78,7 @@ mdv_cfstorage * mdv_cfstorage_open(mdv_uuid const *uuid, uint32_t nodes_num)
 
     cfstorage->uuid = *uuid;
     cfstorage->nodes_num = nodes_num;
+    cfstorage->tr_logs = (mdv_map_handle *)(cfstorage->top + nodes_num);
 
     atomic_init(&cfstorage->id_generator, 0);
 
@@ -104,7 +128,7 @@ mdv_cfstorage * mdv_cfstorage_open(mdv_uuid const *uuid, uint32_t nodes_num)
     cfstorage->tr_log = mdv_storage_open(path.ptr,
                                          MDV_STRG_TRANSACTION_LOG,
                                          MDV_STRG_TRANSACTION_LOG_MAPS(nodes_num),
-                                         MDV_STRG_NOSUBDIR);
+                                         MDV_STRG_TRLOG_FLAGS());
 
     if (!cfstorage->tr_log)
     {
@@ -115,6 +139,38 @@ mdv_cfstorage * mdv_cfstorage_open(mdv_uuid const *uuid, uint32_t nodes_num)
 
     mdv_rollbacker_push(rollbacker, mdv_storage_release, cfstorage->tr_log);
 
+    cfstorage->removed = mdv_storage_map(cfstorage->tr_log, MDV_MAP_REMOVED, MDV_MAP_CREATE);
+
+    if (!cfstorage->removed)
+    {
+        MDV_LOGE("Map '%s' initialization failed", MDV_MAP_REMOVED);
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    cfstorage->removed_bloom = mdv_storage_map(cfstorage->tr_log, MDV_MAP_REMOVED_BLOOM, MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+    if (!cfstorage->removed_bloom)
+    {
+        MDV_LOGE("Map '%s' initialization failed", MDV_MAP_REMOVED_BLOOM);
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    for(uint32_t i = 0; i < nodes_num; ++i)
+    {
+        cfstorage->tr_logs[i] = mdv_storage_map(cfstorage->tr_log,
+                                                MDV_MAP_TRANSACTION_LOG(i),
+                                                MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+        if (!cfstorage->tr_logs[i])
+        {
+            MDV_LOGE("Map '%s' initialization failed", MDV_MAP_TRANSACTION_LOG(i));
+            mdv_rollback(rollbacker);
+            return 0;
+        }
+    }
+
 
     cfstorage->applied = mdv_idmap_open(cfstorage->tr_log, MDV_MAP_APPLIED, nodes_num);
 
@@ -129,6 +185,13 @@ mdv_cfstorage * mdv_cfstorage_open(mdv_uuid const *uuid, uint32_t nodes_num)
 
     mdv_cfstorage_log_top(cfstorage, nodes_num, cfstorage->top);
 
+    if (!mdv_cfstorage_bloom_init(cfstorage))
+    {
+        MDV_LOGE("Removed objects filter initialization failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
     MDV_LOGI("Storage '%s' opened", str_uuid.ptr);
 
     mdv_rollbacker_free(rollbacker);
@@ -141,6 +204,10 @@ void mdv_cfstorage_close(mdv_cfstorage *cfstorage)
 {
     if(cfstorage)
     {
+        if (MDV_CONFIG.storage.bloom_snapshot)
+            mdv_cfstorage_bloom_save(cfstorage);
+
+        mdv_bloom_free(cfstorage->bloom);
         mdv_idmap_free(cfstorage->applied);
 //        mdv_storage_release(cfstorage->data);
         mdv_storage_release(cfstorage->tr_log);
@@ -182,12 +249,139 @@ bool mdv_cfstorage_drop(mdv_uuid const *uuid)
 }
 
 
+/**
+ * @brief Builds the removed objects Bloom filter from the REMOVED map.
+ * @details Filter capacity is at least twice the number of removed objects.
+ */
+static mdv_bloom * mdv_cfstorage_bloom_build(mdv_cfstorage *cfstorage, mdv_transaction *transaction)
+{
+    mdv_map map = mdv_map_bind(transaction, cfstorage->removed);
+
+    if (!mdv_map_ok(map))
+    {
+        MDV_LOGE("CFstorage table '%s' not opened", MDV_MAP_REMOVED);
+        return 0;
+    }
+
+    uint32_t count = 0;
+
+    {
+        mdv_map_foreach(*transaction, map, entry)
+            ++count;
+    }
+
+    uint32_t const capacity = count < MDV_CFSTORAGE_BLOOM_CAPACITY / 2
+                                ? MDV_CFSTORAGE_BLOOM_CAPACITY
+                                : count * 2;
+
+    mdv_bloom *bloom = mdv_bloom_create(capacity, MDV_CFSTORAGE_BLOOM_ERR);
+
+    if (bloom)
+    {
+        mdv_map_foreach(*transaction, map, entry)
+            mdv_bloom_insert(bloom, entry.key.ptr, entry.key.size);
+    }
+
+    mdv_map_close(&map);
+
+    return bloom;
+}
+
+
+/**
+ * @brief Loads the removed objects Bloom filter snapshot or builds the filter from the REMOVED map.
+ */
+static bool mdv_cfstorage_bloom_init(mdv_cfstorage *cfstorage)
+{
+    cfstorage->bloom = 0;
+
+    mdv_transaction transaction = mdv_transaction_start_read(cfstorage->tr_log);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("CFstorage transaction not started");
+        return false;
+    }
+
+    mdv_map map = mdv_map_bind(&transaction, cfstorage->removed_bloom);
+
+    if (mdv_map_ok(map))
+    {
+        mdv_data const k = { sizeof MDV_CFSTORAGE_BLOOM_KEY, (void*)&MDV_CFSTORAGE_BLOOM_KEY };
+        mdv_data v = {};
+
+        // Snapshot is deleted when new removed object is added, so it is always up to date.
+        if (mdv_map_get(&map, &transaction, &k, &v))
+            cfstorage->bloom = mdv_bloom_deserialize(v.ptr, v.size);
+
+        mdv_map_close(&map);
+    }
+
+    if (!cfstorage->bloom)
+        cfstorage->bloom = mdv_cfstorage_bloom_build(cfstorage, &transaction);
+
+    mdv_transaction_abort(&transaction);
+
+    return cfstorage->bloom != 0;
+}
+
+
+/**
+ * @brief Saves the removed objects Bloom filter snapshot.
+ */
+static void mdv_cfstorage_bloom_save(mdv_cfstorage *cfstorage)
+{
+    if (!cfstorage->bloom)
+        return;
+
+    size_t const size = mdv_bloom_serialized_size(cfstorage->bloom);
+
+    void *buf = mdv_alloc(size, "bloom_snapshot");
+
+    if (!buf)
+    {
+        MDV_LOGW("No memory for removed objects filter snapshot");
+        return;
+    }
+
+    mdv_bloom_serialize(cfstorage->bloom, buf);
+
+    mdv_transaction transaction = mdv_transaction_start(cfstorage->tr_log);
+
+    if (mdv_transaction_ok(transaction))
+    {
+        mdv_map map = mdv_map_bind(&transaction, cfstorage->removed_bloom);
+
+        mdv_data const k = { sizeof MDV_CFSTORAGE_BLOOM_KEY, (void*)&MDV_CFSTORAGE_BLOOM_KEY };
+        mdv_data const v = { size, buf };
+
+        if (mdv_map_ok(map)
+            && mdv_map_put(&map, &transaction, &k, &v))
+        {
+            mdv_map_close(&map);
+            mdv_transaction_commit(&transaction);
+        }
+        else
+        {
+            MDV_LOGW("Removed objects filter snapshot wasn't saved");
+            mdv_map_close(&map);
+            mdv_transaction_abort(&transaction);
+        }
+    }
+
+    mdv_free(buf, "bloom_snapshot");
+}
+
+
 static bool mdv_cfstorage_is_key_deleted(mdv_cfstorage *cfstorage,
                                          mdv_map *map,
                                          mdv_transaction *transaction,
                                          mdv_data const *key)
 {
-    // TODO: Use bloom filter
+    // Most of objects aren't removed. Only probable hits go to the REMOVED map.
+    if (cfstorage->bloom
+        && !mdv_bloom_contains(cfstorage->bloom, key->ptr, key->size))
+        return false;
 
     mdv_data k = { key->size, key->ptr };
     mdv_data v = { 0, 0 };
@@ -198,6 +392,96 @@ static bool mdv_cfstorage_is_key_deleted(mdv_cfstorage *cfstorage,
 }
 
 
+bool mdv_cfstorage_remove(mdv_cfstorage *cfstorage, mdv_objid const *objid)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(3);
+
+    mdv_transaction transaction = mdv_transaction_start(cfstorage->tr_log);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("CFstorage transaction not started");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
+
+    mdv_map rem_map = mdv_map_bind(&transaction, cfstorage->removed);
+
+    if (!mdv_map_ok(rem_map))
+    {
+        MDV_LOGE("CFstorage table '%s' not opened", MDV_MAP_REMOVED);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &rem_map);
+
+    mdv_map bloom_map = mdv_map_bind(&transaction, cfstorage->removed_bloom);
+
+    if (!mdv_map_ok(bloom_map))
+    {
+        MDV_LOGE("CFstorage table '%s' not opened", MDV_MAP_REMOVED_BLOOM);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &bloom_map);
+
+    // Padding bytes are part of the key
+    mdv_objid id;
+    memset(&id, 0, sizeof id);
+    id.node = objid->node;
+    id.id = objid->id;
+
+    mdv_data const key = { sizeof id, &id };
+    mdv_data const value = { 0, 0 };
+
+    if (!mdv_map_put(&rem_map, &transaction, &key, &value))
+    {
+        MDV_LOGE("Removed object wasn't saved");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    // Snapshot is outdated
+    mdv_data const k = { sizeof MDV_CFSTORAGE_BLOOM_KEY, (void*)&MDV_CFSTORAGE_BLOOM_KEY };
+    mdv_map_del(&bloom_map, &transaction, &k, 0);
+
+    // Filter is grown when it is full
+    if (!mdv_bloom_contains(cfstorage->bloom, key.ptr, key.size)
+        && !mdv_bloom_insert(cfstorage->bloom, key.ptr, key.size))
+    {
+        mdv_bloom *bloom = mdv_cfstorage_bloom_build(cfstorage, &transaction);
+
+        if (!bloom)
+        {
+            MDV_LOGE("Removed objects filter wasn't rebuilt");
+            mdv_rollback(rollbacker);
+            return false;
+        }
+
+        mdv_bloom_free(cfstorage->bloom);
+        cfstorage->bloom = bloom;
+    }
+
+    mdv_map_close(&bloom_map);
+    mdv_map_close(&rem_map);
+
+    if (!mdv_transaction_commit(&transaction))
+    {
+        MDV_LOGE("CFstorage transaction failed");
+        mdv_rollbacker_free(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_free(rollbacker);
+
+    return true;
+}
+
+
 uint64_t mdv_cfstorage_new_id(mdv_cfstorage *cfstorage)
 {
     return atomic_fetch_add_explicit(&cfstorage->id_generator, 1, memory_order_relaxed) + 1;
@@ -220,6 +504,12 @@ bool mdv_cfstorage_log_add(mdv_cfstorage  *cfstorage,
                            uint32_t        peer_id,
                            mdv_list const *ops)
 {
+    if (peer_id >= cfstorage->nodes_num)
+    {
+        MDV_LOGE("Node identifier is too big: %u", peer_id);
+        return false;
+    }
+
     mdv_rollbacker *rollbacker = mdv_rollbacker_create(4);
 
     // Start transaction
@@ -235,9 +525,7 @@ bool mdv_cfstorage_log_add(mdv_cfstorage  *cfstorage,
     mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
 
     // Open transaction log
-    mdv_map tr_log = mdv_map_open(&transaction,
-                                  MDV_MAP_TRANSACTION_LOG(peer_id),
-                                  MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mdv_map tr_log = mdv_map_bind(&transaction, cfstorage->tr_logs[peer_id]);
 
     if (!mdv_map_ok(tr_log))
     {
@@ -249,7 +537,7 @@ bool mdv_cfstorage_log_add(mdv_cfstorage  *cfstorage,
     mdv_rollbacker_push(rollbacker, mdv_map_close, &tr_log);
 
     // Open removed objects table
-    mdv_map rem_map = mdv_map_open(&transaction, MDV_MAP_REMOVED, MDV_MAP_CREATE);
+    mdv_map rem_map = mdv_map_bind(&transaction, cfstorage->removed);
 
     if (!mdv_map_ok(rem_map))
     {
@@ -262,11 +550,11 @@ bool mdv_cfstorage_log_add(mdv_cfstorage  *cfstorage,
 
     mdv_list_foreach(ops, mdv_cfstorage_op, op)
     {
-        mdv_objid objid =
-        {
-            .node = peer_id,
-            .id = op->id
-        };
+        // Padding bytes are part of the key
+        mdv_objid objid;
+        memset(&objid, 0, sizeof objid);
+        objid.node = peer_id;
+        objid.id = op->id;
 
         mdv_data key = { sizeof objid, &objid };
 
@@ -278,7 +566,7 @@ bool mdv_cfstorage_log_add(mdv_cfstorage  *cfstorage,
             mdv_data k = { sizeof objid.id, &objid.id };
             mdv_data v = { op->op.size, op->op.ptr };
 
-            if (mdv_map_put_unique(&tr_log, &transaction, &k, &v))
+            if (mdv_map_append(&tr_log, &transaction, &k, &v))
             {
                 if (peer_id != MDV_LOCAL_ID)
                     mdv_cfstorage_top_id_update(cfstorage, peer_id, op->id);
@@ -306,7 +594,7 @@ bool mdv_cfstorage_log_add(mdv_cfstorage  *cfstorage,
 void mdv_cfstorage_log_top(mdv_cfstorage *cfstorage, size_t size, atomic_uint_fast64_t *arr)
 {
     // Start transaction
-    mdv_transaction transaction = mdv_transaction_start(cfstorage->tr_log);
+    mdv_transaction transaction = mdv_transaction_start_read(cfstorage->tr_log);
 
     if (!mdv_transaction_ok(transaction))
     {
@@ -321,9 +609,7 @@ void mdv_cfstorage_log_top(mdv_cfstorage *cfstorage, size_t size, atomic_uint_fa
     for(size_t i = 0; i < size; ++i)
     {
         // Open transaction log
-        mdv_map map = mdv_map_open(&transaction,
-                                   MDV_MAP_TRANSACTION_LOG(i),
-                                   MDV_MAP_SILENT | MDV_MAP_INTEGERKEY);
+        mdv_map map = mdv_map_bind(&transaction, cfstorage->tr_logs[i]);
 
         if (!mdv_map_ok(map))
         {
@@ -346,16 +632,42 @@ void mdv_cfstorage_log_top(mdv_cfstorage *cfstorage, size_t size, atomic_uint_fa
 }
 
 
-static size_t mdv_cfstorage_log_read(mdv_cfstorage *cfstorage,
-                                     uint32_t peer_id,
-                                     uint64_t pos,
-                                     size_t size,
-                                     mdv_list *ops)
+/// TR log records batch handler. Operations point into the storage memory and are valid until the handler returns.
+typedef bool (*mdv_cfstorage_batch_fn)(void *arg, size_t count, mdv_list const *ops);
+
+
+static size_t mdv_cfstorage_log_read(mdv_cfstorage         *cfstorage,
+                                     uint32_t               peer_id,
+                                     uint64_t               pos,
+                                     size_t                 size,
+                                     void                  *arg,
+                                     mdv_cfstorage_batch_fn fn,
+                                     bool                  *ok)
 {
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(2);
+    *ok = false;
+
+    if (peer_id >= cfstorage->nodes_num)
+    {
+        MDV_LOGE("Node identifier is too big: %u", peer_id);
+        return 0;
+    }
+
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(3);
+
+    // All list entries of the batch are allocated at once. Operations aren't copied.
+    mdv_cfstorage_op_list_entry *entries = mdv_alloc(sizeof(mdv_cfstorage_op_list_entry) * size, "cfstorage_op_list_entries");
+
+    if (!entries)
+    {
+        MDV_LOGE("No memory for TR log entries");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, entries, "cfstorage_op_list_entries");
 
     // Start transaction
-    mdv_transaction transaction = mdv_transaction_start(cfstorage->tr_log);
+    mdv_transaction transaction = mdv_transaction_start_read(cfstorage->tr_log);
 
     if (!mdv_transaction_ok(transaction))
     {
@@ -367,9 +679,7 @@ static size_t mdv_cfstorage_log_read(mdv_cfstorage *cfstorage,
     mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
 
     // Open transaction log
-    mdv_map tr_log = mdv_map_open(&transaction,
-                                  MDV_MAP_TRANSACTION_LOG(peer_id),
-                                  MDV_MAP_SILENT | MDV_MAP_INTEGERKEY);
+    mdv_map tr_log = mdv_map_bind(&transaction, cfstorage->tr_logs[peer_id]);
 
     if (!mdv_map_ok(tr_log))
     {
@@ -388,40 +698,63 @@ static size_t mdv_cfstorage_log_read(mdv_cfstorage *cfstorage,
         }
     };
 
+    mdv_list ops = {};
+
     size_t n = 0;
 
     mdv_map_foreach_explicit(transaction, tr_log, entry, MDV_SET_RANGE, MDV_CURSOR_NEXT)
     {
-        mdv_cfstorage_op_list_entry *op = mdv_alloc(sizeof(mdv_cfstorage_op_list_entry) + entry.value.size, "cfstorage_op_list_entry");
+        mdv_cfstorage_op_list_entry *op = entries + n;
 
-        if (!op)
-        {
-            MDV_LOGE("No memory for TR log entry");
-            mdv_map_foreach_break(entry);
-        }
-
-        op->data.id = *(uint64_t*)entry.key.ptr;
+        memcpy(&op->data.id, entry.key.ptr, sizeof op->data.id);
         op->data.op.size = entry.value.size;
-        op->data.op.ptr = (void*)(op + 1);
-
-        memcpy(op->data.op.ptr, entry.value.ptr, entry.value.size);
+        op->data.op.ptr = entry.value.ptr;
 
-        mdv_list_emplace_back(ops, (mdv_list_entry_base *)op);
+        mdv_list_emplace_back(&ops, (mdv_list_entry_base *)op);
 
         if(++n >= size)
             mdv_map_foreach_break(entry);
     }
 
-    mdv_map_close(&tr_log);
+    if (n)
+        *ok = fn(arg, n, &ops);
 
-    mdv_transaction_abort(&transaction);
-
-    mdv_rollbacker_free(rollbacker);
+    mdv_rollback(rollbacker);
 
     return n;
 }
 
 
+/// @cond Doxygen_Suppress
+
+typedef struct
+{
+    uint32_t                peer_src;
+    uint32_t                peer_dst;
+    uint64_t                sync_pos;
+    void                   *arg;
+    mdv_cfstorage_sync_fn   fn;
+} mdv_cfstorage_sync_context;
+
+
+typedef struct
+{
+    uint64_t                applied_pos;
+    void                   *arg;
+    mdv_cfstorage_apply_fn  fn;
+} mdv_cfstorage_apply_context;
+
+/// @endcond
+
+
+static bool mdv_cfstorage_sync_batch(void *arg, size_t count, mdv_list const *ops)
+{
+    mdv_cfstorage_sync_context *ctx = arg;
+    ctx->sync_pos = mdv_list_back(ops, mdv_cfstorage_op)->id + 1;
+    return ctx->fn(ctx->arg, ctx->peer_src, ctx->peer_dst, count, ops);
+}
+
+
 uint64_t mdv_cfstorage_sync(mdv_cfstorage *cfstorage,
                             uint64_t sync_pos,
                             uint32_t peer_src,
@@ -431,23 +764,45 @@ uint64_t mdv_cfstorage_sync(mdv_cfstorage *cfstorage,
 {
     size_t const batch_size = MDV_CONFIG.datasync.batch_size;
 
-    mdv_list ops = {};
+    mdv_cfstorage_sync_context ctx =
+    {
+        .peer_src = peer_src,
+        .peer_dst = peer_dst,
+        .sync_pos = sync_pos,
+        .arg = arg,
+        .fn = fn
+    };
 
     for(bool ok = true; ok;)
     {
-        size_t count = mdv_cfstorage_log_read(cfstorage, peer_src, sync_pos, batch_size, &ops);
+        size_t count = mdv_cfstorage_log_read(cfstorage, peer_src, ctx.sync_pos, batch_size, &ctx, mdv_cfstorage_sync_batch, &ok);
 
         if (!count)     // No data in TR log
             break;
+    }
 
-        sync_pos = mdv_list_back(&ops, mdv_cfstorage_op)->id + 1;
+    return ctx.sync_pos;
+}
+
+
+static bool mdv_cfstorage_apply_batch(void *arg, size_t count, mdv_list const *ops)
+{
+    (void)count;
 
-        ok = fn(arg, peer_src, peer_dst, count, &ops);
+    mdv_cfstorage_apply_context *ctx = arg;
+
+    mdv_list_foreach(ops, mdv_cfstorage_op, op)
+    {
+        if (!ctx->fn(ctx->arg, op))
+        {
+            MDV_LOGE("TR Log operation not applied");
+            return false;
+        }
 
-        mdv_list_clear(&ops);
+        ctx->applied_pos = op->id + 1;
     }
 
-    return sync_pos;
+    return true;
 }
 
 
@@ -466,32 +821,22 @@ bool mdv_cfstorage_log_apply(mdv_cfstorage         *cfstorage,
 
     size_t const batch_size = MDV_CONFIG.datasync.batch_size;
 
-    mdv_list ops = {};
+    mdv_cfstorage_apply_context ctx =
+    {
+        .applied_pos = applied_pos,
+        .arg = arg,
+        .fn = fn
+    };
 
     for(bool ok = true; ok;)
     {
-        size_t count = mdv_cfstorage_log_read(cfstorage, peer_id, applied_pos, batch_size, &ops);
+        size_t count = mdv_cfstorage_log_read(cfstorage, peer_id, ctx.applied_pos, batch_size, &ctx, mdv_cfstorage_apply_batch, &ok);
 
         if (!count)     // No data in TR log
             break;
-
-        mdv_list_foreach(&ops, mdv_cfstorage_op, op)
-        {
-            ok = fn(arg, op);
-
-            if (!ok)
-            {
-                MDV_LOGE("TR Log operation not applied");
-                break;
-            }
-
-            applied_pos = op->id + 1;
-        }
-
-        mdv_list_clear(&ops);
     }
 
-    return mdv_idmap_set(cfstorage->applied, peer_id, applied_pos);
+    return mdv_idmap_set(cfstorage->applied, peer_id, ctx.applied_pos);
 }
 
 
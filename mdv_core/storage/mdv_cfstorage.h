@@ -49,6 +49,9 @@ uint64_t        mdv_cfstorage_new_id(mdv_cfstorage *cfstorage);
 
 mdv_uuid const* mdv_cfstorage_uuid(mdv_cfstorage *cfstorage);
 
+bool            mdv_cfstorage_remove(mdv_cfstorage *cfstorage,
+                                     mdv_objid const *objid);
+
 bool            mdv_cfstorage_log_add(mdv_cfstorage *cfstorage,
                                       uint32_t peer_id,
                                       mdv_list const *ops); // list<mdv_cfstorage_op>
@@ -0,0 +1,251 @@
+#include "mdv_column.h"
+#include <mdv_log.h>
+#include <string.h>
+
+
+bool mdv_column_is_fixed(mdv_field const *field)
+{
+    return field->limit == 1;
+}
+
+
+bool mdv_column_load(mdv_field const *field, mdv_data const *segment, mdv_column *column)
+{
+    mdv_column_hdr hdr;
+
+    if (segment->size < sizeof hdr)
+    {
+        MDV_LOGE("Invalid column segment");
+        return false;
+    }
+
+    memcpy(&hdr, segment->ptr, sizeof hdr);
+
+    uint8_t const *ptr = (uint8_t const *)segment->ptr + sizeof hdr;
+
+    size_t const offsets_size = mdv_column_is_fixed(field)
+                                    ? 0
+                                    : (hdr.count + 1) * sizeof(uint32_t);
+
+    if (segment->size != sizeof hdr + offsets_size + hdr.size)
+    {
+        MDV_LOGE("Invalid column segment size");
+        return false;
+    }
+
+    if (mdv_column_is_fixed(field)
+        && hdr.size != hdr.count * mdv_field_type_size(field->type))
+    {
+        MDV_LOGE("Invalid column segment values size");
+        return false;
+    }
+
+    column->field   = field;
+    column->count   = hdr.count;
+    column->size    = hdr.size;
+    column->offsets = offsets_size ? (uint32_t const *)ptr : 0;
+    column->values  = ptr + offsets_size;
+
+    return true;
+}
+
+
+mdv_data mdv_column_value(mdv_column const *column, uint32_t idx)
+{
+    if (column->offsets)
+    {
+        uint32_t offs[2];
+        memcpy(offs, column->offsets + idx, sizeof offs);
+        return (mdv_data) { offs[1] - offs[0], (void *)(column->values + offs[0]) };
+    }
+
+    uint32_t const size = mdv_field_type_size(column->field->type);
+
+    return (mdv_data) { size, (void *)(column->values + idx * size) };
+}
+
+
+bool mdv_column_builder_init(mdv_column_builder *builder, mdv_field const *field)
+{
+    uint32_t const type_size = mdv_field_type_size(field->type);
+
+    if (!type_size)
+    {
+        MDV_LOGE("Invalid field type: %u", field->type);
+        return false;
+    }
+
+    builder->field = field;
+    builder->count = 0;
+    builder->offsets = 0;
+
+    builder->values = mdv_vector_create(256, sizeof(uint8_t), &mdv_default_allocator);
+
+    if (!builder->values)
+    {
+        MDV_LOGE("No memory for column values");
+        return false;
+    }
+
+    if (!mdv_column_is_fixed(field))
+    {
+        builder->offsets = mdv_vector_create(64, sizeof(uint32_t), &mdv_default_allocator);
+
+        static const uint32_t zero = 0;
+
+        if (!builder->offsets
+            || !mdv_vector_push_back(builder->offsets, &zero))
+        {
+            MDV_LOGE("No memory for column offsets");
+            mdv_column_builder_free(builder);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void mdv_column_builder_free(mdv_column_builder *builder)
+{
+    if (builder->offsets)
+    {
+        mdv_vector_release(builder->offsets);
+        builder->offsets = 0;
+    }
+
+    if (builder->values)
+    {
+        mdv_vector_release(builder->values);
+        builder->values = 0;
+    }
+
+    builder->count = 0;
+}
+
+
+void mdv_column_builder_clear(mdv_column_builder *builder)
+{
+    builder->count = 0;
+
+    mdv_vector_clear(builder->values);
+
+    if (builder->offsets)
+        mdv_vector_resize(builder->offsets, 1);
+}
+
+
+bool mdv_column_builder_append(mdv_column_builder *builder, mdv_column const *column)
+{
+    for(uint32_t i = 0; i < column->count; ++i)
+    {
+        mdv_data const value = mdv_column_value(column, i);
+
+        if (!mdv_column_builder_add(builder, &value))
+            return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_column_value_check(mdv_field const *field, mdv_data const *value)
+{
+    uint32_t const type_size = mdv_field_type_size(field->type);
+
+    if (!type_size || value->size % type_size)
+    {
+        MDV_LOGE("Invalid field size");
+        return false;
+    }
+
+    uint32_t const items = value->size / type_size;
+
+    if (mdv_column_is_fixed(field))
+    {
+        if (items != 1)
+        {
+            MDV_LOGE("Invalid field size");
+            return false;
+        }
+    }
+    else if (field->limit && field->limit < items)
+    {
+        MDV_LOGE("Field is too long");
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_column_builder_add(mdv_column_builder *builder, mdv_data const *value)
+{
+    if (!mdv_column_value_check(builder->field, value))
+        return false;
+
+    size_t const values_size = mdv_vector_size(builder->values);
+
+    if (values_size + value->size > UINT32_MAX)
+    {
+        MDV_LOGE("Column segment is too big");
+        return false;
+    }
+
+    if (value->size
+        && !mdv_vector_append(builder->values, value->ptr, value->size))
+    {
+        MDV_LOGE("No memory for column values");
+        return false;
+    }
+
+    if (builder->offsets)
+    {
+        uint32_t const offset = (uint32_t)(values_size + value->size);
+
+        if (!mdv_vector_push_back(builder->offsets, &offset))
+        {
+            MDV_LOGE("No memory for column offsets");
+            mdv_vector_resize(builder->values, values_size);
+            return false;
+        }
+    }
+
+    builder->count++;
+
+    return true;
+}
+
+
+size_t mdv_column_builder_size(mdv_column_builder const *builder)
+{
+    return sizeof(mdv_column_hdr)
+            + (builder->offsets
+                ? mdv_vector_size(builder->offsets) * sizeof(uint32_t)
+                : 0)
+            + mdv_vector_size(builder->values);
+}
+
+
+void mdv_column_builder_serialize(mdv_column_builder *builder, void *buf)
+{
+    mdv_column_hdr const hdr =
+    {
+        .count = builder->count,
+        .size = (uint32_t)mdv_vector_size(builder->values)
+    };
+
+    uint8_t *ptr = buf;
+
+    memcpy(ptr, &hdr, sizeof hdr);
+    ptr += sizeof hdr;
+
+    if (builder->offsets)
+    {
+        size_t const offsets_size = mdv_vector_size(builder->offsets) * sizeof(uint32_t);
+        memcpy(ptr, mdv_vector_data(builder->offsets), offsets_size);
+        ptr += offsets_size;
+    }
+
+    memcpy(ptr, mdv_vector_data(builder->values), hdr.size);
+}
@@ -0,0 +1,140 @@
+/**
+ * @file
+ * @brief Columnar storage format for table fields.
+ * @details Table rows are stored by columns. Each column is divided into segments.
+ *          Segment contains values of one field for a range of rows.
+ *
+ *          Segment layout:
+ *          @code
+ *          mdv_column_hdr   header;                   // values count and values size
+ *          uint32_t         offsets[count + 1];       // only for variable size fields (limit != 1)
+ *          uint8_t          values[header.size];      // packed values
+ *          @endcode
+ *
+ *          Fields with limit 1 are fixed size and stored as packed arrays.
+ *          Fields with limit 0 (unlimited arrays) or N (arrays limited by N items) are stored
+ *          as offsets array plus values array.
+*/
+#pragma once
+#include <mdv_types.h>
+#include <mdv_vector.h>
+
+
+/// Column segment header
+typedef struct
+{
+    uint32_t count;             ///< Number of values in segment
+    uint32_t size;              ///< Values size in bytes
+} mdv_column_hdr;
+
+
+/// Column segment view. Points into the serialized segment.
+typedef struct
+{
+    mdv_field const *field;     ///< Field description
+    uint32_t         count;     ///< Number of values in segment
+    uint32_t         size;      ///< Values size in bytes
+    uint32_t const  *offsets;   ///< Values offsets (count + 1 items). NULL for fixed size columns.
+    uint8_t const   *values;    ///< Packed values
+} mdv_column;
+
+
+/// Column segment builder
+typedef struct
+{
+    mdv_field const *field;     ///< Field description
+    uint32_t         count;     ///< Number of values in segment
+    mdv_vector      *offsets;   ///< Values offsets (vector<uint32_t>). NULL for fixed size columns.
+    mdv_vector      *values;    ///< Packed values (vector<uint8_t>)
+} mdv_column_builder;
+
+
+/**
+ * @brief Returns true if the field values are stored as packed array.
+ */
+bool mdv_column_is_fixed(mdv_field const *field);
+
+
+/**
+ * @brief Checks the field value size against the field type and limit.
+ */
+bool mdv_column_value_check(mdv_field const *field, mdv_data const *value);
+
+
+/**
+ * @brief Parses serialized column segment.
+ *
+ * @param field [in]    Field description
+ * @param segment [in]  Serialized column segment
+ * @param column [out]  Column segment view
+ *
+ * @return true if column segment is valid
+ */
+bool mdv_column_load(mdv_field const *field, mdv_data const *segment, mdv_column *column);
+
+
+/**
+ * @brief Returns value from the column segment.
+ *
+ * @param column [in]   Column segment view
+ * @param idx [in]      Value index
+ *
+ * @return Field value. Data pointer is not aligned.
+ */
+mdv_data mdv_column_value(mdv_column const *column, uint32_t idx);
+
+
+/**
+ * @brief Initializes column segment builder.
+ *
+ * @param builder [out] Column segment builder
+ * @param field [in]    Field description
+ *
+ * @return true if builder was successfully initialized
+ */
+bool mdv_column_builder_init(mdv_column_builder *builder, mdv_field const *field);
+
+
+/**
+ * @brief Frees resources allocated by column segment builder.
+ */
+void mdv_column_builder_free(mdv_column_builder *builder);
+
+
+/**
+ * @brief Removes all values from column segment builder.
+ */
+void mdv_column_builder_clear(mdv_column_builder *builder);
+
+
+/**
+ * @brief Appends all values of the column segment to the builder.
+ */
+bool mdv_column_builder_append(mdv_column_builder *builder, mdv_column const *column);
+
+
+/**
+ * @brief Appends new value to the builder.
+ * @details Value size is validated against the field type and limit.
+ *
+ * @param builder [in]  Column segment builder
+ * @param value [in]    Field value
+ *
+ * @return true if value was successfully added
+ */
+bool mdv_column_builder_add(mdv_column_builder *builder, mdv_data const *value);
+
+
+/**
+ * @brief Returns serialized column segment size.
+ */
+size_t mdv_column_builder_size(mdv_column_builder const *builder);
+
+
+/**
+ * @brief Serializes column segment.
+ *
+ * @param builder [in]  Column segment builder
+ * @param buf [out]     Buffer for serialized column segment. Buffer size should be at least mdv_column_builder_size().
+ */
+void mdv_column_builder_serialize(mdv_column_builder *builder, void *buf);
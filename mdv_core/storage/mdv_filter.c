@@ -0,0 +1,398 @@
+#include "mdv_filter.h"
+#include "mdv_filter_kernels.h"
+#include <mdv_alloc.h>
+#include <mdv_log.h>
+#include <string.h>
+
+
+/// Compiled predicate node
+typedef struct
+{
+    mdv_predicate_op    op;         ///< Operation
+    mdv_field_type      type;       ///< Field type (only for comparisons)
+    uint32_t            column;     ///< Column segment index in mdv_filter_columns() (only for comparisons)
+    mdv_data            value;      ///< Value to compare with (only for comparisons)
+    mdv_filter_kernel   kernel;     ///< Comparison kernel (only for fixed size fields comparisons)
+    uint32_t            size;       ///< Arguments count (only for logical operations)
+    uint32_t            args;       ///< First argument index (only for logical operations)
+} mdv_filter_node;
+
+
+/// Rows filter
+struct mdv_filter
+{
+    uint32_t            size;       ///< Number of nodes
+    uint32_t            depth;      ///< Number of nested logical operations
+    uint32_t            count;      ///< Number of required columns
+    uint32_t           *columns;    ///< Required columns
+    mdv_filter_node     nodes[1];   ///< Predicate tree nodes. Root is the first node.
+};
+
+
+/// Filter builder
+typedef struct
+{
+    mdv_table_base const *table;    ///< Table description
+    mdv_filter_isa        isa;      ///< Instruction set for comparison kernels
+    mdv_filter           *filter;   ///< Filter
+    uint32_t              nodes;    ///< Number of allocated nodes
+    uint8_t              *values;   ///< Free space for values
+} mdv_filter_builder;
+
+
+static bool mdv_filter_is_cmp(mdv_predicate_op op)
+{
+    return op <= MDV_PRED_GE;
+}
+
+
+/**
+ * @brief Calculates the number of predicate tree nodes and the values size.
+ */
+static bool mdv_filter_size(mdv_table_base const *table,
+                            mdv_predicate const  *predicate,
+                            uint32_t              depth,
+                            uint32_t             *nodes,
+                            uint32_t             *size,
+                            uint32_t             *levels)
+{
+    if (depth >= MDV_PREDICATE_DEPTH_MAX)
+    {
+        MDV_LOGE("Predicate is too deep");
+        return false;
+    }
+
+    ++*nodes;
+
+    if (mdv_filter_is_cmp(predicate->op))
+    {
+        if (predicate->field >= table->size)
+        {
+            MDV_LOGE("Invalid predicate field: %u", predicate->field);
+            return false;
+        }
+
+        mdv_field const *field = table->fields + predicate->field;
+
+        uint32_t const type_size = mdv_field_type_size(field->type);
+
+        if (!type_size
+            || predicate->value.size % type_size
+            || (field->limit == 1 && predicate->value.size != type_size))
+        {
+            MDV_LOGE("Invalid predicate value for field '%s'", field->name.ptr);
+            return false;
+        }
+
+        *size += predicate->value.size;
+
+        return true;
+    }
+
+    if (predicate->op > MDV_PRED_NOT
+        || (predicate->op == MDV_PRED_NOT && predicate->size != 1))
+    {
+        MDV_LOGE("Invalid predicate operation: %u", predicate->op);
+        return false;
+    }
+
+    if (*levels < depth + 1)
+        *levels = depth + 1;
+
+    for(uint32_t i = 0; i < predicate->size; ++i)
+    {
+        if (!mdv_filter_size(table, predicate->args + i, depth + 1, nodes, size, levels))
+            return false;
+    }
+
+    return true;
+}
+
+
+static uint32_t mdv_filter_column(mdv_filter *filter, uint32_t field)
+{
+    for(uint32_t i = 0; i < filter->count; ++i)
+    {
+        if (filter->columns[i] == field)
+            return i;
+    }
+
+    filter->columns[filter->count] = field;
+
+    return filter->count++;
+}
+
+
+static void mdv_filter_compile(mdv_filter_builder *builder, mdv_predicate const *predicate, mdv_filter_node *node)
+{
+    node->op = predicate->op;
+
+    if (mdv_filter_is_cmp(predicate->op))
+    {
+        mdv_filter *filter = builder->filter;
+        mdv_field const *field = builder->table->fields + predicate->field;
+
+        node->type = field->type;
+        node->kernel = field->limit == 1
+                        ? mdv_filter_kernel_get(builder->isa, field->type, predicate->op)
+                        : 0;
+        node->column = mdv_filter_column(filter, predicate->field);
+        node->value.size = predicate->value.size;
+        node->value.ptr = builder->values;
+
+        memcpy(builder->values, predicate->value.ptr, predicate->value.size);
+
+        builder->values += predicate->value.size;
+
+        return;
+    }
+
+    // Arguments are placed contiguously
+    node->size = predicate->size;
+    node->args = builder->nodes;
+
+    builder->nodes += predicate->size;
+
+    for(uint32_t i = 0; i < predicate->size; ++i)
+        mdv_filter_compile(builder, predicate->args + i, builder->filter->nodes + node->args + i);
+}
+
+
+mdv_filter * mdv_filter_create(mdv_table_base const *table, mdv_predicate const *predicate)
+{
+    uint32_t nodes = 0;
+    uint32_t size = 0;
+    uint32_t depth = 0;
+
+    if (!mdv_filter_size(table, predicate, 0, &nodes, &size, &depth))
+        return 0;
+
+    mdv_filter *filter = mdv_alloc(offsetof(mdv_filter, nodes)
+                                    + nodes * sizeof(mdv_filter_node)
+                                    + nodes * sizeof(uint32_t)
+                                    + size,
+                                   "filter");
+
+    if (!filter)
+    {
+        MDV_LOGE("No memory for filter");
+        return 0;
+    }
+
+    filter->size = nodes;
+    filter->depth = depth;
+    filter->count = 0;
+    filter->columns = (uint32_t *)(filter->nodes + nodes);
+
+    mdv_filter_builder builder =
+    {
+        .table = table,
+        .isa = mdv_filter_isa_best(),
+        .filter = filter,
+        .nodes = 1,
+        .values = (uint8_t *)(filter->columns + nodes)
+    };
+
+    mdv_filter_compile(&builder, predicate, filter->nodes);
+
+    return filter;
+}
+
+
+void mdv_filter_free(mdv_filter *filter)
+{
+    mdv_free(filter, "filter");
+}
+
+
+uint32_t mdv_filter_columns(mdv_filter const *filter, uint32_t const **columns)
+{
+    *columns = filter->columns;
+    return filter->count;
+}
+
+
+/**
+ * @brief Compares two items of the given type. Items might be unaligned.
+ */
+static int mdv_filter_item_cmp(mdv_field_type type, uint8_t const *a, uint8_t const *b)
+{
+#define MDV_FILTER_CMP(T)               \
+    {                                   \
+        T x, y;                         \
+        memcpy(&x, a, sizeof x);        \
+        memcpy(&y, b, sizeof y);        \
+        return (x > y) - (x < y);       \
+    }
+
+    switch(type)
+    {
+        case MDV_FLD_TYPE_BOOL:     return (*a != 0) - (*b != 0);
+        case MDV_FLD_TYPE_CHAR:
+        case MDV_FLD_TYPE_BYTE:
+        case MDV_FLD_TYPE_UINT8:    return (*a > *b) - (*a < *b);
+        case MDV_FLD_TYPE_INT8:     MDV_FILTER_CMP(int8_t);
+        case MDV_FLD_TYPE_INT16:    MDV_FILTER_CMP(int16_t);
+        case MDV_FLD_TYPE_UINT16:   MDV_FILTER_CMP(uint16_t);
+        case MDV_FLD_TYPE_INT32:    MDV_FILTER_CMP(int32_t);
+        case MDV_FLD_TYPE_UINT32:   MDV_FILTER_CMP(uint32_t);
+        case MDV_FLD_TYPE_INT64:    MDV_FILTER_CMP(int64_t);
+        case MDV_FLD_TYPE_UINT64:   MDV_FILTER_CMP(uint64_t);
+        case MDV_FLD_TYPE_FLOAT:    MDV_FILTER_CMP(float);
+        case MDV_FLD_TYPE_DOUBLE:   MDV_FILTER_CMP(double);
+    }
+
+#undef MDV_FILTER_CMP
+
+    return 0;
+}
+
+
+/**
+ * @brief Compares field value with the predicate value item by item.
+ */
+static int mdv_filter_value_cmp(mdv_filter_node const *node, mdv_data const *value)
+{
+    uint32_t const type_size = mdv_field_type_size(node->type);
+
+    uint8_t const *a = value->ptr;
+    uint8_t const *b = node->value.ptr;
+
+    uint32_t const size = value->size < node->value.size
+                            ? value->size
+                            : node->value.size;
+
+    if (type_size == 1 && node->type != MDV_FLD_TYPE_BOOL && node->type != MDV_FLD_TYPE_INT8)
+    {
+        int const res = memcmp(a, b, size);
+
+        if (res)
+            return res;
+    }
+    else
+    {
+        for(uint32_t i = 0; i < size; i += type_size)
+        {
+            int const res = mdv_filter_item_cmp(node->type, a + i, b + i);
+
+            if (res)
+                return res;
+        }
+    }
+
+    return (value->size > node->value.size) - (value->size < node->value.size);
+}
+
+
+static bool mdv_filter_cmp(mdv_predicate_op op, int res)
+{
+    switch(op)
+    {
+        case MDV_PRED_EQ:   return res == 0;
+        case MDV_PRED_NE:   return res != 0;
+        case MDV_PRED_LT:   return res < 0;
+        case MDV_PRED_LE:   return res <= 0;
+        case MDV_PRED_GT:   return res > 0;
+        case MDV_PRED_GE:   return res >= 0;
+        default:
+            break;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief Evaluates the predicate node for all rows in column segments.
+ *
+ * @param filter [in]       Rows filter
+ * @param node [in]         Predicate node
+ * @param columns [in]      Column segments
+ * @param tmp [in]          Temporary bitsets for nested logical operations
+ * @param result [out]      Selection bitmap
+ */
+static void mdv_filter_node_apply(mdv_filter const *filter,
+                                  mdv_filter_node const *node,
+                                  mdv_column const *columns,
+                                  mdv_bitset **tmp,
+                                  mdv_bitset *result)
+{
+    switch(node->op)
+    {
+        case MDV_PRED_AND:
+        case MDV_PRED_OR:
+        {
+            if (!node->size)
+            {
+                mdv_bitset_fill(result, node->op == MDV_PRED_AND);
+                return;
+            }
+
+            mdv_filter_node_apply(filter, filter->nodes + node->args, columns, tmp + 1, result);
+
+            for(uint32_t i = 1; i < node->size; ++i)
+            {
+                mdv_filter_node_apply(filter, filter->nodes + node->args + i, columns, tmp + 1, *tmp);
+
+                if (node->op == MDV_PRED_AND)
+                    mdv_bitset_and(result, *tmp);
+                else
+                    mdv_bitset_or(result, *tmp);
+            }
+
+            return;
+        }
+
+        case MDV_PRED_NOT:
+        {
+            mdv_filter_node_apply(filter, filter->nodes + node->args, columns, tmp + 1, result);
+            mdv_bitset_invert(result);
+            return;
+        }
+
+        default:
+            break;
+    }
+
+    mdv_column const *column = columns + node->column;
+
+    if (node->kernel)
+    {
+        node->kernel(column->values, column->count, node->value.ptr, mdv_bitset_data(result));
+        return;
+    }
+
+    mdv_bitset_fill(result, false);
+
+    for(uint32_t idx = 0; idx < column->count; ++idx)
+    {
+        mdv_data const value = mdv_column_value(column, idx);
+
+        if (mdv_filter_cmp(node->op, mdv_filter_value_cmp(node, &value)))
+            mdv_bitset_set(result, idx);
+    }
+}
+
+
+bool mdv_filter_apply(mdv_filter const *filter, mdv_column const *columns, mdv_bitset *selection)
+{
+    size_t const count = mdv_bitset_size(selection);
+
+    mdv_bitset *tmp[MDV_PREDICATE_DEPTH_MAX] = { 0 };
+
+    bool ret = true;
+
+    for(uint32_t i = 0; i < filter->depth && ret; ++i)
+    {
+        tmp[i] = mdv_bitset_create(count, &mdv_default_allocator);
+        ret = tmp[i] != 0;
+    }
+
+    if (ret)
+        mdv_filter_node_apply(filter, filter->nodes, columns, tmp, selection);
+
+    for(uint32_t i = 0; i < filter->depth; ++i)
+        mdv_bitset_free(tmp[i]);
+
+    return ret;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file
+ * @brief Rows filter.
+ * @details Filter is the predicate tree (see mdv_predicate) compiled for the table.
+ *          Fields indices and values are validated when the filter is created,
+ *          so rows are checked without any additional validation.
+ *          Fields values are read directly from the column segments (see mdv_column.h).
+ *          Filter is evaluated for whole segment at once. Fixed size fields are compared
+ *          by vectorized kernels (see mdv_filter_kernels.h) and the results are combined
+ *          by bitwise operations over the selection bitmaps.
+*/
+#pragma once
+#include "mdv_column.h"
+#include <mdv_types.h>
+#include <mdv_bitset.h>
+
+
+/// Rows filter
+typedef struct mdv_filter mdv_filter;
+
+
+/**
+ * @brief Compiles the predicate for the table rows filtering.
+ *
+ * @param table [in]        Table description
+ * @param predicate [in]    Predicate tree
+ *
+ * @return On success, return non-null pointer to the filter
+ * @return On error or if the predicate is invalid for the table, return NULL
+ */
+mdv_filter * mdv_filter_create(mdv_table_base const *table, mdv_predicate const *predicate);
+
+
+/**
+ * @brief Frees the filter created by mdv_filter_create().
+ */
+void mdv_filter_free(mdv_filter *filter);
+
+
+/**
+ * @brief Returns the columns which are required for the filter.
+ * @details Column segments passed to mdv_filter_apply() should be in the same order.
+ *
+ * @param filter [in]       Rows filter
+ * @param columns [out]     Columns indices
+ *
+ * @return Number of columns
+ */
+uint32_t mdv_filter_columns(mdv_filter const *filter, uint32_t const **columns);
+
+
+/**
+ * @brief Checks all rows of the column segments against the filter.
+ *
+ * @param filter [in]       Rows filter
+ * @param columns [in]      Column segments for the columns returned by mdv_filter_columns()
+ * @param selection [out]   Selection bitmap. Bitset size should be equal to the rows count in segments.
+ *                          Bits for rows which match the filter are set.
+ *
+ * @return On success, return true
+ * @return On error, return false
+ */
+bool mdv_filter_apply(mdv_filter const *filter, mdv_column const *columns, mdv_bitset *selection);
@@ -0,0 +1,373 @@
+#include "mdv_filter_kernels.h"
+#include "mdv_simd.h"
+
+
+/*
+ * Scalar kernels
+ */
+#define MDV_SCALAR_KERNEL(name, T, OP)                                      \
+    static void name(void const *values, uint32_t count, void const *value, uint32_t *bits) \
+    {                                                                       \
+        uint8_t const *p = values;                                          \
+        T const c = mdv_ld_##T(value);                                      \
+        for(uint32_t i = 0; i < count; i += 32)                             \
+        {                                                                   \
+            uint32_t const n = count - i < 32 ? count - i : 32;             \
+            uint32_t mask = 0;                                              \
+            for(uint32_t j = 0; j < n; ++j, p += sizeof c)                  \
+                mask |= (uint32_t)(mdv_ld_##T(p) OP c) << j;                \
+            *bits++ = mask;                                                 \
+        }                                                                   \
+    }
+
+#define MDV_SCALAR_KERNELS(T)                                               \
+    MDV_SCALAR_KERNEL(mdv_scalar_##T##_eq, T, ==)                           \
+    MDV_SCALAR_KERNEL(mdv_scalar_##T##_ne, T, !=)                           \
+    MDV_SCALAR_KERNEL(mdv_scalar_##T##_lt, T, <)                            \
+    MDV_SCALAR_KERNEL(mdv_scalar_##T##_le, T, <=)                           \
+    MDV_SCALAR_KERNEL(mdv_scalar_##T##_gt, T, >)                            \
+    MDV_SCALAR_KERNEL(mdv_scalar_##T##_ge, T, >=)
+
+typedef int8_t      i8;
+typedef uint8_t     u8;
+typedef int16_t     i16;
+typedef uint16_t    u16;
+typedef int32_t     i32;
+typedef uint32_t    u32;
+typedef int64_t     i64;
+typedef uint64_t    u64;
+typedef float       f32;
+typedef double      f64;
+
+MDV_SCALAR_KERNELS(i8)
+MDV_SCALAR_KERNELS(u8)
+MDV_SCALAR_KERNELS(i16)
+MDV_SCALAR_KERNELS(u16)
+MDV_SCALAR_KERNELS(i32)
+MDV_SCALAR_KERNELS(u32)
+MDV_SCALAR_KERNELS(i64)
+MDV_SCALAR_KERNELS(u64)
+MDV_SCALAR_KERNELS(f32)
+MDV_SCALAR_KERNELS(f64)
+
+#undef MDV_SCALAR_KERNELS
+#undef MDV_SCALAR_KERNEL
+
+
+/*
+ * Boolean values are compared as (value != 0). Kernels are built from the byte
+ * comparison: if m is the mask of nonzero values then the result is
+ * (1 OP c ? m : 0) | (0 OP c ? ~m : 0).
+ */
+static void mdv_filter_bool_map(uint32_t *bits, uint32_t count, bool t, bool f)
+{
+    uint32_t const words = (count + 31) / 32;
+
+    for(uint32_t i = 0; i < words; ++i)
+        bits[i] = (t ? bits[i] : 0) | (f ? ~bits[i] : 0);
+
+    if (count % 32)
+        bits[words - 1] &= (1u << (count % 32)) - 1;
+}
+
+#define MDV_BOOL_KERNEL(isa, op, OP)                                        \
+    static void mdv_##isa##_bool_##op(void const *values, uint32_t count, void const *value, uint32_t *bits) \
+    {                                                                       \
+        static uint8_t const zero = 0;                                      \
+        bool const c = mdv_ld_u8(value) != 0;                               \
+        mdv_##isa##_u8_ne(values, count, &zero, bits);                      \
+        mdv_filter_bool_map(bits, count, 1 OP c, 0 OP c);                   \
+    }
+
+#define MDV_BOOL_KERNELS(isa)                                               \
+    MDV_BOOL_KERNEL(isa, eq, ==)                                            \
+    MDV_BOOL_KERNEL(isa, ne, !=)                                            \
+    MDV_BOOL_KERNEL(isa, lt, <)                                             \
+    MDV_BOOL_KERNEL(isa, le, <=)                                            \
+    MDV_BOOL_KERNEL(isa, gt, >)                                             \
+    MDV_BOOL_KERNEL(isa, ge, >=)
+
+MDV_BOOL_KERNELS(scalar)
+
+
+#ifdef MDV_SIMD_X86
+
+/*
+ * SIMD kernels. Full words are processed by vectors and the rest values by the scalar kernel.
+ * Unsigned integers are biased by the sign bit and compared as signed ones.
+ * NE, LE and GE for integers are calculated as inverted EQ, GT and LT.
+ */
+#define MDV_SIMD_KERNEL(name, ATTR, VEC, BYTES, ESIZE, LOAD, SET1, CMP, MOVEMASK, INV, TAIL) \
+    ATTR static void name(void const *values, uint32_t count, void const *value, uint32_t *bits) \
+    {                                                                       \
+        uint8_t const *p = values;                                          \
+        VEC const c = SET1(value);                                          \
+        uint32_t const words = count / 32;                                  \
+        for(uint32_t w = 0; w < words; ++w)                                 \
+        {                                                                   \
+            uint32_t mask = 0;                                              \
+            for(uint32_t j = 0; j < 32; j += (BYTES) / (ESIZE), p += (BYTES)) \
+                mask |= (uint32_t)MOVEMASK(CMP(LOAD(p), c)) << j;           \
+            bits[w] = mask ^ (INV);                                         \
+        }                                                                   \
+        if (count % 32)                                                     \
+            TAIL(p, count % 32, value, bits + words);                       \
+    }
+
+#define MDV_SIMD_INT_KERNELS(isa, T, ATTR, VEC, LOAD, SET1, EQ, LT, GT, MOVEMASK) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_eq, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, EQ, MOVEMASK, 0u, mdv_scalar_##T##_eq) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_ne, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, EQ, MOVEMASK, ~0u, mdv_scalar_##T##_ne) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_lt, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, LT, MOVEMASK, 0u, mdv_scalar_##T##_lt) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_le, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, GT, MOVEMASK, ~0u, mdv_scalar_##T##_le) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_gt, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, GT, MOVEMASK, 0u, mdv_scalar_##T##_gt) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_ge, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, LT, MOVEMASK, ~0u, mdv_scalar_##T##_ge)
+
+#define MDV_SIMD_FLT_KERNELS(isa, T, ATTR, VEC, LOAD, SET1, MOVEMASK)       \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_eq, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, mdv_##isa##_eq_##T, MOVEMASK, 0u, mdv_scalar_##T##_eq) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_ne, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, mdv_##isa##_ne_##T, MOVEMASK, 0u, mdv_scalar_##T##_ne) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_lt, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, mdv_##isa##_lt_##T, MOVEMASK, 0u, mdv_scalar_##T##_lt) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_le, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, mdv_##isa##_le_##T, MOVEMASK, 0u, mdv_scalar_##T##_le) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_gt, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, mdv_##isa##_gt_##T, MOVEMASK, 0u, mdv_scalar_##T##_gt) \
+    MDV_SIMD_KERNEL(mdv_##isa##_##T##_ge, ATTR, VEC, sizeof(VEC), sizeof(T), LOAD, SET1, mdv_##isa##_ge_##T, MOVEMASK, 0u, mdv_scalar_##T##_ge)
+
+
+/*
+ * SSE2. There are no 64 bit integers comparisons in SSE2, so scalar kernels are used for them.
+ */
+MDV_SSE2 static inline __m128i mdv_sse2_ld(void const *p)      { return _mm_loadu_si128((__m128i const *)p); }
+MDV_SSE2 static inline __m128i mdv_sse2_ld_u8(void const *p)   { return _mm_xor_si128(mdv_sse2_ld(p), _mm_set1_epi8((char)0x80)); }
+MDV_SSE2 static inline __m128i mdv_sse2_ld_u16(void const *p)  { return _mm_xor_si128(mdv_sse2_ld(p), _mm_set1_epi16((short)0x8000)); }
+MDV_SSE2 static inline __m128i mdv_sse2_ld_u32(void const *p)  { return _mm_xor_si128(mdv_sse2_ld(p), _mm_set1_epi32((int)0x80000000u)); }
+MDV_SSE2 static inline __m128  mdv_sse2_ld_f32(void const *p)  { return _mm_loadu_ps((float const *)p); }
+MDV_SSE2 static inline __m128d mdv_sse2_ld_f64(void const *p)  { return _mm_loadu_pd((double const *)p); }
+
+MDV_SSE2 static inline __m128i mdv_sse2_set1_i8(void const *p)  { return _mm_set1_epi8(mdv_ld_i8(p)); }
+MDV_SSE2 static inline __m128i mdv_sse2_set1_u8(void const *p)  { return _mm_set1_epi8((char)(mdv_ld_u8(p) ^ 0x80u)); }
+MDV_SSE2 static inline __m128i mdv_sse2_set1_i16(void const *p) { return _mm_set1_epi16(mdv_ld_i16(p)); }
+MDV_SSE2 static inline __m128i mdv_sse2_set1_u16(void const *p) { return _mm_set1_epi16((short)(mdv_ld_u16(p) ^ 0x8000u)); }
+MDV_SSE2 static inline __m128i mdv_sse2_set1_i32(void const *p) { return _mm_set1_epi32(mdv_ld_i32(p)); }
+MDV_SSE2 static inline __m128i mdv_sse2_set1_u32(void const *p) { return _mm_set1_epi32((int)(mdv_ld_u32(p) ^ 0x80000000u)); }
+MDV_SSE2 static inline __m128  mdv_sse2_set1_f32(void const *p) { return _mm_set1_ps(mdv_ld_f32(p)); }
+MDV_SSE2 static inline __m128d mdv_sse2_set1_f64(void const *p) { return _mm_set1_pd(mdv_ld_f64(p)); }
+
+MDV_SSE2 static inline uint32_t mdv_sse2_mask8(__m128i v)       { return (uint32_t)_mm_movemask_epi8(v); }
+MDV_SSE2 static inline uint32_t mdv_sse2_mask16(__m128i v)      { return (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(v, v)) & 0xFFu; }
+MDV_SSE2 static inline uint32_t mdv_sse2_mask32(__m128i v)      { return (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(v)); }
+MDV_SSE2 static inline uint32_t mdv_sse2_mask_f32(__m128 v)     { return (uint32_t)_mm_movemask_ps(v); }
+MDV_SSE2 static inline uint32_t mdv_sse2_mask_f64(__m128d v)    { return (uint32_t)_mm_movemask_pd(v); }
+
+MDV_SSE2 static inline __m128 mdv_sse2_eq_f32(__m128 a, __m128 b)   { return _mm_cmpeq_ps(a, b); }
+MDV_SSE2 static inline __m128 mdv_sse2_ne_f32(__m128 a, __m128 b)   { return _mm_cmpneq_ps(a, b); }
+MDV_SSE2 static inline __m128 mdv_sse2_lt_f32(__m128 a, __m128 b)   { return _mm_cmplt_ps(a, b); }
+MDV_SSE2 static inline __m128 mdv_sse2_le_f32(__m128 a, __m128 b)   { return _mm_cmple_ps(a, b); }
+MDV_SSE2 static inline __m128 mdv_sse2_gt_f32(__m128 a, __m128 b)   { return _mm_cmpgt_ps(a, b); }
+MDV_SSE2 static inline __m128 mdv_sse2_ge_f32(__m128 a, __m128 b)   { return _mm_cmpge_ps(a, b); }
+
+MDV_SSE2 static inline __m128d mdv_sse2_eq_f64(__m128d a, __m128d b) { return _mm_cmpeq_pd(a, b); }
+MDV_SSE2 static inline __m128d mdv_sse2_ne_f64(__m128d a, __m128d b) { return _mm_cmpneq_pd(a, b); }
+MDV_SSE2 static inline __m128d mdv_sse2_lt_f64(__m128d a, __m128d b) { return _mm_cmplt_pd(a, b); }
+MDV_SSE2 static inline __m128d mdv_sse2_le_f64(__m128d a, __m128d b) { return _mm_cmple_pd(a, b); }
+MDV_SSE2 static inline __m128d mdv_sse2_gt_f64(__m128d a, __m128d b) { return _mm_cmpgt_pd(a, b); }
+MDV_SSE2 static inline __m128d mdv_sse2_ge_f64(__m128d a, __m128d b) { return _mm_cmpge_pd(a, b); }
+
+MDV_SIMD_INT_KERNELS(sse2, i8,  MDV_SSE2, __m128i, mdv_sse2_ld,     mdv_sse2_set1_i8,  _mm_cmpeq_epi8,  _mm_cmplt_epi8,  _mm_cmpgt_epi8,  mdv_sse2_mask8)
+MDV_SIMD_INT_KERNELS(sse2, u8,  MDV_SSE2, __m128i, mdv_sse2_ld_u8,  mdv_sse2_set1_u8,  _mm_cmpeq_epi8,  _mm_cmplt_epi8,  _mm_cmpgt_epi8,  mdv_sse2_mask8)
+MDV_SIMD_INT_KERNELS(sse2, i16, MDV_SSE2, __m128i, mdv_sse2_ld,     mdv_sse2_set1_i16, _mm_cmpeq_epi16, _mm_cmplt_epi16, _mm_cmpgt_epi16, mdv_sse2_mask16)
+MDV_SIMD_INT_KERNELS(sse2, u16, MDV_SSE2, __m128i, mdv_sse2_ld_u16, mdv_sse2_set1_u16, _mm_cmpeq_epi16, _mm_cmplt_epi16, _mm_cmpgt_epi16, mdv_sse2_mask16)
+MDV_SIMD_INT_KERNELS(sse2, i32, MDV_SSE2, __m128i, mdv_sse2_ld,     mdv_sse2_set1_i32, _mm_cmpeq_epi32, _mm_cmplt_epi32, _mm_cmpgt_epi32, mdv_sse2_mask32)
+MDV_SIMD_INT_KERNELS(sse2, u32, MDV_SSE2, __m128i, mdv_sse2_ld_u32, mdv_sse2_set1_u32, _mm_cmpeq_epi32, _mm_cmplt_epi32, _mm_cmpgt_epi32, mdv_sse2_mask32)
+MDV_SIMD_FLT_KERNELS(sse2, f32, MDV_SSE2, __m128,  mdv_sse2_ld_f32, mdv_sse2_set1_f32, mdv_sse2_mask_f32)
+MDV_SIMD_FLT_KERNELS(sse2, f64, MDV_SSE2, __m128d, mdv_sse2_ld_f64, mdv_sse2_set1_f64, mdv_sse2_mask_f64)
+MDV_BOOL_KERNELS(sse2)
+
+
+/*
+ * AVX2
+ */
+MDV_AVX2 static inline __m256i mdv_avx2_ld(void const *p)      { return _mm256_loadu_si256((__m256i const *)p); }
+MDV_AVX2 static inline __m256i mdv_avx2_ld_u8(void const *p)   { return _mm256_xor_si256(mdv_avx2_ld(p), _mm256_set1_epi8((char)0x80)); }
+MDV_AVX2 static inline __m256i mdv_avx2_ld_u16(void const *p)  { return _mm256_xor_si256(mdv_avx2_ld(p), _mm256_set1_epi16((short)0x8000)); }
+MDV_AVX2 static inline __m256i mdv_avx2_ld_u32(void const *p)  { return _mm256_xor_si256(mdv_avx2_ld(p), _mm256_set1_epi32((int)0x80000000u)); }
+MDV_AVX2 static inline __m256i mdv_avx2_ld_u64(void const *p)  { return _mm256_xor_si256(mdv_avx2_ld(p), _mm256_set1_epi64x((long long)0x8000000000000000ull)); }
+MDV_AVX2 static inline __m256  mdv_avx2_ld_f32(void const *p)  { return _mm256_loadu_ps((float const *)p); }
+MDV_AVX2 static inline __m256d mdv_avx2_ld_f64(void const *p)  { return _mm256_loadu_pd((double const *)p); }
+
+MDV_AVX2 static inline __m256i mdv_avx2_set1_i8(void const *p)  { return _mm256_set1_epi8(mdv_ld_i8(p)); }
+MDV_AVX2 static inline __m256i mdv_avx2_set1_u8(void const *p)  { return _mm256_set1_epi8((char)(mdv_ld_u8(p) ^ 0x80u)); }
+MDV_AVX2 static inline __m256i mdv_avx2_set1_i16(void const *p) { return _mm256_set1_epi16(mdv_ld_i16(p)); }
+MDV_AVX2 static inline __m256i mdv_avx2_set1_u16(void const *p) { return _mm256_set1_epi16((short)(mdv_ld_u16(p) ^ 0x8000u)); }
+MDV_AVX2 static inline __m256i mdv_avx2_set1_i32(void const *p) { return _mm256_set1_epi32(mdv_ld_i32(p)); }
+MDV_AVX2 static inline __m256i mdv_avx2_set1_u32(void const *p) { return _mm256_set1_epi32((int)(mdv_ld_u32(p) ^ 0x80000000u)); }
+MDV_AVX2 static inline __m256i mdv_avx2_set1_i64(void const *p) { return _mm256_set1_epi64x(mdv_ld_i64(p)); }
+MDV_AVX2 static inline __m256i mdv_avx2_set1_u64(void const *p) { return _mm256_set1_epi64x((long long)(mdv_ld_u64(p) ^ 0x8000000000000000ull)); }
+MDV_AVX2 static inline __m256  mdv_avx2_set1_f32(void const *p) { return _mm256_set1_ps(mdv_ld_f32(p)); }
+MDV_AVX2 static inline __m256d mdv_avx2_set1_f64(void const *p) { return _mm256_set1_pd(mdv_ld_f64(p)); }
+
+MDV_AVX2 static inline uint32_t mdv_avx2_mask8(__m256i v)       { return (uint32_t)_mm256_movemask_epi8(v); }
+MDV_AVX2 static inline uint32_t mdv_avx2_mask32(__m256i v)      { return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(v)); }
+MDV_AVX2 static inline uint32_t mdv_avx2_mask64(__m256i v)      { return (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(v)); }
+MDV_AVX2 static inline uint32_t mdv_avx2_mask_f32(__m256 v)     { return (uint32_t)_mm256_movemask_ps(v); }
+MDV_AVX2 static inline uint32_t mdv_avx2_mask_f64(__m256d v)    { return (uint32_t)_mm256_movemask_pd(v); }
+
+// Packing works within 128 bit lanes, so the mask contains the duplicated bytes for each lane
+MDV_AVX2 static inline uint32_t mdv_avx2_mask16(__m256i v)
+{
+    uint32_t const m = (uint32_t)_mm256_movemask_epi8(_mm256_packs_epi16(v, v));
+    return (m & 0xFFu) | ((m >> 8) & 0xFF00u);
+}
+
+MDV_AVX2 static inline __m256i mdv_avx2_lt_i8(__m256i a, __m256i b)    { return _mm256_cmpgt_epi8(b, a); }
+MDV_AVX2 static inline __m256i mdv_avx2_lt_i16(__m256i a, __m256i b)   { return _mm256_cmpgt_epi16(b, a); }
+MDV_AVX2 static inline __m256i mdv_avx2_lt_i32(__m256i a, __m256i b)   { return _mm256_cmpgt_epi32(b, a); }
+MDV_AVX2 static inline __m256i mdv_avx2_lt_i64(__m256i a, __m256i b)   { return _mm256_cmpgt_epi64(b, a); }
+
+MDV_AVX2 static inline __m256 mdv_avx2_eq_f32(__m256 a, __m256 b)      { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+MDV_AVX2 static inline __m256 mdv_avx2_ne_f32(__m256 a, __m256 b)      { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+MDV_AVX2 static inline __m256 mdv_avx2_lt_f32(__m256 a, __m256 b)      { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+MDV_AVX2 static inline __m256 mdv_avx2_le_f32(__m256 a, __m256 b)      { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+MDV_AVX2 static inline __m256 mdv_avx2_gt_f32(__m256 a, __m256 b)      { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+MDV_AVX2 static inline __m256 mdv_avx2_ge_f32(__m256 a, __m256 b)      { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+
+MDV_AVX2 static inline __m256d mdv_avx2_eq_f64(__m256d a, __m256d b)   { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+MDV_AVX2 static inline __m256d mdv_avx2_ne_f64(__m256d a, __m256d b)   { return _mm256_cmp_pd(a, b, _CMP_NEQ_UQ); }
+MDV_AVX2 static inline __m256d mdv_avx2_lt_f64(__m256d a, __m256d b)   { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+MDV_AVX2 static inline __m256d mdv_avx2_le_f64(__m256d a, __m256d b)   { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+MDV_AVX2 static inline __m256d mdv_avx2_gt_f64(__m256d a, __m256d b)   { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+MDV_AVX2 static inline __m256d mdv_avx2_ge_f64(__m256d a, __m256d b)   { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+
+MDV_SIMD_INT_KERNELS(avx2, i8,  MDV_AVX2, __m256i, mdv_avx2_ld,     mdv_avx2_set1_i8,  _mm256_cmpeq_epi8,  mdv_avx2_lt_i8,  _mm256_cmpgt_epi8,  mdv_avx2_mask8)
+MDV_SIMD_INT_KERNELS(avx2, u8,  MDV_AVX2, __m256i, mdv_avx2_ld_u8,  mdv_avx2_set1_u8,  _mm256_cmpeq_epi8,  mdv_avx2_lt_i8,  _mm256_cmpgt_epi8,  mdv_avx2_mask8)
+MDV_SIMD_INT_KERNELS(avx2, i16, MDV_AVX2, __m256i, mdv_avx2_ld,     mdv_avx2_set1_i16, _mm256_cmpeq_epi16, mdv_avx2_lt_i16, _mm256_cmpgt_epi16, mdv_avx2_mask16)
+MDV_SIMD_INT_KERNELS(avx2, u16, MDV_AVX2, __m256i, mdv_avx2_ld_u16, mdv_avx2_set1_u16, _mm256_cmpeq_epi16, mdv_avx2_lt_i16, _mm256_cmpgt_epi16, mdv_avx2_mask16)
+MDV_SIMD_INT_KERNELS(avx2, i32, MDV_AVX2, __m256i, mdv_avx2_ld,     mdv_avx2_set1_i32, _mm256_cmpeq_epi32, mdv_avx2_lt_i32, _mm256_cmpgt_epi32, mdv_avx2_mask32)
+MDV_SIMD_INT_KERNELS(avx2, u32, MDV_AVX2, __m256i, mdv_avx2_ld_u32, mdv_avx2_set1_u32, _mm256_cmpeq_epi32, mdv_avx2_lt_i32, _mm256_cmpgt_epi32, mdv_avx2_mask32)
+MDV_SIMD_INT_KERNELS(avx2, i64, MDV_AVX2, __m256i, mdv_avx2_ld,     mdv_avx2_set1_i64, _mm256_cmpeq_epi64, mdv_avx2_lt_i64, _mm256_cmpgt_epi64, mdv_avx2_mask64)
+MDV_SIMD_INT_KERNELS(avx2, u64, MDV_AVX2, __m256i, mdv_avx2_ld_u64, mdv_avx2_set1_u64, _mm256_cmpeq_epi64, mdv_avx2_lt_i64, _mm256_cmpgt_epi64, mdv_avx2_mask64)
+MDV_SIMD_FLT_KERNELS(avx2, f32, MDV_AVX2, __m256,  mdv_avx2_ld_f32, mdv_avx2_set1_f32, mdv_avx2_mask_f32)
+MDV_SIMD_FLT_KERNELS(avx2, f64, MDV_AVX2, __m256d, mdv_avx2_ld_f64, mdv_avx2_set1_f64, mdv_avx2_mask_f64)
+MDV_BOOL_KERNELS(avx2)
+
+#undef MDV_SIMD_FLT_KERNELS
+#undef MDV_SIMD_INT_KERNELS
+#undef MDV_SIMD_KERNEL
+
+#endif // MDV_SIMD_X86
+
+#undef MDV_BOOL_KERNELS
+#undef MDV_BOOL_KERNEL
+
+
+#define MDV_KERNELS(isa, T)                                                 \
+    {                                                                       \
+        [MDV_PRED_EQ] = mdv_##isa##_##T##_eq,                               \
+        [MDV_PRED_NE] = mdv_##isa##_##T##_ne,                               \
+        [MDV_PRED_LT] = mdv_##isa##_##T##_lt,                               \
+        [MDV_PRED_LE] = mdv_##isa##_##T##_le,                               \
+        [MDV_PRED_GT] = mdv_##isa##_##T##_gt,                               \
+        [MDV_PRED_GE] = mdv_##isa##_##T##_ge                                \
+    }
+
+
+static mdv_filter_kernel const mdv_filter_kernels[MDV_FILTER_ISA_COUNT][MDV_FLD_TYPE_DOUBLE + 1][MDV_PRED_GE + 1] =
+{
+    [MDV_FILTER_ISA_SCALAR] =
+    {
+        [MDV_FLD_TYPE_BOOL]     = MDV_KERNELS(scalar, bool),
+        [MDV_FLD_TYPE_CHAR]     = MDV_KERNELS(scalar, u8),
+        [MDV_FLD_TYPE_BYTE]     = MDV_KERNELS(scalar, u8),
+        [MDV_FLD_TYPE_INT8]     = MDV_KERNELS(scalar, i8),
+        [MDV_FLD_TYPE_UINT8]    = MDV_KERNELS(scalar, u8),
+        [MDV_FLD_TYPE_INT16]    = MDV_KERNELS(scalar, i16),
+        [MDV_FLD_TYPE_UINT16]   = MDV_KERNELS(scalar, u16),
+        [MDV_FLD_TYPE_INT32]    = MDV_KERNELS(scalar, i32),
+        [MDV_FLD_TYPE_UINT32]   = MDV_KERNELS(scalar, u32),
+        [MDV_FLD_TYPE_INT64]    = MDV_KERNELS(scalar, i64),
+        [MDV_FLD_TYPE_UINT64]   = MDV_KERNELS(scalar, u64),
+        [MDV_FLD_TYPE_FLOAT]    = MDV_KERNELS(scalar, f32),
+        [MDV_FLD_TYPE_DOUBLE]   = MDV_KERNELS(scalar, f64)
+    },
+
+#ifdef MDV_SIMD_X86
+    [MDV_FILTER_ISA_SSE2] =
+    {
+        [MDV_FLD_TYPE_BOOL]     = MDV_KERNELS(sse2, bool),
+        [MDV_FLD_TYPE_CHAR]     = MDV_KERNELS(sse2, u8),
+        [MDV_FLD_TYPE_BYTE]     = MDV_KERNELS(sse2, u8),
+        [MDV_FLD_TYPE_INT8]     = MDV_KERNELS(sse2, i8),
+        [MDV_FLD_TYPE_UINT8]    = MDV_KERNELS(sse2, u8),
+        [MDV_FLD_TYPE_INT16]    = MDV_KERNELS(sse2, i16),
+        [MDV_FLD_TYPE_UINT16]   = MDV_KERNELS(sse2, u16),
+        [MDV_FLD_TYPE_INT32]    = MDV_KERNELS(sse2, i32),
+        [MDV_FLD_TYPE_UINT32]   = MDV_KERNELS(sse2, u32),
+        [MDV_FLD_TYPE_FLOAT]    = MDV_KERNELS(sse2, f32),
+        [MDV_FLD_TYPE_DOUBLE]   = MDV_KERNELS(sse2, f64)
+    },
+
+    [MDV_FILTER_ISA_AVX2] =
+    {
+        [MDV_FLD_TYPE_BOOL]     = MDV_KERNELS(avx2, bool),
+        [MDV_FLD_TYPE_CHAR]     = MDV_KERNELS(avx2, u8),
+        [MDV_FLD_TYPE_BYTE]     = MDV_KERNELS(avx2, u8),
+        [MDV_FLD_TYPE_INT8]     = MDV_KERNELS(avx2, i8),
+        [MDV_FLD_TYPE_UINT8]    = MDV_KERNELS(avx2, u8),
+        [MDV_FLD_TYPE_INT16]    = MDV_KERNELS(avx2, i16),
+        [MDV_FLD_TYPE_UINT16]   = MDV_KERNELS(avx2, u16),
+        [MDV_FLD_TYPE_INT32]    = MDV_KERNELS(avx2, i32),
+        [MDV_FLD_TYPE_UINT32]   = MDV_KERNELS(avx2, u32),
+        [MDV_FLD_TYPE_INT64]    = MDV_KERNELS(avx2, i64),
+        [MDV_FLD_TYPE_UINT64]   = MDV_KERNELS(avx2, u64),
+        [MDV_FLD_TYPE_FLOAT]    = MDV_KERNELS(avx2, f32),
+        [MDV_FLD_TYPE_DOUBLE]   = MDV_KERNELS(avx2, f64)
+    },
+#endif
+};
+
+#undef MDV_KERNELS
+
+
+mdv_filter_isa mdv_filter_isa_best()
+{
+#ifdef MDV_SIMD_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2"))
+        return MDV_FILTER_ISA_AVX2;
+
+    if (__builtin_cpu_supports("sse2"))
+        return MDV_FILTER_ISA_SSE2;
+#endif
+
+    return MDV_FILTER_ISA_SCALAR;
+}
+
+
+char const * mdv_filter_isa_name(mdv_filter_isa isa)
+{
+    switch(isa)
+    {
+        case MDV_FILTER_ISA_SCALAR: return "scalar";
+        case MDV_FILTER_ISA_SSE2:   return "SSE2";
+        case MDV_FILTER_ISA_AVX2:   return "AVX2";
+        default:
+            break;
+    }
+    return "unknown";
+}
+
+
+mdv_filter_kernel mdv_filter_kernel_get(mdv_filter_isa isa, mdv_field_type type, mdv_predicate_op op)
+{
+    if (isa >= MDV_FILTER_ISA_COUNT
+        || type < MDV_FLD_TYPE_BOOL
+        || type > MDV_FLD_TYPE_DOUBLE
+        || op > MDV_PRED_GE)
+        return 0;
+
+    for(int i = isa; i >= MDV_FILTER_ISA_SCALAR; --i)
+    {
+        if (mdv_filter_kernels[i][type][op])
+            return mdv_filter_kernels[i][type][op];
+    }
+
+    return 0;
+}
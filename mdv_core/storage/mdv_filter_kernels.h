@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Comparison kernels for fixed size columns.
+ * @details Kernel compares the packed column values with a constant and produces
+ *          the selection bitmap. Bits are packed into 32 bit words starting from the
+ *          least significant bit (the same layout as mdv_bitset_data() has).
+ *          Bits after the values count in the last word are set to zero.
+ *
+ *          Kernels are implemented for scalar code, SSE2 and AVX2. The best
+ *          instruction set is detected at runtime. Kernels for all instruction sets
+ *          give the same results as the C comparison operators.
+*/
+#pragma once
+#include <mdv_types.h>
+
+
+/// Instruction sets
+typedef enum
+{
+    MDV_FILTER_ISA_SCALAR = 0,  ///< Portable C code
+    MDV_FILTER_ISA_SSE2,        ///< SSE2 instructions
+    MDV_FILTER_ISA_AVX2,        ///< AVX2 instructions
+    MDV_FILTER_ISA_COUNT
+} mdv_filter_isa;
+
+
+/**
+ * @brief Comparison kernel
+ *
+ * @param values [in]   Packed values. Values might be unaligned.
+ * @param count [in]    Values count
+ * @param value [in]    Value to compare with. Value might be unaligned.
+ * @param bits [out]    Selection bitmap for (count + 31) / 32 words
+ */
+typedef void (*mdv_filter_kernel)(void const *values, uint32_t count, void const *value, uint32_t *bits);
+
+
+/**
+ * @brief Returns the best instruction set supported by CPU.
+ */
+mdv_filter_isa mdv_filter_isa_best();
+
+
+/**
+ * @brief Returns the instruction set name.
+ */
+char const * mdv_filter_isa_name(mdv_filter_isa isa);
+
+
+/**
+ * @brief Returns the comparison kernel.
+ * @details If there is no kernel for the given instruction set, the kernel
+ *          for the previous instruction set is returned.
+ *
+ * @param isa [in]      Instruction set. Instruction set should be supported by CPU.
+ * @param type [in]     Field type
+ * @param op [in]       Comparison operation (MDV_PRED_EQ ... MDV_PRED_GE)
+ *
+ * @return Comparison kernel or NULL if the arguments are invalid
+ */
+mdv_filter_kernel mdv_filter_kernel_get(mdv_filter_isa isa, mdv_field_type type, mdv_predicate_op op);
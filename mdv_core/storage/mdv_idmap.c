@@ -8,6 +8,7 @@
 struct mdv_idmap
 {
     mdv_storage            *storage;
+    mdv_map_handle          map;
     uint64_t                size;
     char                   *name;
     atomic_uint_fast64_t    ids[1];
@@ -39,6 +40,15 @@ mdv_idmap * mdv_idmap_open(mdv_storage *storage, char const *name, size_t size)
 
     mdv_rollbacker_push(rollbacker, mdv_idmap_free, idmap);
 
+    idmap->map = mdv_storage_map(storage, name, MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+    if (!idmap->map)
+    {
+        MDV_LOGE("Table '%s' not opened", name);
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
     // Start transaction
     mdv_transaction transaction = mdv_transaction_start(storage);
 
@@ -52,9 +62,7 @@ mdv_idmap * mdv_idmap_open(mdv_storage *storage, char const *name, size_t size)
     mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
 
     // Try to open table
-    mdv_map map = mdv_map_open(&transaction,
-                               name,
-                               MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mdv_map map = mdv_map_bind(&transaction, idmap->map);
 
     if (!mdv_map_ok(map))
     {
@@ -148,9 +156,7 @@ bool mdv_idmap_set(mdv_idmap *idmap, uint64_t pos, uint64_t val)
     mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
 
     // Try to open table
-    mdv_map map = mdv_map_open(&transaction,
-                               idmap->name,
-                               MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mdv_map map = mdv_map_bind(&transaction, idmap->map);
 
     if (!mdv_map_ok(map))
     {
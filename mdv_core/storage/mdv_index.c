@@ -0,0 +1,178 @@
+#include "mdv_index.h"
+#include "mdv_column.h"
+#include <mdv_log.h>
+#include <string.h>
+
+
+/// Array items markers
+enum
+{
+    MDV_INDEX_ARRAY_END  = 0,           ///< Array terminator
+    MDV_INDEX_ARRAY_ITEM = 1            ///< Array item prefix
+};
+
+
+static uint32_t mdv_index_field_key_size(mdv_field const *field)
+{
+    uint32_t const type_size = mdv_field_type_size(field->type);
+
+    return mdv_column_is_fixed(field)
+                ? type_size
+                : field->limit * (type_size + 1) + 1;
+}
+
+
+bool mdv_index_desc_check(mdv_table_base const *table, mdv_index_desc const *desc)
+{
+    if (!desc->size || desc->size > MDV_INDEX_FIELDS_MAX)
+    {
+        MDV_LOGE("Invalid number of indexed fields: %u", desc->size);
+        return false;
+    }
+
+    uint32_t key_size = 0;
+
+    for(uint32_t i = 0; i < desc->size; ++i)
+    {
+        if (desc->fields[i] >= table->size)
+        {
+            MDV_LOGE("Invalid indexed field: %u", desc->fields[i]);
+            return false;
+        }
+
+        mdv_field const *field = table->fields + desc->fields[i];
+
+        if (!field->limit)
+        {
+            MDV_LOGE("Field '%s' with unlimited size can't be indexed", field->name.ptr);
+            return false;
+        }
+
+        key_size += mdv_index_field_key_size(field);
+    }
+
+    if (key_size > MDV_INDEX_KEY_MAX)
+    {
+        MDV_LOGE("Index key is too long: %u bytes", key_size);
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Converts the field item to unsigned integer which has the same order.
+ */
+static uint64_t mdv_index_item_load(mdv_field_type type, uint8_t const *ptr)
+{
+    switch(type)
+    {
+        case MDV_FLD_TYPE_INT8:
+            return (uint8_t)(*ptr ^ 0x80u);
+
+        case MDV_FLD_TYPE_INT16:
+        case MDV_FLD_TYPE_UINT16:
+        {
+            uint16_t v;
+            memcpy(&v, ptr, sizeof v);
+            return type == MDV_FLD_TYPE_INT16 ? (uint16_t)(v ^ 0x8000u) : v;
+        }
+
+        case MDV_FLD_TYPE_INT32:
+        case MDV_FLD_TYPE_UINT32:
+        {
+            uint32_t v;
+            memcpy(&v, ptr, sizeof v);
+            return type == MDV_FLD_TYPE_INT32 ? v ^ 0x80000000u : v;
+        }
+
+        case MDV_FLD_TYPE_INT64:
+        case MDV_FLD_TYPE_UINT64:
+        {
+            uint64_t v;
+            memcpy(&v, ptr, sizeof v);
+            return type == MDV_FLD_TYPE_INT64 ? v ^ 0x8000000000000000ull : v;
+        }
+
+        case MDV_FLD_TYPE_FLOAT:
+        {
+            uint32_t v;
+            memcpy(&v, ptr, sizeof v);
+            return (v & 0x80000000u) ? (uint32_t)~v : v | 0x80000000u;
+        }
+
+        case MDV_FLD_TYPE_DOUBLE:
+        {
+            uint64_t v;
+            memcpy(&v, ptr, sizeof v);
+            return (v & 0x8000000000000000ull) ? ~v : v | 0x8000000000000000ull;
+        }
+
+        default:
+            break;
+    }
+
+    return *ptr;
+}
+
+
+static uint8_t * mdv_index_item_store(mdv_field_type type, uint32_t size, uint8_t const *item, uint8_t *key)
+{
+    uint64_t const v = mdv_index_item_load(type, item);
+
+    for(uint32_t i = 0; i < size; ++i)
+        key[i] = (uint8_t)(v >> ((size - 1 - i) * 8));
+
+    return key + size;
+}
+
+
+bool mdv_index_key(mdv_table_base const *table,
+                   mdv_index_desc const *desc,
+                   uint32_t              count,
+                   mdv_data const       *values,
+                   uint8_t              *key,
+                   uint32_t             *size)
+{
+    if (count > desc->size)
+    {
+        MDV_LOGE("Too many index key values: %u", count);
+        return false;
+    }
+
+    uint8_t *ptr = key;
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        mdv_field const *field = table->fields + desc->fields[i];
+
+        if (!mdv_column_value_check(field, values + i))
+        {
+            MDV_LOGE("Invalid index key value for field '%s'", field->name.ptr);
+            return false;
+        }
+
+        uint32_t const type_size = mdv_field_type_size(field->type);
+        uint32_t const items = values[i].size / type_size;
+        uint8_t const *item = values[i].ptr;
+
+        if (mdv_column_is_fixed(field))
+        {
+            ptr = mdv_index_item_store(field->type, type_size, item, ptr);
+            continue;
+        }
+
+        for(uint32_t j = 0; j < items; ++j, item += type_size)
+        {
+            *ptr++ = MDV_INDEX_ARRAY_ITEM;
+            ptr = mdv_index_item_store(field->type, type_size, item, ptr);
+        }
+
+        *ptr++ = MDV_INDEX_ARRAY_END;
+    }
+
+    *size = (uint32_t)(ptr - key);
+
+    return true;
+}
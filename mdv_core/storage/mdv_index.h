@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Secondary index keys.
+ * @details Secondary index maps the values of one or more table fields to the row identifiers.
+ *          Index keys are encoded so that the byte-wise comparison of the keys gives
+ *          the same order as the comparison of the fields values:
+ *          - integers are written in big-endian byte order with the sign bit inverted,
+ *          - floating point numbers are written as integers with all bits inverted for negative
+ *            numbers and with the sign bit inverted for positive numbers,
+ *          - each item of array fields (limit != 1) is prefixed by 0x01 and the array is terminated by 0x00,
+ *            so shorter arrays go before longer arrays with the same prefix.
+ *
+ *          Fields with unlimited arrays (limit 0) can't be indexed because index key size is limited.
+*/
+#pragma once
+#include <mdv_types.h>
+
+
+/// Maximal number of fields in secondary index
+#define MDV_INDEX_FIELDS_MAX    8
+
+
+/// Maximal size of secondary index key
+#define MDV_INDEX_KEY_MAX       511
+
+
+/// Secondary index description
+typedef struct
+{
+    uint32_t id;                                ///< Index identifier
+    uint32_t size;                              ///< Number of indexed fields
+    uint32_t fields[MDV_INDEX_FIELDS_MAX];      ///< Indexed fields indices
+} mdv_index_desc;
+
+
+/**
+ * @brief Checks that the index description is valid for the table.
+ * @details All fields should exist and the maximal key size shouldn't exceed MDV_INDEX_KEY_MAX.
+ */
+bool mdv_index_desc_check(mdv_table_base const *table, mdv_index_desc const *desc);
+
+
+/**
+ * @brief Builds index key.
+ *
+ * @param table [in]    Table description
+ * @param desc [in]     Index description
+ * @param count [in]    Number of values. Should be less than or equal to the number of indexed fields.
+ * @param values [in]   Values of the first count indexed fields
+ * @param key [out]     Buffer for key. Buffer size should be at least MDV_INDEX_KEY_MAX bytes.
+ * @param size [out]    Key size
+ *
+ * @return true if key was successfully built
+ * @return false if values are invalid
+ */
+bool mdv_index_key(mdv_table_base const *table,
+                   mdv_index_desc const *desc,
+                   uint32_t              count,
+                   mdv_data const       *values,
+                   uint8_t              *key,
+                   uint32_t             *size);
@@ -13,7 +13,7 @@ void mdv_metainf_init(mdv_metainf *m)
 
 mdv_storage * mdv_metainf_storage_open(char const *path)
 {
-    mdv_storage *storage = mdv_storage_open(path, MDV_STRG_METAINF, MDV_STRG_METAINF_MAPS, MDV_STRG_NOSUBDIR);
+    mdv_storage *storage = mdv_storage_open(path, MDV_STRG_METAINF, MDV_STRG_METAINF_MAPS, MDV_STRG_DATA_FLAGS());
 
     if (!storage)
     {
@@ -0,0 +1,1652 @@
+#include "mdv_rowdata.h"
+#include "mdv_storages.h"
+#include "../mdv_config.h"
+#include <mdv_serialization.h>
+#include <mdv_rollbacker.h>
+#include <mdv_limits.h>
+#include <mdv_alloc.h>
+#include <mdv_string.h>
+#include <mdv_log.h>
+#include <mdv_mutex.h>
+#include <stdatomic.h>
+#include <string.h>
+
+
+/// Secondary index record in INDEXES map
+typedef struct
+{
+    mdv_index_desc          desc;       ///< Index description
+    uint32_t                ready;      ///< Index is built and maintained by mdv_rowdata_add()
+    uint32_t                alignment;  ///< Alignment (unused)
+    uint64_t                built;      ///< Number of first rows added to the index by builder
+} mdv_rowdata_index_rec;
+
+
+/// Secondary index
+typedef struct
+{
+    mdv_rowdata_index_rec   rec;        ///< Index record
+    mdv_map                 map;        ///< Index map (Key -> row identifiers)
+} mdv_rowdata_index;
+
+
+/// Table rows storage
+struct mdv_rowdata
+{
+    atomic_uint_fast32_t    rc;             ///< References counter
+    mdv_uuid                uuid;           ///< Table UUID
+    mdv_storage            *storage;        ///< Rows storage
+    mdv_map                 table_map;      ///< Table description and rows count
+    mdv_map                 columns;        ///< Columns segments ({ Column, Segment } -> column segment)
+    mdv_map                 tail;           ///< Rows of the last incomplete segment (Row identifier -> packed row)
+    mdv_map                 indexes_map;    ///< Secondary indexes records (Index identifier -> mdv_rowdata_index_rec)
+    mdv_map                 applied_map;    ///< Transaction logs applied positions (Storage UUID -> record identifier)
+    mdv_table_base         *table;          ///< Table description
+    mdv_row_codec          *codec;          ///< Rows codec compiled for the table fields
+    mdv_mutex               indexes_mutex;  ///< Mutex for secondary indexes guard
+    uint32_t                indexes_count;  ///< Number of secondary indexes
+    mdv_rowdata_index       indexes[MDV_STRG_INDEXES_MAX];  ///< Secondary indexes
+};
+
+
+/// Keys for table map
+enum
+{
+    MDV_ROWDATA_TABLE_DESC  = 0,        ///< Table description
+    MDV_ROWDATA_ROWS_COUNT  = 1         ///< Rows count
+};
+
+
+/// Flags for secondary index maps
+static const uint32_t MDV_ROWDATA_INDEX_FLAGS = MDV_MAP_CREATE
+                                                | MDV_MAP_MULTI
+                                                | MDV_MAP_FIXED_SIZE_VALUE
+                                                | MDV_MAP_INTEGERVAL;
+
+
+/// Column segment key
+typedef struct
+{
+    uint64_t column;                    ///< Column index
+    uint64_t segment;                   ///< Segment number
+} mdv_column_key;
+
+
+static mdv_storage * mdv_rowdata_storage_open(mdv_uuid const *uuid)
+{
+    mdv_string const str_uuid = mdv_uuid_to_str(uuid);
+
+    // Build table subdirectory
+    mdv_stack(char, MDV_PATH_MAX) mpool;
+    mdv_stack_clear(mpool);
+
+    static mdv_string const dir_delimeter = mdv_str_static("/");
+    mdv_string path = mdv_str_pdup(mpool, MDV_CONFIG.storage.path.ptr);
+    path = mdv_str_pcat(mpool, path, dir_delimeter, str_uuid);
+
+    if (mdv_str_empty(path))
+    {
+        MDV_LOGE("Path '%s' is too long.", MDV_CONFIG.storage.path.ptr);
+        return 0;
+    }
+
+    mdv_storage *storage = mdv_storage_open(path.ptr,
+                                            MDV_STRG_OBJECTS,
+                                            MDV_STRG_OBJECTS_MAPS,
+                                            MDV_STRG_DATA_FLAGS());
+
+    if (!storage)
+        MDV_LOGE("Storage '%s' wasn't created", str_uuid.ptr);
+
+    return storage;
+}
+
+
+static void mdv_rowdata_indexes_close(mdv_rowdata *rowdata)
+{
+    for(uint32_t i = 0; i < rowdata->indexes_count; ++i)
+        mdv_map_close(&rowdata->indexes[i].map);
+    rowdata->indexes_count = 0;
+}
+
+
+/**
+ * @brief Reads secondary indexes records and opens indexes maps.
+ */
+static bool mdv_rowdata_indexes_load(mdv_rowdata *rowdata, mdv_transaction *transaction)
+{
+    rowdata->indexes_count = 0;
+
+    mdv_map_foreach(*transaction, rowdata->indexes_map, entry)
+    {
+        mdv_rowdata_index_rec rec;
+
+        if (entry.value.size != sizeof rec
+            || rowdata->indexes_count >= MDV_STRG_INDEXES_MAX)
+        {
+            MDV_LOGE("Invalid index record");
+            mdv_cursor_close(&entry.cursor);
+            mdv_rowdata_indexes_close(rowdata);
+            return false;
+        }
+
+        memcpy(&rec, entry.value.ptr, sizeof rec);
+
+        mdv_rowdata_index *index = rowdata->indexes + rowdata->indexes_count;
+
+        index->rec = rec;
+        index->map = mdv_map_open(transaction, MDV_MAP_INDEX(rec.desc.id), MDV_ROWDATA_INDEX_FLAGS);
+
+        if (!mdv_map_ok(index->map))
+        {
+            MDV_LOGE("Index map '%s' not opened", MDV_MAP_INDEX(rec.desc.id));
+            mdv_cursor_close(&entry.cursor);
+            mdv_rowdata_indexes_close(rowdata);
+            return false;
+        }
+
+        ++rowdata->indexes_count;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Reads the table description and the last row identifier.
+ * @details If the table description is provided, it is written to the storage if the storage doesn't contain it yet.
+ */
+static bool mdv_rowdata_init(mdv_rowdata *rowdata, mdv_table_base const *table)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(9);
+
+    mdv_transaction transaction = mdv_transaction_start(rowdata->storage);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("Rows storage transaction not started");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
+
+    uint32_t const flags = table ? MDV_MAP_CREATE : MDV_MAP_SILENT;
+
+    rowdata->table_map = mdv_map_open(&transaction, MDV_MAP_TABLE, flags | MDV_MAP_INTEGERKEY);
+
+    if (!mdv_map_ok(rowdata->table_map))
+    {
+        if (table)
+            MDV_LOGE("Table description map '%s' not opened", MDV_MAP_TABLE);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &rowdata->table_map);
+
+    rowdata->columns = mdv_map_open(&transaction, MDV_MAP_COLUMNS, MDV_MAP_CREATE);
+
+    if (!mdv_map_ok(rowdata->columns))
+    {
+        MDV_LOGE("Columns map '%s' not opened", MDV_MAP_COLUMNS);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &rowdata->columns);
+
+    rowdata->tail = mdv_map_open(&transaction, MDV_MAP_TAIL, MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+    if (!mdv_map_ok(rowdata->tail))
+    {
+        MDV_LOGE("Rows tail map '%s' not opened", MDV_MAP_TAIL);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &rowdata->tail);
+
+    rowdata->indexes_map = mdv_map_open(&transaction, MDV_MAP_INDEXES, MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+    if (!mdv_map_ok(rowdata->indexes_map))
+    {
+        MDV_LOGE("Indexes map '%s' not opened", MDV_MAP_INDEXES);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &rowdata->indexes_map);
+
+    rowdata->applied_map = mdv_map_open(&transaction, MDV_MAP_TABLE_APPLIED, MDV_MAP_CREATE);
+
+    if (!mdv_map_ok(rowdata->applied_map))
+    {
+        MDV_LOGE("Applied positions map '%s' not opened", MDV_MAP_TABLE_APPLIED);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &rowdata->applied_map);
+
+    if (!mdv_rowdata_indexes_load(rowdata, &transaction))
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_rowdata_indexes_close, rowdata);
+
+    static const uint64_t table_key_id = MDV_ROWDATA_TABLE_DESC;
+
+    mdv_data const table_key = { sizeof table_key_id, (void*)&table_key_id };
+
+    if (table)
+    {
+        binn obj;
+
+        if (!mdv_binn_table(table, &obj))
+        {
+            mdv_rollback(rollbacker);
+            return false;
+        }
+
+        mdv_data const value = { binn_size(&obj), binn_ptr(&obj) };
+
+        // Table description is written only once. Errors are ignored because the description might already exist.
+        mdv_map_put_unique(&rowdata->table_map, &transaction, &table_key, &value);
+
+        binn_free(&obj);
+    }
+
+    mdv_data table_desc = {};
+
+    if (!mdv_map_get(&rowdata->table_map, &transaction, &table_key, &table_desc))
+    {
+        MDV_LOGE("Table '%s' description not found", mdv_uuid_to_str(&rowdata->uuid).ptr);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    binn obj;
+
+    if (!binn_load(table_desc.ptr, &obj))
+    {
+        MDV_LOGE("Invalid table description");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    rowdata->table = mdv_unbinn_table(&obj);
+
+    binn_free(&obj);
+
+    if (!rowdata->table)
+    {
+        MDV_LOGE("Invalid table description");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, rowdata->table, "table");
+
+    rowdata->codec = mdv_row_codec_create(rowdata->table->fields, rowdata->table->size);
+
+    if (!rowdata->codec)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_row_codec_free, rowdata->codec);
+
+    if (!mdv_transaction_commit(&transaction))
+    {
+        MDV_LOGE("Rows storage transaction failed");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_free(rollbacker);
+
+    return true;
+}
+
+
+static mdv_rowdata * mdv_rowdata_open_impl(mdv_uuid const *uuid, mdv_table_base const *table)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(3);
+
+    mdv_rowdata *rowdata = mdv_alloc(sizeof(mdv_rowdata), "rowdata");
+
+    if (!rowdata)
+    {
+        MDV_LOGE("No free space of memory for rowdata");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, rowdata, "rowdata");
+
+    atomic_init(&rowdata->rc, 1);
+
+    rowdata->uuid = *uuid;
+
+    if (mdv_mutex_create(&rowdata->indexes_mutex) != MDV_OK)
+    {
+        MDV_LOGE("Indexes mutex not created");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &rowdata->indexes_mutex);
+
+    rowdata->storage = mdv_rowdata_storage_open(uuid);
+
+    if (!rowdata->storage)
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_storage_release, rowdata->storage);
+
+    if (!mdv_rowdata_init(rowdata, table))
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_free(rollbacker);
+
+    return rowdata;
+}
+
+
+mdv_rowdata * mdv_rowdata_create(mdv_table_base const *table)
+{
+    return mdv_rowdata_open_impl(&table->id, table);
+}
+
+
+mdv_rowdata * mdv_rowdata_open(mdv_uuid const *table_id)
+{
+    return mdv_rowdata_open_impl(table_id, 0);
+}
+
+
+mdv_rowdata * mdv_rowdata_retain(mdv_rowdata *rowdata)
+{
+    if (rowdata)
+        atomic_fetch_add_explicit(&rowdata->rc, 1, memory_order_relaxed);
+    return rowdata;
+}
+
+
+uint32_t mdv_rowdata_release(mdv_rowdata *rowdata)
+{
+    if (rowdata)
+    {
+        uint32_t rc = atomic_fetch_sub_explicit(&rowdata->rc, 1, memory_order_relaxed) - 1;
+
+        if (!rc)
+        {
+            mdv_rowdata_indexes_close(rowdata);
+            mdv_mutex_free(&rowdata->indexes_mutex);
+            mdv_map_close(&rowdata->applied_map);
+            mdv_map_close(&rowdata->indexes_map);
+            mdv_map_close(&rowdata->tail);
+            mdv_map_close(&rowdata->columns);
+            mdv_map_close(&rowdata->table_map);
+            mdv_storage_release(rowdata->storage);
+            mdv_row_codec_free(rowdata->codec);
+            mdv_free(rowdata->table, "table");
+            mdv_free(rowdata, "rowdata");
+        }
+
+        return rc;
+    }
+
+    return 0;
+}
+
+
+mdv_table_base const * mdv_rowdata_table(mdv_rowdata *rowdata)
+{
+    return rowdata->table;
+}
+
+
+mdv_row_codec const * mdv_rowdata_codec(mdv_rowdata *rowdata)
+{
+    return rowdata->codec;
+}
+
+
+mdv_storage * mdv_rowdata_storage(mdv_rowdata *rowdata)
+{
+    return rowdata->storage;
+}
+
+
+uint64_t mdv_rowdata_applied_pos(mdv_rowdata *rowdata, mdv_uuid const *trlog)
+{
+    mdv_transaction transaction = mdv_transaction_start_read(rowdata->storage);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("Rows storage transaction not started");
+        return 0;
+    }
+
+    mdv_data const key = { sizeof *trlog, (void*)trlog };
+    mdv_data value = {};
+
+    uint64_t pos = 0;
+
+    if (mdv_map_get(&rowdata->applied_map, &transaction, &key, &value))
+        memcpy(&pos, value.ptr, sizeof pos);
+
+    mdv_transaction_abort(&transaction);
+
+    return pos;
+}
+
+
+bool mdv_rowdata_applied_pos_set(mdv_rowdata *rowdata, mdv_transaction *transaction, mdv_uuid const *trlog, uint64_t pos)
+{
+    mdv_data const key = { sizeof *trlog, (void*)trlog };
+    mdv_data const value = { sizeof pos, &pos };
+
+    if (!mdv_map_put(&rowdata->applied_map, transaction, &key, &value))
+    {
+        MDV_LOGE("Applied position for table '%s' wasn't saved", mdv_uuid_to_str(&rowdata->uuid).ptr);
+        return false;
+    }
+
+    return true;
+}
+
+
+static uint64_t mdv_rowdata_rows_count(mdv_rowdata *rowdata, mdv_transaction *transaction)
+{
+    static const uint64_t key_id = MDV_ROWDATA_ROWS_COUNT;
+
+    mdv_data const key = { sizeof key_id, (void*)&key_id };
+    mdv_data value = {};
+
+    uint64_t count = 0;
+
+    if (mdv_map_get(&rowdata->table_map, transaction, &key, &value))
+        memcpy(&count, value.ptr, sizeof count);
+
+    return count;
+}
+
+
+static bool mdv_rowdata_rows_count_set(mdv_rowdata *rowdata, mdv_transaction *transaction, uint64_t count)
+{
+    static const uint64_t key_id = MDV_ROWDATA_ROWS_COUNT;
+
+    mdv_data const key = { sizeof key_id, (void*)&key_id };
+    mdv_data const value = { sizeof count, &count };
+
+    return mdv_map_put(&rowdata->table_map, transaction, &key, &value);
+}
+
+
+static bool mdv_rowdata_segment_get(mdv_rowdata     *rowdata,
+                                    mdv_transaction *transaction,
+                                    uint32_t         column,
+                                    uint64_t         segment,
+                                    mdv_column      *view)
+{
+    mdv_column_key const key_id = { column, segment };
+
+    mdv_data const key = { sizeof key_id, (void*)&key_id };
+    mdv_data value = {};
+
+    if (!mdv_map_get(&rowdata->columns, transaction, &key, &value))
+    {
+        MDV_LOGE("Column segment %u:%llu not found", column, (unsigned long long)segment);
+        return false;
+    }
+
+    return mdv_column_load(rowdata->table->fields + column, &value, view);
+}
+
+
+static bool mdv_rowdata_segment_put(mdv_rowdata        *rowdata,
+                                    mdv_transaction    *transaction,
+                                    uint32_t            column,
+                                    uint64_t            segment,
+                                    mdv_column_builder *builder)
+{
+    size_t const size = mdv_column_builder_size(builder);
+
+    void *buf = mdv_alloc(size, "column_segment");
+
+    if (!buf)
+    {
+        MDV_LOGE("No memory for column segment");
+        return false;
+    }
+
+    mdv_column_builder_serialize(builder, buf);
+
+    mdv_column_key const key_id = { column, segment };
+
+    mdv_data const key = { sizeof key_id, (void*)&key_id };
+    mdv_data const value = { size, buf };
+
+    bool const ret = mdv_map_put(&rowdata->columns, transaction, &key, &value);
+
+    mdv_free(buf, "column_segment");
+
+    return ret;
+}
+
+
+static void mdv_rowdata_builders_free(mdv_column_builder *builders, uint32_t count)
+{
+    for(uint32_t i = 0; i < count; ++i)
+        mdv_column_builder_free(builders + i);
+    mdv_free(builders, "column_builders");
+}
+
+
+/**
+ * @brief Creates column builders for the requested columns.
+ * @details If columns is NULL, the builders are created for the first count table columns.
+ */
+static mdv_column_builder * mdv_rowdata_builders_create(mdv_table_base const *table,
+                                                        uint32_t              count,
+                                                        uint32_t const       *columns)
+{
+    mdv_column_builder *builders = mdv_alloc(sizeof(mdv_column_builder) * count + 1, "column_builders");
+
+    if (!builders)
+    {
+        MDV_LOGE("No memory for column builders");
+        return 0;
+    }
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if (!mdv_column_builder_init(builders + i, table->fields + (columns ? columns[i] : i)))
+        {
+            mdv_rowdata_builders_free(builders, i);
+            return 0;
+        }
+    }
+
+    return builders;
+}
+
+
+/**
+ * @brief Reads the rows tail into the column builders.
+ * @details If columns is NULL, the first count columns are read.
+ */
+static bool mdv_rowdata_tail_read(mdv_rowdata        *rowdata,
+                                  mdv_transaction    *transaction,
+                                  uint32_t            count,
+                                  uint32_t const     *columns,
+                                  mdv_column_builder *builders)
+{
+    bool ret = true;
+
+    mdv_map_foreach(*transaction, rowdata->tail, entry)
+    {
+        mdv_row_base *row = mdv_row_codec_unpack(rowdata->codec, &entry.value);
+
+        if (!row)
+        {
+            MDV_LOGE("Invalid row in the rows tail");
+            ret = false;
+            mdv_map_foreach_break(entry);
+        }
+
+        for(uint32_t i = 0; ret && i < count; ++i)
+            ret = mdv_column_builder_add(builders + i, row->fields + (columns ? columns[i] : i));
+
+        mdv_free(row, "row");
+
+        if (!ret)
+            mdv_map_foreach_break(entry);
+    }
+
+    return ret;
+}
+
+
+/**
+ * @brief Builds the last incomplete columns segments from the rows tail.
+ * @details Segments are built in memory and should be freed by mdv_free(bufs[i], "column_segment").
+ */
+static bool mdv_rowdata_tail_get(mdv_rowdata     *rowdata,
+                                 mdv_transaction *transaction,
+                                 uint32_t         count,
+                                 uint32_t const  *columns,
+                                 mdv_column      *views,
+                                 void           **bufs)
+{
+    mdv_table_base const *table = rowdata->table;
+
+    mdv_column_builder *builders = mdv_rowdata_builders_create(table, count, columns);
+
+    if (!builders)
+        return false;
+
+    bool ret = mdv_rowdata_tail_read(rowdata, transaction, count, columns, builders);
+
+    uint32_t loaded = 0;
+
+    for(; ret && loaded < count; ++loaded)
+    {
+        size_t const size = mdv_column_builder_size(builders + loaded);
+
+        bufs[loaded] = mdv_alloc(size, "column_segment");
+
+        if (!bufs[loaded])
+        {
+            MDV_LOGE("No memory for column segment");
+            ret = false;
+            break;
+        }
+
+        mdv_column_builder_serialize(builders + loaded, bufs[loaded]);
+
+        mdv_data const segment = { size, bufs[loaded] };
+
+        if (!mdv_column_load(table->fields + columns[loaded], &segment, views + loaded))
+        {
+            mdv_free(bufs[loaded], "column_segment");
+            ret = false;
+            break;
+        }
+    }
+
+    mdv_rowdata_builders_free(builders, count);
+
+    if (!ret)
+    {
+        for(uint32_t i = 0; i < loaded; ++i)
+            mdv_free(bufs[i], "column_segment");
+    }
+
+    return ret;
+}
+
+
+static bool mdv_rowdata_tail_put(mdv_rowdata        *rowdata,
+                                 mdv_transaction    *transaction,
+                                 mdv_row_base const *row,
+                                 uint64_t            row_id)
+{
+    mdv_data packed;
+
+    if (!mdv_row_codec_pack(rowdata->codec, row, &packed))
+        return false;
+
+    mdv_data const key = { sizeof row_id, &row_id };
+
+    bool const ret = mdv_map_append(&rowdata->tail, transaction, &key, &packed);
+
+    mdv_free(packed.ptr, "packed_row");
+
+    return ret;
+}
+
+
+/**
+ * @brief Moves the full rows tail to the columns segments.
+ * @details Each segment is written once when its last row is added.
+ */
+static bool mdv_rowdata_tail_compact(mdv_rowdata *rowdata, mdv_transaction *transaction, uint64_t segment)
+{
+    mdv_table_base const *table = rowdata->table;
+
+    mdv_column_builder *builders = mdv_rowdata_builders_create(table, table->size, 0);
+
+    if (!builders)
+        return false;
+
+    bool ret = mdv_rowdata_tail_read(rowdata, transaction, table->size, 0, builders);
+
+    if (ret && builders[0].count != MDV_ROWDATA_SEGMENT_SIZE)
+    {
+        MDV_LOGE("Rows tail contains %u rows instead of %u", builders[0].count, MDV_ROWDATA_SEGMENT_SIZE);
+        ret = false;
+    }
+
+    for(uint32_t i = 0; ret && i < table->size; ++i)
+        ret = mdv_rowdata_segment_put(rowdata, transaction, i, segment, builders + i);
+
+    mdv_rowdata_builders_free(builders, table->size);
+
+    for(uint64_t row_id = segment * MDV_ROWDATA_SEGMENT_SIZE + 1;
+        ret && row_id <= (segment + 1) * MDV_ROWDATA_SEGMENT_SIZE;
+        ++row_id)
+    {
+        mdv_data const key = { sizeof row_id, &row_id };
+        ret = mdv_map_del(&rowdata->tail, transaction, &key, 0);
+    }
+
+    return ret;
+}
+
+
+static bool mdv_rowdata_fields_check(mdv_table_base const *table, mdv_row_base const *row)
+{
+    if (row->size != table->size)
+        return false;
+
+    for(uint32_t i = 0; i < table->size; ++i)
+    {
+        if (!mdv_column_value_check(table->fields + i, row->fields + i))
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool mdv_rowdata_index_put(mdv_rowdata       *rowdata,
+                                  mdv_transaction   *transaction,
+                                  mdv_rowdata_index *index,
+                                  mdv_data const    *values,
+                                  uint64_t           row_id)
+{
+    uint8_t buf[MDV_INDEX_KEY_MAX];
+    uint32_t size = 0;
+
+    if (!mdv_index_key(rowdata->table, &index->rec.desc, index->rec.desc.size, values, buf, &size))
+        return false;
+
+    mdv_data const key = { size, buf };
+    mdv_data const value = { sizeof row_id, &row_id };
+
+    return mdv_map_put(&index->map, transaction, &key, &value);
+}
+
+
+/**
+ * @brief Adds the row to all built secondary indexes.
+ * @details Indexes which are being built are skipped. Builder catches up on these rows.
+ *          Indexes mutex should be locked by caller.
+ */
+static bool mdv_rowdata_row_index(mdv_rowdata        *rowdata,
+                                  mdv_transaction    *transaction,
+                                  mdv_row_base const *row,
+                                  uint64_t            row_id)
+{
+    for(uint32_t i = 0; i < rowdata->indexes_count; ++i)
+    {
+        mdv_rowdata_index *index = rowdata->indexes + i;
+
+        if (!index->rec.ready)
+            continue;
+
+        mdv_data values[MDV_INDEX_FIELDS_MAX];
+
+        for(uint32_t j = 0; j < index->rec.desc.size; ++j)
+            values[j] = row->fields[index->rec.desc.fields[j]];
+
+        if (!mdv_rowdata_index_put(rowdata, transaction, index, values, row_id))
+        {
+            MDV_LOGE("Row %llu wasn't added to the index %u", (unsigned long long)row_id, index->rec.desc.id);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+mdv_row_base * mdv_rowdata_row_decode(mdv_rowdata *rowdata, mdv_data const *row)
+{
+    mdv_table_base const *table = rowdata->table;
+
+    mdv_row_base *decoded = mdv_row_codec_unpack(rowdata->codec, row);
+
+    if (!decoded || !mdv_rowdata_fields_check(table, decoded))
+    {
+        MDV_LOGE("Invalid row skipped");
+        mdv_free(decoded, "row");
+        return 0;
+    }
+
+    return decoded;
+}
+
+
+bool mdv_rowdata_row_check(mdv_rowdata *rowdata, mdv_data const *row)
+{
+    mdv_row_base *decoded = mdv_row_codec_unpack(rowdata->codec, row);
+
+    bool const ret = decoded
+                        && mdv_rowdata_fields_check(rowdata->table, decoded);
+
+    mdv_free(decoded, "row");
+
+    return ret;
+}
+
+
+bool mdv_rowdata_add(mdv_rowdata *rowdata, mdv_transaction *transaction, mdv_vector *rows)
+{
+    mdv_vector *decoded = mdv_vector_create(mdv_vector_size(rows) ? mdv_vector_size(rows) : 1,
+                                            sizeof(mdv_row_base*),
+                                            &mdv_default_allocator);
+
+    if (!decoded)
+    {
+        MDV_LOGE("No memory for rows");
+        return false;
+    }
+
+    bool ret = true;
+
+    mdv_vector_foreach(rows, mdv_data, data)
+    {
+        mdv_row_base *row = mdv_rowdata_row_decode(rowdata, data);
+
+        if (row && !mdv_vector_push_back(decoded, &row))
+        {
+            MDV_LOGE("No memory for rows");
+            mdv_free(row, "row");
+            ret = false;
+            break;
+        }
+    }
+
+    if (ret)
+        ret = mdv_rowdata_add_rows(rowdata, transaction, decoded);
+
+    mdv_row_base **decoded_rows = mdv_vector_data(decoded);
+
+    for(size_t i = 0; i < mdv_vector_size(decoded); ++i)
+        mdv_free(decoded_rows[i], "row");
+
+    mdv_vector_release(decoded);
+
+    return ret;
+}
+
+
+bool mdv_rowdata_add_rows(mdv_rowdata *rowdata, mdv_transaction *transaction, mdv_vector *rows)
+{
+    uint64_t count = mdv_rowdata_rows_count(rowdata, transaction);
+
+    if (mdv_mutex_lock(&rowdata->indexes_mutex) != MDV_OK)
+        return false;
+
+    bool ret = true;
+
+    mdv_row_base **decoded = mdv_vector_data(rows);
+
+    for(size_t n = 0; n < mdv_vector_size(rows); ++n)
+    {
+        mdv_row_base const *row = decoded[n];
+
+        if (!row)
+            continue;
+
+        // Indexes are updated within the same transaction as the rows
+        ret = mdv_rowdata_tail_put(rowdata, transaction, row, count + 1)
+                && mdv_rowdata_row_index(rowdata, transaction, row, count + 1);
+
+        if (!ret)
+            break;
+
+        if (++count % MDV_ROWDATA_SEGMENT_SIZE == 0)
+        {
+            ret = mdv_rowdata_tail_compact(rowdata, transaction, count / MDV_ROWDATA_SEGMENT_SIZE - 1);
+
+            if (!ret)
+                break;
+        }
+    }
+
+    mdv_mutex_unlock(&rowdata->indexes_mutex);
+
+    if (ret)
+        ret = mdv_rowdata_rows_count_set(rowdata, transaction, count);
+
+    if (!ret)
+        MDV_LOGE("Rows insertion failed");
+
+    return ret;
+}
+
+
+bool mdv_rowdata_scan(mdv_rowdata        *rowdata,
+                      mdv_transaction    *transaction,
+                      uint64_t            first_row,
+                      uint32_t            count,
+                      uint32_t const     *columns,
+                      void               *arg,
+                      mdv_rowdata_scan_fn fn)
+{
+    mdv_table_base const *table = rowdata->table;
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if (columns[i] >= table->size)
+        {
+            MDV_LOGE("Invalid column index: %u", columns[i]);
+            return false;
+        }
+    }
+
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(3);
+
+    mdv_column *views = mdv_alloc(sizeof(mdv_column) * count + 1, "column_views");
+
+    if (!views)
+    {
+        MDV_LOGE("No memory for column views");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, views, "column_views");
+
+    void **bufs = mdv_alloc(sizeof(void*) * count + 1, "column_bufs");
+
+    if (!bufs)
+    {
+        MDV_LOGE("No memory for column segments");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, bufs, "column_bufs");
+
+    mdv_transaction own_transaction = { 0 };
+
+    if (!transaction)
+    {
+        own_transaction = mdv_transaction_start_read(rowdata->storage);
+
+        if (!mdv_transaction_ok(own_transaction))
+        {
+            MDV_LOGE("Rows storage transaction not started");
+            mdv_rollback(rollbacker);
+            return false;
+        }
+
+        mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &own_transaction);
+
+        transaction = &own_transaction;
+    }
+
+    uint64_t const rows_count = mdv_rowdata_rows_count(rowdata, transaction);
+
+    bool ret = true;
+
+    uint64_t const first_segment = first_row ? (first_row - 1) / MDV_ROWDATA_SEGMENT_SIZE : 0;
+
+    for(uint64_t segment = first_segment; ret && segment * MDV_ROWDATA_SEGMENT_SIZE < rows_count; ++segment)
+    {
+        // The last incomplete segment is built from the rows tail
+        bool const tail = (segment + 1) * MDV_ROWDATA_SEGMENT_SIZE > rows_count;
+
+        if (tail)
+            ret = mdv_rowdata_tail_get(rowdata, transaction, count, columns, views, bufs);
+        else
+        {
+            for(uint32_t i = 0; ret && i < count; ++i)
+                ret = mdv_rowdata_segment_get(rowdata, transaction, columns[i], segment, views + i);
+        }
+
+        if (!ret)
+            break;
+
+        bool const next = fn(arg, segment * MDV_ROWDATA_SEGMENT_SIZE + 1, views);
+
+        for(uint32_t i = 0; tail && i < count; ++i)
+            mdv_free(bufs[i], "column_segment");
+
+        if (!next)
+            break;
+    }
+
+    mdv_rollback(rollbacker);
+
+    return ret;
+}
+
+
+/**
+ * @brief Reads the copy of column segment.
+ * @details Unlike mdv_rowdata_segment_get(), the copy remains valid after the transaction end or the storage updates.
+ */
+static bool mdv_rowdata_segment_copy(mdv_rowdata     *rowdata,
+                                     mdv_transaction *transaction,
+                                     uint32_t         column,
+                                     uint64_t         segment,
+                                     mdv_column      *view,
+                                     void           **buf)
+{
+    mdv_column_key const key_id = { column, segment };
+
+    mdv_data const key = { sizeof key_id, (void*)&key_id };
+    mdv_data value = {};
+
+    if (!mdv_map_get(&rowdata->columns, transaction, &key, &value))
+    {
+        MDV_LOGE("Column segment %u:%llu not found", column, (unsigned long long)segment);
+        return false;
+    }
+
+    *buf = mdv_alloc(value.size, "column_segment");
+
+    if (!*buf)
+    {
+        MDV_LOGE("No memory for column segment");
+        return false;
+    }
+
+    memcpy(*buf, value.ptr, value.size);
+
+    mdv_data const copy = { value.size, *buf };
+
+    if (!mdv_column_load(rowdata->table->fields + column, &copy, view))
+    {
+        mdv_free(*buf, "column_segment");
+        return false;
+    }
+
+    return true;
+}
+
+
+/// Indexed fields values handler
+typedef bool (*mdv_rowdata_index_row_fn)(void *arg, mdv_rowdata_index *index, mdv_data const *values, uint64_t row_id);
+
+
+/**
+ * @brief Reads indexed fields values of the rows [first + 1, last].
+ */
+static bool mdv_rowdata_index_rows(mdv_rowdata             *rowdata,
+                                   mdv_transaction         *transaction,
+                                   mdv_rowdata_index       *index,
+                                   uint64_t                 first,
+                                   uint64_t                 last,
+                                   void                    *arg,
+                                   mdv_rowdata_index_row_fn fn)
+{
+    uint32_t const size = index->rec.desc.size;
+
+    uint64_t const rows_count = mdv_rowdata_rows_count(rowdata, transaction);
+
+    bool ret = true;
+
+    for(uint64_t pos = first; ret && pos < last;)
+    {
+        uint64_t const segment = pos / MDV_ROWDATA_SEGMENT_SIZE;
+        uint64_t const end = (segment + 1) * MDV_ROWDATA_SEGMENT_SIZE < last
+                                ? (segment + 1) * MDV_ROWDATA_SEGMENT_SIZE
+                                : last;
+
+        mdv_column views[MDV_INDEX_FIELDS_MAX];
+        void *bufs[MDV_INDEX_FIELDS_MAX];
+        uint32_t loaded = 0;
+
+        if ((segment + 1) * MDV_ROWDATA_SEGMENT_SIZE > rows_count)
+        {
+            if (mdv_rowdata_tail_get(rowdata, transaction, size, index->rec.desc.fields, views, bufs))
+                loaded = size;
+        }
+        else
+        {
+            while(loaded < size
+                  && mdv_rowdata_segment_copy(rowdata, transaction, index->rec.desc.fields[loaded], segment, views + loaded, bufs + loaded))
+                ++loaded;
+        }
+
+        ret = loaded == size;
+
+        if (ret && views[0].count < end - segment * MDV_ROWDATA_SEGMENT_SIZE)
+        {
+            MDV_LOGE("Column segment %llu is too short", (unsigned long long)segment);
+            ret = false;
+        }
+
+        for(; ret && pos < end; ++pos)
+        {
+            uint32_t const idx = (uint32_t)(pos - segment * MDV_ROWDATA_SEGMENT_SIZE);
+
+            mdv_data values[MDV_INDEX_FIELDS_MAX];
+
+            for(uint32_t j = 0; j < size; ++j)
+                values[j] = mdv_column_value(views + j, idx);
+
+            ret = fn(arg, index, values, pos + 1);
+        }
+
+        for(uint32_t j = 0; j < loaded; ++j)
+            mdv_free(bufs[j], "column_segment");
+    }
+
+    return ret;
+}
+
+
+/// Index entries which are prepared by builder outside of the write transaction
+typedef struct
+{
+    mdv_rowdata *rowdata;               ///< Rows storage
+    mdv_vector  *entries;               ///< Packed entries (vector<uint8_t>): { row_id, key size, key }
+} mdv_rowdata_index_batch;
+
+
+static bool mdv_rowdata_index_batch_add(void *arg, mdv_rowdata_index *index, mdv_data const *values, uint64_t row_id)
+{
+    mdv_rowdata_index_batch *batch = arg;
+
+    uint8_t buf[sizeof row_id + sizeof(uint32_t) + MDV_INDEX_KEY_MAX];
+    uint32_t size = 0;
+
+    if (!mdv_index_key(batch->rowdata->table,
+                       &index->rec.desc,
+                       index->rec.desc.size,
+                       values,
+                       buf + sizeof row_id + sizeof size,
+                       &size))
+        return false;
+
+    memcpy(buf, &row_id, sizeof row_id);
+    memcpy(buf + sizeof row_id, &size, sizeof size);
+
+    if (!mdv_vector_append(batch->entries, buf, sizeof row_id + sizeof size + size))
+    {
+        MDV_LOGE("No memory for index entries");
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool mdv_rowdata_index_row_put(void *arg, mdv_rowdata_index *index, mdv_data const *values, uint64_t row_id)
+{
+    void **args = arg;
+    return mdv_rowdata_index_put(args[0], args[1], index, values, row_id);
+}
+
+
+static bool mdv_rowdata_index_save(mdv_rowdata             *rowdata,
+                                   mdv_transaction         *transaction,
+                                   mdv_rowdata_index_rec const *rec)
+{
+    mdv_data const key = { sizeof rec->desc.id, (void*)&rec->desc.id };
+    mdv_data const value = { sizeof *rec, (void*)rec };
+
+    return mdv_map_put(&rowdata->indexes_map, transaction, &key, &value);
+}
+
+
+bool mdv_rowdata_index_create(mdv_rowdata    *rowdata,
+                              uint32_t        count,
+                              uint32_t const *fields,
+                              uint32_t       *index_id)
+{
+    if (!count || count > MDV_INDEX_FIELDS_MAX)
+    {
+        MDV_LOGE("Invalid number of indexed fields: %u", count);
+        return false;
+    }
+
+    mdv_rowdata_index_rec rec = { .desc = { .size = count } };
+
+    memcpy(rec.desc.fields, fields, count * sizeof *fields);
+
+    if (!mdv_index_desc_check(rowdata->table, &rec.desc))
+        return false;
+
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(3);
+
+    // Write transaction is started before the mutex locking (see mdv_rowdata_add())
+    mdv_transaction transaction = mdv_transaction_start(rowdata->storage);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("Rows storage transaction not started");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
+
+    if (mdv_mutex_lock(&rowdata->indexes_mutex) != MDV_OK)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_unlock, &rowdata->indexes_mutex);
+
+    for(uint32_t i = 0; i < rowdata->indexes_count; ++i)
+    {
+        mdv_index_desc const *desc = &rowdata->indexes[i].rec.desc;
+
+        if (desc->size == rec.desc.size
+            && memcmp(desc->fields, rec.desc.fields, rec.desc.size * sizeof *rec.desc.fields) == 0)
+        {
+            *index_id = desc->id;
+            mdv_rollback(rollbacker);
+            return true;
+        }
+    }
+
+    if (rowdata->indexes_count >= MDV_STRG_INDEXES_MAX)
+    {
+        MDV_LOGE("Too many indexes for the table '%s'", mdv_uuid_to_str(&rowdata->uuid).ptr);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    rec.desc.id = rowdata->indexes_count;
+
+    // Index for empty table is ready immediately
+    rec.ready = mdv_rowdata_rows_count(rowdata, &transaction) == 0;
+
+    mdv_rowdata_index *index = rowdata->indexes + rowdata->indexes_count;
+
+    index->rec = rec;
+    index->map = mdv_map_open(&transaction, MDV_MAP_INDEX(rec.desc.id), MDV_ROWDATA_INDEX_FLAGS);
+
+    if (!mdv_map_ok(index->map))
+    {
+        MDV_LOGE("Index map '%s' not opened", MDV_MAP_INDEX(rec.desc.id));
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &index->map);
+
+    if (!mdv_rowdata_index_save(rowdata, &transaction, &rec))
+    {
+        MDV_LOGE("Index record wasn't saved");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    if (!mdv_transaction_commit(&transaction))
+    {
+        MDV_LOGE("Rows storage transaction failed");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    // Index is published while the mutex is locked, so new rows can't miss it
+    ++rowdata->indexes_count;
+
+    mdv_mutex_unlock(&rowdata->indexes_mutex);
+
+    mdv_rollbacker_free(rollbacker);
+
+    *index_id = rec.desc.id;
+
+    return true;
+}
+
+
+/**
+ * @brief Reads the next batch of rows from the snapshot and prepares index entries.
+ */
+static bool mdv_rowdata_index_prepare(mdv_rowdata             *rowdata,
+                                      mdv_rowdata_index       *index,
+                                      uint64_t                 batch_size,
+                                      mdv_rowdata_index_batch *batch)
+{
+    mdv_transaction transaction = mdv_transaction_start_read(rowdata->storage);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("Rows storage transaction not started");
+        return false;
+    }
+
+    uint64_t const rows_count = mdv_rowdata_rows_count(rowdata, &transaction);
+
+    uint64_t const first = index->rec.built;
+    uint64_t const last = rows_count - first > batch_size
+                            ? first + batch_size
+                            : rows_count;
+
+    bool const ret = mdv_rowdata_index_rows(rowdata,
+                                            &transaction,
+                                            index,
+                                            first,
+                                            last,
+                                            batch,
+                                            mdv_rowdata_index_batch_add);
+
+    mdv_transaction_abort(&transaction);
+
+    return ret;
+}
+
+
+/**
+ * @brief Writes prepared index entries and catches up on the rows added after the snapshot.
+ * @details Indexes mutex should be locked by caller.
+ */
+static bool mdv_rowdata_index_write(mdv_rowdata             *rowdata,
+                                    mdv_transaction         *transaction,
+                                    mdv_rowdata_index       *index,
+                                    uint64_t                 batch_size,
+                                    mdv_rowdata_index_batch *batch,
+                                    mdv_rowdata_index_rec   *rec)
+{
+    uint8_t const *ptr = mdv_vector_data(batch->entries);
+    uint8_t const *end = ptr + mdv_vector_size(batch->entries);
+
+    while(ptr < end)
+    {
+        uint64_t row_id;
+        uint32_t size;
+
+        memcpy(&row_id, ptr, sizeof row_id);
+        memcpy(&size, ptr + sizeof row_id, sizeof size);
+
+        mdv_data const key = { size, (void*)(ptr + sizeof row_id + sizeof size) };
+        mdv_data const value = { sizeof row_id, &row_id };
+
+        ptr += sizeof row_id + sizeof size + size;
+
+        // Rows might be indexed by another builder
+        if (row_id <= rec->built)
+            continue;
+
+        if (!mdv_map_put(&index->map, transaction, &key, &value))
+            return false;
+
+        rec->built = row_id;
+    }
+
+    uint64_t const rows_count = mdv_rowdata_rows_count(rowdata, transaction);
+
+    // The rest of rows is indexed within the write transaction and the index is marked ready.
+    // Committer can't add new rows until the transaction is committed.
+    if (rows_count - rec->built <= batch_size)
+    {
+        void *args[] = { rowdata, transaction };
+
+        if (!mdv_rowdata_index_rows(rowdata,
+                                    transaction,
+                                    index,
+                                    rec->built,
+                                    rows_count,
+                                    args,
+                                    mdv_rowdata_index_row_put))
+            return false;
+
+        rec->built = rows_count;
+        rec->ready = 1;
+    }
+
+    return mdv_rowdata_index_save(rowdata, transaction, rec);
+}
+
+
+bool mdv_rowdata_index_build(mdv_rowdata *rowdata, uint32_t index_id, uint32_t batch_size, bool *ready)
+{
+    mdv_rowdata_index_state state;
+
+    if (!mdv_rowdata_index_progress(rowdata, index_id, &state))
+        return false;
+
+    *ready = state.ready;
+
+    if (state.ready)
+        return true;
+
+    if (!batch_size)
+        batch_size = MDV_ROWDATA_SEGMENT_SIZE;
+
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(4);
+
+    mdv_rowdata_index_batch batch =
+    {
+        .rowdata = rowdata,
+        .entries = mdv_vector_create(batch_size * 32, sizeof(uint8_t), &mdv_default_allocator)
+    };
+
+    if (!batch.entries)
+    {
+        MDV_LOGE("No memory for index entries");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_vector_release, batch.entries);
+
+    // Index map and description are immutable. Only the record is changed by builders.
+    mdv_rowdata_index index;
+
+    if (mdv_mutex_lock(&rowdata->indexes_mutex) != MDV_OK)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    index = rowdata->indexes[index_id];
+
+    mdv_mutex_unlock(&rowdata->indexes_mutex);
+
+    // Keys are prepared using the read snapshot, so the committer isn't blocked
+    if (!mdv_rowdata_index_prepare(rowdata, &index, batch_size, &batch))
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_transaction transaction = mdv_transaction_start(rowdata->storage);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("Rows storage transaction not started");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
+
+    if (mdv_mutex_lock(&rowdata->indexes_mutex) != MDV_OK)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_unlock, &rowdata->indexes_mutex);
+
+    mdv_rowdata_index_rec rec = rowdata->indexes[index_id].rec;
+
+    if (!rec.ready
+        && !mdv_rowdata_index_write(rowdata, &transaction, &index, batch_size, &batch, &rec))
+    {
+        MDV_LOGE("Index %u wasn't built", index_id);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    if (!mdv_transaction_commit(&transaction))
+    {
+        MDV_LOGE("Rows storage transaction failed");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    // New index state is published while the mutex is locked, so new rows can't miss the index
+    rowdata->indexes[index_id].rec = rec;
+
+    *ready = rec.ready;
+
+    mdv_rollback(rollbacker);
+
+    return true;
+}
+
+
+bool mdv_rowdata_index_progress(mdv_rowdata *rowdata, uint32_t index_id, mdv_rowdata_index_state *state)
+{
+    bool found = false;
+
+    if (mdv_mutex_lock(&rowdata->indexes_mutex) == MDV_OK)
+    {
+        if (index_id < rowdata->indexes_count)
+        {
+            mdv_rowdata_index_rec const *rec = &rowdata->indexes[index_id].rec;
+            state->ready = rec->ready;
+            state->built = rec->built;
+            found = true;
+        }
+
+        mdv_mutex_unlock(&rowdata->indexes_mutex);
+    }
+
+    if (!found)
+    {
+        MDV_LOGE("Index %u not found", index_id);
+        return false;
+    }
+
+    if (!state->ready)
+    {
+        mdv_transaction transaction = mdv_transaction_start_read(rowdata->storage);
+
+        if (!mdv_transaction_ok(transaction))
+        {
+            MDV_LOGE("Rows storage transaction not started");
+            return false;
+        }
+
+        state->rows = mdv_rowdata_rows_count(rowdata, &transaction);
+
+        mdv_transaction_abort(&transaction);
+    }
+    else
+        state->rows = state->built;
+
+    return true;
+}
+
+
+uint32_t mdv_rowdata_indexes_count(mdv_rowdata *rowdata)
+{
+    uint32_t count = 0;
+
+    if (mdv_mutex_lock(&rowdata->indexes_mutex) == MDV_OK)
+    {
+        count = rowdata->indexes_count;
+        mdv_mutex_unlock(&rowdata->indexes_mutex);
+    }
+
+    return count;
+}
+
+
+static bool mdv_rowdata_index_get(mdv_rowdata *rowdata, uint32_t index_id, mdv_rowdata_index *index)
+{
+    bool found = false;
+
+    if (mdv_mutex_lock(&rowdata->indexes_mutex) == MDV_OK)
+    {
+        if (index_id < rowdata->indexes_count)
+        {
+            *index = rowdata->indexes[index_id];
+            found = true;
+        }
+
+        mdv_mutex_unlock(&rowdata->indexes_mutex);
+    }
+
+    if (!found)
+        MDV_LOGE("Index %u not found", index_id);
+    else if (!index->rec.ready)
+    {
+        MDV_LOGE("Index %u is not ready", index_id);
+        found = false;
+    }
+
+    return found;
+}
+
+
+bool mdv_rowdata_index_lookup(mdv_rowdata          *rowdata,
+                              uint32_t              index_id,
+                              mdv_row_base const   *from,
+                              mdv_row_base const   *to,
+                              void                 *arg,
+                              mdv_rowdata_index_fn  fn)
+{
+    mdv_rowdata_index index;
+
+    if (!mdv_rowdata_index_get(rowdata, index_id, &index))
+        return false;
+
+    uint8_t from_key[MDV_INDEX_KEY_MAX];
+    uint8_t to_key[MDV_INDEX_KEY_MAX];
+
+    uint32_t from_size = 0;
+    uint32_t to_size = 0;
+
+    if (from && !mdv_index_key(rowdata->table, &index.rec.desc, from->size, from->fields, from_key, &from_size))
+        return false;
+
+    if (to && !mdv_index_key(rowdata->table, &index.rec.desc, to->size, to->fields, to_key, &to_size))
+        return false;
+
+    mdv_transaction transaction = mdv_transaction_start_read(rowdata->storage);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("Rows storage transaction not started");
+        return false;
+    }
+
+    mdv_data key = { from_size, from_key };
+    mdv_data value = {};
+
+    mdv_cursor cursor = from_size
+                            ? mdv_cursor_open_explicit(&index.map, &transaction, &key, &value, MDV_SET_RANGE)
+                            : mdv_cursor_open_first(&index.map, &transaction, &key, &value);
+
+    bool ret = true;
+
+    if (mdv_cursor_ok(cursor))
+    {
+        do
+        {
+            // Keys which start with the upper bound are in the range
+            if (to && memcmp(key.ptr, to_key, key.size < to_size ? key.size : to_size) > 0)
+                break;
+
+            uint64_t row_id;
+
+            if (value.size != sizeof row_id)
+            {
+                MDV_LOGE("Invalid index %u entry", index_id);
+                ret = false;
+                break;
+            }
+
+            memcpy(&row_id, value.ptr, sizeof row_id);
+
+            if (!fn(arg, row_id))
+                break;
+        }
+        while(mdv_cursor_get(&cursor, &key, &value, MDV_CURSOR_NEXT));
+
+        mdv_cursor_close(&cursor);
+    }
+
+    mdv_transaction_abort(&transaction);
+
+    return ret;
+}
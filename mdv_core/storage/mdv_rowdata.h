@@ -0,0 +1,316 @@
+/**
+ * @file
+ * @brief Table rows storage.
+ * @details Each table has its own rows storage which contains the table description and the rows data.
+ *          Rows are stored by columns (see mdv_column.h). Each column is divided into segments
+ *          of MDV_ROWDATA_SEGMENT_SIZE rows. Column segment is identified by column index and segment number.
+ *          Rows of the last incomplete segment are kept packed in the rows tail, so the commits don't rewrite
+ *          the segments. When the tail is full, it is moved to the columns segments. Readers build the last
+ *          segment from the tail.
+ *          Row identifiers are row positions in the table starting from 1.
+ *
+ *          Secondary indexes (see mdv_index.h) are stored in the same storage as dup-sorted maps
+ *          (Key -> row identifiers) and are updated within the same transaction as the rows.
+ *          New index is built online: existing rows are indexed in small batches by mdv_rowdata_index_build(),
+ *          while the rows which are added meanwhile are caught up by the last batch.
+*/
+#pragma once
+#include "mdv_storage.h"
+#include "mdv_column.h"
+#include "mdv_index.h"
+#include <mdv_types.h>
+#include <mdv_packed_row.h>
+#include <mdv_uuid.h>
+#include <mdv_vector.h>
+
+
+/// Number of rows in column segment
+#define MDV_ROWDATA_SEGMENT_SIZE 1024
+
+
+/// Table rows storage
+typedef struct mdv_rowdata mdv_rowdata;
+
+
+/**
+ * @brief Creates new rows storage for the table.
+ * @details If the storage already exists, it is opened and the table description is not overwritten.
+ *
+ * @param table [in]    Table description
+ *
+ * @return On success, return non-null pointer to the rows storage
+ * @return On error, return NULL
+ */
+mdv_rowdata * mdv_rowdata_create(mdv_table_base const *table);
+
+
+/**
+ * @brief Opens existing rows storage for the table.
+ *
+ * @param table_id [in] Table identifier
+ *
+ * @return On success, return non-null pointer to the rows storage
+ * @return On error or if the table storage doesn't exist, return NULL
+ */
+mdv_rowdata * mdv_rowdata_open(mdv_uuid const *table_id);
+
+
+/**
+ * @brief Retains rows storage.
+ * @details Reference counter is increased by one.
+ */
+mdv_rowdata * mdv_rowdata_retain(mdv_rowdata *rowdata);
+
+
+/**
+ * @brief Releases rows storage.
+ * @details Reference counter is decreased by one.
+ *          When the reference counter reaches zero, the rows storage is closed and freed.
+ */
+uint32_t mdv_rowdata_release(mdv_rowdata *rowdata);
+
+
+/**
+ * @brief Returns table description.
+ */
+mdv_table_base const * mdv_rowdata_table(mdv_rowdata *rowdata);
+
+
+/**
+ * @brief Returns rows codec compiled for the table fields.
+ */
+mdv_row_codec const * mdv_rowdata_codec(mdv_rowdata *rowdata);
+
+
+/**
+ * @brief Returns key-value storage which is used for rows storing.
+ * @details This storage should be used for transactions starting.
+ */
+mdv_storage * mdv_rowdata_storage(mdv_rowdata *rowdata);
+
+
+/**
+ * @brief Adds new packed rows to the storage.
+ * @details Data is written within the transaction provided by caller.
+ *          Rows are appended to the rows tail which is split by columns when the segment is full.
+ *          Invalid rows are skipped.
+ *
+ * @param rowdata [in]      Rows storage
+ * @param transaction [in]  Write transaction started for mdv_rowdata_storage()
+ * @param rows [in]         Packed rows (vector<mdv_data>, see mdv_packed_row.h)
+ *
+ * @return true if rows were successfully written
+ * @return false if error was happened
+ */
+bool mdv_rowdata_add(mdv_rowdata *rowdata, mdv_transaction *transaction, mdv_vector *rows);
+
+
+/**
+ * @brief Unpacks row and checks it against the table schema.
+ * @details Rows can be decoded without any transaction, so the decoding can be done
+ *          concurrently and out of the write transaction.
+ *
+ * @param rowdata [in]  Rows storage
+ * @param row [in]      Packed row
+ *
+ * @return On success, returns decoded row which should be freed by mdv_free(row, "row")
+ * @return If the row is invalid, returns NULL
+ */
+mdv_row_base * mdv_rowdata_row_decode(mdv_rowdata *rowdata, mdv_data const *row);
+
+
+/**
+ * @brief Checks packed row against the table schema.
+ * @details Rows are checked by the same rules as mdv_rowdata_row_decode() uses,
+ *          so the row which passed the check is never skipped by the storage.
+ *
+ * @param rowdata [in]  Rows storage
+ * @param row [in]      Packed row
+ *
+ * @return true if the row is valid
+ */
+bool mdv_rowdata_row_check(mdv_rowdata *rowdata, mdv_data const *row);
+
+
+/**
+ * @brief Adds new decoded rows to the storage.
+ * @details Rows are decoded by mdv_rowdata_row_decode(). NULL rows are skipped.
+ *          Ownership isn't transferred, the rows should be freed by the caller.
+ *
+ * @param rowdata [in]      Rows storage
+ * @param transaction [in]  Write transaction started for mdv_rowdata_storage()
+ * @param rows [in]         Decoded rows (vector<mdv_row_base*>)
+ *
+ * @return true if rows were successfully written
+ * @return false if error was happened
+ */
+bool mdv_rowdata_add_rows(mdv_rowdata *rowdata, mdv_transaction *transaction, mdv_vector *rows);
+
+
+/**
+ * @brief Returns the last transaction log record applied to the table.
+ *
+ * @param rowdata [in]  Rows storage
+ * @param trlog [in]    Transaction log storage UUID
+ *
+ * @return Last applied record identifier. Zero if nothing was applied.
+ */
+uint64_t mdv_rowdata_applied_pos(mdv_rowdata *rowdata, mdv_uuid const *trlog);
+
+
+/**
+ * @brief Saves the last transaction log record applied to the table.
+ * @details Position is saved in the same transaction as the applied rows,
+ *          so the transaction log records are applied to the table exactly once.
+ *
+ * @param rowdata [in]      Rows storage
+ * @param transaction [in]  Write transaction started for mdv_rowdata_storage()
+ * @param trlog [in]        Transaction log storage UUID
+ * @param pos [in]          Last applied record identifier
+ *
+ * @return true if the position was saved
+ */
+bool mdv_rowdata_applied_pos_set(mdv_rowdata *rowdata, mdv_transaction *transaction, mdv_uuid const *trlog, uint64_t pos);
+
+
+/**
+ * @brief Columns segments handler for rows scanning.
+ *
+ * @param arg [in]          User defined argument
+ * @param first_row [in]    First row identifier in segment
+ * @param columns [in]      Requested columns segments. All segments contain the same number of values.
+ *
+ * @return true to continue scanning or false to stop
+ */
+typedef bool (*mdv_rowdata_scan_fn)(void *arg, uint64_t first_row, mdv_column const *columns);
+
+
+/**
+ * @brief Scans table rows.
+ * @details Only requested columns are read. Scan starts from the segment which contains the first_row,
+ *          so the handler should skip the rows before first_row.
+ *
+ * @param rowdata [in]      Rows storage
+ * @param transaction [in]  Read-only transaction started for mdv_rowdata_storage() (e.g. snapshot transaction).
+ *                          If NULL, the rows are read from the new read-only transaction.
+ * @param first_row [in]    First row identifier
+ * @param count [in]        Requested columns count
+ * @param columns [in]      Requested columns indices
+ * @param arg [in]          User defined argument which is passed to the handler
+ * @param fn [in]           Columns segments handler
+ *
+ * @return true if scan was successfully completed
+ * @return false if error was happened
+ */
+bool mdv_rowdata_scan(mdv_rowdata        *rowdata,
+                      mdv_transaction    *transaction,
+                      uint64_t            first_row,
+                      uint32_t            count,
+                      uint32_t const     *columns,
+                      void               *arg,
+                      mdv_rowdata_scan_fn fn);
+
+
+/**
+ * @brief Creates secondary index on the table fields.
+ * @details Index is only registered, so this function returns quickly. Index for a table with rows
+ *          isn't ready for lookups until it is built by mdv_rowdata_index_build().
+ *          When the index is ready, new rows are added to the index by mdv_rowdata_add().
+ *          If the index on the same fields already exists, its identifier is returned.
+ *
+ * @param rowdata [in]      Rows storage
+ * @param count [in]        Number of indexed fields
+ * @param fields [in]       Indexed fields indices
+ * @param index_id [out]    Index identifier
+ *
+ * @return true if index was successfully created
+ * @return false if error was happened
+ */
+bool mdv_rowdata_index_create(mdv_rowdata    *rowdata,
+                              uint32_t        count,
+                              uint32_t const *fields,
+                              uint32_t       *index_id);
+
+
+/**
+ * @brief Adds the next batch of existing rows to the secondary index.
+ * @details Rows are read from the snapshot, so the rows writer isn't blocked while the batch is prepared.
+ *          Prepared entries are written within a short write transaction. When less than batch_size
+ *          rows remain, they are indexed within the same transaction and the index becomes ready.
+ *          The function is called repeatedly until the index is ready. Concurrent calls for the same
+ *          index are safe.
+ *
+ * @param rowdata [in]      Rows storage
+ * @param index_id [in]     Index identifier
+ * @param batch_size [in]   Number of rows in the batch
+ * @param ready [out]       Index is ready
+ *
+ * @return true if the batch was successfully processed
+ * @return false if error was happened
+ */
+bool mdv_rowdata_index_build(mdv_rowdata *rowdata, uint32_t index_id, uint32_t batch_size, bool *ready);
+
+
+/// Secondary index state
+typedef struct
+{
+    bool     ready;     ///< Index is built and ready for lookups
+    uint64_t built;     ///< Number of rows added to the index
+    uint64_t rows;      ///< Number of rows in the table
+} mdv_rowdata_index_state;
+
+
+/**
+ * @brief Returns secondary index state (i.e. the building progress).
+ *
+ * @param rowdata [in]      Rows storage
+ * @param index_id [in]     Index identifier
+ * @param state [out]       Index state
+ *
+ * @return true if index state was successfully read
+ * @return false if index doesn't exist
+ */
+bool mdv_rowdata_index_progress(mdv_rowdata *rowdata, uint32_t index_id, mdv_rowdata_index_state *state);
+
+
+/**
+ * @brief Returns the number of secondary indexes. Index identifiers are in range [0, count).
+ */
+uint32_t mdv_rowdata_indexes_count(mdv_rowdata *rowdata);
+
+
+/**
+ * @brief Row identifiers handler for index lookups.
+ *
+ * @param arg [in]          User defined argument
+ * @param row_id [in]       Row identifier
+ *
+ * @return true to continue lookup or false to stop
+ */
+typedef bool (*mdv_rowdata_index_fn)(void *arg, uint64_t row_id);
+
+
+/**
+ * @brief Looks up rows by secondary index.
+ * @details Bounds contain the values of the first indexed fields. Rows whose indexed fields
+ *          are between the bounds (inclusive) are passed to the handler in index order.
+ *          Row identifiers with equal keys are passed in ascending order.
+ *          For equality lookup the same bound should be used for from and to.
+ *          Lookup fails if the index isn't built yet.
+ *
+ * @param rowdata [in]      Rows storage
+ * @param index_id [in]     Index identifier
+ * @param from [in]         Lower bound. If NULL, the lookup starts from the first key.
+ * @param to [in]           Upper bound. If NULL, the lookup goes up to the last key.
+ * @param arg [in]          User defined argument which is passed to the handler
+ * @param fn [in]           Row identifiers handler
+ *
+ * @return true if lookup was successfully completed
+ * @return false if error was happened
+ */
+bool mdv_rowdata_index_lookup(mdv_rowdata          *rowdata,
+                              uint32_t              index_id,
+                              mdv_row_base const   *from,
+                              mdv_row_base const   *to,
+                              void                 *arg,
+                              mdv_rowdata_index_fn  fn);
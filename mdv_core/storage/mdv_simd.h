@@ -0,0 +1,43 @@
+/**
+ * @file
+ * @brief Internal helpers for the SIMD kernels of the columns filter and aggregator.
+ * @details Instruction sets are enabled per function with the target attributes,
+ *          so the kernels are compiled without extra compiler flags and selected at runtime
+ *          (see mdv_filter_isa_best()).
+*/
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define MDV_SIMD_X86
+#   include <immintrin.h>
+#   define MDV_SSE2 __attribute__((target("sse2")))
+#   define MDV_AVX2 __attribute__((target("avx2")))
+#endif
+
+
+/*
+ * Unaligned values loading
+ */
+#define MDV_SIMD_LOAD(name, T)                                              \
+    static inline T mdv_ld_##name(void const *p)                            \
+    {                                                                       \
+        T v;                                                                \
+        memcpy(&v, p, sizeof v);                                            \
+        return v;                                                           \
+    }
+
+MDV_SIMD_LOAD(i8,  int8_t)
+MDV_SIMD_LOAD(u8,  uint8_t)
+MDV_SIMD_LOAD(i16, int16_t)
+MDV_SIMD_LOAD(u16, uint16_t)
+MDV_SIMD_LOAD(i32, int32_t)
+MDV_SIMD_LOAD(u32, uint32_t)
+MDV_SIMD_LOAD(i64, int64_t)
+MDV_SIMD_LOAD(u64, uint64_t)
+MDV_SIMD_LOAD(f32, float)
+MDV_SIMD_LOAD(f64, double)
+
+#undef MDV_SIMD_LOAD
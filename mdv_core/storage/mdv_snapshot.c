@@ -0,0 +1,253 @@
+#include "mdv_snapshot.h"
+#include <mdv_alloc.h>
+#include <mdv_hashmap.h>
+#include <mdv_mutex.h>
+#include <mdv_rollbacker.h>
+#include <mdv_log.h>
+#include <stdatomic.h>
+
+
+/// Read snapshot
+struct mdv_snapshot
+{
+    atomic_uint_fast32_t    rc;         ///< References counter
+    uint64_t                id;         ///< Snapshot identifier
+    uint64_t                epoch;      ///< Tablespace changes epoch at the moment of the snapshot creation
+    mdv_mutex               mutex;      ///< Pinned tables and transactions guard
+    mdv_hashmap            *tables;     ///< Pinned tables (Table UUID -> mdv_snapshot_table)
+    mdv_hashmap            *positions;  ///< Transaction logs applied positions (Storage UUID -> mdv_snapshot_position)
+};
+
+
+/// Pinned table
+typedef struct
+{
+    mdv_uuid        uuid;           ///< Table UUID
+    mdv_rowdata    *rowdata;        ///< Table rows storage
+    mdv_transaction transaction;    ///< Pinned read-only transaction
+} mdv_snapshot_table;
+
+
+/// Transaction log applied position
+typedef struct
+{
+    mdv_uuid        uuid;           ///< Transaction log storage UUID
+    uint64_t        pos;            ///< Last applied record identifier
+} mdv_snapshot_pos;
+
+
+mdv_snapshot * mdv_snapshot_create(uint64_t id, uint64_t epoch)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(4);
+
+    mdv_snapshot *snapshot = mdv_alloc(sizeof(mdv_snapshot), "snapshot");
+
+    if (!snapshot)
+    {
+        MDV_LOGE("No memory for snapshot");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, snapshot, "snapshot");
+
+    atomic_init(&snapshot->rc, 1);
+
+    snapshot->id = id;
+    snapshot->epoch = epoch;
+
+    if (mdv_mutex_create(&snapshot->mutex) != MDV_OK)
+    {
+        MDV_LOGE("Snapshot mutex not created");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &snapshot->mutex);
+
+    snapshot->tables = mdv_hashmap_create(mdv_snapshot_table,
+                                          uuid,
+                                          16,
+                                          mdv_uuid_hash,
+                                          mdv_uuid_cmp);
+
+    if (!snapshot->tables)
+    {
+        MDV_LOGE("No memory for snapshot");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_hashmap_release, snapshot->tables);
+
+    snapshot->positions = mdv_hashmap_create(mdv_snapshot_pos,
+                                             uuid,
+                                             4,
+                                             mdv_uuid_hash,
+                                             mdv_uuid_cmp);
+
+    if (!snapshot->positions)
+    {
+        MDV_LOGE("No memory for snapshot");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_free(rollbacker);
+
+    return snapshot;
+}
+
+
+mdv_snapshot * mdv_snapshot_retain(mdv_snapshot *snapshot)
+{
+    if (snapshot)
+        atomic_fetch_add_explicit(&snapshot->rc, 1, memory_order_relaxed);
+    return snapshot;
+}
+
+
+uint32_t mdv_snapshot_release(mdv_snapshot *snapshot)
+{
+    if (snapshot)
+    {
+        uint32_t rc = atomic_fetch_sub_explicit(&snapshot->rc, 1, memory_order_relaxed) - 1;
+
+        if (!rc)
+        {
+            mdv_hashmap_foreach(snapshot->tables, mdv_snapshot_table, entry)
+            {
+                mdv_transaction_abort(&entry->transaction);
+                mdv_rowdata_release(entry->rowdata);
+            }
+
+            mdv_hashmap_release(snapshot->tables);
+            mdv_hashmap_release(snapshot->positions);
+            mdv_mutex_free(&snapshot->mutex);
+            mdv_free(snapshot, "snapshot");
+        }
+
+        return rc;
+    }
+
+    return 0;
+}
+
+
+uint64_t mdv_snapshot_id(mdv_snapshot const *snapshot)
+{
+    return snapshot->id;
+}
+
+
+uint64_t mdv_snapshot_epoch(mdv_snapshot const *snapshot)
+{
+    return snapshot->epoch;
+}
+
+
+bool mdv_snapshot_table_add(mdv_snapshot *snapshot, mdv_rowdata *rowdata)
+{
+    mdv_uuid const *uuid = &mdv_rowdata_table(rowdata)->id;
+
+    if (mdv_mutex_lock(&snapshot->mutex) != MDV_OK)
+        return false;
+
+    bool ret = mdv_hashmap_find(snapshot->tables, uuid) != 0;
+
+    if (!ret)
+    {
+        mdv_snapshot_table table =
+        {
+            .uuid = *uuid,
+            .rowdata = rowdata,
+            .transaction = mdv_transaction_start_snapshot(mdv_rowdata_storage(rowdata))
+        };
+
+        if (mdv_transaction_ok(table.transaction))
+        {
+            ret = mdv_hashmap_insert(snapshot->tables, &table, sizeof table) != 0;
+
+            if (ret)
+                mdv_rowdata_retain(rowdata);
+            else
+            {
+                MDV_LOGE("No memory for snapshot table");
+                mdv_transaction_abort(&table.transaction);
+            }
+        }
+        else
+            MDV_LOGE("Snapshot transaction for table '%s' not started", mdv_uuid_to_str(uuid).ptr);
+    }
+
+    mdv_mutex_unlock(&snapshot->mutex);
+
+    return ret;
+}
+
+
+mdv_rowdata * mdv_snapshot_table_lock(mdv_snapshot     *snapshot,
+                                      mdv_uuid const   *table,
+                                      mdv_transaction **transaction)
+{
+    if (mdv_mutex_lock(&snapshot->mutex) != MDV_OK)
+        return 0;
+
+    mdv_snapshot_table *entry = mdv_hashmap_find(snapshot->tables, table);
+
+    if (!entry)
+    {
+        mdv_mutex_unlock(&snapshot->mutex);
+        return 0;
+    }
+
+    *transaction = &entry->transaction;
+
+    return entry->rowdata;
+}
+
+
+void mdv_snapshot_unlock(mdv_snapshot *snapshot)
+{
+    mdv_mutex_unlock(&snapshot->mutex);
+}
+
+
+bool mdv_snapshot_position_add(mdv_snapshot *snapshot, mdv_uuid const *trlog, uint64_t pos)
+{
+    mdv_snapshot_pos const position =
+    {
+        .uuid = *trlog,
+        .pos = pos
+    };
+
+    if (mdv_mutex_lock(&snapshot->mutex) != MDV_OK)
+        return false;
+
+    bool const ret = mdv_hashmap_insert(snapshot->positions, &position, sizeof position) != 0;
+
+    mdv_mutex_unlock(&snapshot->mutex);
+
+    if (!ret)
+        MDV_LOGE("No memory for snapshot position");
+
+    return ret;
+}
+
+
+uint64_t mdv_snapshot_position(mdv_snapshot *snapshot, mdv_uuid const *trlog)
+{
+    uint64_t pos = 0;
+
+    if (mdv_mutex_lock(&snapshot->mutex) == MDV_OK)
+    {
+        mdv_snapshot_pos const *position = mdv_hashmap_find(snapshot->positions, trlog);
+
+        if (position)
+            pos = position->pos;
+
+        mdv_mutex_unlock(&snapshot->mutex);
+    }
+
+    return pos;
+}
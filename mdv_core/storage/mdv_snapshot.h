@@ -0,0 +1,116 @@
+/**
+ * @file
+ * @brief Consistent read snapshot of the tablespace.
+ * @details Snapshot pins read-only transactions for the table rows storages and keeps
+ *          the transaction logs applied positions at the moment of the snapshot creation.
+ *          Tables rows are read from the pinned transactions, so the multi-table reads
+ *          are consistent without locks and the snapshot can be used by several requests
+ *          (e.g. for paged rows selection).
+ *
+ *          Pinned transactions are used by one request at a time, so the table is locked
+ *          by mdv_snapshot_table_lock() while it is read.
+*/
+#pragma once
+#include "mdv_rowdata.h"
+#include <mdv_uuid.h>
+
+
+/// Read snapshot
+typedef struct mdv_snapshot mdv_snapshot;
+
+
+/**
+ * @brief Creates new empty snapshot.
+ *
+ * @param id [in]       Snapshot identifier
+ * @param epoch [in]    Tablespace changes epoch at the moment of the snapshot creation
+ *
+ * @return On success, return non-null pointer to the snapshot
+ * @return On error, return NULL
+ */
+mdv_snapshot * mdv_snapshot_create(uint64_t id, uint64_t epoch);
+
+
+/**
+ * @brief Retains snapshot.
+ * @details Reference counter is increased by one.
+ */
+mdv_snapshot * mdv_snapshot_retain(mdv_snapshot *snapshot);
+
+
+/**
+ * @brief Releases snapshot.
+ * @details Reference counter is decreased by one.
+ *          When the reference counter reaches zero, the pinned transactions are finished.
+ */
+uint32_t mdv_snapshot_release(mdv_snapshot *snapshot);
+
+
+/**
+ * @brief Returns snapshot identifier.
+ */
+uint64_t mdv_snapshot_id(mdv_snapshot const *snapshot);
+
+
+/**
+ * @brief Returns tablespace changes epoch at the moment of the snapshot creation.
+ */
+uint64_t mdv_snapshot_epoch(mdv_snapshot const *snapshot);
+
+
+/**
+ * @brief Pins read-only transaction for the table rows storage.
+ * @details Caller is responsible that the table isn't changed since the snapshot creation.
+ *          If the table is already pinned, nothing is done.
+ *
+ * @param snapshot [in]     Read snapshot
+ * @param rowdata [in]      Table rows storage
+ *
+ * @return true if the table was successfully pinned
+ */
+bool mdv_snapshot_table_add(mdv_snapshot *snapshot, mdv_rowdata *rowdata);
+
+
+/**
+ * @brief Locks the pinned table for reading.
+ * @details On success, the snapshot should be unlocked by mdv_snapshot_unlock().
+ *
+ * @param snapshot [in]         Read snapshot
+ * @param table [in]            Table identifier
+ * @param transaction [out]     Pinned read-only transaction
+ *
+ * @return On success, return table rows storage. It is valid until the snapshot is unlocked.
+ * @return If the table isn't pinned, return NULL
+ */
+mdv_rowdata * mdv_snapshot_table_lock(mdv_snapshot     *snapshot,
+                                      mdv_uuid const   *table,
+                                      mdv_transaction **transaction);
+
+
+/**
+ * @brief Unlocks the table locked by mdv_snapshot_table_lock().
+ */
+void mdv_snapshot_unlock(mdv_snapshot *snapshot);
+
+
+/**
+ * @brief Saves the transaction log applied position.
+ *
+ * @param snapshot [in]     Read snapshot
+ * @param trlog [in]        Transaction log storage UUID
+ * @param pos [in]          Last applied transaction log record identifier
+ *
+ * @return true if the position was successfully saved
+ */
+bool mdv_snapshot_position_add(mdv_snapshot *snapshot, mdv_uuid const *trlog, uint64_t pos);
+
+
+/**
+ * @brief Returns the transaction log applied position at the moment of the snapshot creation.
+ *
+ * @param snapshot [in]     Read snapshot
+ * @param trlog [in]        Transaction log storage UUID
+ *
+ * @return Last applied transaction log record identifier. Zero if the transaction log wasn't applied.
+ */
+uint64_t mdv_snapshot_position(mdv_snapshot *snapshot, mdv_uuid const *trlog);
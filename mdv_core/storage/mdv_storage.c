@@ -1,8 +1,16 @@
 #include "mdv_storage.h"
+#include "../mdv_config.h"
 #include <mdv_log.h>
 #include <mdv_alloc.h>
 #include <mdv_string.h>
 #include <mdv_filesystem.h>
+#include <mdv_mutex.h>
+#include <mdv_vector.h>
+#include <mdv_rollbacker.h>
+#include <mdv_rwlock.h>
+#include <mdv_condvar.h>
+#include <mdv_threads.h>
+#include <mdv_time.h>
 #include <stdatomic.h>
 #include <string.h>
 #include <assert.h>
@@ -21,8 +29,78 @@ struct mdv_storage
 {
     atomic_uint_fast32_t    ref_counter;
     MDB_env                *env;
+    mdv_mutex               writer;         ///< Write transactions guard
+    mdv_vector             *journal;        ///< Write transaction journal for replay after map resizing (vector<uint8_t>)
+    bool                    journal_ok;     ///< Journal contains all operations of the current write transaction
+    bool                    journal_next;   ///< Next write transaction is journaled because the previous one didn't fit into the map
+    uint64_t                written;        ///< Amount of data written by the current (or previous) write transaction
+    uint32_t                page_size;      ///< Memory map page size
+    mdv_mutex               maps_mutex;     ///< Maps cache guard
+    mdv_vector             *maps;           ///< Resolved maps cache (vector<mdv_storage_map_entry>)
+    mdv_mutex               readers_mutex;  ///< Read-only transactions pool guard
+    mdv_vector             *readers;        ///< Read-only transactions pool (vector<MDB_txn*>)
+    mdv_rwlock              remap_lock;     ///< Memory map resizing waits for active read-only transactions
+    mdv_condvar             pins_cv;        ///< Memory map resizing waits for pinned read-only transactions
+    uint32_t                pins;           ///< Number of pinned read-only transactions
+    bool                    sync_commits;   ///< Each commit is flushed to disk
+    atomic_uint_fast64_t    mark;           ///< Committed watermark
+    atomic_uint_fast64_t    durable;        ///< Watermark flushed to disk
+    atomic_uint_fast64_t    unflushed;      ///< Amount of data written after the last flush
+    bool                    has_flusher;    ///< Background flusher is started
+    bool                    flusher_stop;   ///< Background flusher should be stopped
+    mdv_condvar             flusher_cv;     ///< Background flusher wakeup
+    mdv_thread              flusher;        ///< Background flusher thread
 };
 
+
+/// Resolved map
+typedef struct
+{
+    char const     *name;                   ///< Map name
+    MDB_dbi         dbi;                    ///< Map descriptor
+} mdv_storage_map_entry;
+
+
+/// Journaled operations
+enum
+{
+    MDV_JOURNAL_OPEN,                       ///< Map opening
+    MDV_JOURNAL_PUT,                        ///< Data insertion
+    MDV_JOURNAL_DEL                         ///< Data deletion
+};
+
+
+/// Journaled operation header. Key (or map name) and value are placed after header.
+typedef struct
+{
+    uint32_t op;                            ///< Operation type
+    uint32_t flags;                         ///< LMDB flags
+    uint32_t dbi;                           ///< Map descriptor
+    uint32_t key_size;                      ///< Key (or map name) size
+    uint32_t value_size;                    ///< Value size
+    uint32_t has_value;                     ///< Value is provided (used for deletion)
+} mdv_journal_op;
+
+
+/// Maximum number of map size increments for one write transaction
+enum { MDV_STORAGE_MAX_GROW_ATTEMPTS = 16 };
+
+
+/// Maximum number of reset read-only transactions kept in pool
+enum { MDV_STORAGE_READERS_POOL_SIZE = 16 };
+
+
+/// Pinned read-only transactions checking interval in milliseconds
+enum { MDV_STORAGE_PINS_WAIT = 100 };
+
+
+/// Number of unpinned read-only transactions of all storages held by the current thread (they hold the remap locks)
+static _Thread_local uint32_t mdv_storage_thread_readers = 0;
+
+
+static bool mdv_storage_map_find(mdv_storage *pstorage, char const *name, MDB_dbi *dbi);
+static void * mdv_storage_flusher(void *arg);
+
 /// @endcond
 
 
@@ -74,7 +152,9 @@ mdv_storage * mdv_storage_open(char const *path, char const *name, uint32_t dbs_
             return 0;                                                                       \
         }
 
-    uint32_t mdb_flags = MDB_NOSUBDIR;
+    // Read-only transactions aren't bound to threads because they are pooled and renewed by any thread.
+    // Pool is shared by the jobs threads, and snapshots are started and finished by different threads.
+    uint32_t mdb_flags = MDB_NOSUBDIR | MDB_NOTLS;
 
     if (flags & MDV_STRG_FIXEDMAP)      mdb_flags |= MDB_FIXEDMAP;
     if (flags & MDV_STRG_NOSUBDIR)      mdb_flags |= MDB_NOSUBDIR;
@@ -93,8 +173,19 @@ mdv_storage * mdv_storage_open(char const *path, char const *name, uint32_t dbs_
 
     MDV_DB_CALL(mdb_env_create(&env));
     MDV_DB_CALL(mdb_env_set_maxdbs(env, dbs_num));
+
+    if (MDV_CONFIG.storage.map_size)
+        MDV_DB_CALL(mdb_env_set_mapsize(env, MDV_CONFIG.storage.map_size));
+
+    if (MDV_CONFIG.storage.max_readers)
+        MDV_DB_CALL(mdb_env_set_maxreaders(env, MDV_CONFIG.storage.max_readers));
+
     MDV_DB_CALL(mdb_env_open(env, db_path.ptr, mdb_flags, 0664));
 
+    MDB_stat stat;
+
+    MDV_DB_CALL(mdb_env_stat(env, &stat));
+
     #undef MDV_DB_CALL
 
     mdv_storage *pstorage = (mdv_storage *)mdv_alloc(sizeof(mdv_storage), "storage");
@@ -102,38 +193,698 @@ mdv_storage * mdv_storage_open(char const *path, char const *name, uint32_t dbs_
     {
         MDV_LOGE("Memory allocation failed");
         mdb_env_close(env);
+        return 0;
+    }
+
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(11);
+
+    mdv_rollbacker_push(rollbacker, mdb_env_close, env);
+    mdv_rollbacker_push(rollbacker, mdv_free, pstorage, "storage");
+
+    if (mdv_mutex_create(&pstorage->writer) != MDV_OK)
+    {
+        MDV_LOGE("Storage mutex creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &pstorage->writer);
+
+    if (mdv_mutex_create(&pstorage->maps_mutex) != MDV_OK)
+    {
+        MDV_LOGE("Storage mutex creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &pstorage->maps_mutex);
+
+    pstorage->journal = mdv_vector_create(4096, sizeof(uint8_t), &mdv_default_allocator);
+
+    if (!pstorage->journal)
+    {
+        MDV_LOGE("Memory allocation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_vector_release, pstorage->journal);
+
+    pstorage->maps = mdv_vector_create(dbs_num ? dbs_num : 1, sizeof(mdv_storage_map_entry), &mdv_default_allocator);
+
+    if (!pstorage->maps)
+    {
+        MDV_LOGE("Memory allocation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_vector_release, pstorage->maps);
+
+    if (mdv_mutex_create(&pstorage->readers_mutex) != MDV_OK)
+    {
+        MDV_LOGE("Storage mutex creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &pstorage->readers_mutex);
+
+    if (mdv_rwlock_create(&pstorage->remap_lock) != MDV_OK)
+    {
+        MDV_LOGE("Storage lock creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_rwlock_free, &pstorage->remap_lock);
+
+    pstorage->readers = mdv_vector_create(MDV_STORAGE_READERS_POOL_SIZE, sizeof(MDB_txn*), &mdv_default_allocator);
+
+    if (!pstorage->readers)
+    {
+        MDV_LOGE("Memory allocation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_vector_release, pstorage->readers);
+
+    if (mdv_condvar_create(&pstorage->flusher_cv) != MDV_OK)
+    {
+        MDV_LOGE("Storage condition variable creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_condvar_free, &pstorage->flusher_cv);
+
+    if (mdv_condvar_create(&pstorage->pins_cv) != MDV_OK)
+    {
+        MDV_LOGE("Storage condition variable creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_condvar_free, &pstorage->pins_cv);
+
+    atomic_init(&pstorage->ref_counter, 1);
+    atomic_init(&pstorage->mark, 0);
+    atomic_init(&pstorage->durable, 0);
+    atomic_init(&pstorage->unflushed, 0);
+    pstorage->env = env;
+    pstorage->journal_ok = false;
+    pstorage->journal_next = false;
+    pstorage->written = 0;
+    pstorage->page_size = stat.ms_psize;
+    pstorage->pins = 0;
+    pstorage->sync_commits = !(mdb_flags & (MDB_NOSYNC | MDB_NOMETASYNC));
+    pstorage->has_flusher = false;
+    pstorage->flusher_stop = false;
+
+    if (flags & MDV_STRG_FLUSHER)
+    {
+        mdv_thread_attrs const attrs =
+        {
+            .stack_size = MDV_THREAD_STACK_SIZE
+        };
+
+        if (mdv_thread_create(&pstorage->flusher, &attrs, mdv_storage_flusher, pstorage) != MDV_OK)
+        {
+            MDV_LOGE("Storage flusher thread creation failed");
+            mdv_rollback(rollbacker);
+            return 0;
+        }
+
+        pstorage->has_flusher = true;
+    }
+
+    mdv_rollbacker_free(rollbacker);
+
+    return pstorage;
+}
+
+
+mdv_storage * mdv_storage_retain(mdv_storage *pstorage)
+{
+    if (pstorage)
+        atomic_fetch_add_explicit(&pstorage->ref_counter, 1, memory_order_relaxed);
+    return pstorage;
+}
+
+
+uint32_t mdv_storage_release(mdv_storage *pstorage)
+{
+    if (pstorage)
+    {
+        uint32_t rc = atomic_fetch_sub_explicit(&pstorage->ref_counter, 1, memory_order_relaxed) - 1;
+
+        if (!rc)
+        {
+            if (pstorage->has_flusher)
+            {
+                if (mdv_condvar_lock(&pstorage->flusher_cv) == MDV_OK)
+                {
+                    pstorage->flusher_stop = true;
+                    mdv_condvar_broadcast(&pstorage->flusher_cv);
+                    mdv_condvar_unlock(&pstorage->flusher_cv);
+                }
+
+                mdv_thread_join(pstorage->flusher);
+                mdv_storage_sync(pstorage);
+            }
+
+            MDB_txn **readers = mdv_vector_data(pstorage->readers);
+
+            for(size_t i = 0; i < mdv_vector_size(pstorage->readers); ++i)
+                mdb_txn_abort(readers[i]);
+
+            mdb_env_close(pstorage->env);
+
+            mdv_vector_foreach(pstorage->maps, mdv_storage_map_entry, entry)
+                mdv_free((char*)entry->name, "storage_map_name");
+
+            mdv_vector_release(pstorage->readers);
+            mdv_vector_release(pstorage->maps);
+            mdv_vector_release(pstorage->journal);
+            mdv_condvar_free(&pstorage->flusher_cv);
+            mdv_condvar_free(&pstorage->pins_cv);
+            mdv_rwlock_free(&pstorage->remap_lock);
+            mdv_mutex_free(&pstorage->readers_mutex);
+            mdv_mutex_free(&pstorage->maps_mutex);
+            mdv_mutex_free(&pstorage->writer);
+            mdv_free(pstorage, "storage");
+        }
+
+        return rc;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Publishes the watermark as durable if it is greater than current one.
+ */
+static void mdv_storage_durable_set(mdv_storage *pstorage, uint64_t mark)
+{
+    uint64_t durable = atomic_load_explicit(&pstorage->durable, memory_order_relaxed);
+
+    while (durable < mark
+           && !atomic_compare_exchange_weak_explicit(&pstorage->durable, &durable, mark,
+                                                     memory_order_release, memory_order_relaxed));
+}
+
+
+void mdv_storage_mark(mdv_storage *pstorage, uint64_t mark)
+{
+    uint64_t committed = atomic_load_explicit(&pstorage->mark, memory_order_relaxed);
+
+    while (committed < mark
+           && !atomic_compare_exchange_weak_explicit(&pstorage->mark, &committed, mark,
+                                                     memory_order_release, memory_order_relaxed));
+
+    if (pstorage->sync_commits)
+        mdv_storage_durable_set(pstorage, mark);
+}
+
+
+uint64_t mdv_storage_durable_mark(mdv_storage const *pstorage)
+{
+    return atomic_load_explicit(&pstorage->durable, memory_order_acquire);
+}
+
+
+bool mdv_storage_sync(mdv_storage *pstorage)
+{
+    // Watermark is published after commit, so all data up to it is flushed below.
+    uint64_t const mark = atomic_load_explicit(&pstorage->mark, memory_order_acquire);
+
+    atomic_store_explicit(&pstorage->unflushed, 0, memory_order_relaxed);
+
+    // Memory map can't be resized while it is flushed
+    if (mdv_rwlock_rdlock(&pstorage->remap_lock) != MDV_OK)
+    {
+        MDV_LOGE("The LMDB flush failed");
+        return false;
+    }
+
+    int rc = mdb_env_sync(pstorage->env, 1);
+
+    mdv_rwlock_unlock(&pstorage->remap_lock);
+
+    if (rc != MDB_SUCCESS)
+    {
+        MDV_LOGE("The LMDB flush failed: '%s' (%d)", mdb_strerror(rc), rc);
+        return false;
+    }
+
+    mdv_storage_durable_set(pstorage, mark);
+
+    return true;
+}
+
+
+/**
+ * @brief Background flusher flushes written data every [storage] flush_interval milliseconds
+ *        or when [storage] flush_size bytes are written.
+ */
+static void * mdv_storage_flusher(void *arg)
+{
+    mdv_storage *pstorage = arg;
+
+    size_t const interval = MDV_CONFIG.storage.flush_interval
+                                ? MDV_CONFIG.storage.flush_interval
+                                : 100;
+
+    if (mdv_condvar_lock(&pstorage->flusher_cv) != MDV_OK)
+    {
+        MDV_LOGE("Storage flusher failed");
+        return 0;
+    }
+
+    while (!pstorage->flusher_stop)
+    {
+        if (!MDV_CONFIG.storage.flush_size
+            || atomic_load_explicit(&pstorage->unflushed, memory_order_relaxed) < MDV_CONFIG.storage.flush_size)
+            mdv_condvar_wait_locked(&pstorage->flusher_cv, interval);
+
+        if (pstorage->flusher_stop)
+            break;
+
+        mdv_condvar_unlock(&pstorage->flusher_cv);
+
+        if (atomic_load_explicit(&pstorage->unflushed, memory_order_relaxed)
+            || atomic_load_explicit(&pstorage->mark, memory_order_relaxed)
+                    != atomic_load_explicit(&pstorage->durable, memory_order_relaxed))
+            mdv_storage_sync(pstorage);
+
+        mdv_condvar_lock(&pstorage->flusher_cv);
+    }
+
+    mdv_condvar_unlock(&pstorage->flusher_cv);
+
+    return 0;
+}
+
+
+static void mdv_storage_journal_add(mdv_storage *pstorage,
+                                    uint32_t op,
+                                    uint32_t flags,
+                                    uint32_t dbi,
+                                    void const *key, uint32_t key_size,
+                                    void const *value, uint32_t value_size)
+{
+    pstorage->written += sizeof(mdv_journal_op) + key_size + (value ? value_size : 0);
+
+    if (!pstorage->journal_ok)
+        return;
+
+    mdv_journal_op const hdr =
+    {
+        .op         = op,
+        .flags      = flags,
+        .dbi        = dbi,
+        .key_size   = key_size,
+        .value_size = value ? value_size : 0,
+        .has_value  = value != 0
+    };
+
+    if (!mdv_vector_append(pstorage->journal, &hdr, sizeof hdr)
+        || (key_size && !mdv_vector_append(pstorage->journal, key, key_size))
+        || (hdr.value_size && !mdv_vector_append(pstorage->journal, value, hdr.value_size)))
+    {
+        MDV_LOGW("No memory for transaction journal. Transaction can't be retried.");
+        pstorage->journal_ok = false;
+    }
+}
+
+
+static int mdv_storage_journal_replay(mdv_storage *pstorage, MDB_txn *txn)
+{
+    uint8_t const *ptr = mdv_vector_data(pstorage->journal);
+    uint8_t const *end = ptr + mdv_vector_size(pstorage->journal);
+
+    while (ptr < end)
+    {
+        mdv_journal_op hdr;
+        memcpy(&hdr, ptr, sizeof hdr);
+        ptr += sizeof hdr;
+
+        MDB_val k = { hdr.key_size, (void*)ptr };
+        ptr += hdr.key_size;
+
+        MDB_val v = { hdr.value_size, (void*)ptr };
+        ptr += hdr.value_size;
+
+        int rc = MDB_SUCCESS;
+
+        switch(hdr.op)
+        {
+            case MDV_JOURNAL_OPEN:
+            {
+                MDB_dbi dbi;
+                rc = mdb_dbi_open(txn, (char const *)k.mv_data, hdr.flags, &dbi);
+                if (rc == MDB_SUCCESS && dbi != hdr.dbi)
+                {
+                    MDV_LOGE("Map descriptor was changed after transaction restart");
+                    rc = MDB_BAD_DBI;
+                }
+                break;
+            }
+
+            case MDV_JOURNAL_PUT:
+                rc = mdb_put(txn, hdr.dbi, &k, &v, hdr.flags);
+                break;
+
+            case MDV_JOURNAL_DEL:
+                rc = mdb_del(txn, hdr.dbi, &k, hdr.has_value ? &v : 0);
+                if (rc == MDB_NOTFOUND)
+                    rc = MDB_SUCCESS;
+                break;
+        }
+
+        if (rc != MDB_SUCCESS)
+            return rc;
+    }
+
+    return MDB_SUCCESS;
+}
+
+
+/**
+ * @brief Waits until all pinned read-only transactions are finished.
+ * @details Pinned snapshots might be used for a long time, so the waiting is limited by the deadline.
+ *          Remap lock isn't held while waiting, so the readers aren't blocked.
+ *
+ * @return true if there are no pinned read-only transactions
+ */
+static bool mdv_storage_pins_wait(mdv_storage *pstorage, size_t deadline)
+{
+    if (mdv_condvar_lock(&pstorage->pins_cv) != MDV_OK)
+        return false;
+
+    while(pstorage->pins)
+    {
+        size_t const now = mdv_gettime();
+
+        if (now >= deadline)
+            break;
+
+        size_t const timeout = deadline - now;
+
+        mdv_condvar_wait_locked(&pstorage->pins_cv, timeout < MDV_STORAGE_PINS_WAIT ? timeout : MDV_STORAGE_PINS_WAIT);
+    }
+
+    bool const ret = !pstorage->pins;
+
+    mdv_condvar_unlock(&pstorage->pins_cv);
+
+    return ret;
+}
+
+
+/**
+ * @brief Returns true if there are pinned read-only transactions.
+ */
+static bool mdv_storage_pinned(mdv_storage *pstorage)
+{
+    bool pinned = true;
+
+    if (mdv_condvar_lock(&pstorage->pins_cv) == MDV_OK)
+    {
+        pinned = pstorage->pins != 0;
+        mdv_condvar_unlock(&pstorage->pins_cv);
+    }
+
+    return pinned;
+}
+
+
+/**
+ * @brief Locks the memory map for resizing.
+ * @details Active read-only transactions point into the memory map, so the remap lock waits for them.
+ *          Pinned transactions don't hold the remap lock. They are waited during storage.map_grow_wait
+ *          before the remap lock is taken, so the readers aren't blocked while the snapshots are pinned.
+ *
+ * @return true if the remap lock is held and there are no pinned transactions
+ */
+static bool mdv_storage_remap_lock(mdv_storage *pstorage)
+{
+    // Remap lock can't be taken while this thread holds it for reading. Waiting for other storages
+    // remap locks with the read-only transaction held might deadlock with other writers.
+    if (mdv_storage_thread_readers)
+    {
+        MDV_LOGE("The LMDB map can't grow while the thread holds the read-only transaction");
+        return false;
+    }
+
+    size_t const deadline = mdv_gettime() + MDV_CONFIG.storage.map_grow_wait;
+
+    for(;;)
+    {
+        if (!mdv_storage_pins_wait(pstorage, deadline))
+        {
+            MDV_LOGE("The LMDB map can't grow because read snapshots are pinned");
+            return false;
+        }
+
+        if (mdv_rwlock_wrlock(&pstorage->remap_lock) != MDV_OK)
+        {
+            MDV_LOGE("The LMDB map resizing failed");
+            return false;
+        }
+
+        // New transactions can't be pinned while the remap lock is held
+        if (!mdv_storage_pinned(pstorage))
+            return true;
+
+        // Snapshot was pinned before the remap lock was taken
+        mdv_rwlock_unlock(&pstorage->remap_lock);
+    }
+}
+
+
+/**
+ * @brief Sets the memory map size.
+ * @details Active read-only transactions point into the memory map. If wait is set, the resizing waits
+ *          for them (see mdv_storage_remap_lock()), otherwise the map isn't resized while any read-only transaction is active.
+ *
+ * @return true if the map was resized
+ */
+static bool mdv_storage_map_resize(mdv_storage *pstorage, size_t size, bool wait)
+{
+    if (wait)
+    {
+        if (!mdv_storage_remap_lock(pstorage))
+            return false;
+    }
+    else
+    {
+        if (mdv_rwlock_trywrlock(&pstorage->remap_lock) != MDV_OK)
+            return false;
+
+        if (mdv_storage_pinned(pstorage))
+        {
+            mdv_rwlock_unlock(&pstorage->remap_lock);
+            return false;
+        }
+    }
+
+    int const rc = mdb_env_set_mapsize(pstorage->env, size);
+
+    mdv_rwlock_unlock(&pstorage->remap_lock);
+
+    if (rc != MDB_SUCCESS)
+    {
+        MDV_LOGE("The LMDB map resizing failed: '%s' (%d)", mdb_strerror(rc), rc);
+        return false;
+    }
+
+    MDV_LOGI("The LMDB map size increased to %zu bytes", size);
+
+    return true;
+}
+
+
+/**
+ * @brief Grows the memory map in advance when its free space is low.
+ * @details It is called by the writer before the write transaction is started. The free space should be
+ *          at least the growth step and twice the size of the previous write transaction, because
+ *          the modified pages are copied. Growth doesn't wait for read-only transactions, so the writer isn't delayed.
+ *
+ * @return true if the map has enough free space and the write transaction needn't be journaled
+ */
+static bool mdv_storage_reserve(mdv_storage *pstorage)
+{
+    uint64_t const grow = MDV_CONFIG.storage.map_grow;
+
+    if (!grow)
+        return false;
+
+    MDB_envinfo info;
+
+    if (mdb_env_info(pstorage->env, &info) != MDB_SUCCESS)
+        return false;
+
+    uint64_t const used = ((uint64_t)info.me_last_pgno + 1) * pstorage->page_size;
+    uint64_t const headroom = 2 * pstorage->written > grow ? 2 * pstorage->written : grow;
+
+    if (used + headroom <= info.me_mapsize)
+        return true;
+
+    uint64_t const steps = (used + headroom - info.me_mapsize + grow - 1) / grow;
+
+    return mdv_storage_map_resize(pstorage, info.me_mapsize + steps * grow, false);
+}
+
+
+/**
+ * @brief Increases the map size and restarts the write transaction after MDB_MAP_FULL error.
+ * @details Other writers are waiting for the storage writer mutex which is held by the current transaction.
+ *          All journaled operations are replayed in the new transaction. If the transaction isn't journaled,
+ *          it fails and the next transaction is journaled, so the retried one can be replayed.
+ *
+ * @param ptransaction [in] [out]   Failed transaction. On success, it is replaced by the new one.
+ * @param aborted [in]              LMDB transaction is already aborted (failed commit)
+ *
+ * @return true if the transaction was restarted
+ */
+static bool mdv_transaction_recover(mdv_transaction *ptransaction, bool aborted)
+{
+    mdv_storage *pstorage = ptransaction->pstorage;
+
+    if (!aborted)
+        mdb_txn_abort((MDB_txn*)ptransaction->ptransaction);
+
+    ptransaction->ptransaction = 0;
+
+    if (!pstorage->journal_ok || !MDV_CONFIG.storage.map_grow)
+    {
+        pstorage->journal_next = MDV_CONFIG.storage.map_grow != 0;
+        MDV_LOGE("The LMDB map is full and the transaction can't be retried");
+        return false;
+    }
+
+    for(int attempt = 0; attempt < MDV_STORAGE_MAX_GROW_ATTEMPTS; ++attempt)
+    {
+        MDB_envinfo info;
+
+        int rc = mdb_env_info(pstorage->env, &info);
+
+        if (rc != MDB_SUCCESS)
+        {
+            MDV_LOGE("The LMDB map resizing failed: '%s' (%d)", mdb_strerror(rc), rc);
+            return false;
+        }
+
+        if (!mdv_storage_map_resize(pstorage, info.me_mapsize + MDV_CONFIG.storage.map_grow, true))
+        {
+            // Retried transaction is journaled again
+            pstorage->journal_next = true;
+            return false;
+        }
+
+        MDB_txn *txn;
+
+        rc = mdb_txn_begin(pstorage->env, 0, 0, &txn);
+
+        if (rc != MDB_SUCCESS)
+        {
+            MDV_LOGE("The LMDB transaction wasn't started: '%s' (%d)", mdb_strerror(rc), rc);
+            return false;
+        }
+
+        rc = mdv_storage_journal_replay(pstorage, txn);
+
+        if (rc == MDB_SUCCESS)
+        {
+            ptransaction->ptransaction = txn;
+            return true;
+        }
+
+        mdb_txn_abort(txn);
+
+        if (rc != MDB_MAP_FULL)
+        {
+            MDV_LOGE("The LMDB transaction replay failed: '%s' (%d)", mdb_strerror(rc), rc);
+            return false;
+        }
     }
 
-    atomic_init(&pstorage->ref_counter, 1);
-    pstorage->env = env;
+    MDV_LOGE("The LMDB map resizing failed");
 
-    return pstorage;
+    return false;
 }
 
 
-mdv_storage * mdv_storage_retain(mdv_storage *pstorage)
+static void mdv_transaction_end(mdv_transaction *ptransaction)
 {
-    if (pstorage)
-        atomic_fetch_add_explicit(&pstorage->ref_counter, 1, memory_order_relaxed);
-    return pstorage;
+    mdv_mutex_unlock(&ptransaction->pstorage->writer);
+    mdv_storage_release(ptransaction->pstorage);
+    ptransaction->ptransaction = 0;
+    ptransaction->pstorage = 0;
 }
 
 
-uint32_t mdv_storage_release(mdv_storage *pstorage)
+/**
+ * @brief Returns read-only transaction to the pool.
+ * @details Transaction is reset, so it doesn't hold any snapshot but keeps the reader slot.
+ */
+static void mdv_transaction_read_end(mdv_transaction *ptransaction)
 {
-    if (pstorage)
+    mdv_storage *pstorage = ptransaction->pstorage;
+    MDB_txn *txn = (MDB_txn*)ptransaction->ptransaction;
+
+    mdb_txn_reset(txn);
+
+    if (ptransaction->pinned)
     {
-        if (atomic_fetch_sub_explicit(&pstorage->ref_counter, 1, memory_order_relaxed) == 1)
+        if (mdv_condvar_lock(&pstorage->pins_cv) == MDV_OK)
         {
-            mdb_env_close(pstorage->env);
-            mdv_free(pstorage, "storage");
+            if (!--pstorage->pins)
+                mdv_condvar_broadcast(&pstorage->pins_cv);
+            mdv_condvar_unlock(&pstorage->pins_cv);
         }
     }
+    else
+    {
+        mdv_rwlock_unlock(&pstorage->remap_lock);
+        --mdv_storage_thread_readers;
+    }
+
+    bool pooled = false;
+
+    if (mdv_mutex_lock(&pstorage->readers_mutex) == MDV_OK)
+    {
+        if (mdv_vector_size(pstorage->readers) < MDV_STORAGE_READERS_POOL_SIZE)
+            pooled = mdv_vector_push_back(pstorage->readers, &txn) != 0;
+        mdv_mutex_unlock(&pstorage->readers_mutex);
+    }
+
+    if (!pooled)
+        mdb_txn_abort(txn);
+
+    mdv_storage_release(pstorage);
+
+    ptransaction->ptransaction = 0;
+    ptransaction->pstorage = 0;
+    ptransaction->pinned = false;
 }
 
 
 mdv_transaction mdv_transaction_start(mdv_storage *pstorage)
 {
+    if (mdv_mutex_lock(&pstorage->writer) != MDV_OK)
+    {
+        MDV_LOGE("The LMDB transaction wasn't started");
+        return (mdv_transaction){ 0, 0 };
+    }
+
+    // Operations are journaled only if the transaction might not fit into the map
+    bool const journal = MDV_CONFIG.storage.map_grow
+                            && (!mdv_storage_reserve(pstorage) || pstorage->journal_next);
+
     MDB_txn *txn;
 
     int rc = mdb_txn_begin(pstorage->env, 0, 0, &txn);
@@ -141,52 +892,182 @@ mdv_transaction mdv_transaction_start(mdv_storage *pstorage)
     if(rc != MDB_SUCCESS)
     {
         MDV_LOGE("The LMDB transaction wasn't started: '%s' (%d)", mdb_strerror(rc), rc);
+        mdv_mutex_unlock(&pstorage->writer);
         return (mdv_transaction){ 0, 0 };
     }
 
+    mdv_vector_clear(pstorage->journal);
+    pstorage->journal_ok = journal;
+    pstorage->journal_next = false;
+    pstorage->written = 0;
+
     return (mdv_transaction){ mdv_storage_retain(pstorage), txn };
 }
 
 
-bool mdv_transaction_commit(mdv_transaction *ptransaction)
+/**
+ * @brief Takes read-only transaction from the pool or starts new one.
+ */
+static MDB_txn * mdv_storage_reader(mdv_storage *pstorage)
 {
-    MDB_txn *txn = (MDB_txn*)ptransaction->ptransaction;
+    MDB_txn *txn = 0;
+
+    if (mdv_mutex_lock(&pstorage->readers_mutex) == MDV_OK)
+    {
+        size_t const size = mdv_vector_size(pstorage->readers);
+
+        if (size)
+        {
+            txn = *(MDB_txn**)mdv_vector_at(pstorage->readers, size - 1);
+            mdv_vector_resize(pstorage->readers, size - 1);
+        }
+
+        mdv_mutex_unlock(&pstorage->readers_mutex);
+    }
+
+    int rc = MDB_SUCCESS;
 
     if (txn)
     {
-        int rc = mdb_txn_commit(txn);
-        if(rc != MDB_SUCCESS)
-            MDV_LOGE("The LMDB transaction wasn't committed: '%s' (%d)", mdb_strerror(rc), rc);
+        rc = mdb_txn_renew(txn);
 
-        mdv_storage_release(ptransaction->pstorage);
+        if (rc != MDB_SUCCESS)
+        {
+            MDV_LOGW("The LMDB read-only transaction wasn't renewed: '%s' (%d)", mdb_strerror(rc), rc);
+            mdb_txn_abort(txn);
+            txn = 0;
+        }
+    }
 
-        ptransaction->ptransaction = 0;
-        ptransaction->pstorage = 0;
+    if (!txn)
+        rc = mdb_txn_begin(pstorage->env, 0, MDB_RDONLY, &txn);
 
-        return rc == MDB_SUCCESS;
+    if(rc != MDB_SUCCESS)
+    {
+        MDV_LOGE("The LMDB read-only transaction wasn't started: '%s' (%d)", mdb_strerror(rc), rc);
+        return 0;
     }
 
-    return false;
+    return txn;
 }
 
 
-bool mdv_transaction_abort(mdv_transaction *ptransaction)
+mdv_transaction mdv_transaction_start_read(mdv_storage *pstorage)
 {
-    MDB_txn *txn = (MDB_txn*)ptransaction->ptransaction;
+    if (mdv_rwlock_rdlock(&pstorage->remap_lock) != MDV_OK)
+    {
+        MDV_LOGE("The LMDB read-only transaction wasn't started");
+        return (mdv_transaction){ 0, 0 };
+    }
 
-    if (txn)
+    MDB_txn *txn = mdv_storage_reader(pstorage);
+
+    if (!txn)
+    {
+        mdv_rwlock_unlock(&pstorage->remap_lock);
+        return (mdv_transaction){ 0, 0 };
+    }
+
+    ++mdv_storage_thread_readers;
+
+    return (mdv_transaction){ mdv_storage_retain(pstorage), txn, true };
+}
+
+
+mdv_transaction mdv_transaction_start_snapshot(mdv_storage *pstorage)
+{
+    // Remap lock is held only while the transaction is pinned
+    if (mdv_rwlock_rdlock(&pstorage->remap_lock) != MDV_OK)
+    {
+        MDV_LOGE("The LMDB read-only transaction wasn't started");
+        return (mdv_transaction){ 0, 0 };
+    }
+
+    MDB_txn *txn = mdv_storage_reader(pstorage);
+
+    if (txn && mdv_condvar_lock(&pstorage->pins_cv) == MDV_OK)
     {
+        ++pstorage->pins;
+        mdv_condvar_unlock(&pstorage->pins_cv);
+    }
+    else if (txn)
+    {
+        MDV_LOGE("The LMDB read-only transaction wasn't started");
         mdb_txn_abort(txn);
+        txn = 0;
+    }
+
+    mdv_rwlock_unlock(&pstorage->remap_lock);
+
+    if (!txn)
+        return (mdv_transaction){ 0, 0 };
+
+    return (mdv_transaction){ mdv_storage_retain(pstorage), txn, true, true };
+}
 
-        mdv_storage_release(ptransaction->pstorage);
 
-        ptransaction->ptransaction = 0;
-        ptransaction->pstorage = 0;
+bool mdv_transaction_commit(mdv_transaction *ptransaction)
+{
+    if (!ptransaction->pstorage)
+        return false;
 
+    if (ptransaction->rdonly)
+    {
+        mdv_transaction_read_end(ptransaction);
         return true;
     }
 
-    return false;
+    int rc = MDB_BAD_TXN;
+
+    while (ptransaction->ptransaction)
+    {
+        rc = mdb_txn_commit((MDB_txn*)ptransaction->ptransaction);
+
+        if (rc != MDB_MAP_FULL
+            || !mdv_transaction_recover(ptransaction, true))
+            break;
+    }
+
+    if(rc != MDB_SUCCESS)
+        MDV_LOGE("The LMDB transaction wasn't committed: '%s' (%d)", mdb_strerror(rc), rc);
+    else if (ptransaction->pstorage->has_flusher)
+    {
+        mdv_storage *pstorage = ptransaction->pstorage;
+
+        uint64_t const size = pstorage->written;
+        uint64_t const unflushed = atomic_fetch_add_explicit(&pstorage->unflushed, size, memory_order_relaxed);
+
+        if (MDV_CONFIG.storage.flush_size
+            && unflushed < MDV_CONFIG.storage.flush_size
+            && unflushed + size >= MDV_CONFIG.storage.flush_size)
+            mdv_condvar_signal(&pstorage->flusher_cv);
+    }
+
+    mdv_transaction_end(ptransaction);
+
+    return rc == MDB_SUCCESS;
+}
+
+
+bool mdv_transaction_abort(mdv_transaction *ptransaction)
+{
+    if (!ptransaction->pstorage)
+        return false;
+
+    if (ptransaction->rdonly)
+    {
+        mdv_transaction_read_end(ptransaction);
+        return true;
+    }
+
+    MDB_txn *txn = (MDB_txn*)ptransaction->ptransaction;
+
+    if (txn)
+        mdb_txn_abort(txn);
+
+    mdv_transaction_end(ptransaction);
+
+    return true;
 }
 
 
@@ -201,6 +1082,10 @@ mdv_map mdv_map_open(mdv_transaction *ptransaction, char const *name, uint32_t f
 
     MDB_txn *txn = (MDB_txn*)ptransaction->ptransaction;
     MDB_dbi dbi;
+
+    if (mdv_storage_map_find(ptransaction->pstorage, name, &dbi))
+        return (mdv_map){ mdv_storage_retain(ptransaction->pstorage), dbi };
+
     int rc = mdb_dbi_open(txn, name, mdb_flags, &dbi);
     if(rc != MDB_SUCCESS)
     {
@@ -209,6 +1094,10 @@ mdv_map mdv_map_open(mdv_transaction *ptransaction, char const *name, uint32_t f
         return (mdv_map){ 0, 0 };
     }
 
+    if (!ptransaction->rdonly)
+        mdv_storage_journal_add(ptransaction->pstorage, MDV_JOURNAL_OPEN, mdb_flags, dbi,
+                                name, name ? strlen(name) + 1 : 0, 0, 0);
+
     return (mdv_map){ mdv_storage_retain(ptransaction->pstorage), dbi };
 }
 
@@ -217,10 +1106,10 @@ void mdv_map_close(mdv_map *pmap)
 {
     if (pmap)
     {
-        MDB_dbi dbi = (MDB_dbi)pmap->dbmap;
-        if (pmap->pstorage && dbi)
+        // Map descriptors aren't closed because they are shared by all
+        // transactions and cached. LMDB closes them with the environment.
+        if (pmap->pstorage)
         {
-            mdb_dbi_close(pmap->pstorage->env, dbi);
             mdv_storage_release(pmap->pstorage);
             pmap->pstorage = 0;
         }
@@ -228,26 +1117,147 @@ void mdv_map_close(mdv_map *pmap)
 }
 
 
-static bool mdv_map_put_impl(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value, unsigned int flags)
+static bool mdv_storage_map_lookup(mdv_storage *pstorage, char const *name, MDB_dbi *dbi)
+{
+    mdv_vector_foreach(pstorage->maps, mdv_storage_map_entry, entry)
+    {
+        if (strcmp(entry->name, name) == 0)
+        {
+            *dbi = entry->dbi;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+static bool mdv_storage_map_find(mdv_storage *pstorage, char const *name, MDB_dbi *dbi)
+{
+    bool found = false;
+
+    if (name && mdv_mutex_lock(&pstorage->maps_mutex) == MDV_OK)
+    {
+        found = mdv_storage_map_lookup(pstorage, name, dbi);
+        mdv_mutex_unlock(&pstorage->maps_mutex);
+    }
+
+    return found;
+}
+
+
+static void mdv_storage_map_cache(mdv_storage *pstorage, char const *name, MDB_dbi *dbi)
+{
+    if (mdv_mutex_lock(&pstorage->maps_mutex) != MDV_OK)
+        return;
+
+    if (!mdv_storage_map_lookup(pstorage, name, dbi))
+    {
+        size_t const name_size = strlen(name) + 1;
+
+        mdv_storage_map_entry entry =
+        {
+            .name = mdv_alloc(name_size, "storage_map_name"),
+            .dbi = *dbi
+        };
+
+        if (entry.name)
+        {
+            memcpy((char*)entry.name, name, name_size);
+
+            if (!mdv_vector_push_back(pstorage->maps, &entry))
+                mdv_free((char*)entry.name, "storage_map_name");
+        }
+    }
+
+    mdv_mutex_unlock(&pstorage->maps_mutex);
+}
+
+
+mdv_map_handle mdv_storage_map(mdv_storage *pstorage, char const *name, uint32_t flags)
+{
+    MDB_dbi dbi = 0;
+
+    if (mdv_storage_map_find(pstorage, name, &dbi))
+        return dbi;
+
+    mdv_transaction transaction = mdv_transaction_start(pstorage);
+
+    if (!mdv_transaction_ok(transaction))
+        return 0;
+
+    mdv_map map = mdv_map_open(&transaction, name, flags);
+
+    if (!mdv_map_ok(map))
+    {
+        mdv_transaction_abort(&transaction);
+        return 0;
+    }
+
+    dbi = map.dbmap;
+
+    mdv_map_close(&map);
+
+    if (!mdv_transaction_commit(&transaction))
+        return 0;
+
+    mdv_storage_map_cache(pstorage, name, &dbi);
+
+    return dbi;
+}
+
+
+mdv_map mdv_map_bind(mdv_transaction *ptransaction, mdv_map_handle handle)
+{
+    if (!handle || !ptransaction->ptransaction)
+        return (mdv_map){ 0, 0 };
+
+    return (mdv_map){ mdv_storage_retain(ptransaction->pstorage), handle };
+}
+
+
+static int mdv_map_put_raw(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value, unsigned int flags)
 {
     MDB_txn *txn = (MDB_txn*)ptransaction->ptransaction;
     MDB_dbi dbi = (MDB_dbi)pmap->dbmap;
 
     if (!txn)
-    {
-        if (!(MDV_MAP_SILENT & flags))
-            MDV_LOGE("Invalid operation. The data should be inserted in transaction.");
-        return false;
-    }
+        return MDB_BAD_TXN;
 
     MDB_val k = { key->size, key->ptr };
     MDB_val v = { value->size, value->ptr };
 
     int rc = mdb_put(txn, dbi, &k, &v, flags);
+
+    if (rc == MDB_MAP_FULL)
+    {
+        // The operation is journaled before the transaction restart because
+        // the key and value may point into the memory map.
+        mdv_storage_journal_add(ptransaction->pstorage, MDV_JOURNAL_PUT, flags, dbi,
+                                key->ptr, key->size, value->ptr, value->size);
+        rc = mdv_transaction_recover(ptransaction, false) ? MDB_SUCCESS : MDB_MAP_FULL;
+    }
+    else if (rc == MDB_SUCCESS)
+        mdv_storage_journal_add(ptransaction->pstorage, MDV_JOURNAL_PUT, flags, dbi,
+                                key->ptr, key->size, value->ptr, value->size);
+
+    return rc;
+}
+
+
+static bool mdv_map_put_impl(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value, unsigned int flags)
+{
+    int rc = mdv_map_put_raw(pmap, ptransaction, key, value, flags);
+
+    if (rc == MDB_BAD_TXN && !ptransaction->ptransaction)
+    {
+        MDV_LOGE("Invalid operation. The data should be inserted in transaction.");
+        return false;
+    }
+
     if(rc != MDB_SUCCESS)
     {
-        if (!(MDV_MAP_SILENT & flags))
-            MDV_LOGE("Unable to put data into the LMDB database: '%s' (%d)", mdb_strerror(rc), rc);
+        MDV_LOGE("Unable to put data into the LMDB database: '%s' (%d)", mdb_strerror(rc), rc);
         return false;
     }
 
@@ -267,6 +1277,41 @@ bool mdv_map_put_unique(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data c
 }
 
 
+static bool mdv_map_append_impl(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value, unsigned int append_flag, unsigned int fallback_flags)
+{
+    int rc = mdv_map_put_raw(pmap, ptransaction, key, value, append_flag);
+
+    if (rc == MDB_KEYEXIST)     // Key is out of order
+        return mdv_map_put_impl(pmap, ptransaction, key, value, fallback_flags);
+
+    if (rc == MDB_BAD_TXN && !ptransaction->ptransaction)
+    {
+        MDV_LOGE("Invalid operation. The data should be inserted in transaction.");
+        return false;
+    }
+
+    if(rc != MDB_SUCCESS)
+    {
+        MDV_LOGE("Unable to append data into the LMDB database: '%s' (%d)", mdb_strerror(rc), rc);
+        return false;
+    }
+
+    return true;
+}
+
+
+bool mdv_map_append(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value)
+{
+    return mdv_map_append_impl(pmap, ptransaction, key, value, MDB_APPEND, MDB_NOOVERWRITE);
+}
+
+
+bool mdv_map_append_dup(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value)
+{
+    return mdv_map_append_impl(pmap, ptransaction, key, value, MDB_APPENDDUP, MDB_NODUPDATA);
+}
+
+
 bool mdv_map_get(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data *value)
 {
     MDB_txn *txn = (MDB_txn*)ptransaction->ptransaction;
@@ -279,8 +1324,9 @@ bool mdv_map_get(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *k
     }
 
     MDB_val k = { key->size, key->ptr };
+    MDB_val v = { 0, 0 };
 
-    int rc = mdb_get(txn, dbi, &k, (MDB_val*)value);
+    int rc = mdb_get(txn, dbi, &k, &v);
 
     if (rc == MDB_NOTFOUND)
         return false;
@@ -291,6 +1337,9 @@ bool mdv_map_get(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *k
         return false;
     }
 
+    value->size = (uint32_t)v.mv_size;
+    value->ptr = v.mv_data;
+
     return true;
 }
 
@@ -311,6 +1360,13 @@ bool mdv_map_del(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *k
 
     int rc = mdb_del(txn, dbi, &k, value ? &v : 0);
 
+    if (rc == MDB_MAP_FULL || rc == MDB_SUCCESS)
+        mdv_storage_journal_add(ptransaction->pstorage, MDV_JOURNAL_DEL, 0, dbi,
+                                k.mv_data, k.mv_size, value ? v.mv_data : 0, v.mv_size);
+
+    if (rc == MDB_MAP_FULL)
+        rc = mdv_transaction_recover(ptransaction, false) ? MDB_SUCCESS : MDB_MAP_FULL;
+
     if (rc == MDB_NOTFOUND)
         return false;
 
@@ -389,12 +1445,31 @@ bool mdv_cursor_get(mdv_cursor *pcursor, mdv_data *key, mdv_data *value, mdv_cur
                                     MDB_FIRST;
     MDB_cursor *cursor = (MDB_cursor *)pcursor->pcursor;
 
-    int rc = mdb_cursor_get(cursor, (MDB_val*)key, (MDB_val*)value, cursor_op);
+    // mdv_data and MDB_val have different size fields, so the data can't be passed by pointer cast.
+    // Otherwise, the padding bytes are read as the high part of the key size.
+    MDB_val k = { key ? key->size : 0, key ? key->ptr : 0 };
+    MDB_val v = { value ? value->size : 0, value ? value->ptr : 0 };
+
+    int rc = mdb_cursor_get(cursor, key ? &k : 0, value ? &v : 0, cursor_op);
 
     switch(rc)
     {
         case MDB_SUCCESS:
+        {
+            if (key)
+            {
+                key->size = (uint32_t)k.mv_size;
+                key->ptr = k.mv_data;
+            }
+
+            if (value)
+            {
+                value->size = (uint32_t)v.mv_size;
+                value->ptr = v.mv_data;
+            }
+
             return true;
+        }
         case MDB_NOTFOUND:
             return false;
     }
@@ -405,6 +1480,40 @@ bool mdv_cursor_get(mdv_cursor *pcursor, mdv_data *key, mdv_data *value, mdv_cur
 }
 
 
+bool mdv_cursor_del(mdv_cursor *pcursor)
+{
+    MDB_cursor *cursor = (MDB_cursor *)pcursor->pcursor;
+
+    MDB_val k, v;
+
+    int rc = mdb_cursor_get(cursor, &k, &v, MDB_GET_CURRENT);
+
+    if (rc == MDB_SUCCESS)
+    {
+        // The key is journaled before the deletion because it points into the memory map.
+        // Journal isn't replayed if the deletion fails.
+        mdv_storage_journal_add(pcursor->pstorage, MDV_JOURNAL_DEL, 0, mdb_cursor_dbi(cursor),
+                                k.mv_data, k.mv_size, 0, 0);
+
+        rc = mdb_cursor_del(cursor, 0);
+    }
+
+    if (rc == MDB_MAP_FULL)
+    {
+        // Cursor is closed with the transaction, so the transaction can't be replayed here
+        pcursor->pstorage->journal_next = MDV_CONFIG.storage.map_grow != 0;
+    }
+
+    if (rc != MDB_SUCCESS)
+    {
+        MDV_LOGE("Unable to delete data by cursor: '%s' (%d)", mdb_strerror(rc), rc);
+        return false;
+    }
+
+    return true;
+}
+
+
 void mdv_map_read(mdv_map *pmap, mdv_transaction *ptransaction, void *map_fields)
 {
     for(mdv_map_field_desc *field = (mdv_map_field_desc *)map_fields;
@@ -27,7 +27,8 @@ typedef enum
     MDV_STRG_NOTLS              = 1 << 7,   ///< Don't use Thread-Local Storage.
     MDV_STRG_NOLOCK             = 1 << 8,   ///< Don't do any locking.
     MDV_STRG_NORDAHEAD          = 1 << 9,   ///< Turn off readahead.
-    MDV_STRG_NOMEMINIT          = 1 << 10   ///< Don't initialize malloc'd memory before writing to unused spaces in the data file.
+    MDV_STRG_NOMEMINIT          = 1 << 10,  ///< Don't initialize malloc'd memory before writing to unused spaces in the data file.
+    MDV_STRG_FLUSHER            = 1 << 11   ///< Start background flusher which flushes system buffers periodically.
 } mdv_storage_flags;
 
 
@@ -65,16 +66,59 @@ mdv_storage * mdv_storage_retain(mdv_storage *pstorage);
 uint32_t mdv_storage_release(mdv_storage *pstorage);
 
 
+/**
+ * @brief Publishes the committed watermark.
+ * @details Watermark is any increasing value (e.g. transaction log identifier) which is assigned
+ *          by the storage owner. It should be published after the data up to the watermark is committed.
+ *          Watermark becomes durable after the next flush to disk.
+ *
+ * @param pstorage [in] storage
+ * @param mark [in]     committed watermark
+ */
+void mdv_storage_mark(mdv_storage *pstorage, uint64_t mark);
+
+
+/**
+ * @brief Returns the watermark which is flushed to disk.
+ * @details For storages opened without MDV_STRG_NOSYNC and MDV_STRG_NOMETASYNC flags,
+ *          each committed watermark is durable.
+ *
+ * @param pstorage [in] storage
+ *
+ * @return durable watermark
+ */
+uint64_t mdv_storage_durable_mark(mdv_storage const *pstorage);
+
+
+/**
+ * @brief Flushes system buffers to disk and publishes the durable watermark.
+ *
+ * @param pstorage [in] storage
+ *
+ * @return true if data was flushed
+ */
+bool mdv_storage_sync(mdv_storage *pstorage);
+
+
 /// Transaction descriptor
 typedef struct
 {
     mdv_storage *pstorage;      ///< storage
     void        *ptransaction;  ///< transaction
+    bool         rdonly;        ///< read-only transaction
+    bool         pinned;        ///< read-only transaction isn't bound to the thread (see mdv_transaction_start_snapshot())
 } mdv_transaction;
 
 
 /**
  * @brief Start new transaction
+ * @details Write transactions are serialized per storage. When the free space of the storage memory map
+ *          is less than the configured growth step, the map is grown before the transaction is started.
+ *          If the map can't be grown in advance (e.g. it is read at the moment), the transaction operations
+ *          are journaled and the transaction is transparently replayed when the map is full and grown.
+ *          Data pointers returned by mdv_map_get() and opened cursors are invalidated by such replay.
+ *          Not journaled transaction which doesn't fit into the map fails and the next transaction is journaled,
+ *          so the retried transaction succeeds.
  *
  * @param pstorage [in] storage opened with mdv_storage_open()
  *
@@ -83,6 +127,37 @@ typedef struct
 mdv_transaction mdv_transaction_start(mdv_storage *pstorage);
 
 
+/**
+ * @brief Start new read-only transaction
+ * @details Read-only transactions are taken from the storage pool and renewed, so repeated reads
+ *          don't acquire new reader slots and don't allocate memory. The transaction should be finished
+ *          with mdv_transaction_abort() or mdv_transaction_commit(), which return it to the pool.
+ *          The memory map can't be grown while read-only transactions are active. If the write transaction
+ *          is performed while the current thread holds the read-only transaction, the memory map isn't grown
+ *          and the write transaction fails when the map is full.
+ *
+ * @param pstorage [in] storage opened with mdv_storage_open()
+ *
+ * @return On success return valid filled transaction descriptor. Validity can be checked with mdv_transaction_ok() macro.
+ */
+mdv_transaction mdv_transaction_start_read(mdv_storage *pstorage);
+
+
+/**
+ * @brief Start new read-only transaction which can be held for a long time.
+ * @details Unlike mdv_transaction_start_read(), the transaction isn't bound to the current thread,
+ *          so it can be finished by any thread. It should be used by one thread at a time.
+ *          The memory map resizing waits until all such transactions are finished, therefore
+ *          they should be finished in bounded time. If they aren't finished during storage.map_grow_wait,
+ *          the map isn't resized and the write transaction fails.
+ *
+ * @param pstorage [in] storage opened with mdv_storage_open()
+ *
+ * @return On success return valid filled transaction descriptor. Validity can be checked with mdv_transaction_ok() macro.
+ */
+mdv_transaction mdv_transaction_start_snapshot(mdv_storage *pstorage);
+
+
 /**
  * @brief Commit transaction. After the successfully commit all data modifications are stored in DB.
  *
@@ -142,6 +217,55 @@ bool    mdv_map_del        (mdv_map *pmap, mdv_transaction *ptransaction, mdv_da
 #define mdv_map_ok(m)      ((m).pstorage != 0 && (m).dbmap != 0)
 
 
+/**
+ * @brief Appends new entry to the end of the map.
+ * @details Appending is much faster than the regular insertion because no B-tree search is performed
+ *          and the pages are filled densely. If the key isn't greater than the last key in the map,
+ *          the entry is inserted with mdv_map_put_unique().
+ */
+bool mdv_map_append(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value);
+
+
+/**
+ * @brief Appends new duplicate value for the key (used only with MDV_MAP_MULTI).
+ * @details If the value isn't greater than the last value for the key, it is inserted with the regular insertion.
+ */
+bool mdv_map_append_dup(mdv_map *pmap, mdv_transaction *ptransaction, mdv_data const *key, mdv_data const *value);
+
+
+/// Map handle cached by storage. Handle is valid while the storage is opened.
+typedef uint32_t mdv_map_handle;
+
+
+/**
+ * @brief Resolves the map handle by name.
+ * @details The map is opened (and created if MDV_MAP_CREATE flag is set) within a separate
+ *          transaction only once. Next calls return the cached handle.
+ *          The function starts its own write transaction, therefore it shouldn't be called
+ *          while a write transaction for the same storage is active in the current thread.
+ *
+ * @param pstorage [in] storage
+ * @param name [in]     map name
+ * @param flags [in]    map opening flags (see mdv_map_flags)
+ *
+ * @return On success, returns nonzero map handle
+ * @return On error, returns zero
+ */
+mdv_map_handle mdv_storage_map(mdv_storage *pstorage, char const *name, uint32_t flags);
+
+
+/**
+ * @brief Binds cached map handle to the transaction.
+ * @details Unlike mdv_map_open(), no map lookup by name is performed.
+ *
+ * @param ptransaction [in] transaction
+ * @param handle [in]       map handle resolved with mdv_storage_map()
+ *
+ * @return map descriptor which should be closed with mdv_map_close()
+ */
+mdv_map mdv_map_bind(mdv_transaction *ptransaction, mdv_map_handle handle);
+
+
 /**
  * @brief Cursor for key-value storage iteration.
  *
@@ -184,6 +308,19 @@ bool        mdv_cursor_close            (mdv_cursor *pcursor);
 bool        mdv_cursor_get              (mdv_cursor *pcursor, mdv_data *key, mdv_data *value, mdv_cursor_op op);
 
 
+/**
+ * @brief Deletes the map entry at the current cursor position.
+ * @details Cursor should be opened within the write transaction. After the deletion, MDV_CURSOR_NEXT
+ *          moves the cursor to the entry which follows the deleted one. If the memory map is full,
+ *          the deletion fails and the transaction should be aborted.
+ *
+ * @param pcursor [in]  Cursor
+ *
+ * @return true if the entry was deleted
+ */
+bool        mdv_cursor_del              (mdv_cursor *pcursor);
+
+
 /**
  * @brief Check cursor validity
  *
@@ -1,7 +1,39 @@
 #include "mdv_storages.h"
+#include "mdv_storage.h"
+#include "../mdv_config.h"
 #include <stdio.h>
 
 
+static uint32_t mdv_storage_durability_flags(uint32_t durability)
+{
+    switch(durability)
+    {
+        case MDV_DURABILITY_METASYNC:
+            return MDV_STRG_NOSUBDIR | MDV_STRG_NOMETASYNC | MDV_STRG_FLUSHER;
+
+        case MDV_DURABILITY_ASYNC:
+            return MDV_STRG_NOSUBDIR | MDV_STRG_NOSYNC | MDV_STRG_FLUSHER;
+
+        default:
+            break;
+    }
+
+    return MDV_STRG_NOSUBDIR;
+}
+
+
+uint32_t MDV_STRG_DATA_FLAGS()
+{
+    return mdv_storage_durability_flags(MDV_CONFIG.storage.durability);
+}
+
+
+uint32_t MDV_STRG_TRLOG_FLAGS()
+{
+    return mdv_storage_durability_flags(MDV_CONFIG.storage.trlog_durability);
+}
+
+
 char const *MDV_STRG_TRLOG(mdv_uuid const *uuid)
 {
     static _Thread_local char name[64];
@@ -17,3 +49,11 @@ char const *MDV_MAP_TRANSACTION_LOG(uint32_t node_id)
     snprintf(name, sizeof name, "%u.log", node_id);
     return name;
 }
+
+
+char const *MDV_MAP_INDEX(uint32_t index_id)
+{
+    static _Thread_local char name[64];
+    snprintf(name, sizeof name, "%u.idx", index_id);
+    return name;
+}
@@ -3,6 +3,14 @@
 #include <mdv_uuid.h>
 
 
+/// Flags for data storages opening. Depends on [storage] durability.
+uint32_t MDV_STRG_DATA_FLAGS();
+
+
+/// Flags for transaction log storages opening. Depends on [storage] trlog_durability.
+uint32_t MDV_STRG_TRLOG_FLAGS();
+
+
 #define MDV_STRG_METAINF                "metainf.mdb"
 #define MDV_STRG_METAINF_MAPS           2
 #define MDV_MAP_METAINF                 "METAINF"           /// Common information about the DB
@@ -10,16 +18,23 @@
 
 
 #define MDV_STRG_OBJECTS                "objects.mdb"
-#define MDV_STRG_OBJECTS_MAPS           2
+#define MDV_STRG_INDEXES_MAX            8                   /// Maximal number of secondary indexes per table
+#define MDV_STRG_OBJECTS_MAPS           (6 + MDV_STRG_INDEXES_MAX)
 #define MDV_MAP_OBJECTS                 "OBJECTS"           /// DB objects: tables, rows, etc
 #define MDV_MAP_REMOVED                 "REMOVED"           /// Removed objects identifiers
+#define MDV_MAP_TABLE                   "TABLE"             /// Table description and rows count
+#define MDV_MAP_COLUMNS                 "COLUMNS"           /// Table columns segments
+#define MDV_MAP_TAIL                    "TAIL"              /// Table rows which don't fill the column segment yet
+#define MDV_MAP_INDEXES                 "INDEXES"           /// Secondary indexes descriptions
+#define MDV_MAP_TABLE_APPLIED           "APPLIED"           /// Transaction logs positions applied to the table
 /*
     ObjectID - NodeID + TRLogId (4 bytes + 8 bytes)
 */
 
 #define MDV_STRG_TRANSACTION_LOG        "trlog.mdb"
-#define MDV_STRG_TRANSACTION_LOG_MAPS(N)(2 + N)
+#define MDV_STRG_TRANSACTION_LOG_MAPS(N)(3 + N)
 #define MDV_MAP_REMOVED                 "REMOVED"
+#define MDV_MAP_REMOVED_BLOOM           "REMOVED_BLOOM"     /// Bloom filter snapshot for removed objects identifiers
 
 
 char const *MDV_STRG_TRLOG(mdv_uuid const *uuid);
@@ -29,3 +44,6 @@ char const *MDV_STRG_TRLOG(mdv_uuid const *uuid);
 
 
 char const *MDV_MAP_TRANSACTION_LOG(uint32_t node_id);
+
+
+char const *MDV_MAP_INDEX(uint32_t index_id);           /// Secondary index (Key -> row identifiers)
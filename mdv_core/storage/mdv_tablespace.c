@@ -1,4 +1,8 @@
 #include "mdv_tablespace.h"
+#include "mdv_rowdata.h"
+#include "mdv_filter.h"
+#include "mdv_aggregator.h"
+#include "mdv_snapshot.h"
 #include "../mdv_config.h"
 #include "../mdv_tracker.h"
 #include "../event/mdv_table.h"
@@ -9,25 +13,239 @@
 #include <mdv_rollbacker.h>
 #include <mdv_hashmap.h>
 #include <mdv_mutex.h>
+#include <mdv_rwlock.h>
+#include <mdv_condvar.h>
+#include <mdv_limits.h>
+#include <mdv_time.h>
+#include <mdv_threads.h>
+#include <stdatomic.h>
 #include <stddef.h>
+#include <string.h>
+
+
+/// Transaction log storage reference
+typedef struct
+{
+    mdv_uuid   uuid;    ///< Storage UUID
+    mdv_trlog *trlog;   ///< Transaction log storage
+} mdv_trlog_ref;
+
+
+/**
+ * @brief Transaction logs registry version.
+ * @details Registry version is immutable after the publication. New version is copied when the
+ *          transaction log is opened and the previous one is retired until the tablespace is closed.
+ *          Transaction logs are opened once per cluster node, so the retired versions are small.
+ */
+typedef struct mdv_trlogs
+{
+    struct mdv_trlogs  *prev;       ///< Retired registry version
+    uint32_t            size;       ///< Number of transaction logs
+    mdv_trlog_ref       refs[];     ///< Transaction logs sorted by storage UUID
+} mdv_trlogs;
 
 
 /// DB tables space
 struct mdv_tablespace
 {
-    mdv_mutex    trlogs_mutex;  ///< Mutex for transaction logs guard
-    mdv_hashmap *trlogs;        ///< Transaction logs map (Node UUID -> mdv_trlog)
+    mdv_mutex    trlogs_mutex;  ///< Mutex for transaction logs registry writers
+    _Atomic(mdv_trlogs *) trlogs;   ///< Transaction logs registry (Node UUID -> mdv_trlog). Readers are wait-free.
+    mdv_mutex    tables_mutex;  ///< Mutex for tables guard
+    mdv_hashmap *tables;        ///< Tables rows storages (Table UUID -> mdv_rowdata)
+    mdv_rwlock   apply_lock;    ///< Snapshots are created between the applied batches
+    atomic_uint_fast64_t epoch; ///< Changes epoch. It is increased by each applied batch.
+    mdv_mutex    snapshots_mutex;   ///< Mutex for snapshots guard
+    mdv_hashmap *snapshots;     ///< Read snapshots (Snapshot ID -> mdv_snapshot_ref)
+    atomic_uint_fast64_t snapshot_id;   ///< Last snapshot identifier
     mdv_uuid     uuid;          ///< Current node UUID
     mdv_ebus    *ebus;          ///< Events bus
+    mdv_jobber  *jobber;        ///< Secondary indexes builders and transaction logs checkpointers
+    mdv_jobber  *partitioner;   ///< Parallel tables committers (NULL - tables are committed sequentially)
+    mdv_jobber  *pipeliner;     ///< Transaction logs readers and decoders (NULL - batches are applied sequentially)
+    mdv_thread   reaper;        ///< Expired snapshots releasing thread
+    atomic_bool  active;        ///< Status
 };
 
 
-/// Transaction log storage reference
+/// Table rows storage reference
 typedef struct
 {
-    mdv_uuid   uuid;    ///< Storage UUID
-    mdv_trlog *trlog;   ///< Transaction log storage
-} mdv_trlog_ref;
+    mdv_uuid     uuid;      ///< Table UUID
+    mdv_rowdata *rowdata;   ///< Table rows storage
+    uint64_t     changed;   ///< Epoch of the last table change
+} mdv_rowdata_ref;
+
+
+/// Read snapshot reference
+typedef struct
+{
+    uint64_t      id;       ///< Snapshot identifier
+    mdv_snapshot *snapshot; ///< Read snapshot
+    size_t        expires;  ///< Expiration time in milliseconds
+} mdv_snapshot_ref;
+
+
+/// Table reader
+typedef struct
+{
+    mdv_snapshot    *snapshot;      ///< Read snapshot (NULL - the latest data is read)
+    mdv_rowdata     *rowdata;       ///< Table rows storage
+    mdv_transaction *transaction;   ///< Pinned snapshot transaction (NULL - new read-only transaction is used)
+} mdv_tablespace_reader;
+
+
+/// Rows which should be inserted into the table
+typedef struct
+{
+    mdv_uuid     uuid;      ///< Table UUID
+    mdv_uuid     trlog;     ///< Transaction log storage UUID
+    mdv_rowdata *rowdata;   ///< Table rows storage
+    mdv_vector  *rows;      ///< Serialized rows (vector<mdv_data>)
+    uint64_t     applied;   ///< Last transaction log record identifier applied to the table
+    uint64_t     last;      ///< Last transaction log record identifier in the batch
+} mdv_table_rows;
+
+
+/// Transaction log applier context
+typedef struct
+{
+    mdv_tablespace *tablespace; ///< Tablespace
+    mdv_uuid        storage;    ///< Transaction log storage UUID
+    mdv_hashmap    *tables;     ///< Rows which should be inserted (Table UUID -> mdv_table_rows)
+    uint64_t        epoch;      ///< Changes epoch of the applied batch
+} mdv_tablespace_applier;
+
+
+/// Secondary index builder context
+typedef struct
+{
+    mdv_tablespace *tablespace; ///< Tablespace
+    mdv_rowdata    *rowdata;    ///< Table rows storage
+    uint32_t        index_id;   ///< Index identifier
+} mdv_tablespace_indexer;
+
+
+typedef mdv_job(mdv_tablespace_indexer)     mdv_tablespace_indexer_job;
+
+
+/// Transaction log checkpoint context
+typedef struct
+{
+    mdv_tablespace *tablespace; ///< Tablespace
+    mdv_trlog      *trlog;      ///< Transaction log
+} mdv_tablespace_checkpointer;
+
+
+typedef mdv_job(mdv_tablespace_checkpointer) mdv_tablespace_checkpointer_job;
+
+
+/**
+ * @brief Partitioned batch commit context.
+ * @details Batch is split by tables. Partitions are claimed by the applier thread and by the
+ *          partitioner jobs, so the applier never waits for the jobs which aren't started yet.
+ */
+typedef struct
+{
+    atomic_uint_fast32_t rc;            ///< References counter
+    mdv_tablespace      *tablespace;    ///< Tablespace
+    uint64_t             epoch;         ///< Changes epoch of the applied batch
+    uint32_t             size;          ///< Number of partitions
+    atomic_uint_fast32_t next;          ///< Next unclaimed partition
+    atomic_uint_fast32_t finished;      ///< Number of finished partitions
+    atomic_bool          ok;            ///< All partitions are successfully committed
+    mdv_condvar          cv;            ///< Partitions completion signal
+    mdv_table_rows      *partitions[];  ///< Rows for each table
+} mdv_tablespace_partitions;
+
+
+/// Partition committer context
+typedef struct
+{
+    mdv_tablespace_partitions *partitions;  ///< Partitioned batch
+} mdv_tablespace_partitioner;
+
+
+typedef mdv_job(mdv_tablespace_partitioner) mdv_tablespace_partitioner_job;
+
+
+enum { MDV_TABLESPACE_PIPELINE_DEPTH = 4 };     ///< Maximum number of batches in the apply pipeline
+
+
+/// Apply pipeline reader states
+enum
+{
+    MDV_PIPELINE_READER_PENDING = 0,    ///< Reader job isn't started yet
+    MDV_PIPELINE_READER_RUNNING,        ///< Reader reads the transaction log
+    MDV_PIPELINE_READER_FINISHED,       ///< Transaction log is read
+    MDV_PIPELINE_READER_CANCELLED       ///< Reader job was cancelled by the writer before start
+};
+
+
+/// Transaction log record prepared for writing
+typedef struct
+{
+    uint64_t      id;           ///< Transaction log record identifier
+    mdv_trlog_op *op;           ///< Operation copy
+    bool          ok;           ///< Record is successfully prepared
+    mdv_uuid      table;        ///< Table UUID (only for the rows insertion)
+    mdv_rowdata  *rowdata;      ///< Table rows storage (only for the rows insertion)
+    mdv_row_base *row;          ///< Decoded row (only for the rows insertion, NULL - invalid row)
+} mdv_tablespace_record;
+
+
+/// Transaction log batch in the apply pipeline
+typedef struct
+{
+    atomic_uint_fast32_t  rc;           ///< References counter
+    uint32_t              size;         ///< Number of records
+    uint32_t              chunks;       ///< Number of chunks for decoding
+    atomic_uint_fast32_t  next;         ///< Next unclaimed chunk
+    atomic_uint_fast32_t  decoded;      ///< Number of decoded chunks
+    mdv_tablespace_record records[];    ///< Records. Operations copies are placed after the records.
+} mdv_tablespace_batch;
+
+
+/**
+ * @brief Pipelined transaction log apply context.
+ * @details Transaction log is applied by three stages connected by the bounded batches queue:
+ *          - reader job prefetches the next batch and applies the schema operations,
+ *          - decoder jobs decode the rows of the batch concurrently,
+ *          - writer (the applier thread) commits the decoded batches one by one.
+ *
+ *          Work is claimed like the partitions, so the writer decodes the batch by itself
+ *          if the decoders are busy, and it applies the log sequentially if the reader isn't started.
+ */
+typedef struct
+{
+    atomic_uint_fast32_t  rc;           ///< References counter
+    mdv_tablespace       *tablespace;   ///< Tablespace
+    mdv_trlog            *trlog;        ///< Transaction log storage
+    atomic_uint_fast32_t  reader;       ///< Reader state
+    atomic_bool           active;       ///< Pipeline is active. Reader is stopped when it is false.
+    mdv_condvar           cv;           ///< Stages progress signal
+    _Atomic(mdv_tablespace_batch *) batches[MDV_TABLESPACE_PIPELINE_DEPTH];  ///< Batches queue (NULL - free slot)
+} mdv_tablespace_pipeline;
+
+
+/// Transaction log prefetcher context
+typedef struct
+{
+    mdv_tablespace_pipeline *pipeline;  ///< Apply pipeline
+} mdv_tablespace_prefetcher;
+
+
+typedef mdv_job(mdv_tablespace_prefetcher)  mdv_tablespace_prefetcher_job;
+
+
+/// Batch decoder context
+typedef struct
+{
+    mdv_tablespace_pipeline *pipeline;  ///< Apply pipeline
+    mdv_tablespace_batch    *batch;     ///< Decoded batch
+} mdv_tablespace_decoder;
+
+
+typedef mdv_job(mdv_tablespace_decoder)     mdv_tablespace_decoder_job;
 
 
 /// DB operations list
@@ -35,13 +253,15 @@ enum
 {
     MDV_OP_TABLE_CREATE = 0,    ///< Create table
     MDV_OP_TABLE_DROP,          ///< Drop table
-    MDV_OP_ROW_INSERT           ///< Insert data into a table
+    MDV_OP_ROW_INSERT,          ///< Insert data into a table
+    MDV_OP_INDEX_CREATE         ///< Create secondary index
 };
 
 
 /**
  * @brief Insert new record into the transaction log for new table creation.
  * @details After the successfully table creation new generated table UUID is saved to table->id.
+ *          Table storage is created immediately, so the rows can be inserted before the log is applied.
  *
  * @param tablespace [in]   Pointer to a tablespace structure
  * @param table [in] [out]  Table description
@@ -51,318 +271,2978 @@ enum
 static bool mdv_tablespace_log_create_table(mdv_tablespace *tablespace, mdv_table_base *table);
 
 
-static mdv_trlog * mdv_tablespace_trlog(mdv_tablespace *tablespace, mdv_uuid const *uuid)
-{
-    mdv_trlog_ref *ref = 0;
+/**
+ * @brief Insert new record into the transaction log for new row insertion.
+ * @details Row is checked against the table schema and invalid rows are rejected.
+ *          Inserted row identifier is saved to evt->row_id.
+ *
+ * @param tablespace [in]   Pointer to a tablespace structure
+ * @param evt [in] [out]    Row insertion event
+ *
+ * @return true if operation successfully completed.
+ */
+static bool mdv_tablespace_log_insert_row(mdv_tablespace *tablespace, mdv_evt_insert_row *evt);
+
+
+/**
+ * @brief Creates the table storage if it doesn't exist.
+ */
+static bool mdv_tablespace_create_table(mdv_tablespace *tablespace, mdv_table_base const *table);
+
+
+/**
+ * @brief Insert new record into the transaction log for secondary index creation.
+ * @details Index is registered when the transaction log is applied and it is built in background.
+ *
+ * @param tablespace [in]   Pointer to a tablespace structure
+ * @param evt [in]          Index creation event
+ *
+ * @return true if operation successfully completed.
+ */
+static bool mdv_tablespace_log_create_index(mdv_tablespace *tablespace, mdv_evt_create_index const *evt);
+
+
+/**
+ * @brief Selects the table rows.
+ * @details Rows are filtered by the predicate during the columns scanning and only requested fields are serialized.
+ *
+ * @param tablespace [in]   Pointer to a tablespace structure
+ * @param evt [in] [out]    Rows selection event. Selected rows are saved to evt->rows and evt->ids.
+ *
+ * @return true if operation successfully completed.
+ */
+static bool mdv_tablespace_select(mdv_tablespace *tablespace, mdv_evt_select *evt);
+
+
+/**
+ * @brief Aggregates the table rows.
+ * @details Rows are filtered and aggregated during the columns scanning, so only the groups are kept in memory.
+ *
+ * @param tablespace [in]   Pointer to a tablespace structure
+ * @param evt [in] [out]    Rows aggregation event. Groups are saved to evt->rows and evt->ids.
+ *
+ * @return true if operation successfully completed.
+ */
+static bool mdv_tablespace_aggregate(mdv_tablespace *tablespace, mdv_evt_aggregate *evt);
+
+
+/**
+ * @brief Creates new read snapshot.
+ * @details Read-only transactions for all opened tables are pinned and the transaction logs applied
+ *          positions are saved between the applied batches, so the snapshot is consistent for all tables.
+ *          Unused snapshot is released after MDV_CONFIG.snapshot.ttl seconds.
+ *
+ * @param tablespace [in]   Pointer to a tablespace structure
+ * @param id [out]          Snapshot identifier
+ *
+ * @return true if operation successfully completed.
+ */
+static bool mdv_tablespace_snapshot_create(mdv_tablespace *tablespace, uint64_t *id);
+
+
+/**
+ * @brief Releases read snapshot created by mdv_tablespace_snapshot_create().
+ *
+ * @param tablespace [in]   Pointer to a tablespace structure
+ * @param id [in]           Snapshot identifier
+ *
+ * @return true if snapshot was found and released.
+ */
+static bool mdv_tablespace_snapshot_release(mdv_tablespace *tablespace, uint64_t id);
+
+
+static size_t mdv_u64_hash(uint64_t const *id)
+{
+    return (size_t)*id;
+}
+
+
+static int mdv_u64_keys_cmp(uint64_t const *id1, uint64_t const *id2)
+{
+    return *id1 < *id2 ? -1
+            : *id1 > *id2 ? 1
+            : 0;
+}
+
+
+/**
+ * @brief Finds the transaction log in the registry version.
+ *
+ * @param trlogs [in]   Transaction logs registry version
+ * @param uuid [in]     Transaction log storage UUID
+ * @param pos [out]     Insertion position if the transaction log isn't found
+ *
+ * @return Transaction log reference or NULL if the transaction log isn't registered
+ */
+static mdv_trlog_ref const * mdv_trlogs_find(mdv_trlogs const *trlogs, mdv_uuid const *uuid, uint32_t *pos)
+{
+    uint32_t left = 0, right = trlogs ? trlogs->size : 0;
+
+    while(left < right)
+    {
+        uint32_t const mid = left + (right - left) / 2;
+
+        int const cmp = mdv_uuid_cmp(&trlogs->refs[mid].uuid, uuid);
+
+        if (cmp == 0)
+            return trlogs->refs + mid;
+        else if (cmp < 0)
+            left = mid + 1;
+        else
+            right = mid;
+    }
+
+    if (pos)
+        *pos = left;
+
+    return 0;
+}
+
+
+/**
+ * @brief Frees the transaction logs registry with all retired versions.
+ * @details Only the latest version owns the transaction logs references.
+ */
+static void mdv_trlogs_free(mdv_trlogs *trlogs)
+{
+    for(uint32_t i = 0; trlogs && i < trlogs->size; ++i)
+        mdv_trlog_release(trlogs->refs[i].trlog);
+
+    while(trlogs)
+    {
+        mdv_trlogs *prev = trlogs->prev;
+        mdv_free(trlogs, "trlogs");
+        trlogs = prev;
+    }
+}
+
+
+static mdv_trlog * mdv_tablespace_trlog(mdv_tablespace *tablespace, mdv_uuid const *uuid)
+{
+    mdv_trlogs const *trlogs = atomic_load_explicit(&tablespace->trlogs, memory_order_acquire);
+
+    mdv_trlog_ref const *ref = mdv_trlogs_find(trlogs, uuid, 0);
+
+    // Registered transaction logs are released only when the tablespace is closed
+    return ref ? mdv_trlog_retain(ref->trlog) : 0;
+}
+
+
+static mdv_trlog * mdv_tablespace_trlog_create(mdv_tablespace *tablespace, mdv_uuid const *uuid)
+{
+    mdv_trlog *trlog = mdv_tablespace_trlog(tablespace, uuid);
+
+    if (trlog)
+        return trlog;
+
+    if (mdv_mutex_lock(&tablespace->trlogs_mutex) != MDV_OK)
+        return 0;
+
+    mdv_trlogs *trlogs = atomic_load_explicit(&tablespace->trlogs, memory_order_relaxed);
+
+    uint32_t pos = 0;
+
+    mdv_trlog_ref const *ref = mdv_trlogs_find(trlogs, uuid, &pos);
+
+    if (ref)
+        trlog = mdv_trlog_retain(ref->trlog);
+    else
+    {
+        uint32_t const size = trlogs ? trlogs->size : 0;
+
+        mdv_trlogs *new_trlogs = mdv_alloc(offsetof(mdv_trlogs, refs) + (size + 1) * sizeof(mdv_trlog_ref), "trlogs");
+
+        trlog = new_trlogs
+                    ? mdv_trlog_open(uuid, MDV_CONFIG.storage.path.ptr)
+                    : 0;
+
+        if (trlog)
+        {
+            new_trlogs->prev = trlogs;
+            new_trlogs->size = size + 1;
+
+            if (pos)
+                memcpy(new_trlogs->refs, trlogs->refs, pos * sizeof(mdv_trlog_ref));
+
+            new_trlogs->refs[pos] = (mdv_trlog_ref) { *uuid, trlog };
+
+            if (pos < size)
+                memcpy(new_trlogs->refs + pos + 1, trlogs->refs + pos, (size - pos) * sizeof(mdv_trlog_ref));
+
+            atomic_store_explicit(&tablespace->trlogs, new_trlogs, memory_order_release);
+
+            trlog = mdv_trlog_retain(trlog);
+        }
+        else
+        {
+            MDV_LOGE("Transaction log '%s' opening failed", mdv_uuid_to_str(uuid).ptr);
+            mdv_free(new_trlogs, "trlogs");
+        }
+    }
+
+    mdv_mutex_unlock(&tablespace->trlogs_mutex);
+
+    return trlog;
+}
+
+
+/**
+ * @brief Builds the secondary index in background. Building is stopped when the tablespace is closed.
+ */
+static void mdv_tablespace_indexer_fn(mdv_job_base *job)
+{
+    mdv_tablespace_indexer *ctx = (mdv_tablespace_indexer *)job->data;
+
+    mdv_uuid const *table_id = &mdv_rowdata_table(ctx->rowdata)->id;
+
+    bool ready = false;
+
+    // Index is built by small batches, so the rows writer isn't blocked for a long time
+    while(atomic_load(&ctx->tablespace->active) && !ready)
+    {
+        if (!mdv_rowdata_index_build(ctx->rowdata, ctx->index_id, MDV_CONFIG.indexer.batch_size, &ready))
+        {
+            MDV_LOGE("Index %u for table '%s' building failed", ctx->index_id, mdv_uuid_to_str(table_id).ptr);
+            return;
+        }
+
+        mdv_rowdata_index_state state;
+
+        if (!ready && mdv_rowdata_index_progress(ctx->rowdata, ctx->index_id, &state))
+            MDV_LOGD("Index %u for table '%s' building: %llu of %llu rows",
+                     ctx->index_id,
+                     mdv_uuid_to_str(table_id).ptr,
+                     (unsigned long long)state.built,
+                     (unsigned long long)state.rows);
+    }
+
+    if (ready)
+        MDV_LOGI("Index %u for table '%s' is built", ctx->index_id, mdv_uuid_to_str(table_id).ptr);
+}
+
+
+static void mdv_tablespace_indexer_finalize(mdv_job_base *job)
+{
+    mdv_tablespace_indexer *ctx = (mdv_tablespace_indexer *)job->data;
+    mdv_rowdata_release(ctx->rowdata);
+    mdv_free(job, "indexer_job");
+}
+
+
+/**
+ * @brief Schedules secondary index building.
+ */
+static void mdv_tablespace_index_build(mdv_tablespace *tablespace, mdv_rowdata *rowdata, uint32_t index_id)
+{
+    mdv_tablespace_indexer_job *job = mdv_alloc(sizeof(mdv_tablespace_indexer_job), "indexer_job");
+
+    if (!job)
+    {
+        MDV_LOGE("No memory for index builder job");
+        return;
+    }
+
+    job->fn              = mdv_tablespace_indexer_fn;
+    job->finalize        = mdv_tablespace_indexer_finalize;
+    job->data.tablespace = tablespace;
+    job->data.rowdata    = mdv_rowdata_retain(rowdata);
+    job->data.index_id   = index_id;
+
+    if (mdv_jobber_push(tablespace->jobber, (mdv_job_base*)job) != MDV_OK)
+    {
+        MDV_LOGE("Index builder job failed");
+        mdv_rowdata_release(rowdata);
+        mdv_free(job, "indexer_job");
+    }
+}
+
+
+/**
+ * @brief Schedules building of secondary indexes which weren't completed before the table was closed.
+ */
+static void mdv_tablespace_indexes_resume(mdv_tablespace *tablespace, mdv_rowdata *rowdata)
+{
+    uint32_t const count = mdv_rowdata_indexes_count(rowdata);
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        mdv_rowdata_index_state state;
+
+        if (mdv_rowdata_index_progress(rowdata, i, &state) && !state.ready)
+            mdv_tablespace_index_build(tablespace, rowdata, i);
+    }
+}
+
+
+/**
+ * @brief Returns rows storage for the table.
+ * @details If the table description is provided, new rows storage is created if it doesn't exist.
+ */
+static mdv_rowdata * mdv_tablespace_rowdata(mdv_tablespace *tablespace,
+                                            mdv_uuid const *uuid,
+                                            mdv_table_base const *table)
+{
+    mdv_rowdata_ref *ref = 0;
+    mdv_rowdata *opened = 0;
+
+    if (mdv_mutex_lock(&tablespace->tables_mutex) == MDV_OK)
+    {
+        ref = mdv_hashmap_find(tablespace->tables, uuid);
+
+        if(!ref)
+        {
+            mdv_rowdata_ref new_ref =
+            {
+                .uuid = *uuid,
+                .rowdata = table
+                            ? mdv_rowdata_create(table)
+                            : mdv_rowdata_open(uuid)
+            };
+
+            if (new_ref.rowdata)
+            {
+                ref = mdv_hashmap_insert(tablespace->tables, &new_ref, sizeof new_ref);
+
+                if (!ref)
+                {
+                    mdv_rowdata_release(new_ref.rowdata);
+                    new_ref.rowdata = 0;
+                }
+                else
+                    opened = new_ref.rowdata;
+            }
+        }
+
+        mdv_mutex_unlock(&tablespace->tables_mutex);
+    }
+
+    if (opened)
+        mdv_tablespace_indexes_resume(tablespace, opened);
+
+    return ref ? mdv_rowdata_retain(ref->rowdata) : 0;
+}
+
+
+/**
+ * @brief Saves the epoch of the last table change.
+ */
+static void mdv_tablespace_table_changed(mdv_tablespace *tablespace, mdv_uuid const *uuid, uint64_t epoch)
+{
+    if (mdv_mutex_lock(&tablespace->tables_mutex) == MDV_OK)
+    {
+        mdv_rowdata_ref *ref = mdv_hashmap_find(tablespace->tables, uuid);
+
+        if (ref && ref->changed < epoch)
+            ref->changed = epoch;
+
+        mdv_mutex_unlock(&tablespace->tables_mutex);
+    }
+}
+
+
+/**
+ * @brief Returns the epoch of the last table change.
+ */
+static uint64_t mdv_tablespace_table_epoch(mdv_tablespace *tablespace, mdv_uuid const *uuid)
+{
+    uint64_t epoch = 0;
+
+    if (mdv_mutex_lock(&tablespace->tables_mutex) == MDV_OK)
+    {
+        mdv_rowdata_ref const *ref = mdv_hashmap_find(tablespace->tables, uuid);
+
+        if (ref)
+            epoch = ref->changed;
+
+        mdv_mutex_unlock(&tablespace->tables_mutex);
+    }
+
+    return epoch;
+}
+
+
+/**
+ * @brief Releases the expired read snapshots.
+ */
+static void mdv_tablespace_snapshots_expire(mdv_tablespace *tablespace)
+{
+    enum { MDV_EXPIRED_BATCH = 16 };
+
+    size_t const now = mdv_gettime();
+
+    size_t count = 0;
+
+    do
+    {
+        mdv_snapshot *expired[MDV_EXPIRED_BATCH];
+
+        count = 0;
+
+        if (mdv_mutex_lock(&tablespace->snapshots_mutex) != MDV_OK)
+            return;
+
+        mdv_hashmap_foreach(tablespace->snapshots, mdv_snapshot_ref, ref)
+        {
+            if (ref->expires <= now)
+            {
+                expired[count++] = ref->snapshot;
+
+                if (count == MDV_EXPIRED_BATCH)
+                    break;
+            }
+        }
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            uint64_t const id = mdv_snapshot_id(expired[i]);
+            mdv_hashmap_erase(tablespace->snapshots, &id);
+        }
+
+        mdv_mutex_unlock(&tablespace->snapshots_mutex);
+
+        // Pinned transactions are finished outside the lock
+        for(size_t i = 0; i < count; ++i)
+        {
+            MDV_LOGI("Snapshot %llu is expired", (unsigned long long)mdv_snapshot_id(expired[i]));
+            mdv_snapshot_release(expired[i]);
+        }
+    }
+    while(count == MDV_EXPIRED_BATCH);
+}
+
+
+/**
+ * @brief Returns the read snapshot and prolongs its lifetime.
+ */
+static mdv_snapshot * mdv_tablespace_snapshot(mdv_tablespace *tablespace, uint64_t id)
+{
+    mdv_tablespace_snapshots_expire(tablespace);
+
+    mdv_snapshot *snapshot = 0;
+
+    if (mdv_mutex_lock(&tablespace->snapshots_mutex) == MDV_OK)
+    {
+        mdv_snapshot_ref *ref = mdv_hashmap_find(tablespace->snapshots, &id);
+
+        if (ref)
+        {
+            ref->expires = mdv_gettime() + MDV_CONFIG.snapshot.ttl * 1000ull;
+            snapshot = mdv_snapshot_retain(ref->snapshot);
+        }
+
+        mdv_mutex_unlock(&tablespace->snapshots_mutex);
+    }
+
+    if (!snapshot)
+        MDV_LOGE("Snapshot %llu not found", (unsigned long long)id);
+
+    return snapshot;
+}
+
+
+static bool mdv_tablespace_snapshot_create(mdv_tablespace *tablespace, uint64_t *id)
+{
+    mdv_tablespace_snapshots_expire(tablespace);
+
+    mdv_vector *tables = mdv_vector_create(16, sizeof(mdv_rowdata*), &mdv_default_allocator);
+
+    if (!tables)
+    {
+        MDV_LOGE("No memory for snapshot");
+        return false;
+    }
+
+    if (mdv_rwlock_wrlock(&tablespace->apply_lock) != MDV_OK)
+    {
+        MDV_LOGE("Snapshot creation failed");
+        mdv_vector_release(tables);
+        return false;
+    }
+
+    mdv_snapshot *snapshot = mdv_snapshot_create(atomic_fetch_add_explicit(&tablespace->snapshot_id, 1, memory_order_relaxed) + 1,
+                                                 atomic_load_explicit(&tablespace->epoch, memory_order_relaxed));
+
+    bool ret = snapshot != 0;
+
+    mdv_trlogs const *trlogs = atomic_load_explicit(&tablespace->trlogs, memory_order_acquire);
+
+    for(uint32_t i = 0; ret && trlogs && i < trlogs->size; ++i)
+        ret = mdv_snapshot_position_add(snapshot, &trlogs->refs[i].uuid, mdv_trlog_applied_pos(trlogs->refs[i].trlog));
+
+    // Tables are pinned outside the tables mutex
+    if (ret && mdv_mutex_lock(&tablespace->tables_mutex) == MDV_OK)
+    {
+        mdv_hashmap_foreach(tablespace->tables, mdv_rowdata_ref, ref)
+        {
+            if (ret)
+            {
+                ret = mdv_vector_push_back(tables, &ref->rowdata) != 0;
+
+                if (ret)
+                    mdv_rowdata_retain(ref->rowdata);
+                else
+                    MDV_LOGE("No memory for snapshot");
+            }
+        }
+
+        mdv_mutex_unlock(&tablespace->tables_mutex);
+    }
+
+    mdv_rowdata **rowdatas = mdv_vector_data(tables);
+
+    for(size_t i = 0; i < mdv_vector_size(tables); ++i)
+    {
+        if (ret)
+            ret = mdv_snapshot_table_add(snapshot, rowdatas[i]);
+        mdv_rowdata_release(rowdatas[i]);
+    }
+
+    mdv_rwlock_unlock(&tablespace->apply_lock);
+
+    mdv_vector_release(tables);
+
+    if (ret && mdv_mutex_lock(&tablespace->snapshots_mutex) == MDV_OK)
+    {
+        mdv_snapshot_ref const ref =
+        {
+            .id = mdv_snapshot_id(snapshot),
+            .snapshot = snapshot,
+            .expires = mdv_gettime() + MDV_CONFIG.snapshot.ttl * 1000ull
+        };
+
+        ret = mdv_hashmap_insert(tablespace->snapshots, &ref, sizeof ref) != 0;
+
+        mdv_mutex_unlock(&tablespace->snapshots_mutex);
+
+        if (!ret)
+            MDV_LOGE("No memory for snapshot");
+    }
+    else
+        ret = false;
+
+    if (!ret)
+    {
+        MDV_LOGE("Snapshot creation failed");
+        mdv_snapshot_release(snapshot);
+        return false;
+    }
+
+    *id = mdv_snapshot_id(snapshot);
+
+    MDV_LOGI("Snapshot %llu is created", (unsigned long long)*id);
+
+    return true;
+}
+
+
+static bool mdv_tablespace_snapshot_release(mdv_tablespace *tablespace, uint64_t id)
+{
+    mdv_snapshot *snapshot = 0;
+
+    if (mdv_mutex_lock(&tablespace->snapshots_mutex) == MDV_OK)
+    {
+        mdv_snapshot_ref *ref = mdv_hashmap_find(tablespace->snapshots, &id);
+
+        if (ref)
+        {
+            snapshot = ref->snapshot;
+            mdv_hashmap_erase(tablespace->snapshots, &id);
+        }
+
+        mdv_mutex_unlock(&tablespace->snapshots_mutex);
+    }
+
+    if (!snapshot)
+    {
+        MDV_LOGE("Snapshot %llu not found", (unsigned long long)id);
+        return false;
+    }
+
+    mdv_snapshot_release(snapshot);
+
+    return true;
+}
+
+
+/**
+ * @brief Locks the table in the read snapshot.
+ * @details Tables which weren't opened at the moment of the snapshot creation are pinned on the first access.
+ *          It is possible only if the table wasn't changed since the snapshot creation.
+ */
+static mdv_rowdata * mdv_tablespace_snapshot_table(mdv_tablespace   *tablespace,
+                                                   mdv_snapshot     *snapshot,
+                                                   mdv_uuid const   *table_id,
+                                                   mdv_transaction **transaction)
+{
+    mdv_rowdata *rowdata = mdv_snapshot_table_lock(snapshot, table_id, transaction);
+
+    if (rowdata)
+        return rowdata;
+
+    if (mdv_rwlock_wrlock(&tablespace->apply_lock) != MDV_OK)
+        return 0;
+
+    bool pinned = false;
+
+    rowdata = mdv_tablespace_rowdata(tablespace, table_id, 0);
+
+    if (rowdata)
+    {
+        if (mdv_tablespace_table_epoch(tablespace, table_id) <= mdv_snapshot_epoch(snapshot))
+            pinned = mdv_snapshot_table_add(snapshot, rowdata);
+        else
+            MDV_LOGE("Table '%s' was changed after the snapshot %llu creation",
+                     mdv_uuid_to_str(table_id).ptr,
+                     (unsigned long long)mdv_snapshot_id(snapshot));
+
+        mdv_rowdata_release(rowdata);
+    }
+
+    mdv_rwlock_unlock(&tablespace->apply_lock);
+
+    return pinned
+            ? mdv_snapshot_table_lock(snapshot, table_id, transaction)
+            : 0;
+}
+
+
+/**
+ * @brief Prepares the table for reading. If the snapshot identifier isn't zero, the table is read from the snapshot.
+ */
+static bool mdv_tablespace_reader_open(mdv_tablespace *tablespace, mdv_uuid const *table_id, uint64_t snapshot_id, mdv_tablespace_reader *reader)
+{
+    *reader = (mdv_tablespace_reader) { 0 };
+
+    if (!snapshot_id)
+    {
+        reader->rowdata = mdv_tablespace_rowdata(tablespace, table_id, 0);
+        return reader->rowdata != 0;
+    }
+
+    reader->snapshot = mdv_tablespace_snapshot(tablespace, snapshot_id);
+
+    if (!reader->snapshot)
+        return false;
+
+    reader->rowdata = mdv_tablespace_snapshot_table(tablespace, reader->snapshot, table_id, &reader->transaction);
+
+    if (!reader->rowdata)
+    {
+        mdv_snapshot_release(reader->snapshot);
+        reader->snapshot = 0;
+        return false;
+    }
+
+    return true;
+}
+
+
+static void mdv_tablespace_reader_close(mdv_tablespace_reader *reader)
+{
+    if (reader->snapshot)
+    {
+        mdv_snapshot_unlock(reader->snapshot);
+        mdv_snapshot_release(reader->snapshot);
+    }
+    else
+        mdv_rowdata_release(reader->rowdata);
+
+    *reader = (mdv_tablespace_reader) { 0 };
+}
+
+
+static mdv_errno mdv_tablespace_evt_create_table(void *arg, mdv_event *event)
+{
+    mdv_tablespace       *tablespace   = arg;
+    mdv_evt_create_table *create_table = (mdv_evt_create_table *)event;
+
+    if (mdv_tablespace_log_create_table(tablespace, create_table->table))
+    {
+        MDV_LOGI("New table '%s' is created", mdv_uuid_to_str(&create_table->table->id).ptr);
+        return MDV_OK;
+    }
+
+    return MDV_FAILED;
+}
+
+static mdv_errno mdv_tablespace_evt_insert_row(void *arg, mdv_event *event)
+{
+    mdv_tablespace     *tablespace = arg;
+    mdv_evt_insert_row *insert_row = (mdv_evt_insert_row *)event;
+
+    return mdv_tablespace_log_insert_row(tablespace, insert_row)
+                ? MDV_OK
+                : MDV_FAILED;
+}
+
+
+static mdv_errno mdv_tablespace_evt_create_index(void *arg, mdv_event *event)
+{
+    mdv_tablespace       *tablespace   = arg;
+    mdv_evt_create_index *create_index = (mdv_evt_create_index *)event;
+
+    return mdv_tablespace_log_create_index(tablespace, create_index)
+                ? MDV_OK
+                : MDV_FAILED;
+}
+
+
+static mdv_errno mdv_tablespace_evt_select(void *arg, mdv_event *event)
+{
+    mdv_tablespace *tablespace = arg;
+    mdv_evt_select *select     = (mdv_evt_select *)event;
+
+    return mdv_tablespace_select(tablespace, select)
+                ? MDV_OK
+                : MDV_FAILED;
+}
+
+
+static mdv_errno mdv_tablespace_evt_aggregate(void *arg, mdv_event *event)
+{
+    mdv_tablespace    *tablespace = arg;
+    mdv_evt_aggregate *aggregate  = (mdv_evt_aggregate *)event;
+
+    return mdv_tablespace_aggregate(tablespace, aggregate)
+                ? MDV_OK
+                : MDV_FAILED;
+}
+
+
+static mdv_errno mdv_tablespace_evt_create_snapshot(void *arg, mdv_event *event)
+{
+    mdv_tablespace          *tablespace      = arg;
+    mdv_evt_create_snapshot *create_snapshot = (mdv_evt_create_snapshot *)event;
+
+    return mdv_tablespace_snapshot_create(tablespace, &create_snapshot->id)
+                ? MDV_OK
+                : MDV_FAILED;
+}
+
+
+static mdv_errno mdv_tablespace_evt_release_snapshot(void *arg, mdv_event *event)
+{
+    mdv_tablespace           *tablespace       = arg;
+    mdv_evt_release_snapshot *release_snapshot = (mdv_evt_release_snapshot *)event;
+
+    return mdv_tablespace_snapshot_release(tablespace, release_snapshot->id)
+                ? MDV_OK
+                : MDV_FAILED;
+}
+
+
+static mdv_errno mdv_tablespace_evt_trlog_apply(void *arg, mdv_event *event)
+{
+    mdv_tablespace      *tablespace = arg;
+    mdv_evt_trlog_apply *apply      = (mdv_evt_trlog_apply *)event;
+
+    return mdv_tablespace_log_apply(tablespace, &apply->uuid)
+                ? MDV_OK
+                : MDV_FAILED;
+}
+
+
+static const mdv_event_handler_type mdv_tablespace_handlers[] =
+{
+    { MDV_EVT_CREATE_TABLE, mdv_tablespace_evt_create_table },
+    { MDV_EVT_INSERT_ROW,   mdv_tablespace_evt_insert_row },
+    { MDV_EVT_CREATE_INDEX, mdv_tablespace_evt_create_index },
+    { MDV_EVT_SELECT,       mdv_tablespace_evt_select },
+    { MDV_EVT_AGGREGATE,    mdv_tablespace_evt_aggregate },
+    { MDV_EVT_CREATE_SNAPSHOT,  mdv_tablespace_evt_create_snapshot },
+    { MDV_EVT_RELEASE_SNAPSHOT, mdv_tablespace_evt_release_snapshot },
+    { MDV_EVT_TRLOG_APPLY,  mdv_tablespace_evt_trlog_apply },
+};
+
+
+/**
+ * @brief Releases the expired snapshots.
+ * @details Storage memory map resizing waits for the pinned transactions,
+ *          so the expired snapshots are released even if there are no user requests.
+ */
+static void * mdv_tablespace_reaper(void *arg)
+{
+    mdv_tablespace *tablespace = arg;
+
+    for(uint32_t ticks = 1; atomic_load(&tablespace->active); ++ticks)
+    {
+        mdv_sleep(100);
+
+        if (ticks % 10 == 0)
+            mdv_tablespace_snapshots_expire(tablespace);
+    }
+
+    return 0;
+}
+
+
+static void mdv_tablespace_reaper_stop(mdv_tablespace *tablespace)
+{
+    atomic_store(&tablespace->active, false);
+    mdv_thread_join(tablespace->reaper);
+}
+
+
+mdv_tablespace * mdv_tablespace_open(mdv_uuid const *uuid, mdv_ebus *ebus, mdv_jobber_config const *jconfig)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(12);
+
+    mdv_tablespace *tablespace = mdv_alloc(sizeof(mdv_tablespace), "tablespace");
+
+    if (!tablespace)
+    {
+        MDV_LOGE("No memory for new tablespace");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, tablespace, "tablespace");
+
+    tablespace->uuid = *uuid;
+
+    mdv_errno err = mdv_mutex_create(&tablespace->trlogs_mutex);
+
+    if (err != MDV_OK)
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &tablespace->trlogs_mutex);
+
+    atomic_init(&tablespace->trlogs, 0);
+
+    err = mdv_mutex_create(&tablespace->tables_mutex);
+
+    if (err != MDV_OK)
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &tablespace->tables_mutex);
+
+    tablespace->tables = mdv_hashmap_create(mdv_rowdata_ref,
+                                            uuid,
+                                            64,
+                                            mdv_uuid_hash,
+                                            mdv_uuid_cmp);
+
+    if (!tablespace->tables)
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_hashmap_release, tablespace->tables);
+
+    if (mdv_rwlock_create(&tablespace->apply_lock) != MDV_OK)
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_rwlock_free, &tablespace->apply_lock);
+
+    err = mdv_mutex_create(&tablespace->snapshots_mutex);
+
+    if (err != MDV_OK)
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &tablespace->snapshots_mutex);
+
+    tablespace->snapshots = mdv_hashmap_create(mdv_snapshot_ref,
+                                               id,
+                                               16,
+                                               mdv_u64_hash,
+                                               mdv_u64_keys_cmp);
+
+    if (!tablespace->snapshots)
+    {
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_hashmap_release, tablespace->snapshots);
+
+    atomic_init(&tablespace->epoch, 0);
+    atomic_init(&tablespace->snapshot_id, 0);
+    atomic_init(&tablespace->active, true);
+
+    tablespace->jobber = mdv_jobber_create(jconfig);
+
+    if (!tablespace->jobber)
+    {
+        MDV_LOGE("Jobs scheduler creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_jobber_release, tablespace->jobber);
+
+    tablespace->partitioner = 0;
+
+    if (MDV_CONFIG.committer.partitions)
+    {
+        mdv_jobber_config const pconfig =
+        {
+            .threadpool =
+            {
+                .size = MDV_CONFIG.committer.partitions,
+                .thread_attrs =
+                {
+                    .stack_size = MDV_THREAD_STACK_SIZE
+                }
+            },
+            .queue =
+            {
+                .count = 1
+            }
+        };
+
+        tablespace->partitioner = mdv_jobber_create(&pconfig);
+
+        if (!tablespace->partitioner)
+        {
+            MDV_LOGE("Jobs scheduler creation failed");
+            mdv_rollback(rollbacker);
+            return 0;
+        }
+
+        mdv_rollbacker_push(rollbacker, mdv_jobber_release, tablespace->partitioner);
+    }
+
+    tablespace->pipeliner = 0;
+
+    if (MDV_CONFIG.committer.pipeline)
+    {
+        mdv_jobber_config const pconfig =
+        {
+            .threadpool =
+            {
+                .size = MDV_CONFIG.committer.pipeline,
+                .thread_attrs =
+                {
+                    .stack_size = MDV_THREAD_STACK_SIZE
+                }
+            },
+            .queue =
+            {
+                .count = 1
+            }
+        };
+
+        tablespace->pipeliner = mdv_jobber_create(&pconfig);
+
+        if (!tablespace->pipeliner)
+        {
+            MDV_LOGE("Jobs scheduler creation failed");
+            mdv_rollback(rollbacker);
+            return 0;
+        }
+
+        mdv_rollbacker_push(rollbacker, mdv_jobber_release, tablespace->pipeliner);
+    }
+
+    mdv_thread_attrs const attrs =
+    {
+        .stack_size = MDV_THREAD_STACK_SIZE
+    };
+
+    if (mdv_thread_create(&tablespace->reaper, &attrs, mdv_tablespace_reaper, tablespace) != MDV_OK)
+    {
+        MDV_LOGE("Snapshots reaper thread creation failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_tablespace_reaper_stop, tablespace);
+
+    tablespace->ebus = mdv_ebus_retain(ebus);
+
+    mdv_rollbacker_push(rollbacker, mdv_ebus_release, tablespace->ebus);
+
+    if (mdv_ebus_subscribe_all(tablespace->ebus,
+                               tablespace,
+                               mdv_tablespace_handlers,
+                               sizeof mdv_tablespace_handlers / sizeof *mdv_tablespace_handlers) != MDV_OK)
+    {
+        MDV_LOGE("Ebus subscription failed");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    // Data synchronizer doesn't acknowledge replicated positions yet (see mdv_trlog_ack())
+    if (MDV_CONFIG.cluster.size && MDV_CONFIG.trlog.checkpoint_batch)
+        MDV_LOGW("TR log checkpoint is disabled in cluster mode. Transaction logs aren't truncated.");
+
+    mdv_rollbacker_free(rollbacker);
+
+    return tablespace;
+}
+
+
+void mdv_tablespace_close(mdv_tablespace *tablespace)
+{
+    if (tablespace)
+    {
+        mdv_ebus_unsubscribe_all(tablespace->ebus,
+                                 tablespace,
+                                 mdv_tablespace_handlers,
+                                 sizeof mdv_tablespace_handlers / sizeof *mdv_tablespace_handlers);
+
+        mdv_ebus_release(tablespace->ebus);
+
+        // Unfinished indexes building is resumed when the table is opened next time
+        atomic_store(&tablespace->active, false);
+
+        mdv_jobber_release(tablespace->jobber);
+
+        mdv_jobber_release(tablespace->partitioner);
+
+        mdv_jobber_release(tablespace->pipeliner);
+
+        mdv_thread_join(tablespace->reaper);
+
+        mdv_hashmap_foreach(tablespace->snapshots, mdv_snapshot_ref, ref)
+        {
+            mdv_snapshot_release(ref->snapshot);
+        }
+
+        mdv_hashmap_release(tablespace->snapshots);
+
+        mdv_mutex_free(&tablespace->snapshots_mutex);
+
+        mdv_rwlock_free(&tablespace->apply_lock);
+
+        mdv_trlogs_free(atomic_load(&tablespace->trlogs));
+
+        mdv_mutex_free(&tablespace->trlogs_mutex);
+
+        mdv_hashmap_foreach(tablespace->tables, mdv_rowdata_ref, ref)
+        {
+            mdv_rowdata_release(ref->rowdata);
+        }
+
+        mdv_hashmap_release(tablespace->tables);
+
+        mdv_mutex_free(&tablespace->tables_mutex);
+
+        mdv_free(tablespace, "tablespace");
+    }
+}
+
+static void mdv_tablespace_trlog_changed_notify(mdv_tablespace *tablespace, mdv_uuid const *storage)
+{
+    mdv_evt_trlog_changed *evt = mdv_evt_trlog_changed_create(storage);
+
+    if (evt)
+    {
+        mdv_ebus_publish(tablespace->ebus, &evt->base, MDV_EVT_DEFAULT);
+        mdv_evt_trlog_changed_release(evt);
+    }
+}
+
+
+/**
+ * @brief Writes new DB operation to the current node transaction log.
+ *
+ * @param tablespace [in]   Pointer to a tablespace structure
+ * @param type [in]         DB operation type
+ * @param obj [in]          Serialized DB operation
+ * @param id [out]          Transaction log record identifier
+ *
+ * @return true if operation successfully completed.
+ */
+static bool mdv_tablespace_log_op(mdv_tablespace *tablespace, uint32_t type, binn *obj, uint64_t *id)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(2);
+
+    mdv_trlog *trlog = mdv_tablespace_trlog_create(tablespace, &tablespace->uuid);
+
+    if (!trlog)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_trlog_release, trlog);
+
+    int const binn_obj_size = binn_size(obj);
+
+    size_t const op_size = offsetof(mdv_trlog_op, payload)
+                            + binn_obj_size;
+
+    mdv_trlog_op *op = mdv_staligned_alloc(sizeof(uint64_t), op_size, "trlog_op");
+
+    if (!op)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_stfree, op, "trlog_op");
+
+    op->size = op_size;
+    op->type = type;
+    memcpy(op->payload, binn_ptr(obj), binn_obj_size);
+
+    if (!mdv_trlog_add_op(trlog, op, id))
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollback(rollbacker);
+
+    mdv_tablespace_trlog_changed_notify(tablespace, &tablespace->uuid);
+
+    return true;
+}
+
+
+static bool mdv_tablespace_log_create_table(mdv_tablespace *tablespace, mdv_table_base *table)
+{
+    table->id = mdv_uuid_generate();
+
+    binn obj;
+
+    if (!mdv_binn_table(table, &obj))
+        return false;
+
+    bool const ret = mdv_tablespace_log_op(tablespace, MDV_OP_TABLE_CREATE, &obj, 0);
+
+    binn_free(&obj);
+
+    // Table storage is created without waiting for the log applying, so the rows can be checked on insertion
+    return ret
+            && mdv_tablespace_create_table(tablespace, table);
+}
+
+
+static bool mdv_tablespace_log_insert_row(mdv_tablespace *tablespace, mdv_evt_insert_row *evt)
+{
+    // Row is checked before logging, so the invalid rows are rejected instead of being skipped by the applying
+    mdv_rowdata *rowdata = mdv_tablespace_rowdata(tablespace, &evt->table, 0);
+
+    if (!rowdata)
+    {
+        MDV_LOGE("Row insertion failed. Table '%s' not found.", mdv_uuid_to_str(&evt->table).ptr);
+        return false;
+    }
+
+    bool const valid = mdv_rowdata_row_check(rowdata, &evt->row);
+
+    mdv_rowdata_release(rowdata);
+
+    if (!valid)
+    {
+        MDV_LOGE("Row insertion failed. Invalid row.");
+        return false;
+    }
+
+    binn obj;
+
+    if (!binn_create_object(&obj))
+    {
+        MDV_LOGE("binn_insert_row failed");
+        return false;
+    }
+
+    if (0
+        || !binn_object_set_uint64(&obj, "U0", evt->table.u64[0])
+        || !binn_object_set_uint64(&obj, "U1", evt->table.u64[1])
+        || !binn_object_set_blob(&obj, "R", evt->row.ptr, (int)evt->row.size))
+    {
+        MDV_LOGE("binn_insert_row failed");
+        binn_free(&obj);
+        return false;
+    }
+
+    uint64_t id = 0;
+
+    bool const ret = mdv_tablespace_log_op(tablespace, MDV_OP_ROW_INSERT, &obj, &id);
+
+    binn_free(&obj);
+
+    if (ret)
+    {
+        evt->row_id.node = tablespace->uuid;
+        evt->row_id.id = id;
+    }
+
+    return ret;
+}
+
+
+static bool mdv_tablespace_log_create_index(mdv_tablespace *tablespace, mdv_evt_create_index const *evt)
+{
+    binn obj;
+
+    if (!binn_create_object(&obj))
+    {
+        MDV_LOGE("binn_create_index failed");
+        return false;
+    }
+
+    binn *fields = binn_list();
+
+    if (!fields)
+    {
+        MDV_LOGE("binn_create_index failed");
+        binn_free(&obj);
+        return false;
+    }
+
+    bool ret = true;
+
+    for(uint32_t i = 0; ret && i < evt->size; ++i)
+        ret = binn_list_add_uint32(fields, evt->fields[i]);
+
+    if (0
+        || !ret
+        || !binn_object_set_uint64(&obj, "U0", evt->table.u64[0])
+        || !binn_object_set_uint64(&obj, "U1", evt->table.u64[1])
+        || !binn_object_set_list(&obj, "F", fields))
+    {
+        MDV_LOGE("binn_create_index failed");
+        binn_free(fields);
+        binn_free(&obj);
+        return false;
+    }
+
+    binn_free(fields);
+
+    ret = mdv_tablespace_log_op(tablespace, MDV_OP_INDEX_CREATE, &obj, 0);
+
+    binn_free(&obj);
+
+    return ret;
+}
+
+
+static bool mdv_tablespace_create_table(mdv_tablespace *tablespace, mdv_table_base const *table)
+{
+    mdv_rowdata *rowdata = mdv_tablespace_rowdata(tablespace, &table->id, table);
+
+    if (!rowdata)
+    {
+        MDV_LOGE("Table '%s' storage wasn't created", mdv_uuid_to_str(&table->id).ptr);
+        return false;
+    }
+
+    mdv_rowdata_release(rowdata);
+
+    return true;
+}
+
+
+static bool mdv_tablespace_create_index(mdv_tablespace *tablespace, binn *obj)
+{
+    mdv_uuid table_id;
+    void *list = 0;
+
+    if (0
+        || !binn_object_get_uint64(obj, "U0", (uint64 *)(table_id.u64 + 0))
+        || !binn_object_get_uint64(obj, "U1", (uint64 *)(table_id.u64 + 1))
+        || !binn_object_get_list(obj, "F", &list))
+    {
+        MDV_LOGE("Index creation failed. Invalid TR log operation.");
+        return false;
+    }
+
+    int const count = binn_count(list);
+
+    if (count <= 0 || count > MDV_INDEX_FIELDS_MAX)
+    {
+        MDV_LOGE("Index creation failed. Invalid TR log operation.");
+        return false;
+    }
+
+    uint32_t fields[MDV_INDEX_FIELDS_MAX];
+
+    for(int i = 0; i < count; ++i)
+    {
+        if (!binn_list_get_uint32(list, i + 1, fields + i))
+        {
+            MDV_LOGE("Index creation failed. Invalid TR log operation.");
+            return false;
+        }
+    }
+
+    mdv_rowdata *rowdata = mdv_tablespace_rowdata(tablespace, &table_id, 0);
+
+    if (!rowdata)
+    {
+        MDV_LOGE("Index creation failed. Table '%s' not found.", mdv_uuid_to_str(&table_id).ptr);
+        return false;
+    }
+
+    uint32_t index_id = 0;
+
+    bool const ret = mdv_rowdata_index_create(rowdata, (uint32_t)count, fields, &index_id);
+
+    if (ret)
+    {
+        MDV_LOGI("Index %u for table '%s' is created", index_id, mdv_uuid_to_str(&table_id).ptr);
+
+        mdv_rowdata_index_state state;
+
+        if (mdv_rowdata_index_progress(rowdata, index_id, &state) && !state.ready)
+            mdv_tablespace_index_build(tablespace, rowdata, index_id);
+    }
+
+    mdv_rowdata_release(rowdata);
+
+    return ret;
+}
+
+
+/// Rows selection context
+typedef struct
+{
+    mdv_evt_select *evt;            ///< Rows selection request
+    mdv_filter     *filter;         ///< Rows filter (NULL - all rows are selected)
+    uint32_t        offset;         ///< Index of the first requested field column in scanned columns
+    mdv_field      *fields;         ///< Requested fields descriptions
+    mdv_row_codec  *codec;          ///< Requested fields codec
+    mdv_row_base   *row;            ///< Requested fields values
+    uint8_t        *buf;            ///< Aligned buffer for fields values
+    size_t          capacity;       ///< Buffer size
+    uint32_t        count;          ///< Number of selected rows
+    size_t          size;           ///< Serialized rows size
+    bool            ok;             ///< Selection status
+} mdv_tablespace_selection;
+
+
+/// Maximum size of the selected rows which are returned at once
+enum { MDV_TABLESPACE_SELECT_SIZE_MAX = MDV_MSG_SIZE_MAX / 2 };
+
+
+/**
+ * @brief Copies the requested fields values of the row into the aligned buffer.
+ */
+static bool mdv_tablespace_select_row(mdv_tablespace_selection *selection, mdv_column const *columns, uint32_t idx)
+{
+    uint32_t const size = selection->evt->size;
+
+    size_t buf_size = 0;
+
+    for(uint32_t i = 0; i < size; ++i)
+    {
+        selection->row->fields[i] = mdv_column_value(columns + selection->offset + i, idx);
+        buf_size += (selection->row->fields[i].size + 7u) & ~7u;
+    }
+
+    if (buf_size > selection->capacity)
+    {
+        if (!mdv_realloc2((void**)&selection->buf, buf_size, "selection_buf"))
+        {
+            MDV_LOGE("No memory for selected row");
+            return false;
+        }
+
+        selection->capacity = buf_size;
+    }
+
+    // Values in column segments aren't aligned
+    uint8_t *ptr = selection->buf;
+
+    for(uint32_t i = 0; i < size; ++i)
+    {
+        mdv_data *field = selection->row->fields + i;
+        memcpy(ptr, field->ptr, field->size);
+        field->ptr = ptr;
+        ptr += (field->size + 7u) & ~7u;
+    }
+
+    return true;
+}
+
+
+static bool mdv_tablespace_select_add(mdv_tablespace_selection *selection, uint64_t first_row, mdv_column const *columns, uint32_t idx)
+{
+    mdv_evt_select *evt = selection->evt;
+
+    if ((evt->limit && selection->count >= evt->limit)
+        || selection->size >= MDV_TABLESPACE_SELECT_SIZE_MAX)
+    {
+        evt->next = first_row + idx;
+        return false;
+    }
+
+    mdv_data row;
+
+    if (!mdv_tablespace_select_row(selection, columns, idx)
+        || !mdv_row_codec_pack(selection->codec, selection->row, &row))
+    {
+        selection->ok = false;
+        return false;
+    }
+
+    if (!binn_list_add_blob(evt->rows, row.ptr, (int)row.size)
+        || !binn_list_add_uint64(evt->ids, first_row + idx))
+    {
+        MDV_LOGE("No memory for selected rows");
+        mdv_free(row.ptr, "packed_row");
+        selection->ok = false;
+        return false;
+    }
+
+    selection->size += row.size;
+    selection->count++;
+
+    mdv_free(row.ptr, "packed_row");
+
+    return true;
+}
+
+
+static bool mdv_tablespace_select_fn(void *arg, uint64_t first_row, mdv_column const *columns)
+{
+    mdv_tablespace_selection *selection = arg;
+    mdv_evt_select *evt = selection->evt;
+
+    uint32_t const count = columns[0].count;
+
+    uint32_t idx = evt->first > first_row
+                        ? (uint32_t)(evt->first - first_row)
+                        : 0;
+
+    mdv_bitset *selected = 0;
+
+    if (selection->filter)
+    {
+        selected = mdv_bitset_create(count, &mdv_default_allocator);
+
+        if (!selected
+            || !mdv_filter_apply(selection->filter, columns, selected))
+        {
+            mdv_bitset_free(selected);
+            selection->ok = false;
+            return false;
+        }
+    }
+
+    bool ret = true;
+
+    for(; idx < count && ret; ++idx)
+    {
+        if (selected
+            && !mdv_bitset_test(selected, idx))
+            continue;
+
+        ret = mdv_tablespace_select_add(selection, first_row, columns, idx);
+    }
+
+    mdv_bitset_free(selected);
+
+    return ret;
+}
+
+
+static bool mdv_tablespace_select(mdv_tablespace *tablespace, mdv_evt_select *evt)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(6);
+
+    mdv_tablespace_reader reader;
+
+    if (!mdv_tablespace_reader_open(tablespace, &evt->table, evt->snapshot, &reader))
+    {
+        MDV_LOGE("Rows selection failed. Table '%s' not found.", mdv_uuid_to_str(&evt->table).ptr);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_tablespace_reader_close, &reader);
+
+    mdv_rowdata *rowdata = reader.rowdata;
+
+    mdv_table_base const *table = mdv_rowdata_table(rowdata);
+
+    if (!evt->size)
+    {
+        MDV_LOGE("Rows selection failed. No fields requested.");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    for(uint32_t i = 0; i < evt->size; ++i)
+    {
+        if (evt->fields[i] >= table->size)
+        {
+            MDV_LOGE("Rows selection failed. Invalid field: %u", evt->fields[i]);
+            mdv_rollback(rollbacker);
+            return false;
+        }
+    }
+
+    mdv_tablespace_selection selection =
+    {
+        .evt = evt,
+        .ok = true
+    };
+
+    uint32_t const *filter_columns = 0;
+
+    if (evt->predicate)
+    {
+        selection.filter = mdv_filter_create(table, evt->predicate);
+
+        if (!selection.filter)
+        {
+            MDV_LOGE("Rows selection failed. Invalid predicate.");
+            mdv_rollback(rollbacker);
+            return false;
+        }
+
+        mdv_rollbacker_push(rollbacker, mdv_filter_free, selection.filter);
+
+        selection.offset = mdv_filter_columns(selection.filter, &filter_columns);
+    }
+
+    // Scanned columns are the filter columns followed by the requested fields
+    uint32_t const columns_count = selection.offset + evt->size;
+
+    uint32_t *columns = mdv_alloc(columns_count * sizeof(uint32_t)
+                                  + evt->size * sizeof(mdv_field)
+                                  + offsetof(mdv_row_base, fields) + evt->size * sizeof(mdv_data),
+                                  "selection");
+
+    if (!columns)
+    {
+        MDV_LOGE("No memory for rows selection");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, columns, "selection");
+
+    selection.fields = (mdv_field *)(columns + columns_count + (columns_count & 1));
+    selection.row = (mdv_row_base *)(selection.fields + evt->size);
+    selection.row->size = evt->size;
+
+    memcpy(columns, filter_columns, selection.offset * sizeof *columns);
+    memcpy(columns + selection.offset, evt->fields, evt->size * sizeof *columns);
+
+    for(uint32_t i = 0; i < evt->size; ++i)
+        selection.fields[i] = table->fields[evt->fields[i]];
+
+    selection.codec = mdv_row_codec_create(selection.fields, evt->size);
+
+    if (!selection.codec)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_row_codec_free, selection.codec);
+
+    evt->ids = binn_list();
+    evt->rows = binn_list();
+
+    if (!evt->ids || !evt->rows)
+    {
+        MDV_LOGE("No memory for selected rows");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    evt->next = 0;
+
+    bool const ret = mdv_rowdata_scan(rowdata,
+                                      reader.transaction,
+                                      evt->first,
+                                      columns_count,
+                                      columns,
+                                      &selection,
+                                      mdv_tablespace_select_fn)
+                        && selection.ok;
+
+    mdv_free(selection.buf, "selection_buf");
+
+    mdv_rollback(rollbacker);
+
+    return ret;
+}
+
+
+/// Rows aggregation context
+typedef struct
+{
+    mdv_evt_aggregate  *evt;            ///< Rows aggregation request
+    mdv_filter         *filter;         ///< Rows filter (NULL - all rows are aggregated)
+    uint32_t            offset;         ///< Index of the first aggregator column in scanned columns
+    mdv_aggregator     *aggregator;     ///< Rows aggregator
+    mdv_row_codec      *codec;          ///< Result rows codec
+    uint32_t            count;          ///< Number of groups
+    size_t              size;           ///< Serialized groups size
+    bool                ok;             ///< Aggregation status
+} mdv_tablespace_aggregation;
+
+
+static bool mdv_tablespace_aggregate_fn(void *arg, uint64_t first_row, mdv_column const *columns)
+{
+    mdv_tablespace_aggregation *aggregation = arg;
+
+    (void)first_row;
+
+    mdv_bitset *selected = 0;
+
+    if (aggregation->filter)
+    {
+        selected = mdv_bitset_create(columns[0].count, &mdv_default_allocator);
+
+        if (!selected
+            || !mdv_filter_apply(aggregation->filter, columns, selected))
+        {
+            mdv_bitset_free(selected);
+            aggregation->ok = false;
+            return false;
+        }
+    }
+
+    aggregation->ok = mdv_aggregator_add(aggregation->aggregator, columns + aggregation->offset, selected);
+
+    mdv_bitset_free(selected);
+
+    return aggregation->ok;
+}
+
+
+static bool mdv_tablespace_aggregate_row(void *arg, mdv_row_base const *row)
+{
+    mdv_tablespace_aggregation *aggregation = arg;
+    mdv_evt_aggregate *evt = aggregation->evt;
+
+    if (aggregation->size >= MDV_TABLESPACE_SELECT_SIZE_MAX)
+    {
+        MDV_LOGE("Rows aggregation failed. Too many groups.");
+        return false;
+    }
+
+    mdv_data packed;
+
+    if (!mdv_row_codec_pack(aggregation->codec, row, &packed))
+        return false;
+
+    if (!binn_list_add_blob(evt->rows, packed.ptr, (int)packed.size)
+        || !binn_list_add_uint64(evt->ids, ++aggregation->count))
+    {
+        MDV_LOGE("No memory for aggregated rows");
+        mdv_free(packed.ptr, "packed_row");
+        return false;
+    }
+
+    aggregation->size += packed.size;
+
+    mdv_free(packed.ptr, "packed_row");
+
+    return true;
+}
+
+
+static bool mdv_tablespace_aggregate(mdv_tablespace *tablespace, mdv_evt_aggregate *evt)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(5);
+
+    mdv_tablespace_reader reader;
+
+    if (!mdv_tablespace_reader_open(tablespace, &evt->table, evt->snapshot, &reader))
+    {
+        MDV_LOGE("Rows aggregation failed. Table '%s' not found.", mdv_uuid_to_str(&evt->table).ptr);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_tablespace_reader_close, &reader);
+
+    mdv_rowdata *rowdata = reader.rowdata;
+
+    mdv_table_base const *table = mdv_rowdata_table(rowdata);
+
+    mdv_tablespace_aggregation aggregation =
+    {
+        .evt = evt,
+        .ok = true
+    };
+
+    aggregation.aggregator = mdv_aggregator_create(table,
+                                                   evt->groups_size,
+                                                   evt->groups,
+                                                   evt->size,
+                                                   evt->aggregates);
+
+    if (!aggregation.aggregator)
+    {
+        MDV_LOGE("Rows aggregation failed. Invalid aggregate functions.");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_aggregator_free, aggregation.aggregator);
+
+    mdv_field const *fields = 0;
+    uint32_t const fields_count = mdv_aggregator_fields(aggregation.aggregator, &fields);
+
+    aggregation.codec = mdv_row_codec_create(fields, fields_count);
+
+    if (!aggregation.codec)
+    {
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_row_codec_free, aggregation.codec);
+
+    uint32_t const *filter_columns = 0;
+
+    if (evt->predicate)
+    {
+        aggregation.filter = mdv_filter_create(table, evt->predicate);
+
+        if (!aggregation.filter)
+        {
+            MDV_LOGE("Rows aggregation failed. Invalid predicate.");
+            mdv_rollback(rollbacker);
+            return false;
+        }
+
+        mdv_rollbacker_push(rollbacker, mdv_filter_free, aggregation.filter);
+
+        aggregation.offset = mdv_filter_columns(aggregation.filter, &filter_columns);
+    }
+
+    // Scanned columns are the filter columns followed by the aggregator columns
+    uint32_t const *aggregator_columns = 0;
+    uint32_t const aggregator_count = mdv_aggregator_columns(aggregation.aggregator, &aggregator_columns);
+    uint32_t const columns_count = aggregation.offset + aggregator_count;
+
+    uint32_t *columns = mdv_alloc(columns_count * sizeof(uint32_t), "aggregation.columns");
+
+    if (!columns)
+    {
+        MDV_LOGE("No memory for rows aggregation");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_free, columns, "aggregation.columns");
+
+    memcpy(columns, filter_columns, aggregation.offset * sizeof *columns);
+    memcpy(columns + aggregation.offset, aggregator_columns, aggregator_count * sizeof *columns);
+
+    evt->ids = binn_list();
+    evt->rows = binn_list();
+
+    if (!evt->ids || !evt->rows)
+    {
+        MDV_LOGE("No memory for aggregated rows");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    bool const ret = mdv_rowdata_scan(rowdata,
+                                      reader.transaction,
+                                      1,
+                                      columns_count,
+                                      columns,
+                                      &aggregation,
+                                      mdv_tablespace_aggregate_fn)
+                        && aggregation.ok
+                        && mdv_aggregator_result(aggregation.aggregator,
+                                                 &aggregation,
+                                                 mdv_tablespace_aggregate_row);
+
+    mdv_rollback(rollbacker);
+
+    return ret;
+}
+
+
+/**
+ * @brief Reads the table identifier and the serialized row from the row insertion operation.
+ */
+static bool mdv_tablespace_row_parse(binn *obj, mdv_uuid *table_id, mdv_data *row)
+{
+    int size = 0;
+
+    if (0
+        || !binn_object_get_uint64(obj, "U0", (uint64 *)(table_id->u64 + 0))
+        || !binn_object_get_uint64(obj, "U1", (uint64 *)(table_id->u64 + 1))
+        || !binn_object_get_blob(obj, "R", &row->ptr, &size))
+    {
+        MDV_LOGE("Row insertion failed. Invalid TR log operation.");
+        return false;
+    }
+
+    row->size = (uint32_t)size;
+
+    return true;
+}
+
+
+static void mdv_tablespace_rows_free(mdv_vector *rows)
+{
+    mdv_row_base **data = mdv_vector_data(rows);
+
+    for(size_t i = 0; i < mdv_vector_size(rows); ++i)
+        mdv_free(data[i], "row");
+
+    mdv_vector_clear(rows);
+}
+
+
+/**
+ * @brief Returns the rows which should be inserted into the table. New entry is created if it doesn't exist.
+ */
+static mdv_table_rows * mdv_tablespace_applier_rows(mdv_tablespace_applier *applier,
+                                                   mdv_uuid const         *table_id,
+                                                   mdv_rowdata            *rowdata)
+{
+    mdv_table_rows *rows = mdv_hashmap_find(applier->tables, table_id);
+
+    if (rows)
+        return rows;
+
+    mdv_table_rows new_rows =
+    {
+        .uuid = *table_id,
+        .trlog = applier->storage,
+        .rowdata = rowdata,
+        .applied = mdv_rowdata_applied_pos(rowdata, &applier->storage)
+    };
+
+    new_rows.last = new_rows.applied;
+
+    new_rows.rows = mdv_vector_create(MDV_CONFIG.committer.batch_size,
+                                      sizeof(mdv_row_base*),
+                                      &mdv_default_allocator);
+
+    if (!new_rows.rows)
+    {
+        MDV_LOGE("No memory for rows");
+        return 0;
+    }
+
+    rows = mdv_hashmap_insert(applier->tables, &new_rows, sizeof new_rows);
+
+    if (!rows)
+    {
+        MDV_LOGE("No memory for rows");
+        mdv_vector_release(new_rows.rows);
+        return 0;
+    }
+
+    mdv_rowdata_retain(rowdata);
+
+    return rows;
+}
+
+
+/**
+ * @brief Adds the decoded row to the table rows. Invalid rows (NULL) are skipped by commit.
+ * @details Row ownership is transferred to the table rows on success.
+ */
+static bool mdv_tablespace_rows_add(mdv_table_rows *rows, uint64_t id, mdv_row_base *row)
+{
+    if (!mdv_vector_push_back(rows->rows, &row))
+    {
+        MDV_LOGE("No memory for rows");
+        return false;
+    }
+
+    rows->last = id;
+
+    return true;
+}
+
+
+static bool mdv_tablespace_insert_row(mdv_tablespace_applier *applier, uint64_t id, binn *obj)
+{
+    mdv_uuid table_id;
+    mdv_data row;
+
+    if (!mdv_tablespace_row_parse(obj, &table_id, &row))
+        return false;
+
+    mdv_table_rows *rows = mdv_hashmap_find(applier->tables, &table_id);
+
+    if (!rows)
+    {
+        mdv_rowdata *rowdata = mdv_tablespace_rowdata(applier->tablespace, &table_id, 0);
+
+        if (!rowdata)
+        {
+            MDV_LOGE("Row insertion failed. Table '%s' not found.", mdv_uuid_to_str(&table_id).ptr);
+            return false;
+        }
+
+        rows = mdv_tablespace_applier_rows(applier, &table_id, rowdata);
+
+        mdv_rowdata_release(rowdata);
+
+        if (!rows)
+            return false;
+    }
+
+    // Row was committed before the transaction log applied position was saved
+    if (id <= rows->applied)
+        return true;
+
+    mdv_row_base *decoded = mdv_rowdata_row_decode(rows->rowdata, &row);
+
+    if (!mdv_tablespace_rows_add(rows, id, decoded))
+    {
+        mdv_free(decoded, "row");
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Applies the tables schema operation (table or index creation).
+ */
+static bool mdv_tablespace_schema_apply(mdv_tablespace *tablespace, uint32_t type, binn *obj, uint64_t epoch)
+{
+    bool ret = true;
+
+    switch(type)
+    {
+        case MDV_OP_TABLE_CREATE:
+        {
+            mdv_table_base *table = mdv_unbinn_table(obj);
+
+            if (table)
+            {
+                ret = mdv_tablespace_create_table(tablespace, table);
+
+                if (ret)
+                    mdv_tablespace_table_changed(tablespace, &table->id, epoch);
+
+                mdv_free(table, "table");
+            }
+            else
+                MDV_LOGE("Table creation failed. Invalid TR log operation.");
+
+            break;
+        }
+
+        case MDV_OP_INDEX_CREATE:
+        {
+            ret = mdv_tablespace_create_index(tablespace, obj);
+            break;
+        }
+
+        default:
+            MDV_LOGE("Unsupported DB operation");
+    }
+
+    return ret;
+}
+
+
+static bool mdv_tablespace_trlog_apply(void *arg, uint64_t id, mdv_trlog_op const *op)
+{
+    mdv_tablespace_applier *applier = arg;
+
+    binn obj;
+
+    if (!binn_load((void*)op->payload, &obj))
+    {
+        MDV_LOGE("Invalid transaction operation");
+        return false;
+    }
+
+    // Operation points into the TR log storage and may be not aligned
+    uint32_t type;
+    memcpy(&type, &op->type, sizeof type);
+
+    bool const ret = type == MDV_OP_ROW_INSERT
+                        ? mdv_tablespace_insert_row(applier, id, &obj)
+                        : mdv_tablespace_schema_apply(applier->tablespace, type, &obj, applier->epoch);
+
+    binn_free(&obj);
+
+    return ret;
+}
+
+
+static void mdv_tablespace_applier_clear(mdv_tablespace_applier *applier)
+{
+    mdv_hashmap_foreach(applier->tables, mdv_table_rows, entry)
+    {
+        mdv_tablespace_rows_free(entry->rows);
+        mdv_vector_release(entry->rows);
+        mdv_rowdata_release(entry->rowdata);
+    }
+
+    mdv_hashmap_clear(applier->tables);
+}
+
+
+/**
+ * @brief Frees the written rows. Tables are kept for the next batch.
+ *
+ * @param applier [in]      Transaction log applier context
+ * @param committed [in]    Rows were successfully committed
+ */
+static void mdv_tablespace_applier_reset(mdv_tablespace_applier *applier, bool committed)
+{
+    mdv_hashmap_foreach(applier->tables, mdv_table_rows, entry)
+    {
+        if (mdv_vector_empty(entry->rows))
+            continue;
+
+        if (committed)
+            entry->applied = entry->last;
+        else
+            entry->last = entry->applied;
+
+        mdv_tablespace_rows_free(entry->rows);
+    }
+}
+
+
+/**
+ * @brief Writes the table rows and the transaction log applied position using one transaction.
+ * @details Rows are applied exactly once, because the applied position is changed only with the rows.
+ */
+static bool mdv_tablespace_rows_commit(mdv_table_rows *rows)
+{
+    mdv_transaction transaction = mdv_transaction_start(mdv_rowdata_storage(rows->rowdata));
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("Rows storage transaction not started");
+        return false;
+    }
+
+    if (!mdv_rowdata_add_rows(rows->rowdata, &transaction, rows->rows)
+        || !mdv_rowdata_applied_pos_set(rows->rowdata, &transaction, &rows->trlog, rows->last))
+    {
+        mdv_transaction_abort(&transaction);
+        return false;
+    }
+
+    if (!mdv_transaction_commit(&transaction))
+    {
+        MDV_LOGE("Rows storage transaction failed");
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool mdv_tablespace_sequential_commit(mdv_tablespace_applier *applier)
+{
+    bool ret = true;
+
+    mdv_hashmap_foreach(applier->tables, mdv_table_rows, entry)
+    {
+        if (!ret || mdv_vector_empty(entry->rows))
+            continue;
+
+        ret = mdv_tablespace_rows_commit(entry);
+
+        if (ret)
+            mdv_tablespace_table_changed(applier->tablespace, &entry->uuid, applier->epoch);
+    }
+
+    return ret;
+}
+
+
+static void mdv_tablespace_partitions_release(mdv_tablespace_partitions *partitions)
+{
+    if (atomic_fetch_sub_explicit(&partitions->rc, 1, memory_order_acq_rel) == 1)
+    {
+        mdv_condvar_free(&partitions->cv);
+        mdv_free(partitions, "partitions");
+    }
+}
+
+
+/**
+ * @brief Commits the unclaimed partitions.
+ */
+static void mdv_tablespace_partitions_commit(mdv_tablespace_partitions *partitions)
+{
+    for(uint32_t i = atomic_fetch_add_explicit(&partitions->next, 1, memory_order_relaxed);
+        i < partitions->size;
+        i = atomic_fetch_add_explicit(&partitions->next, 1, memory_order_relaxed))
+    {
+        mdv_table_rows *rows = partitions->partitions[i];
+
+        // Remaining partitions are skipped after the failure, so the batch is applied again
+        if (atomic_load_explicit(&partitions->ok, memory_order_relaxed))
+        {
+            if (mdv_tablespace_rows_commit(rows))
+                mdv_tablespace_table_changed(partitions->tablespace, &rows->uuid, partitions->epoch);
+            else
+                atomic_store_explicit(&partitions->ok, false, memory_order_relaxed);
+        }
+
+        if (atomic_fetch_add_explicit(&partitions->finished, 1, memory_order_acq_rel) + 1 == partitions->size
+            && mdv_condvar_lock(&partitions->cv) == MDV_OK)
+        {
+            mdv_condvar_broadcast(&partitions->cv);
+            mdv_condvar_unlock(&partitions->cv);
+        }
+    }
+}
+
+
+static void mdv_tablespace_partitioner_fn(mdv_job_base *job)
+{
+    mdv_tablespace_partitioner *ctx = (mdv_tablespace_partitioner *)job->data;
+    mdv_tablespace_partitions_commit(ctx->partitions);
+}
+
+
+static void mdv_tablespace_partitioner_finalize(mdv_job_base *job)
+{
+    mdv_tablespace_partitioner *ctx = (mdv_tablespace_partitioner *)job->data;
+    mdv_tablespace_partitions_release(ctx->partitions);
+    mdv_free(job, "partitioner_job");
+}
+
+
+/**
+ * @brief Commits the tables rows concurrently.
+ * @details Tables are independent and each table is written using its own storage.
+ *          Batch is committed when all partitions are finished, so the applied position advances only after that.
+ */
+static bool mdv_tablespace_partitioned_commit(mdv_tablespace_applier *applier, uint32_t size)
+{
+    mdv_tablespace_partitions *partitions = mdv_alloc(offsetof(mdv_tablespace_partitions, partitions)
+                                                        + size * sizeof(mdv_table_rows*),
+                                                      "partitions");
+
+    if (!partitions)
+    {
+        MDV_LOGW("No memory for partitioned commit");
+        return mdv_tablespace_sequential_commit(applier);
+    }
+
+    if (mdv_condvar_create(&partitions->cv) != MDV_OK)
+    {
+        MDV_LOGW("Partitioned commit failed");
+        mdv_free(partitions, "partitions");
+        return mdv_tablespace_sequential_commit(applier);
+    }
+
+    atomic_init(&partitions->rc, 1);
+    atomic_init(&partitions->next, 0);
+    atomic_init(&partitions->finished, 0);
+    atomic_init(&partitions->ok, true);
+
+    partitions->tablespace = applier->tablespace;
+    partitions->epoch = applier->epoch;
+    partitions->size = 0;
+
+    mdv_hashmap_foreach(applier->tables, mdv_table_rows, entry)
+    {
+        if (!mdv_vector_empty(entry->rows))
+            partitions->partitions[partitions->size++] = entry;
+    }
+
+    // Applier thread commits partitions too
+    for(uint32_t i = 1; i < size; ++i)
+    {
+        mdv_tablespace_partitioner_job *job = mdv_alloc(sizeof(mdv_tablespace_partitioner_job), "partitioner_job");
+
+        if (!job)
+            break;
+
+        job->fn              = mdv_tablespace_partitioner_fn;
+        job->finalize        = mdv_tablespace_partitioner_finalize;
+        job->data.partitions = partitions;
+
+        atomic_fetch_add_explicit(&partitions->rc, 1, memory_order_relaxed);
+
+        if (mdv_jobber_push(applier->tablespace->partitioner, (mdv_job_base*)job) != MDV_OK)
+        {
+            atomic_fetch_sub_explicit(&partitions->rc, 1, memory_order_relaxed);
+            mdv_free(job, "partitioner_job");
+            break;
+        }
+    }
+
+    mdv_tablespace_partitions_commit(partitions);
+
+    if (mdv_condvar_lock(&partitions->cv) == MDV_OK)
+    {
+        while(atomic_load_explicit(&partitions->finished, memory_order_acquire) < partitions->size)
+            mdv_condvar_wait_locked(&partitions->cv, 100);
+
+        mdv_condvar_unlock(&partitions->cv);
+    }
+
+    bool const ret = atomic_load_explicit(&partitions->ok, memory_order_relaxed);
+
+    mdv_tablespace_partitions_release(partitions);
+
+    return ret;
+}
+
+
+/**
+ * @brief Commits the batch rows. All rows for the table are written using one transaction.
+ */
+static bool mdv_tablespace_applier_commit(mdv_tablespace_applier *applier)
+{
+    uint32_t tables = 0;
+
+    mdv_hashmap_foreach(applier->tables, mdv_table_rows, entry)
+    {
+        if (!mdv_vector_empty(entry->rows))
+            ++tables;
+    }
+
+    return applier->tablespace->partitioner && tables > 1
+            ? mdv_tablespace_partitioned_commit(applier, tables)
+            : mdv_tablespace_sequential_commit(applier);
+}
+
+
+static bool mdv_tablespace_trlog_commit(void *arg)
+{
+    mdv_tablespace_applier *applier = arg;
+
+    bool const ret = mdv_tablespace_applier_commit(applier);
+
+    mdv_tablespace_applier_clear(applier);
+
+    return ret;
+}
+
+
+static void mdv_tablespace_pipeline_notify(mdv_tablespace_pipeline *pipeline)
+{
+    if (mdv_condvar_lock(&pipeline->cv) == MDV_OK)
+    {
+        mdv_condvar_broadcast(&pipeline->cv);
+        mdv_condvar_unlock(&pipeline->cv);
+    }
+}
+
+
+static void mdv_tablespace_batch_release(mdv_tablespace_batch *batch)
+{
+    if (batch && atomic_fetch_sub_explicit(&batch->rc, 1, memory_order_acq_rel) == 1)
+    {
+        for(uint32_t i = 0; i < batch->size; ++i)
+        {
+            mdv_free(batch->records[i].row, "row");
+            mdv_rowdata_release(batch->records[i].rowdata);
+        }
+
+        mdv_free(batch, "batch");
+    }
+}
+
+
+static void mdv_tablespace_pipeline_release(mdv_tablespace_pipeline *pipeline)
+{
+    if (atomic_fetch_sub_explicit(&pipeline->rc, 1, memory_order_acq_rel) == 1)
+    {
+        for(uint32_t i = 0; i < MDV_TABLESPACE_PIPELINE_DEPTH; ++i)
+            mdv_tablespace_batch_release(atomic_load(pipeline->batches + i));
+
+        mdv_condvar_free(&pipeline->cv);
+        mdv_trlog_release(pipeline->trlog);
+        mdv_free(pipeline, "pipeline");
+    }
+}
+
+
+/**
+ * @brief Copies the transaction log records. Batch and the operations copies are allocated by one block.
+ */
+static void mdv_tablespace_batch_copy(void *arg, mdv_trlog_view const *ops, size_t count)
+{
+    size_t size = offsetof(mdv_tablespace_batch, records) + count * sizeof(mdv_tablespace_record);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        uint32_t op_size;
+        memcpy(&op_size, &ops[i].op->size, sizeof op_size);
+        size += (op_size + 7u) & ~7u;
+    }
+
+    mdv_tablespace_batch *batch = mdv_alloc(size, "batch");
+
+    if (!batch)
+    {
+        MDV_LOGE("No memory for TR log batch");
+        return;
+    }
+
+    atomic_init(&batch->rc, 1);
+    atomic_init(&batch->next, 0);
+    atomic_init(&batch->decoded, 0);
+
+    batch->size = (uint32_t)count;
+    batch->chunks = 0;
+
+    uint8_t *buf = (uint8_t *)(batch->records + count);
+
+    for(size_t i = 0; i < count; ++i)
+    {
+        uint32_t op_size;
+        memcpy(&op_size, &ops[i].op->size, sizeof op_size);
+
+        batch->records[i] = (mdv_tablespace_record)
+        {
+            .id = ops[i].id,
+            .op = memcpy(buf, ops[i].op, op_size),
+            .ok = true
+        };
+
+        buf += (op_size + 7u) & ~7u;
+    }
+
+    *(mdv_tablespace_batch **)arg = batch;
+}
+
+
+/**
+ * @brief Decodes the row insertion operation.
+ * @details Records of other types are applied by the reader.
+ */
+static void mdv_tablespace_record_decode(mdv_tablespace *tablespace, mdv_tablespace_record *record)
+{
+    if (record->op->type != MDV_OP_ROW_INSERT)
+        return;
+
+    binn obj;
+
+    if (!binn_load(record->op->payload, &obj))
+    {
+        MDV_LOGE("Invalid transaction operation");
+        record->ok = false;
+        return;
+    }
+
+    mdv_data row;
+
+    if (!mdv_tablespace_row_parse(&obj, &record->table, &row))
+        record->ok = false;
+    else
+    {
+        record->rowdata = mdv_tablespace_rowdata(tablespace, &record->table, 0);
+
+        if (record->rowdata)
+            record->row = mdv_rowdata_row_decode(record->rowdata, &row);
+        else
+        {
+            MDV_LOGE("Row insertion failed. Table '%s' not found.", mdv_uuid_to_str(&record->table).ptr);
+            record->ok = false;
+        }
+    }
+
+    binn_free(&obj);
+}
+
+
+/**
+ * @brief Decodes the unclaimed chunks of the batch.
+ *
+ * @return true if all chunks of the batch are decoded
+ */
+static bool mdv_tablespace_batch_decode(mdv_tablespace_pipeline *pipeline, mdv_tablespace_batch *batch)
+{
+    for(uint32_t i = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed);
+        i < batch->chunks;
+        i = atomic_fetch_add_explicit(&batch->next, 1, memory_order_relaxed))
+    {
+        uint32_t const from = (uint32_t)((uint64_t)batch->size * i / batch->chunks);
+        uint32_t const to   = (uint32_t)((uint64_t)batch->size * (i + 1) / batch->chunks);
+
+        for(uint32_t j = from; j < to; ++j)
+            mdv_tablespace_record_decode(pipeline->tablespace, batch->records + j);
+
+        if (atomic_fetch_add_explicit(&batch->decoded, 1, memory_order_acq_rel) + 1 == batch->chunks)
+            mdv_tablespace_pipeline_notify(pipeline);
+    }
+
+    return atomic_load_explicit(&batch->decoded, memory_order_acquire) == batch->chunks;
+}
+
+
+static void mdv_tablespace_decoder_fn(mdv_job_base *job)
+{
+    mdv_tablespace_decoder *ctx = (mdv_tablespace_decoder *)job->data;
+    mdv_tablespace_batch_decode(ctx->pipeline, ctx->batch);
+}
+
+
+static void mdv_tablespace_decoder_finalize(mdv_job_base *job)
+{
+    mdv_tablespace_decoder *ctx = (mdv_tablespace_decoder *)job->data;
+    mdv_tablespace_batch_release(ctx->batch);
+    mdv_tablespace_pipeline_release(ctx->pipeline);
+    mdv_free(job, "decoder_job");
+}
+
+
+/**
+ * @brief Applies the schema operations of the batch and starts the rows decoding.
+ * @details Schema operations are applied before the rows of the batch and the next batches are decoded.
+ *          If the operation isn't applied, the batch is truncated.
+ *
+ * @return true if all records of the batch are prepared
+ */
+static bool mdv_tablespace_batch_prepare(mdv_tablespace_pipeline *pipeline, mdv_tablespace_batch *batch)
+{
+    mdv_tablespace *tablespace = pipeline->tablespace;
+
+    uint32_t n = 0;
+
+    for(; n < batch->size; ++n)
+    {
+        mdv_trlog_op const *op = batch->records[n].op;
+
+        if (op->type == MDV_OP_ROW_INSERT)
+            continue;
+
+        binn obj;
+
+        if (!binn_load((void*)op->payload, &obj))
+        {
+            MDV_LOGE("Invalid transaction operation");
+            break;
+        }
+
+        bool ret = false;
+
+        // Snapshots aren't created while the schema is changed
+        if (mdv_rwlock_rdlock(&tablespace->apply_lock) == MDV_OK)
+        {
+            uint64_t const epoch = atomic_fetch_add_explicit(&tablespace->epoch, 1, memory_order_relaxed) + 1;
+            ret = mdv_tablespace_schema_apply(tablespace, op->type, &obj, epoch);
+            mdv_rwlock_unlock(&tablespace->apply_lock);
+        }
+
+        binn_free(&obj);
+
+        if (!ret)
+            break;
+    }
+
+    bool const ret = n == batch->size;
 
-    if (mdv_mutex_lock(&tablespace->trlogs_mutex) == MDV_OK)
+    batch->size = n;
+    batch->chunks = n < MDV_CONFIG.committer.pipeline ? n : MDV_CONFIG.committer.pipeline;
+
+    for(uint32_t i = 0; i < batch->chunks; ++i)
     {
-        ref = mdv_hashmap_find(tablespace->trlogs, uuid);
-        mdv_mutex_unlock(&tablespace->trlogs_mutex);
-    }
+        mdv_tablespace_decoder_job *job = mdv_alloc(sizeof(mdv_tablespace_decoder_job), "decoder_job");
 
-    if (ref)
-        return mdv_trlog_retain(ref->trlog);
+        if (!job)
+            break;
 
-    return 0;
+        job->fn             = mdv_tablespace_decoder_fn;
+        job->finalize       = mdv_tablespace_decoder_finalize;
+        job->data.pipeline  = pipeline;
+        job->data.batch     = batch;
+
+        atomic_fetch_add_explicit(&pipeline->rc, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&batch->rc, 1, memory_order_relaxed);
+
+        // Chunks which aren't claimed by the decoders are decoded by the writer
+        if (mdv_jobber_push(tablespace->pipeliner, (mdv_job_base*)job) != MDV_OK)
+        {
+            atomic_fetch_sub_explicit(&batch->rc, 1, memory_order_relaxed);
+            atomic_fetch_sub_explicit(&pipeline->rc, 1, memory_order_relaxed);
+            mdv_free(job, "decoder_job");
+            break;
+        }
+    }
+
+    return ret;
 }
 
 
-static mdv_trlog * mdv_tablespace_trlog_create(mdv_tablespace *tablespace, mdv_uuid const *uuid)
+static void mdv_tablespace_prefetcher_fn(mdv_job_base *job)
 {
-    mdv_trlog_ref *ref = 0;
+    mdv_tablespace_prefetcher *ctx = (mdv_tablespace_prefetcher *)job->data;
+    mdv_tablespace_pipeline *pipeline = ctx->pipeline;
+
+    uint_fast32_t state = MDV_PIPELINE_READER_PENDING;
+
+    if (!atomic_compare_exchange_strong(&pipeline->reader, &state, MDV_PIPELINE_READER_RUNNING))
+        return;     // Reader was cancelled by the writer
 
-    if (mdv_mutex_lock(&tablespace->trlogs_mutex) == MDV_OK)
+    uint64_t pos = mdv_trlog_applied_pos(pipeline->trlog) + 1;
+
+    for(uint32_t tail = 0;
+        atomic_load(&pipeline->active) && atomic_load(&pipeline->tablespace->active);
+        ++tail)
     {
-        ref = mdv_hashmap_find(tablespace->trlogs, uuid);
+        _Atomic(mdv_tablespace_batch *) *slot = pipeline->batches + tail % MDV_TABLESPACE_PIPELINE_DEPTH;
 
-        if(!ref)
+        // Reader waits for the writer if the queue is full
+        if (mdv_condvar_lock(&pipeline->cv) == MDV_OK)
         {
-            mdv_trlog_ref new_ref =
-            {
-                .uuid = *uuid,
-                .trlog = mdv_trlog_open(uuid, MDV_CONFIG.storage.path.ptr)
-            };
+            while(atomic_load(slot) && atomic_load(&pipeline->active))
+                mdv_condvar_wait_locked(&pipeline->cv, 100);
+            mdv_condvar_unlock(&pipeline->cv);
+        }
 
-            if (new_ref.trlog)
-            {
-                ref = mdv_hashmap_insert(tablespace->trlogs, &new_ref, sizeof new_ref);
+        if (atomic_load(slot) || !atomic_load(&pipeline->active))
+            break;
 
-                if (!ref)
-                {
-                    mdv_trlog_release(new_ref.trlog);
-                    new_ref.trlog = 0;
-                }
-            }
-        }
+        mdv_tablespace_batch *batch = 0;
 
-        mdv_mutex_unlock(&tablespace->trlogs_mutex);
-    }
+        size_t const count = mdv_trlog_read_batch(pipeline->trlog,
+                                                  pos,
+                                                  MDV_CONFIG.committer.batch_size,
+                                                  &batch,
+                                                  mdv_tablespace_batch_copy);
 
-    return ref ? mdv_trlog_retain(ref->trlog) : 0;
-}
+        if (!batch)
+            break;
 
+        bool const prepared = mdv_tablespace_batch_prepare(pipeline, batch);
 
-static mdv_errno mdv_tablespace_evt_create_table(void *arg, mdv_event *event)
-{
-    mdv_tablespace       *tablespace   = arg;
-    mdv_evt_create_table *create_table = (mdv_evt_create_table *)event;
+        if (!batch->size)
+        {
+            mdv_tablespace_batch_release(batch);
+            break;
+        }
 
-    if (mdv_tablespace_log_create_table(tablespace, create_table->table))
-    {
-        MDV_LOGI("New table '%s' is created", mdv_uuid_to_str(&create_table->table->id).ptr);
-        return MDV_OK;
+        pos = batch->records[batch->size - 1].id + 1;
+
+        atomic_store(slot, batch);
+
+        mdv_tablespace_pipeline_notify(pipeline);
+
+        if (!prepared || count < MDV_CONFIG.committer.batch_size)
+            break;
     }
 
-    return MDV_FAILED;
+    atomic_store(&pipeline->reader, MDV_PIPELINE_READER_FINISHED);
+
+    mdv_tablespace_pipeline_notify(pipeline);
 }
 
-static mdv_errno mdv_tablespace_evt_trlog_apply(void *arg, mdv_event *event)
-{
-    mdv_tablespace      *tablespace = arg;
-    mdv_evt_trlog_apply *apply      = (mdv_evt_trlog_apply *)event;
 
-    return mdv_tablespace_log_apply(tablespace, &apply->uuid)
-                ? MDV_OK
-                : MDV_FAILED;
+static void mdv_tablespace_prefetcher_finalize(mdv_job_base *job)
+{
+    mdv_tablespace_prefetcher *ctx = (mdv_tablespace_prefetcher *)job->data;
+    mdv_tablespace_pipeline_release(ctx->pipeline);
+    mdv_free(job, "prefetcher_job");
 }
 
 
-static const mdv_event_handler_type mdv_tablespace_handlers[] =
+/**
+ * @brief Writes the decoded batch.
+ * @details Records are written until the first record which wasn't decoded.
+ *
+ * @return number of written records
+ */
+static uint32_t mdv_tablespace_batch_write(mdv_tablespace_pipeline *pipeline,
+                                           mdv_tablespace_applier  *applier,
+                                           mdv_tablespace_batch    *batch)
 {
-    { MDV_EVT_CREATE_TABLE, mdv_tablespace_evt_create_table },
-    { MDV_EVT_TRLOG_APPLY,  mdv_tablespace_evt_trlog_apply },
-};
+    uint32_t n = 0;
 
+    for(; n < batch->size; ++n)
+    {
+        mdv_tablespace_record *record = batch->records + n;
 
-mdv_tablespace * mdv_tablespace_open(mdv_uuid const *uuid, mdv_ebus *ebus)
-{
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(4);
+        if (!record->ok)
+            break;
 
-    mdv_tablespace *tablespace = mdv_alloc(sizeof(mdv_tablespace), "tablespace");
+        // Schema operations are applied by the reader
+        if (!record->rowdata)
+            continue;
 
-    if (!tablespace)
-    {
-        MDV_LOGE("No memory for new tablespace");
-        mdv_rollback(rollbacker);
-        return 0;
-    }
+        mdv_table_rows *rows = mdv_tablespace_applier_rows(applier, &record->table, record->rowdata);
 
-    mdv_rollbacker_push(rollbacker, mdv_free, tablespace, "tablespace");
+        if (!rows)
+            break;
 
-    tablespace->uuid = *uuid;
+        // Row was committed before the transaction log applied position was saved
+        if (record->id <= rows->applied)
+            continue;
 
-    mdv_errno err = mdv_mutex_create(&tablespace->trlogs_mutex);
+        if (!mdv_tablespace_rows_add(rows, record->id, record->row))
+            break;
 
-    if (err != MDV_OK)
-    {
-        mdv_rollback(rollbacker);
-        return 0;
+        record->row = 0;
     }
 
-    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &tablespace->trlogs_mutex);
+    if (!n)
+        return 0;
 
-    tablespace->trlogs = mdv_hashmap_create(mdv_trlog_ref,
-                                            uuid,
-                                            64,
-                                            mdv_uuid_hash,
-                                            mdv_uuid_cmp);
+    bool ret = false;
 
-    if (!tablespace->trlogs)
+    // Snapshots aren't created while the batch is committed
+    if (mdv_rwlock_rdlock(&applier->tablespace->apply_lock) == MDV_OK)
     {
-        mdv_rollback(rollbacker);
-        return 0;
+        applier->epoch = atomic_fetch_add_explicit(&applier->tablespace->epoch, 1, memory_order_relaxed) + 1;
+        ret = mdv_tablespace_applier_commit(applier);
+        mdv_rwlock_unlock(&applier->tablespace->apply_lock);
     }
 
-    mdv_rollbacker_push(rollbacker, mdv_hashmap_release, tablespace->trlogs);
+    mdv_tablespace_applier_reset(applier, ret);
 
-    tablespace->ebus = mdv_ebus_retain(ebus);
-
-    mdv_rollbacker_push(rollbacker, mdv_ebus_release, tablespace->ebus);
-
-    if (mdv_ebus_subscribe_all(tablespace->ebus,
-                               tablespace,
-                               mdv_tablespace_handlers,
-                               sizeof mdv_tablespace_handlers / sizeof *mdv_tablespace_handlers) != MDV_OK)
+    if (!ret)
     {
-        MDV_LOGE("Ebus subscription failed");
-        mdv_rollback(rollbacker);
+        MDV_LOGE("TR Log batch not committed");
         return 0;
     }
 
-    mdv_rollbacker_free(rollbacker);
+    mdv_trlog_applied_pos_set(pipeline->trlog, batch->records[n - 1].id);
 
-    return tablespace;
+    return n;
 }
 
 
-void mdv_tablespace_close(mdv_tablespace *tablespace)
+/**
+ * @brief Applies the transaction log by the pipeline.
+ *
+ * @return false if the pipeline wasn't started and the transaction log should be applied sequentially
+ */
+static bool mdv_tablespace_pipeline_apply(mdv_tablespace *tablespace, mdv_trlog *trlog, mdv_tablespace_applier *applier)
 {
-    if (tablespace)
-    {
-        mdv_ebus_unsubscribe_all(tablespace->ebus,
-                                 tablespace,
-                                 mdv_tablespace_handlers,
-                                 sizeof mdv_tablespace_handlers / sizeof *mdv_tablespace_handlers);
+    mdv_tablespace_pipeline *pipeline = mdv_alloc(sizeof(mdv_tablespace_pipeline), "pipeline");
 
-        mdv_ebus_release(tablespace->ebus);
+    if (!pipeline)
+    {
+        MDV_LOGW("No memory for TR log apply pipeline");
+        return false;
+    }
 
-        mdv_hashmap_foreach(tablespace->trlogs, mdv_trlog_ref, ref)
-        {
-            mdv_trlog_release(ref->trlog);
-        }
+    if (mdv_condvar_create(&pipeline->cv) != MDV_OK)
+    {
+        MDV_LOGW("TR log apply pipeline creation failed");
+        mdv_free(pipeline, "pipeline");
+        return false;
+    }
 
-        mdv_hashmap_release(tablespace->trlogs);
+    atomic_init(&pipeline->rc, 1);
+    atomic_init(&pipeline->reader, MDV_PIPELINE_READER_PENDING);
+    atomic_init(&pipeline->active, true);
 
-        mdv_mutex_free(&tablespace->trlogs_mutex);
+    for(uint32_t i = 0; i < MDV_TABLESPACE_PIPELINE_DEPTH; ++i)
+        atomic_init(pipeline->batches + i, 0);
 
-        mdv_free(tablespace, "tablespace");
-    }
-}
+    pipeline->tablespace = tablespace;
+    pipeline->trlog = mdv_trlog_retain(trlog);
 
-static void mdv_tablespace_trlog_changed_notify(mdv_tablespace *tablespace)
-{
-    mdv_evt_trlog_changed *evt = mdv_evt_trlog_changed_create();
+    mdv_tablespace_prefetcher_job *job = mdv_alloc(sizeof(mdv_tablespace_prefetcher_job), "prefetcher_job");
 
-    if (evt)
+    if (!job)
     {
-        mdv_ebus_publish(tablespace->ebus, &evt->base, MDV_EVT_UNIQUE);
-        mdv_evt_trlog_changed_release(evt);
+        MDV_LOGW("No memory for TR log reader");
+        mdv_tablespace_pipeline_release(pipeline);
+        return false;
     }
-}
 
+    job->fn             = mdv_tablespace_prefetcher_fn;
+    job->finalize       = mdv_tablespace_prefetcher_finalize;
+    job->data.pipeline  = pipeline;
 
-static bool mdv_tablespace_log_create_table(mdv_tablespace *tablespace, mdv_table_base *table)
-{
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(3);
-
-    mdv_trlog *trlog = mdv_tablespace_trlog_create(tablespace, &tablespace->uuid);
+    atomic_fetch_add_explicit(&pipeline->rc, 1, memory_order_relaxed);
 
-    if (!trlog)
+    if (mdv_jobber_push(tablespace->pipeliner, (mdv_job_base*)job) != MDV_OK)
     {
-        mdv_rollback(rollbacker);
+        atomic_fetch_sub_explicit(&pipeline->rc, 1, memory_order_relaxed);
+        mdv_free(job, "prefetcher_job");
+        mdv_tablespace_pipeline_release(pipeline);
         return false;
     }
 
-    mdv_rollbacker_push(rollbacker, mdv_trlog_release, trlog);
+    bool started = true;
 
-    table->id = mdv_uuid_generate();
+    for(uint32_t head = 0;;)
+    {
+        _Atomic(mdv_tablespace_batch *) *slot = pipeline->batches + head % MDV_TABLESPACE_PIPELINE_DEPTH;
 
-    binn obj;
+        mdv_tablespace_batch *batch = atomic_load(slot);
 
-    if (!mdv_binn_table(table, &obj))
-    {
-        mdv_rollback(rollbacker);
-        return false;
-    }
+        if (!batch)
+        {
+            uint_fast32_t state = atomic_load(&pipeline->reader);
 
-    mdv_rollbacker_push(rollbacker, binn_free, &obj);
+            if (state == MDV_PIPELINE_READER_FINISHED)
+            {
+                // Last batch might be published before the reader is finished
+                if (!atomic_load(slot))
+                    break;
+                continue;
+            }
 
-    int const binn_obj_size = binn_size(&obj);
+            if (mdv_condvar_lock(&pipeline->cv) == MDV_OK)
+            {
+                while(!atomic_load(slot) && atomic_load(&pipeline->reader) == MDV_PIPELINE_READER_RUNNING)
+                    mdv_condvar_wait_locked(&pipeline->cv, 100);
 
-    size_t const op_size = offsetof(mdv_trlog_op, payload)
-                            + binn_obj_size;
+                if (!atomic_load(slot)
+                    && atomic_load(&pipeline->reader) == MDV_PIPELINE_READER_PENDING
+                    && MDV_CONFIG.committer.pipeline_wait)
+                    mdv_condvar_wait_locked(&pipeline->cv, MDV_CONFIG.committer.pipeline_wait);
 
-    mdv_trlog_op *op = mdv_staligned_alloc(sizeof(uint64_t), op_size, "trlog_op");
+                mdv_condvar_unlock(&pipeline->cv);
+            }
 
-    if (!op)
-    {
-        mdv_rollback(rollbacker);
-        return false;
-    }
+            // All workers are busy. Writer doesn't wait for the reader job.
+            if (state == MDV_PIPELINE_READER_PENDING
+                && atomic_compare_exchange_strong(&pipeline->reader, &state, MDV_PIPELINE_READER_CANCELLED))
+            {
+                started = false;
+                break;
+            }
 
-    mdv_rollbacker_push(rollbacker, mdv_stfree, op, "trlog_op");
+            continue;
+        }
 
-    op->size = offsetof(mdv_trlog_op, payload) + binn_obj_size;
-    op->type = MDV_OP_TABLE_CREATE;
-    memcpy(op->payload, binn_ptr(&obj), binn_obj_size);
+        // Writer decodes the batch by itself if the decoders are busy
+        if (!mdv_tablespace_batch_decode(pipeline, batch)
+            && mdv_condvar_lock(&pipeline->cv) == MDV_OK)
+        {
+            while(atomic_load_explicit(&batch->decoded, memory_order_acquire) < batch->chunks)
+                mdv_condvar_wait_locked(&pipeline->cv, 100);
 
-    mdv_uuid const *objid = 0;
+            mdv_condvar_unlock(&pipeline->cv);
+        }
 
-    if (!mdv_trlog_add_op(trlog, op))
-    {
-        mdv_rollback(rollbacker);
-        return false;
+        uint32_t const written = mdv_tablespace_batch_write(pipeline, applier, batch);
+
+        atomic_store(slot, 0);
+
+        ++head;
+
+        mdv_tablespace_pipeline_notify(pipeline);
+
+        bool const completed = written == batch->size;
+
+        mdv_tablespace_batch_release(batch);
+
+        if (!completed)
+            break;
     }
 
-    mdv_rollback(rollbacker);
+    // Stop the reader and wait for it
+    atomic_store(&pipeline->active, false);
 
-    mdv_tablespace_trlog_changed_notify(tablespace);
+    mdv_tablespace_pipeline_notify(pipeline);
 
-    return true;
-}
+    uint_fast32_t state = MDV_PIPELINE_READER_PENDING;
+
+    if (!atomic_compare_exchange_strong(&pipeline->reader, &state, MDV_PIPELINE_READER_CANCELLED)
+        && mdv_condvar_lock(&pipeline->cv) == MDV_OK)
+    {
+        while(atomic_load(&pipeline->reader) == MDV_PIPELINE_READER_RUNNING)
+            mdv_condvar_wait_locked(&pipeline->cv, 100);
 
+        mdv_condvar_unlock(&pipeline->cv);
+    }
 
-static bool mdv_tablespace_create_table(mdv_tablespace *tablespace, mdv_table_base *table)
-{
-    // TODO: OOOOOOOOOOOOOOOOOOOOOOOOOO
-    return true;
+    mdv_tablespace_applier_clear(applier);
+
+    mdv_tablespace_pipeline_release(pipeline);
+
+    return started;
 }
 
 
-static bool mdv_tablespace_trlog_apply(void *arg, mdv_trlog_op *op)
+/**
+ * @brief Flushes all tables storages to disk.
+ * @details It is called before the transaction log truncation if the tables storages don't flush each commit.
+ */
+static bool mdv_tablespace_tables_flush(void *arg)
 {
     mdv_tablespace *tablespace = arg;
 
-    binn obj;
+    mdv_vector *tables = mdv_vector_create(8, sizeof(mdv_rowdata *), &mdv_default_allocator);
 
-    if (!binn_load(op->payload, &obj))
+    if (!tables)
     {
-        MDV_LOGE("Invalid transaction operation");
+        MDV_LOGE("No memory for tables flush");
         return false;
     }
 
     bool ret = true;
 
-    switch(op->type)
+    // Tables are flushed outside the tables mutex
+    if (mdv_mutex_lock(&tablespace->tables_mutex) == MDV_OK)
     {
-        case MDV_OP_TABLE_CREATE:
+        mdv_hashmap_foreach(tablespace->tables, mdv_rowdata_ref, ref)
         {
-            mdv_table_base *table = mdv_unbinn_table(&obj);
-
-            if (table)
+            if (ret)
             {
-                ret = mdv_tablespace_create_table(tablespace, table);
+                ret = mdv_vector_push_back(tables, &ref->rowdata) != 0;
 
-                mdv_free(table, "table");
+                if (ret)
+                    mdv_rowdata_retain(ref->rowdata);
+                else
+                    MDV_LOGE("No memory for tables flush");
             }
-            else
-                MDV_LOGE("Table creation failed. Invalid TR log operation.");
-
-            break;
         }
 
-        case MDV_OP_ROW_INSERT:
-        {
-            MDV_LOGE("TODO: MDV_OP_ROW_INSERT");
-            break;
-        }
+        mdv_mutex_unlock(&tablespace->tables_mutex);
+    }
+    else
+        ret = false;
 
-        default:
-            MDV_LOGE("Unsupported DB operation");
+    mdv_rowdata **rowdatas = mdv_vector_data(tables);
+
+    for(size_t i = 0; i < mdv_vector_size(tables); ++i)
+    {
+        if (ret)
+            ret = mdv_storage_sync(mdv_rowdata_storage(rowdatas[i]));
+        mdv_rowdata_release(rowdatas[i]);
     }
 
-    binn_free(&obj);
+    mdv_vector_release(tables);
 
     return ret;
 }
 
 
+static void mdv_tablespace_checkpoint(mdv_tablespace *tablespace, mdv_trlog *trlog)
+{
+    uint64_t const low_water = mdv_trlog_checkpoint(trlog,
+                                                    0,
+                                                    MDV_CONFIG.trlog.checkpoint_batch,
+                                                    tablespace,
+                                                    MDV_CONFIG.storage.durability == MDV_DURABILITY_SYNC
+                                                        ? 0
+                                                        : mdv_tablespace_tables_flush);
+
+    MDV_LOGI("TR log '%s' checkpoint. Low-water mark: %llu, applied: %llu",
+             mdv_uuid_to_str(mdv_trlog_uuid(trlog)).ptr,
+             (unsigned long long)low_water,
+             (unsigned long long)mdv_trlog_applied_pos(trlog));
+}
+
+
+static void mdv_tablespace_checkpointer_fn(mdv_job_base *job)
+{
+    mdv_tablespace_checkpointer *ctx = (mdv_tablespace_checkpointer *)job->data;
+
+    if (atomic_load(&ctx->tablespace->active))
+        mdv_tablespace_checkpoint(ctx->tablespace, ctx->trlog);
+}
+
+
+static void mdv_tablespace_checkpointer_finalize(mdv_job_base *job)
+{
+    mdv_tablespace_checkpointer *ctx = (mdv_tablespace_checkpointer *)job->data;
+    mdv_trlog_release(ctx->trlog);
+    mdv_free(job, "checkpointer_job");
+}
+
+
+/**
+ * @brief Schedules the transaction log checkpoint when a full batch of records can be deleted.
+ * @details Checkpoint flushes the tables, so it is performed by the background jobs
+ *          and the log applier isn't blocked. Only one checkpoint per transaction log is scheduled.
+ *          Peers don't acknowledge replicated positions yet, so the checkpoint is disabled in cluster mode.
+ */
+static void mdv_tablespace_checkpoint_schedule(mdv_tablespace *tablespace, mdv_trlog *trlog)
+{
+    if (!MDV_CONFIG.trlog.checkpoint_batch
+        || MDV_CONFIG.cluster.size
+        || !mdv_trlog_checkpoint_due(trlog, 0, MDV_CONFIG.trlog.checkpoint_batch))
+        return;
+
+    mdv_tablespace_checkpointer_job *job = mdv_alloc(sizeof(mdv_tablespace_checkpointer_job), "checkpointer_job");
+
+    if (job)
+    {
+        job->fn              = mdv_tablespace_checkpointer_fn;
+        job->finalize        = mdv_tablespace_checkpointer_finalize;
+        job->data.tablespace = tablespace;
+        job->data.trlog      = mdv_trlog_retain(trlog);
+
+        if (mdv_jobber_push(tablespace->jobber, (mdv_job_base*)job) == MDV_OK)
+            return;
+
+        MDV_LOGE("TR log checkpoint job failed");
+        mdv_trlog_release(trlog);
+        mdv_free(job, "checkpointer_job");
+    }
+    else
+        MDV_LOGE("No memory for TR log checkpoint job");
+
+    // Checkpoint is performed in place to reset the schedule
+    mdv_tablespace_checkpoint(tablespace, trlog);
+}
+
+
 bool mdv_tablespace_log_apply(mdv_tablespace *tablespace, mdv_uuid const *storage)
 {
     mdv_trlog *trlog = mdv_tablespace_trlog(tablespace, storage);
 
     if (trlog)
     {
-        while(mdv_trlog_apply(trlog,
-                              MDV_CONFIG.committer.batch_size,
-                              tablespace,
-                              mdv_tablespace_trlog_apply)
-                >= MDV_CONFIG.committer.batch_size);
+        mdv_tablespace_applier applier =
+        {
+            .tablespace = tablespace,
+            .storage = *storage,
+            .tables = mdv_hashmap_create(mdv_table_rows,
+                                         uuid,
+                                         4,
+                                         mdv_uuid_hash,
+                                         mdv_uuid_cmp)
+        };
+
+        if (!applier.tables)
+        {
+            MDV_LOGE("No memory for TR log applier");
+            mdv_trlog_release(trlog);
+            return false;
+        }
+
+        mdv_trlog_applier const trlog_applier =
+        {
+            .arg = &applier,
+            .apply = mdv_tablespace_trlog_apply,
+            .commit = mdv_tablespace_trlog_commit
+        };
+
+        bool const pipelined = tablespace->pipeliner
+                                && mdv_trlog_changed(trlog)
+                                && mdv_tablespace_pipeline_apply(tablespace, trlog, &applier);
+
+        while(!pipelined)
+        {
+            // Snapshots aren't created while the batch is applied
+            if (mdv_rwlock_rdlock(&tablespace->apply_lock) != MDV_OK)
+                break;
+
+            applier.epoch = atomic_fetch_add_explicit(&tablespace->epoch, 1, memory_order_relaxed) + 1;
+
+            uint32_t const applied = mdv_trlog_apply(trlog,
+                                                     MDV_CONFIG.committer.batch_size,
+                                                     &trlog_applier);
+
+            mdv_rwlock_unlock(&tablespace->apply_lock);
+
+            if (applied < MDV_CONFIG.committer.batch_size)
+                break;
+        }
+
+        mdv_tablespace_applier_clear(&applier);
+
+        mdv_hashmap_release(applier.tables);
+
+        mdv_tablespace_checkpoint_schedule(tablespace, trlog);
 
         mdv_trlog_release(trlog);
     }
 
     return true;
 }
-
@@ -10,6 +10,7 @@
 #include <mdv_vector.h>
 #include <mdv_uuid.h>
 #include <mdv_ebus.h>
+#include <mdv_jobber.h>
 
 
 /// DB tables space
@@ -21,10 +22,11 @@ typedef struct mdv_tablespace mdv_tablespace;
  *
  * @param uuid [in]        Current node UUID
  * @param ebus [in]        Events bus
+ * @param jconfig [in]     Jobs scheduler configuration for secondary indexes building
  *
  * @return pointer to a tablespace
  */
-mdv_tablespace * mdv_tablespace_open(mdv_uuid const *uuid, mdv_ebus *ebus);
+mdv_tablespace * mdv_tablespace_open(mdv_uuid const *uuid, mdv_ebus *ebus, mdv_jobber_config const *jconfig);
 
 
 /**
@@ -2,17 +2,52 @@
 #include "mdv_storage.h"
 #include "mdv_storages.h"
 #include "mdv_idmap.h"
+#include "../mdv_config.h"
 #include <mdv_rollbacker.h>
 #include <mdv_alloc.h>
 #include <mdv_string.h>
 #include <mdv_limits.h>
 #include <mdv_log.h>
 #include <mdv_filesystem.h>
+#include <mdv_vector.h>
+#include <mdv_condvar.h>
+#include <mdv_hashmap.h>
+#include <mdv_mutex.h>
+#include <mdv_lz.h>
 #include <stdatomic.h>
+#include <stddef.h>
 #include <assert.h>
 
 
 static const uint32_t MDV_TRLOG_APPLIED_POS_KEY = 0;
+static const uint32_t MDV_TRLOG_LOW_WATER_KEY = 1;
+
+
+/**
+ * @brief Operation type flag for compressed records
+ * @details Payload of the compressed record is the original payload size (uint32)
+ *          followed by the compressed payload (see mdv_lz.h).
+ */
+static const uint32_t MDV_TRLOG_OP_LZ = 1u << 31;
+
+
+/// Group commit states
+enum
+{
+    MDV_TRLOG_OP_PENDING,                       ///< Operation is waiting for the commit
+    MDV_TRLOG_OP_COMMITTED,                     ///< Operation is committed
+    MDV_TRLOG_OP_FAILED                         ///< Operation isn't written
+};
+
+
+/// Operation waiting for the group commit
+typedef struct mdv_trlog_waiter
+{
+    mdv_trlog_op const         *op;             ///< DB operation
+    uint64_t                    id;             ///< Assigned identifier
+    int                         state;          ///< Group commit state
+    struct mdv_trlog_waiter    *next;           ///< Next waiting operation
+} mdv_trlog_waiter;
 
 
 /// Transaction logs storage
@@ -20,18 +55,39 @@ struct mdv_trlog
 {
     mdv_uuid                uuid;               ///< storage UUID
     mdv_storage            *storage;            ///< transaction log storage
+    mdv_map_handle          trlog_map;          ///< transaction log map
+    mdv_map_handle          applied_map;        ///< transaction log application position map
     atomic_uint_fast64_t    top;                ///< transaction log last insertion position
     atomic_uint_fast64_t    applied;            ///< transaction log application position
+    mdv_condvar             gc_cv;              ///< group commit condition variable
+    mdv_trlog_waiter       *gc_head;            ///< first operation waiting for the group commit
+    mdv_trlog_waiter       *gc_tail;            ///< last operation waiting for the group commit
+    uint32_t                gc_size;            ///< number of operations waiting for the group commit
+    bool                    gc_leader;          ///< some thread performs the group commit
+    atomic_uint_fast64_t    low_water;          ///< all records up to this position are deleted
+    atomic_bool             checkpoint;         ///< checkpoint is in progress
+    atomic_bool             checkpoint_due;     ///< checkpoint is scheduled
+    mdv_mutex               acks_mutex;         ///< peers acknowledgements guard
+    mdv_hashmap            *acks;               ///< positions acknowledged by peers (Peer UUID -> mdv_trlog_ack_ref)
 };
 
 
+/// Transaction log position acknowledged by peer
+typedef struct
+{
+    mdv_uuid    peer;                           ///< Peer UUID
+    uint64_t    pos;                            ///< Acknowledged position
+} mdv_trlog_ack_ref;
+
+
 static void mdv_trlog_init(mdv_trlog *trlog)
 {
     atomic_init(&trlog->top, 0);
     atomic_init(&trlog->applied, 0);
+    atomic_init(&trlog->low_water, 0);
 
     // Start transaction
-    mdv_transaction transaction = mdv_transaction_start(trlog->storage);
+    mdv_transaction transaction = mdv_transaction_start_read(trlog->storage);
 
     if (!mdv_transaction_ok(transaction))
     {
@@ -43,9 +99,7 @@ static void mdv_trlog_init(mdv_trlog *trlog)
     do
     {
         // Open transaction log
-        mdv_map map = mdv_map_open(&transaction,
-                                    MDV_MAP_TRLOG,
-                                    MDV_MAP_SILENT | MDV_MAP_INTEGERKEY);
+        mdv_map map = mdv_map_bind(&transaction, trlog->trlog_map);
 
         if (!mdv_map_ok(map))
             break;
@@ -65,9 +119,7 @@ static void mdv_trlog_init(mdv_trlog *trlog)
     do
     {
         // Open transaction log
-        mdv_map map = mdv_map_open(&transaction,
-                                    MDV_MAP_APPLIED,
-                                    MDV_MAP_SILENT | MDV_MAP_INTEGERKEY);
+        mdv_map map = mdv_map_bind(&transaction, trlog->applied_map);
 
         if (!mdv_map_ok(map))
             break;
@@ -78,6 +130,23 @@ static void mdv_trlog_init(mdv_trlog *trlog)
         if (mdv_map_get(&map, &transaction, &key, &value))
             atomic_init(&trlog->applied, *(uint64_t*)value.ptr);
 
+        mdv_data const low_water_key = { sizeof MDV_TRLOG_LOW_WATER_KEY, (void*)&MDV_TRLOG_LOW_WATER_KEY };
+
+        if (mdv_map_get(&map, &transaction, &low_water_key, &value))
+        {
+            uint64_t const low_water = *(uint64_t*)value.ptr;
+
+            atomic_init(&trlog->low_water, low_water);
+
+            // Records up to the low-water mark are applied
+            if (atomic_load(&trlog->applied) < low_water)
+                atomic_init(&trlog->applied, low_water);
+
+            // Identifiers of deleted records must not be reused
+            if (atomic_load(&trlog->top) < low_water)
+                atomic_init(&trlog->top, low_water);
+        }
+
         mdv_map_close(&map);
     } while(0);
 
@@ -87,7 +156,7 @@ static void mdv_trlog_init(mdv_trlog *trlog)
 
 mdv_trlog * mdv_trlog_open(mdv_uuid const *uuid, char const *root_dir)
 {
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(3);
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(6);
 
     mdv_trlog *trlog = mdv_alloc(sizeof(mdv_trlog), "trlog");
 
@@ -133,7 +202,7 @@ mdv_trlog * mdv_trlog_open(mdv_uuid const *uuid, char const *root_dir)
     trlog->storage = mdv_storage_open(path.ptr,
                                       MDV_STRG_TRLOG(uuid),
                                       MDV_STRG_TRLOG_MAPS,
-                                      MDV_STRG_NOSUBDIR);
+                                      MDV_STRG_TRLOG_FLAGS());
 
     if (!trlog->storage)
     {
@@ -142,10 +211,59 @@ mdv_trlog * mdv_trlog_open(mdv_uuid const *uuid, char const *root_dir)
         return 0;
     }
 
-    mdv_trlog_init(trlog);
-
     mdv_rollbacker_push(rollbacker, mdv_storage_release, trlog->storage);
 
+    trlog->trlog_map = mdv_storage_map(trlog->storage, MDV_MAP_TRLOG, MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    trlog->applied_map = mdv_storage_map(trlog->storage, MDV_MAP_APPLIED, MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+    if (!trlog->trlog_map || !trlog->applied_map)
+    {
+        MDV_LOGE("TR log maps weren't opened");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    if (mdv_condvar_create(&trlog->gc_cv) != MDV_OK)
+    {
+        MDV_LOGE("TR log condition variable wasn't created");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_condvar_free, &trlog->gc_cv);
+
+    if (mdv_mutex_create(&trlog->acks_mutex) != MDV_OK)
+    {
+        MDV_LOGE("TR log mutex wasn't created");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_mutex_free, &trlog->acks_mutex);
+
+    trlog->acks = mdv_hashmap_create(mdv_trlog_ack_ref,
+                                     peer,
+                                     4,
+                                     mdv_uuid_hash,
+                                     mdv_uuid_cmp);
+
+    if (!trlog->acks)
+    {
+        MDV_LOGE("No free space of memory for TR log acknowledgements");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    trlog->gc_head = 0;
+    trlog->gc_tail = 0;
+    trlog->gc_size = 0;
+    trlog->gc_leader = false;
+
+    atomic_init(&trlog->checkpoint, false);
+    atomic_init(&trlog->checkpoint_due, false);
+
+    mdv_trlog_init(trlog);
+
     mdv_rollbacker_free(rollbacker);
 
     return trlog;
@@ -165,12 +283,23 @@ uint32_t mdv_trlog_release(mdv_trlog *trlog)
     uint32_t rc = mdv_storage_release(trlog->storage);
 
     if (!rc)
+    {
+        mdv_hashmap_release(trlog->acks);
+        mdv_mutex_free(&trlog->acks_mutex);
+        mdv_condvar_free(&trlog->gc_cv);
         mdv_free(trlog, "trlog");
+    }
 
     return rc;
 }
 
 
+mdv_uuid const * mdv_trlog_uuid(mdv_trlog *trlog)
+{
+    return &trlog->uuid;
+}
+
+
 static uint64_t mdv_trlog_new_id(mdv_trlog *trlog)
 {
     return atomic_fetch_add_explicit(&trlog->top, 1, memory_order_relaxed) + 1;
@@ -187,46 +316,32 @@ static void mdv_trlog_id_maximize(mdv_trlog *trlog, uint64_t id)
 }
 
 
-static void mdv_trlog_applied_pos_set(mdv_trlog *trlog, uint64_t applied_pos)
+/**
+ * @brief Saves transaction log application position using the given transaction.
+ * @details Applied position is saved with other transaction log changes, so it doesn't require a separate commit.
+ *          Appliers save the applied positions in data storages, so the saved position is only a hint where the
+ *          applying is resumed after restart.
+ */
+static bool mdv_trlog_applied_pos_save(mdv_trlog *trlog, mdv_transaction *transaction)
 {
-    atomic_store_explicit(&trlog->applied, applied_pos, memory_order_relaxed);
-
-    // Start transaction
-    mdv_transaction transaction = mdv_transaction_start(trlog->storage);
-
-    if (!mdv_transaction_ok(transaction))
-    {
-        MDV_LOGE("TR log transaction not started");
-        return;
-    }
-
-    // Open transaction log
-    mdv_map map = mdv_map_open(&transaction,
-                                MDV_MAP_APPLIED,
-                                MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mdv_map map = mdv_map_bind(transaction, trlog->applied_map);
 
     if (!mdv_map_ok(map))
-    {
-        mdv_transaction_abort(&transaction);
-        return;
-    }
+        return false;
+
+    uint64_t applied_pos = atomic_load_explicit(&trlog->applied, memory_order_relaxed);
 
-    // Save transaction log application position
     mdv_data const key = { sizeof MDV_TRLOG_APPLIED_POS_KEY, (void*)&MDV_TRLOG_APPLIED_POS_KEY };
     mdv_data value = { sizeof applied_pos, &applied_pos };
 
-    if (mdv_map_put(&map, &transaction, &key, &value))
-    {
-        if (!mdv_transaction_commit(&transaction))
-            MDV_LOGE("Transaction failed.");
-        mdv_map_close(&map);
-    }
-    else
-    {
-        MDV_LOGE("TR log applied posiotion wasn't saved");
-        mdv_map_close(&map);
-        mdv_transaction_abort(&transaction);
-    }
+    bool const ret = mdv_map_put(&map, transaction, &key, &value);
+
+    if (!ret)
+        MDV_LOGW("TR log applied position wasn't saved");
+
+    mdv_map_close(&map);
+
+    return ret;
 }
 
 
@@ -248,9 +363,7 @@ bool mdv_trlog_add(mdv_trlog *trlog,
     mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
 
     // Open transaction log
-    mdv_map tr_log = mdv_map_open(&transaction,
-                                  MDV_MAP_TRLOG,
-                                  MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mdv_map tr_log = mdv_map_bind(&transaction, trlog->trlog_map);
 
     if (!mdv_map_ok(tr_log))
     {
@@ -261,13 +374,27 @@ bool mdv_trlog_add(mdv_trlog *trlog,
 
     mdv_rollbacker_push(rollbacker, mdv_map_close, &tr_log);
 
+    uint64_t mark = 0;
+
     mdv_list_foreach(ops, mdv_trlog_data, op)
     {
+        // Peers send decompressed operations. Compressed record flag isn't trusted.
+        if (op->op.type & MDV_TRLOG_OP_LZ)
+        {
+            MDV_LOGW("OP with invalid type %x rejected.", op->op.type);
+            continue;
+        }
+
         mdv_data k = { sizeof op->id, &op->id };
         mdv_data v = { op->op.size, &op->op };
 
-        if (mdv_map_put_unique(&tr_log, &transaction, &k, &v))
+        if (mdv_map_append(&tr_log, &transaction, &k, &v))
+        {
             mdv_trlog_id_maximize(trlog, op->id);
+
+            if (op->id > mark)
+                mark = op->id;
+        }
         else
             MDV_LOGW("OP insertion failed.");
     }
@@ -279,6 +406,8 @@ bool mdv_trlog_add(mdv_trlog *trlog,
         return false;
     }
 
+    mdv_storage_mark(trlog->storage, mark);
+
     mdv_map_close(&tr_log);
 
     mdv_rollbacker_free(rollbacker);
@@ -287,73 +416,349 @@ bool mdv_trlog_add(mdv_trlog *trlog,
 }
 
 
-bool mdv_trlog_add_op(mdv_trlog *trlog,
-                      mdv_trlog_op const *op)
+/// Group commit result of the operation. Results are kept by the leader until the batch is committed.
+typedef struct
+{
+    uint64_t    id;                             ///< Assigned identifier
+    bool        ok;                             ///< Operation is written
+} mdv_trlog_result;
+
+
+/**
+ * @brief Writes operations batch to the transaction log using one transaction.
+ * @details New identifiers are generated for operations. Results are saved to the leader local array,
+ *          waiters states aren't changed, so all waiters are alive while the batch is committed.
+ *
+ *          Identifiers of the failed batch are returned if no other identifiers were generated after them.
+ *          Identifiers of the operations which weren't inserted into the committed batch aren't reused,
+ *          so the transaction log might contain gaps. Readers don't rely on the contiguous identifiers.
+ *
+ * @return true if the batch transaction is committed
+ */
+static bool mdv_trlog_commit_batch(mdv_trlog *trlog, mdv_trlog_waiter const *batch, mdv_trlog_result *results)
 {
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(2);
-
-    // Start transaction
     mdv_transaction transaction = mdv_transaction_start(trlog->storage);
 
-    if (!mdv_transaction_ok(transaction))
+    mdv_map tr_log = mdv_transaction_ok(transaction)
+                        ? mdv_map_bind(&transaction, trlog->trlog_map)
+                        : (mdv_map){ 0, 0 };
+
+    if (!mdv_map_ok(tr_log))
     {
         MDV_LOGE("TR log transaction failed");
-        mdv_rollback(rollbacker);
+
+        if (mdv_transaction_ok(transaction))
+            mdv_transaction_abort(&transaction);
+
         return false;
     }
 
-    mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
+    uint64_t first = 0, last = 0, mark = 0;
 
-    // Open transaction log
-    mdv_map tr_log = mdv_map_open(&transaction,
-                                  MDV_MAP_TRLOG,
-                                  MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    size_t n = 0;
 
-    if (!mdv_map_ok(tr_log))
+    for(mdv_trlog_waiter const *w = batch; w; w = w->next, ++n)
     {
-        MDV_LOGE("Transaction log map '%s' not opened", MDV_MAP_TRLOG);
-        mdv_rollback(rollbacker);
+        uint64_t id = mdv_trlog_new_id(trlog);
+
+        if (!first)
+            first = id;
+        last = id;
+
+        mdv_data k = { sizeof id, &id };
+        mdv_data v = { w->op->size, (void*)w->op };
+
+        results[n].id = id;
+        results[n].ok = mdv_map_append(&tr_log, &transaction, &k, &v);
+
+        if (results[n].ok)
+            mark = id;
+        else
+            MDV_LOGW("OP insertion failed.");
+    }
+
+    mdv_map_close(&tr_log);
+
+    // Errors are ignored because the applied position is only a hint
+    mdv_trlog_applied_pos_save(trlog, &transaction);
+
+    if (!mdv_transaction_commit(&transaction))
+    {
+        MDV_LOGE("TR log transaction failed");
+
+        // Identifiers are reused by the next batch
+        if (first)
+            atomic_compare_exchange_strong(&trlog->top, &last, first - 1);
+
         return false;
     }
 
-    mdv_rollbacker_push(rollbacker, mdv_map_close, &tr_log);
+    mdv_storage_mark(trlog->storage, mark);
 
-    uint64_t id = mdv_trlog_new_id(trlog);
+    return true;
+}
 
-    mdv_data k = { sizeof id, &id };
-    mdv_data v = { op->size, (void*)op };
 
-    if (!mdv_map_put_unique(&tr_log, &transaction, &k, &v))
+/**
+ * @brief Compresses the operation payload.
+ * @details Null pointer is returned if the operation isn't compressible.
+ */
+static mdv_trlog_op * mdv_trlog_op_compress(mdv_trlog_op const *op)
+{
+    uint32_t const hdr_size = offsetof(mdv_trlog_op, payload) + sizeof(uint32_t);
+    uint32_t const payload_size = op->size - offsetof(mdv_trlog_op, payload);
+
+    // Operations larger than a message are stored as is, because the reader rejects such sizes
+    if (op->size <= hdr_size + 1
+        || payload_size > MDV_MSG_SIZE_MAX)
+        return 0;
+
+    // Compressed record must be smaller than the original one
+    uint32_t const capacity = op->size - hdr_size - 1;
+
+    mdv_trlog_op *packed = mdv_alloc(hdr_size + capacity, "trlog_op");
+
+    if (!packed)
     {
-        MDV_LOGW("OP insertion failed.");
-        mdv_rollback(rollbacker);
-        return false;
+        MDV_LOGW("No memory for TR log operation compression");
+        return 0;
     }
 
-    if (!mdv_transaction_commit(&transaction))
+    size_t const size = mdv_lz_compress(op->payload, payload_size, packed->payload + sizeof(uint32_t), capacity);
+
+    if (!size)
     {
-        MDV_LOGE("TR log transaction failed");
-        mdv_rollback(rollbacker);
+        mdv_free(packed, "trlog_op");
+        return 0;
+    }
+
+    packed->size = hdr_size + size;
+    packed->type = op->type | MDV_TRLOG_OP_LZ;
+    memcpy(packed->payload, &payload_size, sizeof payload_size);
+
+    return packed;
+}
+
+
+/**
+ * @brief Decompresses the transaction log record.
+ * @details Record size is taken from the storage, so the corrupted header doesn't cause reading out of the record.
+ */
+static mdv_trlog_op * mdv_trlog_op_decompress(mdv_trlog_op const *op, size_t record_size)
+{
+    size_t const hdr_size = offsetof(mdv_trlog_op, payload) + sizeof(uint32_t);
+
+    mdv_trlog_op packed;
+    memcpy(&packed, op, offsetof(mdv_trlog_op, payload));
+
+    if (record_size < hdr_size
+        || packed.size != record_size)
+    {
+        MDV_LOGE("TR log record is corrupted");
+        return 0;
+    }
+
+    uint32_t payload_size;
+    memcpy(&payload_size, op->payload, sizeof payload_size);
+
+    if (payload_size > MDV_MSG_SIZE_MAX)
+    {
+        MDV_LOGE("TR log record is corrupted");
+        return 0;
+    }
+
+    size_t const size = offsetof(mdv_trlog_op, payload) + (size_t)payload_size;
+
+    mdv_trlog_op *unpacked = mdv_alloc(size, "trlog_op");
+
+    if (!unpacked)
+    {
+        MDV_LOGE("No memory for TR log operation");
+        return 0;
+    }
+
+    if (mdv_lz_decompress(op->payload + sizeof(uint32_t),
+                          record_size - hdr_size,
+                          unpacked->payload,
+                          payload_size) != payload_size)
+    {
+        MDV_LOGE("TR log record is corrupted");
+        mdv_free(unpacked, "trlog_op");
+        return 0;
+    }
+
+    unpacked->size = (uint32_t)size;
+    unpacked->type = packed.type & ~MDV_TRLOG_OP_LZ;
+
+    return unpacked;
+}
+
+
+bool mdv_trlog_add_op(mdv_trlog *trlog,
+                      mdv_trlog_op const *op,
+                      uint64_t *id)
+{
+    // Large operations are compressed by the caller thread to keep the group commit short
+    mdv_trlog_op *packed = MDV_CONFIG.trlog.compression && op->size >= MDV_CONFIG.trlog.compression
+                                ? mdv_trlog_op_compress(op)
+                                : 0;
+
+    mdv_trlog_waiter waiter =
+    {
+        .op = packed ? packed : op,
+        .id = 0,
+        .state = MDV_TRLOG_OP_PENDING,
+        .next = 0
+    };
+
+    uint32_t const batch_size = MDV_CONFIG.trlog.batch_size ? MDV_CONFIG.trlog.batch_size : 1;
+
+    if (mdv_condvar_lock(&trlog->gc_cv) != MDV_OK)
+    {
+        MDV_LOGE("TR log group commit failed");
+        mdv_free(packed, "trlog_op");
         return false;
     }
 
-    mdv_map_close(&tr_log);
+    // Enqueue the operation
+    if (trlog->gc_tail)
+        trlog->gc_tail->next = &waiter;
+    else
+        trlog->gc_head = &waiter;
 
-    mdv_rollbacker_free(rollbacker);
+    trlog->gc_tail = &waiter;
+
+    if (++trlog->gc_size >= batch_size)
+        mdv_condvar_broadcast(&trlog->gc_cv);
+
+    while (waiter.state == MDV_TRLOG_OP_PENDING)
+    {
+        if (trlog->gc_leader)
+        {
+            // Other thread performs the group commit. Wait for it.
+            mdv_condvar_wait_locked(&trlog->gc_cv, 0);
+            continue;
+        }
+
+        // The current thread becomes a leader and commits the waiting operations.
+        trlog->gc_leader = true;
+
+        if (MDV_CONFIG.trlog.linger && trlog->gc_size < batch_size)
+            mdv_condvar_wait_locked(&trlog->gc_cv, MDV_CONFIG.trlog.linger);
+
+        mdv_trlog_waiter *batch = trlog->gc_head;
+        mdv_trlog_waiter *last = batch;
+
+        uint32_t n = 1;
+
+        for(; n < batch_size && last->next; ++n)
+            last = last->next;
+
+        trlog->gc_head = last->next;
+
+        if (!trlog->gc_head)
+            trlog->gc_tail = 0;
+
+        last->next = 0;
+
+        trlog->gc_size -= n;
+
+        mdv_condvar_unlock(&trlog->gc_cv);
+
+        // Batch waiters are pending and alive until the results are published
+        mdv_trlog_result *results = mdv_alloc(n * sizeof(mdv_trlog_result), "trlog_results");
+
+        bool const committed = results
+                                && mdv_trlog_commit_batch(trlog, batch, results);
+
+        if (!results)
+            MDV_LOGE("No memory for TR log group commit");
+
+        mdv_condvar_lock(&trlog->gc_cv);
+
+        // Waiter may return as soon as its state is published, so the waiter isn't used after that
+        for(uint32_t i = 0; batch; ++i)
+        {
+            mdv_trlog_waiter *w = batch;
+            batch = w->next;
+
+            if (committed && results[i].ok)
+            {
+                w->id = results[i].id;
+                w->state = MDV_TRLOG_OP_COMMITTED;
+            }
+            else
+                w->state = MDV_TRLOG_OP_FAILED;
+        }
+
+        mdv_free(results, "trlog_results");
+
+        trlog->gc_leader = false;
+
+        mdv_condvar_broadcast(&trlog->gc_cv);
+    }
+
+    mdv_condvar_unlock(&trlog->gc_cv);
+
+    mdv_free(packed, "trlog_op");
+
+    if (waiter.state != MDV_TRLOG_OP_COMMITTED)
+        return false;
+
+    if (id)
+        *id = waiter.id;
 
     return true;
 }
 
 
-static size_t mdv_trlog_read(mdv_trlog                    *trlog,
-                             uint64_t                      pos,
-                             size_t                        size,
-                             mdv_list/*<mdv_trlog_data>*/ *ops)
+/**
+ * @brief Frees decompressed operations of the batch.
+ */
+static void mdv_trlog_unpacked_free(mdv_vector *unpacked)
 {
-    mdv_rollbacker *rollbacker = mdv_rollbacker_create(2);
+    mdv_trlog_op **ops = mdv_vector_data(unpacked);
+
+    for(size_t i = 0; i < mdv_vector_size(unpacked); ++i)
+        mdv_free(ops[i], "trlog_op");
+
+    mdv_vector_release(unpacked);
+}
+
+
+size_t mdv_trlog_read_batch(mdv_trlog         *trlog,
+                            uint64_t           pos,
+                            size_t             size,
+                            void              *arg,
+                            mdv_trlog_batch_fn fn)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(4);
+
+    mdv_vector *ops = mdv_vector_create(size, sizeof(mdv_trlog_view), &mdv_default_allocator);
+
+    if (!ops)
+    {
+        MDV_LOGE("No memory for TR log batch");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_vector_release, ops);
+
+    // Compressed records are decompressed into the memory which is valid until the handler returns
+    mdv_vector *unpacked = mdv_vector_create(4, sizeof(mdv_trlog_op*), &mdv_default_allocator);
+
+    if (!unpacked)
+    {
+        MDV_LOGE("No memory for TR log batch");
+        mdv_rollback(rollbacker);
+        return 0;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_trlog_unpacked_free, unpacked);
 
     // Start transaction
-    mdv_transaction transaction = mdv_transaction_start(trlog->storage);
+    mdv_transaction transaction = mdv_transaction_start_read(trlog->storage);
 
     if (!mdv_transaction_ok(transaction))
     {
@@ -365,9 +770,7 @@ static size_t mdv_trlog_read(mdv_trlog                    *trlog,
     mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
 
     // Open transaction log
-    mdv_map tr_log = mdv_map_open(&transaction,
-                                  MDV_MAP_TRLOG,
-                                  MDV_MAP_SILENT | MDV_MAP_INTEGERKEY);
+    mdv_map tr_log = mdv_map_bind(&transaction, trlog->trlog_map);
 
     if (!mdv_map_ok(tr_log))
     {
@@ -387,39 +790,354 @@ static size_t mdv_trlog_read(mdv_trlog                    *trlog,
         }
     };
 
-    size_t n = 0;
-
     mdv_map_foreach_explicit(transaction, tr_log, entry, MDV_SET_RANGE, MDV_CURSOR_NEXT)
     {
-        mdv_trlog_entry *op = mdv_alloc(sizeof(mdv_trlog_entry) + entry.value.size, "trlog_entry");
+        mdv_trlog_view view =
+        {
+            .op = entry.value.ptr
+        };
+
+        memcpy(&view.id, entry.key.ptr, sizeof view.id);
 
-        if (!op)
+        assert(view.op->size == entry.value.size);
+
+        uint32_t type;
+        memcpy(&type, &view.op->type, sizeof type);
+
+        if (type & MDV_TRLOG_OP_LZ)
         {
-            MDV_LOGE("No memory for TR log entry");
+            mdv_trlog_op *op = mdv_trlog_op_decompress(view.op, entry.value.size);
+
+            // The batch is cut before the broken record, so it is never skipped
+            if (!op)
+                mdv_map_foreach_break(entry);
+
+            if (!mdv_vector_push_back(unpacked, &op))
+            {
+                MDV_LOGE("No memory for TR log batch");
+                mdv_free(op, "trlog_op");
+                mdv_map_foreach_break(entry);
+            }
+
+            view.op = op;
+        }
+
+        if (!mdv_vector_push_back(ops, &view))
+        {
+            MDV_LOGE("No memory for TR log batch");
             mdv_map_foreach_break(entry);
         }
 
-        mdv_trlog_op const *trlog_op = entry.value.ptr;
+        if(mdv_vector_size(ops) >= size)
+            mdv_map_foreach_break(entry);
+    }
 
-        op->data.id = *(uint64_t*)entry.key.ptr;
+    size_t const count = mdv_vector_size(ops);
 
-        assert(trlog_op->size == entry.value.size);
+    if (count)
+        fn(arg, mdv_vector_data(ops), count);
 
-        memcpy(&op->data.op, trlog_op, trlog_op->size);
+    mdv_rollback(rollbacker);
 
-        mdv_list_emplace_back(ops, (mdv_list_entry_base *)op);
+    return count;
+}
 
-        if(++n >= size)
-            mdv_map_foreach_break(entry);
+
+mdv_trlog_op * mdv_trlog_op_copy(mdv_trlog_op const *op)
+{
+    uint32_t size;
+    memcpy(&size, &op->size, sizeof size);
+
+    mdv_trlog_op *copy = mdv_alloc(size, "trlog_op");
+
+    if (!copy)
+    {
+        MDV_LOGE("No memory for TR log operation");
+        return 0;
+    }
+
+    memcpy(copy, op, size);
+
+    return copy;
+}
+
+
+void mdv_trlog_op_free(mdv_trlog_op *op)
+{
+    mdv_free(op, "trlog_op");
+}
+
+
+bool mdv_trlog_ack(mdv_trlog *trlog, mdv_uuid const *peer, uint64_t pos)
+{
+    bool ret = false;
+
+    if (mdv_mutex_lock(&trlog->acks_mutex) == MDV_OK)
+    {
+        mdv_trlog_ack_ref *ref = mdv_hashmap_find(trlog->acks, peer);
+
+        if (ref)
+        {
+            if (ref->pos < pos)
+                ref->pos = pos;
+            ret = true;
+        }
+        else
+        {
+            mdv_trlog_ack_ref const new_ref =
+            {
+                .peer = *peer,
+                .pos = pos
+            };
+
+            ret = mdv_hashmap_insert(trlog->acks, &new_ref, sizeof new_ref) != 0;
+        }
+
+        mdv_mutex_unlock(&trlog->acks_mutex);
+    }
+
+    return ret;
+}
+
+
+/**
+ * @brief Returns the minimal position acknowledged by all peers.
+ * @details Zero is returned if less than peers_num peers acknowledged positions.
+ */
+static uint64_t mdv_trlog_acked(mdv_trlog *trlog, uint32_t peers_num)
+{
+    uint64_t pos = UINT64_MAX;
+
+    if (!peers_num)
+        return pos;
+
+    if (mdv_mutex_lock(&trlog->acks_mutex) != MDV_OK)
+        return 0;
+
+    if (mdv_hashmap_size(trlog->acks) < peers_num)
+        pos = 0;
+    else
+    {
+        mdv_hashmap_foreach(trlog->acks, mdv_trlog_ack_ref, ref)
+        {
+            if (ref->pos < pos)
+                pos = ref->pos;
+        }
     }
 
+    mdv_mutex_unlock(&trlog->acks_mutex);
+
+    return pos;
+}
+
+
+/**
+ * @brief Deletes transaction log records in range (from, to] using one transaction.
+ * @details Records are deleted by the cursor which starts from the first record after 'from'.
+ *          New low-water mark is saved in the same transaction.
+ */
+static bool mdv_trlog_truncate(mdv_trlog *trlog, uint64_t from, uint64_t to)
+{
+    mdv_rollbacker *rollbacker = mdv_rollbacker_create(4);
+
+    mdv_transaction transaction = mdv_transaction_start(trlog->storage);
+
+    if (!mdv_transaction_ok(transaction))
+    {
+        MDV_LOGE("TR log transaction failed");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_transaction_abort, &transaction);
+
+    mdv_map tr_log = mdv_map_bind(&transaction, trlog->trlog_map);
+
+    if (!mdv_map_ok(tr_log))
+    {
+        MDV_LOGE("Transaction log map '%s' not opened", MDV_MAP_TRLOG);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &tr_log);
+
+    mdv_map applied = mdv_map_bind(&transaction, trlog->applied_map);
+
+    if (!mdv_map_ok(applied))
+    {
+        MDV_LOGE("Transaction log map '%s' not opened", MDV_MAP_APPLIED);
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_rollbacker_push(rollbacker, mdv_map_close, &applied);
+
+    // Identifiers might contain gaps, so only the existing records are visited
+    uint64_t id = from + 1;
+
+    mdv_data k = { sizeof id, &id };
+    mdv_data v = {};
+
+    mdv_cursor cursor = mdv_cursor_open_explicit(&tr_log, &transaction, &k, &v, MDV_SET_RANGE);
+
+    if (mdv_cursor_ok(cursor))
+    {
+        bool deleted = true;
+
+        do
+        {
+            memcpy(&id, k.ptr, sizeof id);
+
+            if (id > to)
+                break;
+
+            deleted = mdv_cursor_del(&cursor);
+        }
+        while(deleted && mdv_cursor_get(&cursor, &k, &v, MDV_CURSOR_NEXT));
+
+        mdv_cursor_close(&cursor);
+
+        if (!deleted)
+        {
+            MDV_LOGE("TR log records weren't deleted");
+            mdv_rollback(rollbacker);
+            return false;
+        }
+    }
+
+    mdv_data const low_water_key = { sizeof MDV_TRLOG_LOW_WATER_KEY, (void*)&MDV_TRLOG_LOW_WATER_KEY };
+    mdv_data const low_water = { sizeof to, &to };
+
+    if (!mdv_map_put(&applied, &transaction, &low_water_key, &low_water))
+    {
+        MDV_LOGE("TR log low-water mark wasn't saved");
+        mdv_rollback(rollbacker);
+        return false;
+    }
+
+    mdv_map_close(&applied);
+
+    mdv_trlog_applied_pos_save(trlog, &transaction);
     mdv_map_close(&tr_log);
 
-    mdv_transaction_abort(&transaction);
+    if (!mdv_transaction_commit(&transaction))
+    {
+        MDV_LOGE("TR log transaction failed");
+        mdv_rollbacker_free(rollbacker);
+        return false;
+    }
 
     mdv_rollbacker_free(rollbacker);
 
-    return n;
+    return true;
+}
+
+
+uint64_t mdv_trlog_checkpoint(mdv_trlog         *trlog,
+                              uint32_t           peers_num,
+                              uint32_t           batch_size,
+                              void              *arg,
+                              mdv_trlog_flush_fn flush)
+{
+    uint64_t low_water = atomic_load_explicit(&trlog->low_water, memory_order_relaxed);
+
+    bool idle = false;
+
+    if (!atomic_compare_exchange_strong(&trlog->checkpoint, &idle, true))
+    {
+        atomic_store(&trlog->checkpoint_due, false);
+        return low_water;       // Other thread performs the checkpoint
+    }
+
+    if (!batch_size)
+        batch_size = 1;
+
+    uint64_t target = atomic_load(&trlog->applied);
+    uint64_t const acked = mdv_trlog_acked(trlog, peers_num);
+
+    if (acked < target)
+        target = acked;
+
+    // Data applied before the flush is durable after it
+    if (flush
+        && target > low_water
+        && target - low_water >= batch_size
+        && !flush(arg))
+    {
+        MDV_LOGE("TR log checkpoint failed. Applied data isn't flushed.");
+        target = low_water;
+    }
+
+    // Records are deleted by full batches to avoid small transactions
+    while (target > low_water && target - low_water >= batch_size)
+    {
+        uint64_t const pos = low_water + batch_size;
+
+        if (!mdv_trlog_truncate(trlog, low_water, pos))
+            break;
+
+        low_water = pos;
+
+        atomic_store_explicit(&trlog->low_water, low_water, memory_order_relaxed);
+
+        MDV_LOGD("TR log low-water mark: %llu", (unsigned long long)low_water);
+    }
+
+    atomic_store(&trlog->checkpoint, false);
+    atomic_store(&trlog->checkpoint_due, false);
+
+    return low_water;
+}
+
+
+bool mdv_trlog_checkpoint_due(mdv_trlog *trlog, uint32_t peers_num, uint32_t batch_size)
+{
+    if (!batch_size)
+        batch_size = 1;
+
+    uint64_t const low_water = atomic_load_explicit(&trlog->low_water, memory_order_relaxed);
+
+    uint64_t target = atomic_load(&trlog->applied);
+
+    if (target <= low_water || target - low_water < batch_size)
+        return false;
+
+    uint64_t const acked = mdv_trlog_acked(trlog, peers_num);
+
+    if (acked < target)
+        target = acked;
+
+    if (target <= low_water || target - low_water < batch_size)
+        return false;
+
+    bool idle = false;
+
+    return atomic_compare_exchange_strong(&trlog->checkpoint_due, &idle, true);
+}
+
+
+uint64_t mdv_trlog_low_water(mdv_trlog *trlog)
+{
+    return atomic_load_explicit(&trlog->low_water, memory_order_relaxed);
+}
+
+
+uint64_t mdv_trlog_applied_pos(mdv_trlog *trlog)
+{
+    return atomic_load_explicit(&trlog->applied, memory_order_relaxed);
+}
+
+
+void mdv_trlog_applied_pos_set(mdv_trlog *trlog, uint64_t pos)
+{
+    atomic_store_explicit(&trlog->applied, pos, memory_order_relaxed);
+}
+
+
+uint64_t mdv_trlog_durable_id(mdv_trlog *trlog)
+{
+    return mdv_storage_durable_mark(trlog->storage);
 }
 
 
@@ -430,44 +1148,75 @@ bool mdv_trlog_changed(mdv_trlog *trlog)
 }
 
 
-uint32_t mdv_trlog_apply(mdv_trlog         *trlog,
-                         uint32_t           batch_size,
-                         void              *arg,
-                         mdv_trlog_apply_fn fn)
-{
-    uint64_t const applied_pos = atomic_load_explicit(&trlog->applied, memory_order_relaxed);
-    uint64_t const top         = atomic_load_explicit(&trlog->top, memory_order_relaxed);
+/// @cond Doxygen_Suppress
 
-    if (applied_pos >= top)
-        return 0;
+typedef struct
+{
+    mdv_trlog_applier const *applier;           ///< Transaction log applier
+    uint64_t                 applied_pos;       ///< Last applied record identifier
+    uint32_t                 applied;           ///< Number of applied records
+} mdv_trlog_apply_context;
 
-    mdv_list/*<mdv_trlog_data>*/ ops = {};
+/// @endcond
 
-    size_t const count = mdv_trlog_read(trlog, applied_pos + 1, batch_size, &ops);
 
-    if (!count)     // No data in TR log
-        return 0;
+static void mdv_trlog_apply_batch(void *arg, mdv_trlog_view const *ops, size_t count)
+{
+    mdv_trlog_apply_context *ctx = arg;
+    mdv_trlog_applier const *applier = ctx->applier;
 
-    uint64_t new_applied_pos = applied_pos;
+    uint64_t applied_pos = ctx->applied_pos;
 
-    size_t n = 0;
+    uint32_t n = 0;
 
-    mdv_list_foreach(&ops, mdv_trlog_data, op)
+    for(size_t i = 0; i < count; ++i)
     {
-        if (!fn(arg, &op->op))
+        if (!applier->apply(applier->arg, ops[i].id, ops[i].op))
         {
             MDV_LOGE("TR Log operation not applied");
             break;
         }
 
-        new_applied_pos = op->id;
+        applied_pos = ops[i].id;
         ++n;
     }
 
-    mdv_list_clear(&ops);
+    // Operations point into the TR log storage and they are valid until the batch handler returns
+    if (n && !applier->commit(applier->arg))
+    {
+        MDV_LOGE("TR Log batch not committed");
+        n = 0;
+    }
 
     if (n)
-        mdv_trlog_applied_pos_set(trlog, new_applied_pos);
+    {
+        ctx->applied_pos = applied_pos;
+        ctx->applied = n;
+    }
+}
+
+
+uint32_t mdv_trlog_apply(mdv_trlog               *trlog,
+                         uint32_t                 batch_size,
+                         mdv_trlog_applier const *applier)
+{
+    uint64_t const applied_pos = atomic_load_explicit(&trlog->applied, memory_order_relaxed);
+    uint64_t const top         = atomic_load_explicit(&trlog->top, memory_order_relaxed);
+
+    if (applied_pos >= top)
+        return 0;
+
+    mdv_trlog_apply_context ctx =
+    {
+        .applier = applier,
+        .applied_pos = applied_pos,
+        .applied = 0
+    };
+
+    mdv_trlog_read_batch(trlog, applied_pos + 1, batch_size, &ctx, mdv_trlog_apply_batch);
+
+    if (ctx.applied)
+        mdv_trlog_applied_pos_set(trlog, ctx.applied_pos);
 
-    return n;
+    return ctx.applied;
 }
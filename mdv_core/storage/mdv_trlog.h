@@ -35,12 +35,53 @@ typedef struct
 } mdv_trlog_data;
 
 
-typedef bool (*mdv_trlog_apply_fn)(void *arg, mdv_trlog_op *op);
+typedef bool (*mdv_trlog_apply_fn)(void *arg, uint64_t id, mdv_trlog_op const *op);
+typedef bool (*mdv_trlog_commit_fn)(void *arg);
+
+
+/**
+ * @brief Transaction log applier
+ * @details Operations are passed to the apply() callback one by one.
+ *          Operations are valid until the commit() callback returns.
+ *          All operations of the batch should be written to the data storage by the commit() callback.
+ *          Transaction log applied position is changed only after successful commit.
+ *
+ *          Applied position isn't saved by a separate transaction. It is saved with the next transaction
+ *          log changes or checkpoint, so after the crash the records might be passed to the applier again.
+ *          Applier should save the last applied record identifier (see apply() callback) in the data storage
+ *          using the same transaction as the applied data and skip the records which are already applied.
+ */
+typedef struct
+{
+    void               *arg;        ///< Argument which is passed to the callbacks
+    mdv_trlog_apply_fn  apply;      ///< DB operation handler
+    mdv_trlog_commit_fn commit;     ///< Batch commit handler
+} mdv_trlog_applier;
 
 
 typedef mdv_list_entry(mdv_trlog_data) mdv_trlog_entry;
 
 
+/// Transaction log record view. Operation points directly into the storage memory or into the decompressed record copy.
+typedef struct
+{
+    uint64_t            id;     ///< record identifier
+    mdv_trlog_op const *op;     ///< DB operation (not aligned)
+} mdv_trlog_view;
+
+
+/**
+ * @brief Transaction log batch handler
+ * @details Operations are valid until the handler returns.
+ *          If an operation must outlive the handler call, it should be copied with mdv_trlog_op_copy().
+ *
+ * @param arg [in]      User defined argument
+ * @param ops [in]      Transaction log records
+ * @param count [in]    Number of records
+ */
+typedef void (*mdv_trlog_batch_fn)(void *arg, mdv_trlog_view const *ops, size_t count);
+
+
 /**
  * @brief Opens or creates new transaction log storage
  *
@@ -73,6 +114,14 @@ mdv_trlog * mdv_trlog_retain(mdv_trlog *trlog);
 uint32_t mdv_trlog_release(mdv_trlog *trlog);
 
 
+/**
+ * @brief Returns transaction log storage UUID.
+ *
+ * @param trlog [in]    Transaction logs storage
+ */
+mdv_uuid const * mdv_trlog_uuid(mdv_trlog *trlog);
+
+
 /**
  * @brief Writes data to the transaction log.
  *
@@ -92,12 +141,143 @@ bool mdv_trlog_add(mdv_trlog *trlog,
  *
  * @param trlog [in]            Transaction logs storage
  * @param op [in]               DB operation to be written to the transaction log
+ * @param id [out]              Identifier of the transaction log record (may be NULL)
  *
  * @return true if data was successfully written
  * @return false if error was happened
  */
 bool mdv_trlog_add_op(mdv_trlog *trlog,
-                      mdv_trlog_op const *op);
+                      mdv_trlog_op const *op,
+                      uint64_t *id);
+
+
+/**
+ * @brief Reads the transaction log records batch without copying.
+ * @details Records are read within one read-only transaction which is active while the handler is called.
+ *
+ * @param trlog [in]    Transaction logs storage
+ * @param pos [in]      First record identifier
+ * @param size [in]     Maximum number of records in batch
+ * @param arg [in]      User defined argument which is passed to the handler
+ * @param fn [in]       Batch handler
+ *
+ * @return number of records passed to the handler
+ */
+size_t mdv_trlog_read_batch(mdv_trlog         *trlog,
+                            uint64_t           pos,
+                            size_t             size,
+                            void              *arg,
+                            mdv_trlog_batch_fn fn);
+
+
+/**
+ * @brief Copies the transaction log operation.
+ * @details Copy is aligned and should be freed with mdv_trlog_op_free().
+ */
+mdv_trlog_op * mdv_trlog_op_copy(mdv_trlog_op const *op);
+
+
+/**
+ * @brief Frees the transaction log operation copy.
+ */
+void mdv_trlog_op_free(mdv_trlog_op *op);
+
+
+/**
+ * @brief Saves the transaction log position acknowledged by the peer.
+ * @details Acknowledged positions are kept in memory. After restart, the transaction log
+ *          isn't truncated until all peers acknowledge their positions again.
+ *          Data synchronizer doesn't acknowledge positions yet, so the tablespace disables the checkpoint in cluster mode.
+ *
+ * @param trlog [in]    Transaction logs storage
+ * @param peer [in]     Peer UUID
+ * @param pos [in]      Position replicated to the peer
+ *
+ * @return true if position was saved
+ */
+bool mdv_trlog_ack(mdv_trlog *trlog, mdv_uuid const *peer, uint64_t pos);
+
+
+/**
+ * @brief Applied data flusher. It returns true if all applied data is flushed to disk.
+ */
+typedef bool (*mdv_trlog_flush_fn)(void *arg);
+
+
+/**
+ * @brief Deletes the transaction log records which are applied and acknowledged by all peers.
+ * @details Low-water mark is the minimal position which is both applied and acknowledged by peers_num peers.
+ *          Records are deleted by full batches. Each batch is deleted in separate transaction.
+ *
+ *          Applied position means only that the data storage transaction is committed. If the data storage
+ *          doesn't flush each commit, the flush() callback is called once before the first batch deletion.
+ *          Records are deleted only up to the position which was applied before the flush. If the flush fails,
+ *          nothing is deleted.
+ *
+ * @param trlog [in]        Transaction logs storage
+ * @param peers_num [in]    Number of peers which should acknowledge positions
+ * @param batch_size [in]   Number of records deleted in one transaction
+ * @param arg [in]          Argument which is passed to the flush() callback
+ * @param flush [in]        Applied data flusher (NULL if each commit is durable)
+ *
+ * @return transaction log low-water mark
+ */
+uint64_t mdv_trlog_checkpoint(mdv_trlog         *trlog,
+                              uint32_t           peers_num,
+                              uint32_t           batch_size,
+                              void              *arg,
+                              mdv_trlog_flush_fn flush);
+
+
+/**
+ * @brief Checks whether the checkpoint should be scheduled.
+ * @details Checkpoint is due when at least one full batch of records is applied and acknowledged.
+ *          Returns true only once until the next mdv_trlog_checkpoint() call is finished,
+ *          so the caller schedules at most one checkpoint at a time.
+ *
+ * @param trlog [in]        Transaction logs storage
+ * @param peers_num [in]    Number of peers which should acknowledge positions
+ * @param batch_size [in]   Number of records deleted in one transaction
+ *
+ * @return true if the checkpoint should be scheduled
+ */
+bool mdv_trlog_checkpoint_due(mdv_trlog *trlog, uint32_t peers_num, uint32_t batch_size);
+
+
+/**
+ * @brief Returns transaction log low-water mark. All records up to this position are deleted.
+ *
+ * @param trlog [in]
+ */
+uint64_t mdv_trlog_low_water(mdv_trlog *trlog);
+
+
+/**
+ * @brief Returns the identifier of the last applied transaction log record.
+ *
+ * @param trlog [in]
+ */
+uint64_t mdv_trlog_applied_pos(mdv_trlog *trlog);
+
+
+/**
+ * @brief Saves the identifier of the last applied transaction log record.
+ * @details It is used by the appliers which read the transaction log by mdv_trlog_read_batch().
+ *          Position is kept in memory and it is saved with the next transaction log changes or checkpoint.
+ *
+ * @param trlog [in]    Transaction logs storage
+ * @param pos [in]      Last applied record identifier
+ */
+void mdv_trlog_applied_pos_set(mdv_trlog *trlog, uint64_t pos);
+
+
+/**
+ * @brief Returns the identifier up to which the transaction log is flushed to disk.
+ * @details With async durability, records after this identifier might be lost on system crash.
+ *
+ * @param trlog [in]
+ */
+uint64_t mdv_trlog_durable_id(mdv_trlog *trlog);
 
 
 /**
@@ -110,9 +290,14 @@ bool mdv_trlog_changed(mdv_trlog *trlog);
 
 /**
  * @brief Applies transaction log
+ * @details Operations are read by batches. Each batch is committed by applier using one commit() call.
+ *
+ * @param trlog [in]            Transaction logs storage
+ * @param batch_size [in]       Maximum number of operations in batch
+ * @param applier [in]          Transaction log applier
+ *
  * @return number of applied rows
  */
-uint32_t mdv_trlog_apply(mdv_trlog         *trlog,
-                         uint32_t           batch_size,
-                         void              *arg,
-                         mdv_trlog_apply_fn fn);
+uint32_t mdv_trlog_apply(mdv_trlog               *trlog,
+                         uint32_t                 batch_size,
+                         mdv_trlog_applier const *applier);
@@ -82,3 +82,74 @@ size_t mdv_bitset_size(mdv_bitset const *bitset)
 {
     return bitset->size;
 }
+
+
+static size_t mdv_bitset_words(mdv_bitset const *bitset)
+{
+    return mdv_bitset_capacity(bitset->size) / (sizeof(uint32_t) * CHAR_BIT);
+}
+
+
+static void mdv_bitset_tail_clear(mdv_bitset *bitset)
+{
+    size_t const b = CHAR_BIT * sizeof *bitset->bits;
+    size_t const tail = bitset->size % b;
+
+    if (tail)
+        bitset->bits[bitset->size / b] &= (1u << tail) - 1;
+}
+
+
+uint32_t * mdv_bitset_data(mdv_bitset *bitset)
+{
+    return bitset->bits;
+}
+
+
+void mdv_bitset_fill(mdv_bitset *bitset, bool value)
+{
+    memset(bitset->bits, value ? 0xFF : 0, mdv_bitset_capacity(bitset->size) / CHAR_BIT);
+    mdv_bitset_tail_clear(bitset);
+}
+
+
+void mdv_bitset_and(mdv_bitset *bitset, mdv_bitset const *other)
+{
+    size_t const words = mdv_bitset_words(bitset);
+
+    for(size_t i = 0; i < words; ++i)
+        bitset->bits[i] &= other->bits[i];
+}
+
+
+void mdv_bitset_or(mdv_bitset *bitset, mdv_bitset const *other)
+{
+    size_t const words = mdv_bitset_words(bitset);
+
+    for(size_t i = 0; i < words; ++i)
+        bitset->bits[i] |= other->bits[i];
+}
+
+
+void mdv_bitset_invert(mdv_bitset *bitset)
+{
+    size_t const words = mdv_bitset_words(bitset);
+
+    for(size_t i = 0; i < words; ++i)
+        bitset->bits[i] = ~bitset->bits[i];
+
+    mdv_bitset_tail_clear(bitset);
+}
+
+
+size_t mdv_bitset_count(mdv_bitset const *bitset)
+{
+    size_t const words = mdv_bitset_words(bitset);
+
+    size_t count = 0;
+
+    for(size_t i = 0; i < words; ++i)
+        count += (size_t)__builtin_popcount(bitset->bits[i]);
+
+    return count;
+}
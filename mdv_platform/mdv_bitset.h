@@ -50,3 +50,41 @@ bool mdv_bitset_test(mdv_bitset const *bitset, size_t pos);
  * @brief Returns the bitset size
  */
 size_t mdv_bitset_size(mdv_bitset const *bitset);
+
+
+/**
+ * @brief Returns the bits storage.
+ * @details Bits are packed into 32 bit words starting from the least significant bit.
+ *          Bits after the bitset size in the last word are always zero.
+ */
+uint32_t * mdv_bitset_data(mdv_bitset *bitset);
+
+
+/**
+ * @brief Sets all bits to the given value.
+ */
+void mdv_bitset_fill(mdv_bitset *bitset, bool value);
+
+
+/**
+ * @brief Performs binary AND between the bitsets. Bitsets should have the same size.
+ */
+void mdv_bitset_and(mdv_bitset *bitset, mdv_bitset const *other);
+
+
+/**
+ * @brief Performs binary OR between the bitsets. Bitsets should have the same size.
+ */
+void mdv_bitset_or(mdv_bitset *bitset, mdv_bitset const *other);
+
+
+/**
+ * @brief Flips all bits.
+ */
+void mdv_bitset_invert(mdv_bitset *bitset);
+
+
+/**
+ * @brief Returns the number of bits set to true.
+ */
+size_t mdv_bitset_count(mdv_bitset const *bitset);
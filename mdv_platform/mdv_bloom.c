@@ -31,6 +31,11 @@ struct mdv_bloom
 
 mdv_bloom * mdv_bloom_create(uint32_t entries, double err)
 {
+    // Bits count is infinite for zero probability and it is negative for the probability above one (NaN is clamped too)
+    err = err > 1.0 ? 1.0
+          : err >= 0.00001 ? err
+          : 0.00001;
+
     size_t const bits = MDV_BLOOM_BITS(entries, err);
     size_t const bytes = MDV_BLOOM_BYTES(bits);
     size_t const size = offsetof(mdv_bloom, bf) + bytes;
@@ -47,9 +52,7 @@ mdv_bloom * mdv_bloom_create(uint32_t entries, double err)
     bloom->capacity = entries;
     bloom->size = 0;
     bloom->hashes = MDV_BLOOM_HASH_FNS(bits, entries);
-    bloom->err = err > 1.0 ? 1.0
-                 : err < 0.00001 ? 0.00001
-                 : err;
+    bloom->err = err;
     memset(bloom->bf, 0, bytes);
 
     return bloom;
@@ -75,7 +78,7 @@ bool mdv_bloom_insert(mdv_bloom *bloom, void const *data, uint32_t const len)
         uint32_t const bit = hash % bloom->bits;
         uint32_t const byte = bit / 8;
         uint32_t const offset = bit % 8;
-        is_changed |= (bloom->bf[byte] >> offset) == 0;
+        is_changed |= ((bloom->bf[byte] >> offset) & 1) == 0;
         bloom->bf[byte] |= 1 << offset;
     }
 
@@ -94,7 +97,7 @@ bool mdv_bloom_contains(mdv_bloom *bloom, void const *data, uint32_t const len)
         uint32_t const bit = hash % bloom->bits;
         uint32_t const byte = bit / 8;
         uint32_t const offset = bit % 8;
-        if ((bloom->bf[byte] >> offset) == 0)
+        if (((bloom->bf[byte] >> offset) & 1) == 0)
             return false;
     }
 
@@ -114,6 +117,70 @@ uint32_t mdv_bloom_size(mdv_bloom const *bloom)
 }
 
 
+/// Serialized Bloom filter header
+typedef struct
+{
+    uint64_t bits;      ///< number of bits in bloom filter
+    uint32_t capacity;  ///< max entries number
+    uint32_t size;      ///< actually added number of entries
+    double   err;       ///< error
+} mdv_bloom_hdr;
+
+
+size_t mdv_bloom_serialized_size(mdv_bloom const *bloom)
+{
+    return sizeof(mdv_bloom_hdr) + MDV_BLOOM_BYTES(bloom->bits);
+}
+
+
+void mdv_bloom_serialize(mdv_bloom const *bloom, void *buf)
+{
+    mdv_bloom_hdr const hdr =
+    {
+        .bits = bloom->bits,
+        .capacity = bloom->capacity,
+        .size = bloom->size,
+        .err = bloom->err
+    };
+
+    memcpy(buf, &hdr, sizeof hdr);
+    memcpy((uint8_t*)buf + sizeof hdr, bloom->bf, MDV_BLOOM_BYTES(bloom->bits));
+}
+
+
+mdv_bloom * mdv_bloom_deserialize(void const *buf, size_t size)
+{
+    mdv_bloom_hdr hdr;
+
+    if (size < sizeof hdr)
+    {
+        MDV_LOGE("bloom_deserialize failed. Invalid data.");
+        return 0;
+    }
+
+    memcpy(&hdr, buf, sizeof hdr);
+
+    mdv_bloom *bloom = mdv_bloom_create(hdr.capacity, hdr.err);
+
+    if (!bloom)
+        return 0;
+
+    if (bloom->bits != hdr.bits
+        || size != mdv_bloom_serialized_size(bloom)
+        || hdr.size > hdr.capacity)
+    {
+        MDV_LOGE("bloom_deserialize failed. Invalid data.");
+        mdv_bloom_free(bloom);
+        return 0;
+    }
+
+    bloom->size = hdr.size;
+    memcpy(bloom->bf, (uint8_t const*)buf + sizeof hdr, MDV_BLOOM_BYTES(bloom->bits));
+
+    return bloom;
+}
+
+
 #undef MDV_LN2
 #undef MDV_BLOOM_BITS
 #undef MDV_BLOOM_BYTES
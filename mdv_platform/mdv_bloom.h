@@ -82,3 +82,33 @@ uint32_t mdv_bloom_capacity(mdv_bloom const *bloom);
  */
 uint32_t mdv_bloom_size(mdv_bloom const *bloom);
 
+
+/**
+ * @brief Return serialized Bloom filter size
+ *
+ * @param bloom [in] Bloom filter
+ *
+ * @return serialized Bloom filter size in bytes
+ */
+size_t mdv_bloom_serialized_size(mdv_bloom const *bloom);
+
+
+/**
+ * @brief Serialize Bloom filter
+ *
+ * @param bloom [in] Bloom filter
+ * @param buf [out]  Buffer for serialized Bloom filter. Buffer size should be at least mdv_bloom_serialized_size().
+ */
+void mdv_bloom_serialize(mdv_bloom const *bloom, void *buf);
+
+
+/**
+ * @brief Create Bloom filter from serialized data
+ *
+ * @param buf [in]  Serialized Bloom filter
+ * @param size [in] Serialized data size
+ *
+ * @return On success return nonzero pointer to new created bloom filter
+ * @return On error return NULL pointer
+ */
+mdv_bloom * mdv_bloom_deserialize(void const *buf, size_t size);
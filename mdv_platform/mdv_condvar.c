@@ -106,15 +106,16 @@ mdv_errno mdv_condvar_wait(mdv_condvar *cv)
 }
 
 
-mdv_errno mdv_condvar_timedwait(mdv_condvar *cv, size_t duration)
+/**
+ * @brief Waits for the condition variable signal. Mutex should be locked by the caller.
+ */
+static mdv_errno mdv_condvar_wait_until(mdv_condvar *cv, size_t duration)
 {
-    mdv_errno err = MDV_FAILED;
-
     struct timespec t;
 
     if (clock_gettime(CLOCK_MONOTONIC, &t) != 0)
     {
-        err = mdv_error();
+        mdv_errno err = mdv_error();
         MDV_LOGE("clock_gettime failed with error %d", err);
         return err;
     }
@@ -122,25 +123,74 @@ mdv_errno mdv_condvar_timedwait(mdv_condvar *cv, size_t duration)
     t.tv_sec += duration / 1000;
     t.tv_nsec += (duration % 1000) * 1000000;
 
-    if (pthread_mutex_lock(&cv->mutex) == 0)
+    if (t.tv_nsec >= 1000000000)
     {
-        int cv_err = pthread_cond_timedwait(&cv->cv, &cv->mutex, &t);
+        t.tv_sec += 1;
+        t.tv_nsec -= 1000000000;
+    }
 
-        if (cv_err == 0)
-            err = MDV_OK;
-        else if (cv_err == ETIMEDOUT)
-            err = MDV_ETIMEDOUT;
-        else
-        {
-            err = cv_err;
-            MDV_LOGE("condvar waiting failed with error %d", err);
-        }
+    int const cv_err = pthread_cond_timedwait(&cv->cv, &cv->mutex, &t);
 
-        pthread_mutex_unlock(&cv->mutex);
+    switch(cv_err)
+    {
+        case 0:         return MDV_OK;
+        case ETIMEDOUT: return MDV_ETIMEDOUT;
     }
-    else
+
+    MDV_LOGE("condvar waiting failed with error %d", cv_err);
+
+    return cv_err;
+}
+
+
+mdv_errno mdv_condvar_timedwait(mdv_condvar *cv, size_t duration)
+{
+    if (pthread_mutex_lock(&cv->mutex) != 0)
+    {
         MDV_LOGE("condvar mutex locking failed");
+        return MDV_FAILED;
+    }
+
+    mdv_errno const err = mdv_condvar_wait_until(cv, duration);
+
+    pthread_mutex_unlock(&cv->mutex);
 
     return err;
 }
 
+
+mdv_errno mdv_condvar_lock(mdv_condvar *cv)
+{
+    return pthread_mutex_lock(&cv->mutex) == 0 ? MDV_OK : MDV_FAILED;
+}
+
+
+mdv_errno mdv_condvar_unlock(mdv_condvar *cv)
+{
+    return pthread_mutex_unlock(&cv->mutex) == 0 ? MDV_OK : MDV_FAILED;
+}
+
+
+mdv_errno mdv_condvar_wait_locked(mdv_condvar *cv, size_t duration)
+{
+    if (duration)
+        return mdv_condvar_wait_until(cv, duration);
+
+    int const cv_err = pthread_cond_wait(&cv->cv, &cv->mutex);
+
+    if (cv_err)
+        MDV_LOGE("condvar waiting failed with error %d", cv_err);
+
+    return cv_err ? cv_err : MDV_OK;
+}
+
+
+mdv_errno mdv_condvar_broadcast(mdv_condvar *cv)
+{
+    int cv_err = pthread_cond_broadcast(&cv->cv);
+
+    if (cv_err)
+        MDV_LOGE("condvar broadcasting failed with error %d", cv_err);
+
+    return cv_err ? cv_err : MDV_OK;
+}
@@ -72,3 +72,47 @@ mdv_errno mdv_condvar_wait(mdv_condvar *cv);
 mdv_errno mdv_condvar_timedwait(mdv_condvar *cv, size_t duration);
 
 
+/**
+ * @brief Lock the condition variable mutex
+ * @details Used with mdv_condvar_wait_locked() when the waiting is guarded by a predicate.
+ *
+ * @param cv [in] condition variable
+ *
+ * @return On success return MDV_OK
+ * @return On error non zero value is returned
+ */
+mdv_errno mdv_condvar_lock(mdv_condvar *cv);
+
+
+/**
+ * @brief Unlock the condition variable mutex
+ *
+ * @param cv [in] condition variable
+ *
+ * @return On success return MDV_OK
+ * @return On error non zero value is returned
+ */
+mdv_errno mdv_condvar_unlock(mdv_condvar *cv);
+
+
+/**
+ * @brief Wait on a condition. The condition variable mutex should be locked by caller.
+ *
+ * @param cv [in] condition variable
+ * @param duration [in] time duration in milliseconds for wait. Zero means infinite waiting.
+ *
+ * @return On success return MDV_OK or MDV_ETIMEDOUT
+ * @return On error non zero value is returned
+ */
+mdv_errno mdv_condvar_wait_locked(mdv_condvar *cv, size_t duration);
+
+
+/**
+ * @brief Wake up all threads waiting on a condition
+ *
+ * @param cv [in] condition variable
+ *
+ * @return On success return MDV_OK
+ * @return On error non zero value is returned
+ */
+mdv_errno mdv_condvar_broadcast(mdv_condvar *cv);
@@ -0,0 +1,237 @@
+#include "mdv_lz.h"
+#include <string.h>
+
+
+enum
+{
+    MDV_LZ_MIN_MATCH        = 4,        ///< Minimum match length
+    MDV_LZ_LAST_LITERALS    = 5,        ///< Last bytes are always stored as literals
+    MDV_LZ_MAX_OFFSET       = 65535,    ///< Maximum match offset
+    MDV_LZ_HASH_BITS        = 12,       ///< Hash table size (log2)
+    MDV_LZ_SKIP_TRIGGER     = 6,        ///< Search step is increased for each 2^MDV_LZ_SKIP_TRIGGER bytes without matches
+    MDV_LZ_RUN_MASK         = 15        ///< Length is continued by the next bytes
+};
+
+
+static uint32_t mdv_lz_read32(uint8_t const *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+
+static uint32_t mdv_lz_hash(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - MDV_LZ_HASH_BITS);
+}
+
+
+static uint8_t * mdv_lz_length_write(uint8_t *op, uint8_t const *end, size_t len)
+{
+    for(len -= MDV_LZ_RUN_MASK; len >= 255; len -= 255)
+    {
+        if (op >= end)
+            return 0;
+        *op++ = 255;
+    }
+
+    if (op >= end)
+        return 0;
+
+    *op++ = (uint8_t)len;
+
+    return op;
+}
+
+
+static uint8_t const * mdv_lz_length_read(uint8_t const *ip, uint8_t const *end, size_t *len)
+{
+    uint8_t b;
+
+    do
+    {
+        if (ip >= end)
+            return 0;
+        b = *ip++;
+        *len += b;
+    }
+    while (b == 255);
+
+    return ip;
+}
+
+
+/**
+ * @brief Writes the literals followed by the match. If the match length is zero, the last record is written.
+ */
+static uint8_t * mdv_lz_record_write(uint8_t           *op,
+                                     uint8_t const     *end,
+                                     uint8_t const     *literals,
+                                     size_t             literals_len,
+                                     size_t             offset,
+                                     size_t             match_len)
+{
+    if (op >= end)
+        return 0;
+
+    size_t const match = match_len ? match_len - MDV_LZ_MIN_MATCH : 0;
+
+    uint8_t *token = op++;
+
+    *token = (uint8_t)((literals_len < MDV_LZ_RUN_MASK ? literals_len : MDV_LZ_RUN_MASK) << 4)
+           | (uint8_t)(match < MDV_LZ_RUN_MASK ? match : MDV_LZ_RUN_MASK);
+
+    if (literals_len >= MDV_LZ_RUN_MASK
+        && !(op = mdv_lz_length_write(op, end, literals_len)))
+        return 0;
+
+    if ((size_t)(end - op) < literals_len)
+        return 0;
+
+    memcpy(op, literals, literals_len);
+    op += literals_len;
+
+    if (!match_len)
+        return op;
+
+    if (end - op < 2)
+        return 0;
+
+    *op++ = (uint8_t)(offset & 0xFF);
+    *op++ = (uint8_t)(offset >> 8);
+
+    if (match >= MDV_LZ_RUN_MASK)
+        op = mdv_lz_length_write(op, end, match);
+
+    return op;
+}
+
+
+size_t mdv_lz_bound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+
+size_t mdv_lz_compress(void const *src, size_t size, void *dst, size_t capacity)
+{
+    uint8_t const *in = src;
+    uint8_t *op = dst;
+    uint8_t const *end = op + capacity;
+
+    uint32_t table[1 << MDV_LZ_HASH_BITS];
+    memset(table, 0, sizeof table);
+
+    size_t anchor = 0;
+
+    if (size > MDV_LZ_MIN_MATCH + MDV_LZ_LAST_LITERALS)
+    {
+        size_t const limit = size - MDV_LZ_LAST_LITERALS;
+
+        for(size_t ip = 0; ip + MDV_LZ_MIN_MATCH <= limit;)
+        {
+            uint32_t const seq = mdv_lz_read32(in + ip);
+            uint32_t const h = mdv_lz_hash(seq);
+            size_t const ref = table[h];
+
+            table[h] = (uint32_t)ip;
+
+            if (ref >= ip
+                || ip - ref > MDV_LZ_MAX_OFFSET
+                || mdv_lz_read32(in + ref) != seq)
+            {
+                // Incompressible data is skipped faster
+                ip += 1 + ((ip - anchor) >> MDV_LZ_SKIP_TRIGGER);
+                continue;
+            }
+
+            size_t len = MDV_LZ_MIN_MATCH;
+
+            while (ip + len < limit && in[ref + len] == in[ip + len])
+                ++len;
+
+            op = mdv_lz_record_write(op, end, in + anchor, ip - anchor, ip - ref, len);
+
+            if (!op)
+                return 0;
+
+            ip += len;
+            anchor = ip;
+        }
+    }
+
+    op = mdv_lz_record_write(op, end, in + anchor, size - anchor, 0, 0);
+
+    return op ? (size_t)(op - (uint8_t *)dst) : 0;
+}
+
+
+size_t mdv_lz_decompress(void const *src, size_t size, void *dst, size_t capacity)
+{
+    uint8_t const *ip = src;
+    uint8_t const *iend = ip + size;
+
+    uint8_t *op = dst;
+    uint8_t *oend = op + capacity;
+
+    while (ip < iend)
+    {
+        unsigned const token = *ip++;
+
+        // Literals
+        size_t len = token >> 4;
+
+        if (len == MDV_LZ_RUN_MASK
+            && !(ip = mdv_lz_length_read(ip, iend, &len)))
+            return 0;
+
+        if ((size_t)(iend - ip) < len
+            || (size_t)(oend - op) < len)
+            return 0;
+
+        memcpy(op, ip, len);
+        op += len;
+        ip += len;
+
+        // The last record contains only literals
+        if (ip == iend)
+            break;
+
+        // Match
+        if (iend - ip < 2)
+            return 0;
+
+        size_t const offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+
+        if (!offset || offset > (size_t)(op - (uint8_t *)dst))
+            return 0;
+
+        len = token & MDV_LZ_RUN_MASK;
+
+        if (len == MDV_LZ_RUN_MASK
+            && !(ip = mdv_lz_length_read(ip, iend, &len)))
+            return 0;
+
+        len += MDV_LZ_MIN_MATCH;
+
+        if ((size_t)(oend - op) < len)
+            return 0;
+
+        uint8_t const *ref = op - offset;
+
+        if (offset >= len)
+            memcpy(op, ref, len);
+        else
+        {
+            // Overlapped match repeats the last bytes
+            for(size_t i = 0; i < len; ++i)
+                op[i] = ref[i];
+        }
+
+        op += len;
+    }
+
+    return (size_t)(op - (uint8_t *)dst);
+}
@@ -0,0 +1,48 @@
+/**
+ * @file mdv_lz.h
+ * @brief LZ77 family block compression.
+ * @details Compressed block is a sequence of records. Each record starts with a token byte.
+ *          The high 4 bits of the token are the literals length and the low 4 bits are the match length minus 4.
+ *          If the length is 15, it is continued by the next bytes until a byte is less than 255.
+ *          The literals follow the token. The match offset (uint16, little endian) follows the literals.
+ *          The last record contains only literals.
+ *
+ *          Compression is fast and doesn't allocate memory. Decompression checks all bounds,
+ *          so the corrupted or malicious blocks are rejected.
+ */
+#pragma once
+#include "mdv_def.h"
+
+
+/**
+ * @brief Returns the maximum compressed block size for the given data size.
+ */
+size_t mdv_lz_bound(size_t size);
+
+
+/**
+ * @brief Compresses the data block.
+ *
+ * @param src [in]          Data for compression
+ * @param size [in]         Data size
+ * @param dst [out]         Buffer for the compressed block
+ * @param capacity [in]     Buffer size
+ *
+ * @return On success, returns the compressed block size
+ * @return If the compressed block doesn't fit into the buffer, returns zero
+ */
+size_t mdv_lz_compress(void const *src, size_t size, void *dst, size_t capacity);
+
+
+/**
+ * @brief Decompresses the data block.
+ *
+ * @param src [in]          Compressed block
+ * @param size [in]         Compressed block size
+ * @param dst [out]         Buffer for the decompressed data
+ * @param capacity [in]     Buffer size
+ *
+ * @return On success, returns the decompressed data size
+ * @return If the block is corrupted or the data doesn't fit into the buffer, returns zero
+ */
+size_t mdv_lz_decompress(void const *src, size_t size, void *dst, size_t capacity);
@@ -0,0 +1,50 @@
+#include "mdv_rwlock.h"
+#include "mdv_log.h"
+
+
+mdv_errno mdv_rwlock_create(mdv_rwlock *rwlock)
+{
+    int err = pthread_rwlock_init(rwlock, 0);
+
+    if (err)
+    {
+        MDV_LOGE("rwlock initialization failed with error %d", err);
+        return MDV_FAILED;
+    }
+
+    return MDV_OK;
+}
+
+
+void mdv_rwlock_free(mdv_rwlock *rwlock)
+{
+    pthread_rwlock_destroy(rwlock);
+}
+
+
+mdv_errno mdv_rwlock_rdlock(mdv_rwlock *rwlock)
+{
+    int err = pthread_rwlock_rdlock(rwlock);
+    return err ? MDV_FAILED : MDV_OK;
+}
+
+
+mdv_errno mdv_rwlock_wrlock(mdv_rwlock *rwlock)
+{
+    int err = pthread_rwlock_wrlock(rwlock);
+    return err ? MDV_FAILED : MDV_OK;
+}
+
+
+mdv_errno mdv_rwlock_trywrlock(mdv_rwlock *rwlock)
+{
+    int err = pthread_rwlock_trywrlock(rwlock);
+    return err ? MDV_FAILED : MDV_OK;
+}
+
+
+mdv_errno mdv_rwlock_unlock(mdv_rwlock *rwlock)
+{
+    int err = pthread_rwlock_unlock(rwlock);
+    return err ? MDV_FAILED : MDV_OK;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file
+ * @brief Readers-writer lock
+ */
+#pragma once
+#include "mdv_def.h"
+
+#ifdef MDV_PLATFORM_LINUX
+    #include <pthread.h>
+#endif
+
+
+/// Readers-writer lock descriptor
+typedef pthread_rwlock_t mdv_rwlock;
+
+
+/**
+ * @brief Create new readers-writer lock
+ *
+ * @param rwlock [in]   readers-writer lock
+ *
+ * @return MDV_OK if lock is successfully created
+ * @return non zero error code if error occurred
+ */
+mdv_errno mdv_rwlock_create(mdv_rwlock *rwlock);
+
+
+/**
+ * @brief Free readers-writer lock
+ *
+ * @param rwlock [in]   readers-writer lock
+ */
+void mdv_rwlock_free(mdv_rwlock *rwlock);
+
+
+/**
+ * @brief Lock a readers-writer lock for reading
+ *
+ * @param rwlock [in] readers-writer lock
+ *
+ * @return MDV_OK lock is successfully acquired
+ * @return non zero value if error has occurred
+ */
+mdv_errno mdv_rwlock_rdlock(mdv_rwlock *rwlock);
+
+
+/**
+ * @brief Lock a readers-writer lock for writing
+ *
+ * @param rwlock [in] readers-writer lock
+ *
+ * @return MDV_OK lock is successfully acquired
+ * @return non zero value if error has occurred
+ */
+mdv_errno mdv_rwlock_wrlock(mdv_rwlock *rwlock);
+
+
+/**
+ * @brief Try to lock a readers-writer lock for writing
+ *
+ * @param rwlock [in] readers-writer lock
+ *
+ * @return MDV_OK lock is successfully acquired
+ * @return non zero value if the lock is held or error has occurred
+ */
+mdv_errno mdv_rwlock_trywrlock(mdv_rwlock *rwlock);
+
+
+/**
+ * @brief Unlock a readers-writer lock
+ *
+ * @param rwlock [in] readers-writer lock
+ *
+ * @return MDV_OK lock is successfully released
+ * @return non zero value if error has occurred
+ */
+mdv_errno mdv_rwlock_unlock(mdv_rwlock *rwlock);
@@ -1,8 +1,44 @@
 #pragma once
 #include "mdv_core/mdv_serialization.h"
+#include "mdv_core/mdv_column.h"
+#include "mdv_core/mdv_filter.h"
+#include "mdv_core/mdv_filter_kernels.h"
+#include "mdv_core/mdv_aggregator.h"
+#include "mdv_core/mdv_storage.h"
+#include "mdv_core/mdv_trlog.h"
+#include "mdv_core/mdv_cfstorage.h"
+#include "mdv_core/mdv_rowdata.h"
+#include "mdv_core/mdv_snapshot.h"
+#include "mdv_core/mdv_tablespace.h"
+#include "mdv_core/mdv_committer.h"
 
 
 MU_TEST_SUITE(core)
 {
     MU_RUN_TEST(core_serialization);
+    MU_RUN_TEST(core_column);
+    MU_RUN_TEST(core_filter);
+    MU_RUN_TEST(core_filter_kernels);
+    MU_RUN_TEST(core_aggregator);
+    MU_RUN_TEST(core_storage_map_grow);
+    MU_RUN_TEST(core_storage_map_grow_reader);
+    MU_RUN_TEST(core_storage_map_grow_pinned);
+    MU_RUN_TEST(core_storage_map_cache);
+    MU_RUN_TEST(core_storage_cursor_range);
+    MU_RUN_TEST(core_storage_read_transaction);
+    MU_RUN_TEST(core_storage_map_append);
+    MU_RUN_TEST(core_storage_durable_mark);
+    MU_RUN_TEST(core_trlog_read_batch);
+    MU_RUN_TEST(core_trlog_group_commit);
+    MU_RUN_TEST(core_trlog_checkpoint);
+    MU_RUN_TEST(core_trlog_compression);
+    MU_RUN_TEST(core_cfstorage_removed);
+    MU_RUN_TEST(core_rowdata_index);
+    MU_RUN_TEST(core_rowdata_scan);
+    MU_RUN_TEST(core_snapshot);
+    MU_RUN_TEST(core_tablespace_pipeline);
+    MU_RUN_TEST(core_tablespace_pipeline_commit_failure);
+    MU_RUN_TEST(core_tablespace_partitioned_commit);
+    MU_RUN_TEST(core_tablespace_invalid_rows);
+    MU_RUN_TEST(core_committer_schedule);
 }
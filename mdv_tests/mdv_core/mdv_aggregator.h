@@ -0,0 +1,295 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_aggregator.h>
+#include <string.h>
+
+
+typedef mdv_table(3) test_aggregator_table;
+
+
+static test_aggregator_table const test_aggregator_tbl =
+{
+    .name = mdv_str_static("aggregator"),
+    .size = 3,
+    .fields =
+    {
+        { MDV_FLD_TYPE_INT32, 1, mdv_str_static("num") },
+        { MDV_FLD_TYPE_INT32, 1, mdv_str_static("key") },
+        { MDV_FLD_TYPE_CHAR,  0, mdv_str_static("str") }
+    }
+};
+
+
+enum { TEST_AGGREGATOR_ROWS = 200, TEST_AGGREGATOR_KEYS = 100 };
+
+
+typedef struct
+{
+    uint32_t    groups;                             ///< Number of result rows
+    int64_t     int_values[TEST_AGGREGATOR_KEYS];   ///< Values indexed by INT32 group key
+    uint64_t    counts[TEST_AGGREGATOR_KEYS];       ///< Counts indexed by INT32 group key
+    mdv_data    fields[8];                          ///< Last result row fields
+    uint8_t     bytes[8][8];                        ///< Last result row fields values
+    bool        ok;
+} test_aggregator_result;
+
+
+static bool test_aggregator_row(void *arg, mdv_row_base const *row)
+{
+    test_aggregator_result *result = arg;
+
+    ++result->groups;
+
+    for(uint32_t i = 0; i < row->size && i < 8; ++i)
+    {
+        result->fields[i].size = row->fields[i].size;
+        result->fields[i].ptr = result->bytes[i];
+
+        if (row->fields[i].size <= 8)
+            memcpy(result->bytes[i], row->fields[i].ptr, row->fields[i].size);
+        else
+            result->ok = false;
+    }
+
+    return true;
+}
+
+
+static bool test_aggregator_group_row(void *arg, mdv_row_base const *row)
+{
+    test_aggregator_result *result = arg;
+
+    ++result->groups;
+
+    int32_t key;
+    int64_t sum;
+    uint64_t count;
+
+    if (row->size != 3
+        || row->fields[0].size != sizeof key
+        || row->fields[1].size != sizeof count
+        || row->fields[2].size != sizeof sum)
+    {
+        result->ok = false;
+        return false;
+    }
+
+    memcpy(&key, row->fields[0].ptr, sizeof key);
+    memcpy(&count, row->fields[1].ptr, sizeof count);
+    memcpy(&sum, row->fields[2].ptr, sizeof sum);
+
+    if (key < 0 || key >= TEST_AGGREGATOR_KEYS || result->counts[key])
+    {
+        result->ok = false;
+        return false;
+    }
+
+    result->counts[key] = count;
+    result->int_values[key] = sum;
+
+    return true;
+}
+
+
+static bool test_aggregator_run(mdv_column const *segments,
+                                uint32_t groups_size,
+                                uint32_t const *groups,
+                                uint32_t size,
+                                mdv_aggregate const *aggregates,
+                                mdv_bitset const *selection,
+                                mdv_aggregator_fn fn,
+                                test_aggregator_result *result)
+{
+    mdv_table_base const *table = (mdv_table_base const *)&test_aggregator_tbl;
+
+    memset(result, 0, sizeof *result);
+    result->ok = true;
+
+    mdv_aggregator *aggregator = mdv_aggregator_create(table, groups_size, groups, size, aggregates);
+
+    if (!aggregator)
+        return false;
+
+    uint32_t const *fields = 0;
+    uint32_t const count = mdv_aggregator_columns(aggregator, &fields);
+
+    mdv_column columns[count];
+
+    for(uint32_t i = 0; i < count; ++i)
+        columns[i] = segments[fields[i]];
+
+    bool const ret = mdv_aggregator_add(aggregator, columns, selection)
+                     && mdv_aggregator_result(aggregator, result, fn);
+
+    mdv_aggregator_free(aggregator);
+
+    return ret && result->ok;
+}
+
+
+static size_t test_aggregator_column_build(mdv_field const *field, uint32_t count, mdv_data const *values, char *buf)
+{
+    mdv_column_builder builder;
+    mdv_column_builder_init(&builder, field);
+
+    for(uint32_t i = 0; i < count; ++i)
+        mdv_column_builder_add(&builder, values + i);
+
+    size_t const size = mdv_column_builder_size(&builder);
+
+    if (buf)
+        mdv_column_builder_serialize(&builder, buf);
+
+    mdv_column_builder_free(&builder);
+
+    return size;
+}
+
+
+MU_TEST(core_aggregator)
+{
+    mdv_table_base const *table = (mdv_table_base const *)&test_aggregator_tbl;
+
+    enum { ROWS = TEST_AGGREGATOR_ROWS };
+
+    static char const *strs[] = { "a", "bb", "ccc" };
+
+    int32_t nums[ROWS];
+    int32_t keys[ROWS];
+
+    mdv_data num_values[ROWS];
+    mdv_data key_values[ROWS];
+    mdv_data str_values[ROWS];
+
+    for(uint32_t i = 0; i < ROWS; ++i)
+    {
+        nums[i] = (int32_t)i - 50;
+        keys[i] = (int32_t)(i % TEST_AGGREGATOR_KEYS);
+        num_values[i] = (mdv_data){ sizeof *nums, nums + i };
+        key_values[i] = (mdv_data){ sizeof *keys, keys + i };
+        str_values[i] = (mdv_data){ strlen(strs[i % 3]), (void*)strs[i % 3] };
+    }
+
+    size_t const num_size = test_aggregator_column_build(table->fields + 0, ROWS, num_values, 0);
+    size_t const key_size = test_aggregator_column_build(table->fields + 1, ROWS, key_values, 0);
+    size_t const str_size = test_aggregator_column_build(table->fields + 2, ROWS, str_values, 0);
+
+    char num_buf[num_size];
+    char key_buf[key_size];
+    char str_buf[str_size];
+
+    test_aggregator_column_build(table->fields + 0, ROWS, num_values, num_buf);
+    test_aggregator_column_build(table->fields + 1, ROWS, key_values, key_buf);
+    test_aggregator_column_build(table->fields + 2, ROWS, str_values, str_buf);
+
+    mdv_column segments[3];
+
+    mu_check(mdv_column_load(table->fields + 0, &(mdv_data){ num_size, num_buf }, segments + 0));
+    mu_check(mdv_column_load(table->fields + 1, &(mdv_data){ key_size, key_buf }, segments + 1));
+    mu_check(mdv_column_load(table->fields + 2, &(mdv_data){ str_size, str_buf }, segments + 2));
+
+    mdv_aggregate const aggregates[] =
+    {
+        { MDV_AGG_COUNT, 0 },
+        { MDV_AGG_SUM,   0 },
+        { MDV_AGG_MIN,   0 },
+        { MDV_AGG_MAX,   0 },
+        { MDV_AGG_AVG,   0 },
+    };
+
+    enum { AGGREGATES = sizeof aggregates / sizeof *aggregates };
+
+    test_aggregator_result result;
+
+    uint64_t count;
+    int64_t sum;
+    int32_t min, max;
+    double avg;
+
+    // SELECT COUNT(*), SUM(num), MIN(num), MAX(num), AVG(num)
+    mu_check(test_aggregator_run(segments, 0, 0, AGGREGATES, aggregates, 0, &test_aggregator_row, &result));
+    mu_check(result.groups == 1);
+
+    memcpy(&count, result.bytes[0], sizeof count);
+    memcpy(&sum,   result.bytes[1], sizeof sum);
+    memcpy(&min,   result.bytes[2], sizeof min);
+    memcpy(&max,   result.bytes[3], sizeof max);
+    memcpy(&avg,   result.bytes[4], sizeof avg);
+
+    mu_check(result.fields[2].size == sizeof min);
+    mu_check(count == ROWS);
+    mu_check(sum == 9900);
+    mu_check(min == -50);
+    mu_check(max == 149);
+    mu_check(avg == 49.5);
+
+    // Only even rows are selected
+    mdv_bitset *selection = mdv_bitset_create(ROWS, &mdv_default_allocator);
+
+    mu_check(selection);
+
+    for(uint32_t i = 0; i < ROWS; i += 2)
+        mdv_bitset_set(selection, i);
+
+    mu_check(test_aggregator_run(segments, 0, 0, AGGREGATES, aggregates, selection, &test_aggregator_row, &result));
+    mu_check(result.groups == 1);
+
+    memcpy(&count, result.bytes[0], sizeof count);
+    memcpy(&sum,   result.bytes[1], sizeof sum);
+    memcpy(&min,   result.bytes[2], sizeof min);
+    memcpy(&max,   result.bytes[3], sizeof max);
+    memcpy(&avg,   result.bytes[4], sizeof avg);
+
+    mu_check(count == ROWS / 2);
+    mu_check(sum == 4900);
+    mu_check(min == -50);
+    mu_check(max == 148);
+    mu_check(avg == 49.0);
+
+    // Empty selection still produces the single row
+    mdv_bitset_fill(selection, false);
+
+    mu_check(test_aggregator_run(segments, 0, 0, AGGREGATES, aggregates, selection, &test_aggregator_row, &result));
+    mu_check(result.groups == 1);
+
+    memcpy(&count, result.bytes[0], sizeof count);
+    memcpy(&sum,   result.bytes[1], sizeof sum);
+
+    mu_check(count == 0);
+    mu_check(sum == 0);
+
+    // SELECT key, COUNT(*), SUM(num) GROUP BY key (more groups than the initial hash table capacity)
+    uint32_t const key_group[] = { 1 };
+
+    mdv_aggregate const group_aggregates[] =
+    {
+        { MDV_AGG_COUNT, 0 },
+        { MDV_AGG_SUM,   0 },
+    };
+
+    mu_check(test_aggregator_run(segments, 1, key_group, 2, group_aggregates, 0, &test_aggregator_group_row, &result));
+    mu_check(result.groups == TEST_AGGREGATOR_KEYS);
+
+    for(int32_t k = 0; k < TEST_AGGREGATOR_KEYS; ++k)
+    {
+        mu_check(result.counts[k] == 2);
+        mu_check(result.int_values[k] == 2 * k);
+    }
+
+    // Grouping by the variable length field
+    uint32_t const str_group[] = { 2 };
+
+    mu_check(test_aggregator_run(segments, 1, str_group, 1, aggregates, 0, &test_aggregator_row, &result));
+    mu_check(result.groups == 3);
+
+    // Invalid aggregate functions
+    mdv_aggregate const sum_str[] = { { MDV_AGG_SUM, 2 } };
+    mdv_aggregate const bad_field[] = { { MDV_AGG_MAX, 3 } };
+    uint32_t const bad_group[] = { 3 };
+
+    mu_check(!mdv_aggregator_create(table, 0, 0, 1, sum_str));
+    mu_check(!mdv_aggregator_create(table, 0, 0, 1, bad_field));
+    mu_check(!mdv_aggregator_create(table, 1, bad_group, 1, aggregates));
+
+    mdv_bitset_free(selection);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_cfstorage.h>
+#include <mdv_config.h>
+#include <mdv_filesystem.h>
+#include <string.h>
+
+
+static bool test_cfstorage_apply_fn(void *arg, mdv_cfstorage_op const *op)
+{
+    uint64_t *sum = arg;
+    *sum += op->id;
+    return true;
+}
+
+
+static bool test_cfstorage_add(mdv_cfstorage *cfstorage, uint32_t peer_id, uint64_t first, uint64_t last)
+{
+    mdv_op op = {};
+    mdv_list ops = {};
+
+    for(uint64_t id = first; id <= last; ++id)
+    {
+        mdv_cfstorage_op const entry =
+        {
+            .id = id,
+            .op = { sizeof op, &op }
+        };
+
+        if (!mdv_list_push_back(&ops, entry))
+        {
+            mdv_list_clear(&ops);
+            return false;
+        }
+    }
+
+    bool const ret = mdv_cfstorage_log_add(cfstorage, peer_id, &ops);
+
+    mdv_list_clear(&ops);
+
+    return ret;
+}
+
+
+MU_TEST(core_cfstorage_removed)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./cfstorage_test");
+    MDV_CONFIG.storage.trlog_durability = MDV_DURABILITY_ASYNC;
+    MDV_CONFIG.storage.bloom_snapshot = 1;
+    MDV_CONFIG.datasync.batch_size = 16;
+
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_cfstorage *cfstorage = mdv_cfstorage_open(&uuid, 2);
+    mu_check(cfstorage);
+
+    mdv_objid const removed = { .node = 1, .id = 5 };
+    mu_check(mdv_cfstorage_remove(cfstorage, &removed));
+
+    mdv_cfstorage_close(cfstorage);
+
+    // Bloom filter is loaded from snapshot
+    cfstorage = mdv_cfstorage_open(&uuid, 2);
+    mu_check(cfstorage);
+
+    mu_check(test_cfstorage_add(cfstorage, 1, 4, 6));
+
+    uint64_t sum = 0;
+    mu_check(mdv_cfstorage_log_apply(cfstorage, 1, &sum, test_cfstorage_apply_fn));
+    mu_check(sum == 4 + 6);
+
+    // Bloom filter is grown
+    for(uint64_t id = 100; id < 1700; ++id)
+    {
+        mdv_objid const objid = { .node = 1, .id = id };
+        mu_check(mdv_cfstorage_remove(cfstorage, &objid));
+    }
+
+    mu_check(test_cfstorage_add(cfstorage, 1, 7, 1800));
+
+    sum = 0;
+    mu_check(mdv_cfstorage_log_apply(cfstorage, 1, &sum, test_cfstorage_apply_fn));
+    mu_check(sum == (7 + 99) * 93 / 2 + (1700 + 1800) * 101 / 2);
+
+    mdv_cfstorage_close(cfstorage);
+
+    mu_check(mdv_cfstorage_drop(&uuid));
+    mu_check(mdv_rmdir("./cfstorage_test"));
+
+    MDV_CONFIG = config;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_column.h>
+#include <mdv_alloc.h>
+#include <string.h>
+
+
+static void test_fixed_column()
+{
+    mdv_field const field = { MDV_FLD_TYPE_INT32, 1, mdv_str_static("i32") };
+
+    mdv_column_builder builder;
+    mu_check(mdv_column_builder_init(&builder, &field));
+
+    int32_t values[] = { 1, -2, 3, 42 };
+
+    for(size_t i = 0; i < sizeof values / sizeof *values; ++i)
+    {
+        mdv_data const value = { sizeof *values, values + i };
+        mu_check(mdv_column_builder_add(&builder, &value));
+    }
+
+    mdv_data const invalid = { sizeof values, values };
+    mu_check(!mdv_column_builder_add(&builder, &invalid));
+
+    size_t const size = mdv_column_builder_size(&builder);
+    mu_check(size == sizeof(mdv_column_hdr) + sizeof values);
+
+    char buf[size];
+    mdv_column_builder_serialize(&builder, buf);
+    mdv_column_builder_free(&builder);
+
+    mdv_column column;
+    mdv_data const segment = { size, buf };
+    mu_check(mdv_column_load(&field, &segment, &column));
+    mu_check(column.count == 4);
+    mu_check(column.offsets == 0);
+    mu_check(memcmp(column.values, values, sizeof values) == 0);
+
+    for(uint32_t i = 0; i < column.count; ++i)
+    {
+        mdv_data const value = mdv_column_value(&column, i);
+        mu_check(value.size == sizeof *values && memcmp(value.ptr, values + i, value.size) == 0);
+    }
+}
+
+
+static void test_variable_column()
+{
+    mdv_field const field = { MDV_FLD_TYPE_CHAR, 0, mdv_str_static("str") };
+
+    char const *values[] = { "hello", "", "columnar", "world" };
+
+    mdv_column_builder builder;
+    mu_check(mdv_column_builder_init(&builder, &field));
+
+    for(size_t i = 0; i < sizeof values / sizeof *values; ++i)
+    {
+        mdv_data const value = { strlen(values[i]), (void*)values[i] };
+        mu_check(mdv_column_builder_add(&builder, &value));
+    }
+
+    size_t const size = mdv_column_builder_size(&builder);
+
+    char buf[size];
+    mdv_column_builder_serialize(&builder, buf);
+
+    mdv_column column;
+    mdv_data const segment = { size, buf };
+    mu_check(mdv_column_load(&field, &segment, &column));
+    mu_check(column.count == 4);
+    mu_check(column.offsets != 0);
+
+    // Builder can be reloaded from the serialized segment
+    mdv_column_builder_clear(&builder);
+    mu_check(mdv_column_builder_append(&builder, &column));
+    mu_check(mdv_column_builder_size(&builder) == size);
+    mdv_column_builder_free(&builder);
+
+    for(uint32_t i = 0; i < column.count; ++i)
+    {
+        mdv_data const value = mdv_column_value(&column, i);
+        mu_check(value.size == strlen(values[i]) && memcmp(value.ptr, values[i], value.size) == 0);
+    }
+
+    mdv_data const truncated = { size - 1, buf };
+    mu_check(!mdv_column_load(&field, &truncated, &column));
+}
+
+
+static void test_limited_column()
+{
+    mdv_field const field = { MDV_FLD_TYPE_UINT16, 2, mdv_str_static("pair") };
+
+    mdv_column_builder builder;
+    mu_check(mdv_column_builder_init(&builder, &field));
+
+    uint16_t pair[] = { 1, 2 };
+    uint16_t triple[] = { 1, 2, 3 };
+
+    mdv_data const value = { sizeof pair, pair };
+    mdv_data const too_long = { sizeof triple, triple };
+
+    mu_check(mdv_column_builder_add(&builder, &value));
+    mu_check(!mdv_column_builder_add(&builder, &too_long));
+    mu_check(builder.count == 1);
+
+    mdv_column_builder_free(&builder);
+}
+
+
+MU_TEST(core_column)
+{
+    test_fixed_column();
+    test_variable_column();
+    test_limited_column();
+}
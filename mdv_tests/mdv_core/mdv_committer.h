@@ -0,0 +1,150 @@
+#pragma once
+#include "../minunit.h"
+#include "mdv_tablespace.h"
+#include <mdv_committer.h>
+#include <event/mdv_trlog.h>
+#include <mdv_topology.h>
+#include <stdatomic.h>
+
+
+/// Transaction log storage which is applied by the test handler
+typedef struct
+{
+    atomic_uint changes;        ///< Number of the storage changes
+    atomic_uint applied;        ///< Changes seen by the last applying
+    atomic_uint applies;        ///< Number of the storage applyings
+    atomic_uint running;        ///< Number of concurrent applyings
+    atomic_uint max_running;    ///< Maximum number of concurrent applyings
+    atomic_bool started;        ///< Applying is started
+    atomic_bool blocked;        ///< Applying waits while it is blocked
+} test_committer_storage;
+
+
+static mdv_errno test_committer_apply(void *arg, mdv_event *event)
+{
+    test_committer_storage *storage = arg;
+
+    (void)event;
+
+    unsigned const running = atomic_fetch_add(&storage->running, 1) + 1;
+
+    if (running > atomic_load(&storage->max_running))
+        atomic_store(&storage->max_running, running);
+
+    // Changes made after this point are applied by the next applying
+    unsigned const changes = atomic_load(&storage->changes);
+
+    atomic_store(&storage->started, true);
+
+    while(atomic_load(&storage->blocked))
+        mdv_sleep(10);
+
+    atomic_store(&storage->applied, changes);
+    atomic_fetch_add(&storage->applies, 1);
+    atomic_fetch_sub(&storage->running, 1);
+
+    return MDV_OK;
+}
+
+
+static bool test_committer_change(mdv_ebus *ebus, test_committer_storage *storage, mdv_uuid const *uuid)
+{
+    atomic_fetch_add(&storage->changes, 1);
+
+    mdv_evt_trlog_changed *evt = mdv_evt_trlog_changed_create(uuid);
+
+    if (!evt)
+        return false;
+
+    bool const ret = mdv_ebus_publish(ebus, &evt->base, MDV_EVT_SYNC) == MDV_OK;
+
+    mdv_evt_trlog_changed_release(evt);
+
+    return ret;
+}
+
+
+static bool test_committer_wait(atomic_uint *value, unsigned expected)
+{
+    for(uint32_t i = 0; i < 500 && atomic_load(value) != expected; ++i)
+        mdv_sleep(10);
+    return atomic_load(value) == expected;
+}
+
+
+MU_TEST(core_committer_schedule)
+{
+    static const mdv_event_handler_type handlers[] =
+    {
+        { MDV_EVT_TRLOG_APPLY, test_committer_apply }
+    };
+
+    mdv_jobber_config const jconfig =
+    {
+        .threadpool =
+        {
+            .size = 2,
+            .thread_attrs =
+            {
+                .stack_size = MDV_THREAD_STACK_SIZE
+            }
+        },
+        .queue =
+        {
+            .count = 1
+        }
+    };
+
+    test_committer_storage storage;
+
+    atomic_init(&storage.changes, 0);
+    atomic_init(&storage.applied, 0);
+    atomic_init(&storage.applies, 0);
+    atomic_init(&storage.running, 0);
+    atomic_init(&storage.max_running, 0);
+    atomic_init(&storage.started, false);
+    atomic_init(&storage.blocked, true);
+
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_ebus *ebus = test_tablespace_ebus_create();
+    mu_check(ebus);
+
+    mu_check(mdv_ebus_subscribe_all(ebus, &storage, handlers, sizeof handlers / sizeof *handlers) == MDV_OK);
+
+    mdv_committer *committer = mdv_committer_create(ebus, &jconfig, &mdv_empty_topology);
+    mu_check(committer);
+
+    mu_check(test_committer_change(ebus, &storage, &uuid));
+
+    for(uint32_t i = 0; i < 500 && !atomic_load(&storage.started); ++i)
+        mdv_sleep(10);
+
+    mu_check(atomic_load(&storage.started));
+
+    // Storage is changed while it is applied. It is marked as dirty and no new job is scheduled.
+    mu_check(test_committer_change(ebus, &storage, &uuid));
+    mu_check(test_committer_change(ebus, &storage, &uuid));
+
+    atomic_store(&storage.blocked, false);
+
+    // Running job applies the storage once more, so the changes aren't lost
+    mu_check(test_committer_wait(&storage.applied, 3));
+    mu_check(test_committer_wait(&storage.applies, 2));
+
+    mdv_sleep(100);
+
+    mu_check(atomic_load(&storage.applies) == 2);
+    mu_check(atomic_load(&storage.max_running) == 1);
+
+    // Applied storage is removed from the scheduled storages and the next change schedules new job
+    mu_check(test_committer_change(ebus, &storage, &uuid));
+    mu_check(test_committer_wait(&storage.applied, 4));
+    mu_check(test_committer_wait(&storage.applies, 3));
+
+    mdv_committer_release(committer);
+
+    mdv_ebus_unsubscribe_all(ebus, &storage, handlers, sizeof handlers / sizeof *handlers);
+
+    mdv_ebus_release(ebus);
+}
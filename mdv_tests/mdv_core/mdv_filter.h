@@ -0,0 +1,149 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_filter.h>
+#include <string.h>
+
+
+typedef mdv_table(2) test_filter_table;
+
+
+static test_filter_table const test_filter_tbl =
+{
+    .name = mdv_str_static("filter"),
+    .size = 2,
+    .fields =
+    {
+        { MDV_FLD_TYPE_INT32, 1, mdv_str_static("num") },
+        { MDV_FLD_TYPE_CHAR,  0, mdv_str_static("str") }
+    }
+};
+
+
+static size_t test_filter_column_build(mdv_field const *field, uint32_t count, mdv_data const *values, char *buf)
+{
+    mdv_column_builder builder;
+    mdv_column_builder_init(&builder, field);
+
+    for(uint32_t i = 0; i < count; ++i)
+        mdv_column_builder_add(&builder, values + i);
+
+    size_t const size = mdv_column_builder_size(&builder);
+
+    if (buf)
+        mdv_column_builder_serialize(&builder, buf);
+
+    mdv_column_builder_free(&builder);
+
+    return size;
+}
+
+
+/**
+ * @brief Returns matched rows as bit mask
+ */
+static uint32_t test_filter_matches(mdv_predicate const *predicate, mdv_column const *segments)
+{
+    mdv_table_base const *table = (mdv_table_base const *)&test_filter_tbl;
+
+    mdv_filter *filter = mdv_filter_create(table, predicate);
+
+    if (!filter)
+        return ~0u;
+
+    uint32_t const *fields = 0;
+    uint32_t const count = mdv_filter_columns(filter, &fields);
+
+    mdv_column columns[count];
+
+    for(uint32_t i = 0; i < count; ++i)
+        columns[i] = segments[fields[i]];
+
+    uint32_t mask = ~0u;
+
+    mdv_bitset *selection = mdv_bitset_create(segments->count, &mdv_default_allocator);
+
+    if (selection && mdv_filter_apply(filter, columns, selection))
+        mask = *mdv_bitset_data(selection);
+
+    mdv_bitset_free(selection);
+    mdv_filter_free(filter);
+
+    return mask;
+}
+
+
+MU_TEST(core_filter)
+{
+    mdv_table_base const *table = (mdv_table_base const *)&test_filter_tbl;
+
+    int32_t const nums[] = { -5, 0, 7, 42, 7 };
+    char const *strs[] = { "apple", "", "apricot", "banana", "app" };
+
+    enum { ROWS = sizeof nums / sizeof *nums };
+
+    mdv_data num_values[ROWS];
+    mdv_data str_values[ROWS];
+
+    for(uint32_t i = 0; i < ROWS; ++i)
+    {
+        num_values[i] = (mdv_data){ sizeof *nums, (void*)(nums + i) };
+        str_values[i] = (mdv_data){ strlen(strs[i]), (void*)strs[i] };
+    }
+
+    size_t const num_size = test_filter_column_build(table->fields + 0, ROWS, num_values, 0);
+    size_t const str_size = test_filter_column_build(table->fields + 1, ROWS, str_values, 0);
+
+    char num_buf[num_size];
+    char str_buf[str_size];
+
+    test_filter_column_build(table->fields + 0, ROWS, num_values, num_buf);
+    test_filter_column_build(table->fields + 1, ROWS, str_values, str_buf);
+
+    mdv_column segments[2];
+
+    mu_check(mdv_column_load(table->fields + 0, &(mdv_data){ num_size, num_buf }, segments + 0));
+    mu_check(mdv_column_load(table->fields + 1, &(mdv_data){ str_size, str_buf }, segments + 1));
+
+    int32_t const seven = 7;
+    int32_t const zero = 0;
+
+    mdv_predicate const eq_seven = { .op = MDV_PRED_EQ, .field = 0, .value = { sizeof seven, (void*)&seven } };
+    mdv_predicate const lt_zero  = { .op = MDV_PRED_LT, .field = 0, .value = { sizeof zero, (void*)&zero } };
+    mdv_predicate const ge_seven = { .op = MDV_PRED_GE, .field = 0, .value = { sizeof seven, (void*)&seven } };
+    mdv_predicate const ne_zero  = { .op = MDV_PRED_NE, .field = 0, .value = { sizeof zero, (void*)&zero } };
+    mdv_predicate const str_lt   = { .op = MDV_PRED_LT, .field = 1, .value = { 5, "apple" } };
+    mdv_predicate const str_eq   = { .op = MDV_PRED_EQ, .field = 1, .value = { 3, "app" } };
+    mdv_predicate const str_gt   = { .op = MDV_PRED_GT, .field = 1, .value = { 3, "app" } };
+
+    mu_check(test_filter_matches(&eq_seven, segments) == 0x14);
+    mu_check(test_filter_matches(&lt_zero, segments) == 0x01);
+    mu_check(test_filter_matches(&ge_seven, segments) == 0x1C);
+    mu_check(test_filter_matches(&ne_zero, segments) == 0x1D);
+
+    // Strings are compared lexicographically, shorter prefix is less
+    mu_check(test_filter_matches(&str_lt, segments) == 0x12);
+    mu_check(test_filter_matches(&str_eq, segments) == 0x10);
+    mu_check(test_filter_matches(&str_gt, segments) == 0x0D);
+
+    mdv_predicate const and_args[] = { ge_seven, str_gt };
+    mdv_predicate const and_pred = { .op = MDV_PRED_AND, .size = 2, .args = and_args };
+    mu_check(test_filter_matches(&and_pred, segments) == 0x0C);
+
+    mdv_predicate const or_args[] = { lt_zero, str_eq };
+    mdv_predicate const or_pred = { .op = MDV_PRED_OR, .size = 2, .args = or_args };
+    mu_check(test_filter_matches(&or_pred, segments) == 0x11);
+
+    mdv_predicate const not_pred = { .op = MDV_PRED_NOT, .size = 1, .args = &or_pred };
+    mu_check(test_filter_matches(&not_pred, segments) == 0x0E);
+
+    // Invalid predicates are rejected
+    mdv_predicate const bad_field = { .op = MDV_PRED_EQ, .field = 2, .value = { sizeof zero, (void*)&zero } };
+    mdv_predicate const bad_value = { .op = MDV_PRED_EQ, .field = 0, .value = { 3, "abc" } };
+    mdv_predicate const bad_not   = { .op = MDV_PRED_NOT, .size = 2, .args = or_args };
+    mdv_predicate const bad_op    = { .op = (mdv_predicate_op)42, .size = 0, .args = 0 };
+
+    mu_check(!mdv_filter_create(table, &bad_field));
+    mu_check(!mdv_filter_create(table, &bad_value));
+    mu_check(!mdv_filter_create(table, &bad_not));
+    mu_check(!mdv_filter_create(table, &bad_op));
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_filter_kernels.h>
+#include <string.h>
+#include <math.h>
+
+
+/**
+ * @brief Generates value of given type from small range. Floating point values might be NaN.
+ */
+static void test_filter_kernel_value(mdv_field_type type, uint32_t r, uint8_t *dst)
+{
+    int const v = (int)(r % 7) - 3;
+
+#define TEST_FILTER_VALUE(T, x) { T const t = (T)(x); memcpy(dst, &t, sizeof t); break; }
+
+    switch(type)
+    {
+        case MDV_FLD_TYPE_BOOL:     TEST_FILTER_VALUE(uint8_t, r % 3);  // 2 is also true
+        case MDV_FLD_TYPE_CHAR:
+        case MDV_FLD_TYPE_BYTE:
+        case MDV_FLD_TYPE_UINT8:    TEST_FILTER_VALUE(uint8_t, v);
+        case MDV_FLD_TYPE_INT8:     TEST_FILTER_VALUE(int8_t, v);
+        case MDV_FLD_TYPE_INT16:    TEST_FILTER_VALUE(int16_t, v);
+        case MDV_FLD_TYPE_UINT16:   TEST_FILTER_VALUE(uint16_t, v);
+        case MDV_FLD_TYPE_INT32:    TEST_FILTER_VALUE(int32_t, v);
+        case MDV_FLD_TYPE_UINT32:   TEST_FILTER_VALUE(uint32_t, v);
+        case MDV_FLD_TYPE_INT64:    TEST_FILTER_VALUE(int64_t, v);
+        case MDV_FLD_TYPE_UINT64:   TEST_FILTER_VALUE(uint64_t, v);
+        case MDV_FLD_TYPE_FLOAT:    TEST_FILTER_VALUE(float, v == 3 ? NAN : v * 0.5f);
+        case MDV_FLD_TYPE_DOUBLE:   TEST_FILTER_VALUE(double, v == 3 ? NAN : v * 0.5);
+    }
+
+#undef TEST_FILTER_VALUE
+}
+
+
+MU_TEST(core_filter_kernels)
+{
+    enum { COUNT = 1000, WORDS = (COUNT + 31) / 32 };
+
+    mdv_filter_isa const best = mdv_filter_isa_best();
+
+    uint8_t buf[COUNT * sizeof(uint64_t) + 1];
+    uint8_t value[sizeof(uint64_t)];
+
+    uint32_t expected[WORDS];
+    uint32_t bits[WORDS];
+
+    uint32_t r = 42;
+
+    for(int type = MDV_FLD_TYPE_BOOL; type <= MDV_FLD_TYPE_DOUBLE; ++type)
+    {
+        uint32_t const size = mdv_field_type_size(type);
+
+        // Unaligned values
+        uint8_t *values = buf + 1;
+
+        for(uint32_t i = 0; i < COUNT; ++i)
+        {
+            r = r * 1103515245u + 12345u;
+            test_filter_kernel_value(type, r >> 16, values + i * size);
+        }
+
+        for(uint32_t c = 0; c < 7; ++c)
+        {
+            test_filter_kernel_value(type, c, value);
+
+            for(int op = MDV_PRED_EQ; op <= MDV_PRED_GE; ++op)
+            {
+                mdv_filter_kernel scalar = mdv_filter_kernel_get(MDV_FILTER_ISA_SCALAR, type, op);
+
+                mu_check(scalar);
+
+                // Odd count checks the tail processing
+                scalar(values, COUNT, value, expected);
+
+                mu_check((expected[WORDS - 1] >> (COUNT % 32)) == 0);
+
+                for(int isa = MDV_FILTER_ISA_SSE2; isa <= (int)best; ++isa)
+                {
+                    mdv_filter_kernel kernel = mdv_filter_kernel_get(isa, type, op);
+
+                    memset(bits, 0xAA, sizeof bits);
+
+                    kernel(values, COUNT, value, bits);
+
+                    mu_check(memcmp(bits, expected, sizeof bits) == 0);
+                }
+            }
+        }
+    }
+
+    mu_check(!mdv_filter_kernel_get(MDV_FILTER_ISA_SCALAR, MDV_FLD_TYPE_INT32, MDV_PRED_AND));
+}
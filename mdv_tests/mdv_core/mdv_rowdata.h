@@ -0,0 +1,391 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_rowdata.h>
+#include <mdv_serialization.h>
+#include <mdv_packed_row.h>
+#include <mdv_config.h>
+#include <mdv_filesystem.h>
+#include <stdio.h>
+#include <string.h>
+
+
+static int32_t test_rowdata_i(uint64_t n)  { return (int32_t)(n % 100) - 50; }
+static double  test_rowdata_d(uint64_t n)  { return (double)n * -0.5; }
+
+
+static bool test_rowdata_add(mdv_rowdata *rowdata, mdv_field const *fields, uint64_t first, uint64_t last)
+{
+    mdv_vector *rows = mdv_vector_create(last - first, sizeof(mdv_data), &mdv_default_allocator);
+
+    mdv_row_codec *codec = mdv_row_codec_create(fields, 3);
+
+    bool ret = rows && codec;
+
+    for(uint64_t n = first; ret && n < last; ++n)
+    {
+        int32_t const i = test_rowdata_i(n);
+        double const d = test_rowdata_d(n);
+        char s[4];
+        snprintf(s, sizeof s, "s%u", (unsigned)(n % 7));
+
+        mdv_row(3) row =
+        {
+            .size = 3,
+            .fields =
+            {
+                { sizeof i, (void*)&i },
+                { 2, s },
+                { sizeof d, (void*)&d }
+            }
+        };
+
+        mdv_data packed;
+
+        ret = mdv_row_codec_pack(codec, (mdv_row_base const *)&row, &packed);
+
+        if (ret && !mdv_vector_push_back(rows, &packed))
+        {
+            mdv_free(packed.ptr, "packed_row");
+            ret = false;
+        }
+    }
+
+    if (ret)
+    {
+        mdv_transaction transaction = mdv_transaction_start(mdv_rowdata_storage(rowdata));
+
+        ret = mdv_transaction_ok(transaction)
+                && mdv_rowdata_add(rowdata, &transaction, rows)
+                && mdv_transaction_commit(&transaction);
+    }
+
+    mdv_data *packed_rows = rows ? mdv_vector_data(rows) : 0;
+
+    for(size_t n = 0; rows && n < mdv_vector_size(rows); ++n)
+        mdv_free(packed_rows[n].ptr, "packed_row");
+
+    mdv_vector_release(rows);
+    mdv_row_codec_free(codec);
+
+    return ret;
+}
+
+
+typedef struct
+{
+    bool     ok;            ///< Lookup was successfully completed
+    bool     ascending;     ///< Row identifiers are in ascending order
+    uint64_t count;         ///< Number of rows
+    uint64_t last;          ///< Last row identifier
+} test_rowdata_ids;
+
+
+static bool test_rowdata_id_fn(void *arg, uint64_t row_id)
+{
+    test_rowdata_ids *ids = arg;
+    ids->ascending = ids->ascending && (!ids->count || ids->last < row_id);
+    ids->last = row_id;
+    ++ids->count;
+    return true;
+}
+
+
+static test_rowdata_ids test_rowdata_lookup(mdv_rowdata *rowdata,
+                                            uint32_t index_id,
+                                            mdv_row_base const *from,
+                                            mdv_row_base const *to)
+{
+    test_rowdata_ids ids = { false, true, 0, 0 };
+    ids.ok = mdv_rowdata_index_lookup(rowdata, index_id, from, to, &ids, test_rowdata_id_fn);
+    return ids;
+}
+
+
+static bool test_rowdata_index_build(mdv_rowdata *rowdata, uint32_t index_id)
+{
+    bool ready = false;
+
+    while(!ready)
+    {
+        if (!mdv_rowdata_index_build(rowdata, index_id, 256, &ready))
+            return false;
+    }
+
+    return true;
+}
+
+
+MU_TEST(core_rowdata_index)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./rowdata_test");
+
+    typedef mdv_table(3) test_table;
+
+    test_table table =
+    {
+        .name = mdv_str_static("indexed"),
+        .id = mdv_uuid_generate(),
+        .size = 3,
+        .fields =
+        {
+            { MDV_FLD_TYPE_INT32,  1, mdv_str_static("i") },
+            { MDV_FLD_TYPE_CHAR,   3, mdv_str_static("s") },
+            { MDV_FLD_TYPE_DOUBLE, 1, mdv_str_static("d") }
+        }
+    };
+
+    mdv_rowdata *rowdata = mdv_rowdata_create((mdv_table_base const *)&table);
+    mu_check(rowdata);
+
+    // Index is built for existing rows
+    mu_check(test_rowdata_add(rowdata, table.fields, 0, 1200));
+
+    uint32_t const i_fields[] = { 0 };
+    uint32_t const si_fields[] = { 1, 0 };
+    uint32_t const d_fields[] = { 2 };
+    uint32_t const invalid_fields[] = { 3 };
+
+    uint32_t i_index = ~0u, si_index = ~0u, d_index = ~0u, index = ~0u;
+
+    mu_check(mdv_rowdata_index_create(rowdata, 1, i_fields, &i_index));
+    mu_check(mdv_rowdata_index_create(rowdata, 2, si_fields, &si_index));
+    mu_check(mdv_rowdata_index_create(rowdata, 1, i_fields, &index) && index == i_index);
+    mu_check(!mdv_rowdata_index_create(rowdata, 1, invalid_fields, &index));
+
+    // Index isn't available until it is built
+    mdv_rowdata_index_state state;
+    mu_check(mdv_rowdata_index_progress(rowdata, i_index, &state));
+    mu_check(!state.ready && state.built == 0 && state.rows == 1200);
+    mu_check(!test_rowdata_lookup(rowdata, i_index, 0, 0).ok);
+
+    // Index is built by batches. Rows which are added during the building are caught up.
+    bool ready = false;
+    mu_check(mdv_rowdata_index_build(rowdata, i_index, 256, &ready) && !ready);
+    mu_check(mdv_rowdata_index_progress(rowdata, i_index, &state));
+    mu_check(!state.ready && state.built == 256);
+
+    mu_check(test_rowdata_add(rowdata, table.fields, 1200, 1300));
+
+    mu_check(test_rowdata_index_build(rowdata, i_index));
+    mu_check(test_rowdata_index_build(rowdata, si_index));
+
+    mu_check(mdv_rowdata_index_progress(rowdata, i_index, &state));
+    mu_check(state.ready && state.built == 1300 && state.rows == 1300);
+
+    // Index is updated with new rows
+    mu_check(test_rowdata_add(rowdata, table.fields, 1300, 1500));
+
+    // Index building is resumed after the table reopening
+    mu_check(mdv_rowdata_index_create(rowdata, 1, d_fields, &d_index));
+    mu_check(i_index != si_index && si_index != d_index);
+    mu_check(mdv_rowdata_index_build(rowdata, d_index, 256, &ready) && !ready);
+
+    mdv_rowdata_release(rowdata);
+
+    rowdata = mdv_rowdata_open(&table.id);
+    mu_check(rowdata);
+
+    mu_check(mdv_rowdata_indexes_count(rowdata) == 3);
+    mu_check(mdv_rowdata_index_progress(rowdata, d_index, &state));
+    mu_check(!state.ready && state.built == 256 && state.rows == 1500);
+    mu_check(test_rowdata_index_build(rowdata, d_index));
+
+    mdv_rowdata_release(rowdata);
+
+    int32_t i_from = -5, i_to = 5;
+
+    typedef mdv_row(1) key1;
+    typedef mdv_row(2) key2;
+
+    key1 const eq = { 1, { { sizeof i_from, &i_from } } };
+
+    // The only lookup right after the table reopening
+    rowdata = mdv_rowdata_open(&table.id);
+    mu_check(rowdata);
+
+    test_rowdata_ids ids = test_rowdata_lookup(rowdata, i_index, (mdv_row_base const *)&eq, (mdv_row_base const *)&eq);
+    mu_check(ids.ok && ids.ascending && ids.count == 15);
+
+    mdv_rowdata_release(rowdata);
+
+    // Indexes are loaded with the table
+    rowdata = mdv_rowdata_open(&table.id);
+    mu_check(rowdata);
+
+    key1 const from = { 1, { { sizeof i_from, &i_from } } };
+    key1 const to = { 1, { { sizeof i_to, &i_to } } };
+
+    ids = test_rowdata_lookup(rowdata, i_index, (mdv_row_base const *)&eq, (mdv_row_base const *)&eq);
+    mu_check(ids.ok && ids.ascending && ids.count == 15);
+
+    ids = test_rowdata_lookup(rowdata, i_index, (mdv_row_base const *)&from, (mdv_row_base const *)&to);
+    mu_check(ids.ok && ids.count == 11 * 15);
+
+    ids = test_rowdata_lookup(rowdata, i_index, 0, (mdv_row_base const *)&to);
+    mu_check(ids.ok && ids.count == 56 * 15);
+
+    ids = test_rowdata_lookup(rowdata, i_index, 0, 0);
+    mu_check(ids.ok && ids.count == 1500);
+
+    // Prefix lookup for composite index
+    key1 const s_eq = { 1, { { 2, "s3" } } };
+    ids = test_rowdata_lookup(rowdata, si_index, (mdv_row_base const *)&s_eq, (mdv_row_base const *)&s_eq);
+    mu_check(ids.ok && ids.count == 214);
+
+    key2 const si_eq = { 2, { { 2, "s3" }, { sizeof i_from, &i_from } } };
+    ids = test_rowdata_lookup(rowdata, si_index, (mdv_row_base const *)&si_eq, (mdv_row_base const *)&si_eq);
+    mu_check(ids.ok && ids.ascending && ids.count == 3 && ids.last == 1446);
+
+    key1 const s_short = { 1, { { 1, "s" } } };
+    ids = test_rowdata_lookup(rowdata, si_index, (mdv_row_base const *)&s_short, (mdv_row_base const *)&s_short);
+    mu_check(ids.ok && ids.count == 0);
+
+    // Negative floating point values order
+    double d_from = -10.0, d_to = -5.0;
+    key1 const df = { 1, { { sizeof d_from, &d_from } } };
+    key1 const dt = { 1, { { sizeof d_to, &d_to } } };
+    ids = test_rowdata_lookup(rowdata, d_index, (mdv_row_base const *)&df, (mdv_row_base const *)&dt);
+    mu_check(ids.ok && ids.count == 11 && ids.last == 11);
+
+    mdv_rowdata_release(rowdata);
+
+    // Index for empty table is ready immediately
+    test_table empty = table;
+    empty.id = mdv_uuid_generate();
+
+    rowdata = mdv_rowdata_create((mdv_table_base const *)&empty);
+    mu_check(rowdata);
+
+    mu_check(mdv_rowdata_index_create(rowdata, 1, i_fields, &index));
+    mu_check(mdv_rowdata_index_progress(rowdata, index, &state) && state.ready);
+    mu_check(test_rowdata_add(rowdata, table.fields, 0, 10));
+
+    ids = test_rowdata_lookup(rowdata, index, 0, 0);
+    mu_check(ids.ok && ids.count == 10);
+
+    // Transaction log applied position is saved with the rows
+    mdv_uuid const trlog = mdv_uuid_generate();
+    mu_check(mdv_rowdata_applied_pos(rowdata, &trlog) == 0);
+
+    mdv_transaction transaction = mdv_transaction_start(mdv_rowdata_storage(rowdata));
+    mu_check(mdv_transaction_ok(transaction));
+    mu_check(mdv_rowdata_applied_pos_set(rowdata, &transaction, &trlog, 42));
+    mu_check(mdv_transaction_commit(&transaction));
+
+    mu_check(mdv_rowdata_applied_pos(rowdata, &trlog) == 42);
+
+    mdv_rowdata_release(rowdata);
+
+    mu_check(mdv_rmdir("./rowdata_test"));
+
+    MDV_CONFIG = config;
+}
+
+
+typedef struct
+{
+    bool     ok;            ///< Values match the added rows
+    uint64_t rows;          ///< Number of scanned rows
+    uint32_t segments;      ///< Number of scanned segments
+} test_rowdata_scan_state;
+
+
+static bool test_rowdata_scan_fn(void *arg, uint64_t first_row, mdv_column const *columns)
+{
+    test_rowdata_scan_state *state = arg;
+
+    state->ok = state->ok
+                && first_row == state->rows + 1
+                && columns[0].count == columns[1].count;
+
+    for(uint32_t n = 0; state->ok && n < columns[0].count; ++n)
+    {
+        uint64_t const row = first_row - 1 + n;
+
+        int32_t const i = test_rowdata_i(row);
+        char s[4];
+        snprintf(s, sizeof s, "s%u", (unsigned)(row % 7));
+
+        mdv_data const vi = mdv_column_value(columns + 0, n);
+        mdv_data const vs = mdv_column_value(columns + 1, n);
+
+        state->ok = vi.size == sizeof i && memcmp(vi.ptr, &i, sizeof i) == 0
+                    && vs.size == 2 && memcmp(vs.ptr, s, 2) == 0;
+    }
+
+    state->rows += columns[0].count;
+    ++state->segments;
+
+    return true;
+}
+
+
+static test_rowdata_scan_state test_rowdata_scan(mdv_rowdata *rowdata)
+{
+    static const uint32_t columns[] = { 0, 1 };
+    test_rowdata_scan_state state = { true, 0, 0 };
+    state.ok = mdv_rowdata_scan(rowdata, 0, 1, 2, columns, &state, test_rowdata_scan_fn) && state.ok;
+    return state;
+}
+
+
+MU_TEST(core_rowdata_scan)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./rowdata_test");
+
+    typedef mdv_table(3) test_table;
+
+    test_table table =
+    {
+        .name = mdv_str_static("scanned"),
+        .id = mdv_uuid_generate(),
+        .size = 3,
+        .fields =
+        {
+            { MDV_FLD_TYPE_INT32,  1, mdv_str_static("i") },
+            { MDV_FLD_TYPE_CHAR,   3, mdv_str_static("s") },
+            { MDV_FLD_TYPE_DOUBLE, 1, mdv_str_static("d") }
+        }
+    };
+
+    mdv_rowdata *rowdata = mdv_rowdata_create((mdv_table_base const *)&table);
+    mu_check(rowdata);
+
+    // Empty table has no segments
+    test_rowdata_scan_state state = test_rowdata_scan(rowdata);
+    mu_check(state.ok && state.rows == 0 && state.segments == 0);
+
+    // Small commits are kept in the rows tail
+    for(uint64_t n = 0; n < 1000; n += 100)
+        mu_check(test_rowdata_add(rowdata, table.fields, n, n + 100));
+
+    state = test_rowdata_scan(rowdata);
+    mu_check(state.ok && state.rows == 1000 && state.segments == 1);
+
+    // Full tail is moved to the column segment
+    mu_check(test_rowdata_add(rowdata, table.fields, 1000, 1024));
+
+    state = test_rowdata_scan(rowdata);
+    mu_check(state.ok && state.rows == 1024 && state.segments == 1);
+
+    // Commit fills the tail and starts the new one
+    mu_check(test_rowdata_add(rowdata, table.fields, 1024, 3000));
+
+    mdv_rowdata_release(rowdata);
+
+    rowdata = mdv_rowdata_open(&table.id);
+    mu_check(rowdata);
+
+    state = test_rowdata_scan(rowdata);
+    mu_check(state.ok && state.rows == 3000 && state.segments == 3);
+
+    mdv_rowdata_release(rowdata);
+
+    mu_check(mdv_rmdir("./rowdata_test"));
+
+    MDV_CONFIG = config;
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "../minunit.h"
 #include <mdv_serialization.h>
+#include <mdv_packed_row.h>
 #include <mdv_alloc.h>
 
 
@@ -39,6 +40,35 @@ static void test_table_serialization()
 }
 
 
+static void test_row_roundtrip(mdv_field const *fields, mdv_row_base const *row)
+{
+    mdv_row_codec *codec = mdv_row_codec_create(fields, row->size);
+
+    mu_check(codec);
+
+    if (!codec)
+        return;
+
+    mdv_data packed;
+
+    mu_check(mdv_row_codec_pack(codec, row, &packed));
+
+    mdv_row_base *deserialized_row = mdv_row_codec_unpack(codec, &packed);
+
+    mu_check(deserialized_row && deserialized_row->size == row->size);
+
+    for(uint32_t i = 0; deserialized_row && i < row->size; ++i)
+    {
+        mu_check(deserialized_row->fields[i].size == row->fields[i].size);
+        mu_check(memcmp(deserialized_row->fields[i].ptr, row->fields[i].ptr, row->fields[i].size) == 0);
+    }
+
+    mdv_free(deserialized_row, "row");
+    mdv_free(packed.ptr, "packed_row");
+    mdv_row_codec_free(codec);
+}
+
+
 static void test_row_serialization()
 {
     int arr[] =  { 41, 42 };
@@ -61,22 +91,256 @@ static void test_row_serialization()
         { MDV_FLD_TYPE_INT32, 3, mdv_str_static("col3") }
     };
 
-    binn obj;
+    test_row_roundtrip(fields, (mdv_row_base const *)&row);
+}
 
-    mu_check(mdv_binn_row(fields, (mdv_row_base const *)&row, &obj));
 
-    mdv_row_base *deserialized_row = mdv_unbinn_row(&obj, fields);
+static void test_row_serialization_mixed_fields()
+{
+    int32_t i32 = 42;
+    uint64_t arr[] = { 1, 2, 3 };
+    double dbl = 3.14;
 
-    mu_check(deserialized_row->size == row.size);
+    mdv_row(3) row =
+    {
+        .size = 3,
+        .fields =
+        {
+            { sizeof i32, &i32 },
+            { sizeof arr, arr },
+            { sizeof dbl, &dbl }
+        }
+    };
 
+    mdv_field fields[] =
+    {
+        { MDV_FLD_TYPE_INT32,  1, mdv_str_static("col1") },
+        { MDV_FLD_TYPE_UINT64, 0, mdv_str_static("col2") },
+        { MDV_FLD_TYPE_DOUBLE, 1, mdv_str_static("col3") }
+    };
+
+    test_row_roundtrip(fields, (mdv_row_base const *)&row);
+}
+
+
+static void test_packed_row()
+{
+    int8_t i8 = -7;
+    uint64_t arr[] = { 1, 2, 3 };
+    int32_t i32 = 42;
+    double dbl = 3.14;
+    char const str[] = "hello";
+
+    mdv_row(5) row =
+    {
+        .size = 5,
+        .fields =
+        {
+            { sizeof i8, &i8 },
+            { sizeof arr, arr },
+            { sizeof i32, &i32 },
+            { sizeof dbl, &dbl },
+            { 5, (void*)str }
+        }
+    };
+
+    mdv_field fields[] =
+    {
+        { MDV_FLD_TYPE_INT8,   1, mdv_str_static("col1") },
+        { MDV_FLD_TYPE_UINT64, 0, mdv_str_static("col2") },
+        { MDV_FLD_TYPE_INT32,  1, mdv_str_static("col3") },
+        { MDV_FLD_TYPE_DOUBLE, 1, mdv_str_static("col4") },
+        { MDV_FLD_TYPE_CHAR,   8, mdv_str_static("col5") }
+    };
+
+    mdv_row_codec *codec = mdv_row_codec_create(fields, row.size);
+
+    mu_check(codec);
+
+    if (!codec)
+        return;
+
+    mdv_data packed;
+
+    mu_check(mdv_row_codec_pack(codec, (mdv_row_base const *)&row, &packed));
+    mu_check(packed.size == mdv_row_codec_packed_size(codec, (mdv_row_base const *)&row));
+    mu_check(mdv_row_codec_check(codec, &packed));
+
+    // Fields are read in place
     for(uint32_t i = 0; i < row.size; ++i)
     {
-        mu_check(deserialized_row->fields[i].size == row.fields[i].size);
-        mu_check(memcmp(deserialized_row->fields[i].ptr, row.fields[i].ptr, row.fields[i].size) == 0);
+        mdv_data value;
+        mu_check(mdv_row_codec_field(codec, packed.ptr, i, &value));
+        mu_check(value.size == row.fields[i].size);
+        mu_check(memcmp(value.ptr, row.fields[i].ptr, row.fields[i].size) == 0);
+    }
+
+    mdv_row_base *unpacked = mdv_row_codec_unpack(codec, &packed);
+
+    mu_check(unpacked && unpacked->size == row.size);
+
+    for(uint32_t i = 0; unpacked && i < row.size; ++i)
+    {
+        mu_check(unpacked->fields[i].size == row.fields[i].size);
+        mu_check(memcmp(unpacked->fields[i].ptr, row.fields[i].ptr, row.fields[i].size) == 0);
     }
 
+    mdv_free(unpacked, "row");
+
+    // Corrupted rows are rejected
+    mdv_data truncated = { packed.size - 1, packed.ptr };
+    mu_check(!mdv_row_codec_check(codec, &truncated));
+    mu_check(!mdv_row_codec_unpack(codec, &truncated));
+
+    mdv_row_codec *short_codec = mdv_row_codec_create(fields, row.size - 1);
+    mu_check(short_codec && !mdv_row_codec_check(short_codec, &packed));
+    mdv_row_codec_free(short_codec);
+
+    // Offsets table is placed after the header (4 bytes), the null bitmap (1 byte) and the fixed section (i8, i32, double)
+    uint32_t *ends = (uint32_t *)((char *)packed.ptr + 24);
+    uint32_t const end = ends[0];
+    ends[0] = packed.size + 8;
+    mu_check(!mdv_row_codec_check(codec, &packed));
+    ends[0] = end;
+    mu_check(mdv_row_codec_check(codec, &packed));
+
+    // Empty single values are rejected. Null bitmap is placed after the header (4 bytes).
+    uint8_t *bitmap = (uint8_t *)packed.ptr + 4;
+    *bitmap |= 1u << 2;
+    mu_check(!mdv_row_codec_check(codec, &packed));
+    mu_check(!mdv_row_codec_unpack(codec, &packed));
+    *bitmap &= ~(1u << 2);
+
+    mdv_free(packed.ptr, "packed_row");
+
+    // Empty single values aren't packed
+    row.fields[2].size = 0;
+    mu_check(!mdv_row_codec_packed_size(codec, (mdv_row_base const *)&row));
+    row.fields[2].size = sizeof i32;
+
+    // Too long fields aren't packed
+    row.fields[4].size = 9;
+    mu_check(!mdv_row_codec_packed_size(codec, (mdv_row_base const *)&row));
+
+    mdv_row_codec_free(codec);
+}
+
+
+static void test_row_codec()
+{
+    uint16_t arr1[] = { 1, 2, 3 };
+    int64_t i64 = -42;
+    float arr2[] = { 0.5f, 1.5f };
+
+    mdv_row(4) row =
+    {
+        .size = 4,
+        .fields =
+        {
+            { sizeof arr1, arr1 },
+            { sizeof i64, &i64 },
+            { 0, 0 },
+            { sizeof arr2, arr2 }
+        }
+    };
+
+    mdv_field fields[] =
+    {
+        { MDV_FLD_TYPE_UINT16, 0, mdv_str_static("col1") },
+        { MDV_FLD_TYPE_INT64,  1, mdv_str_static("col2") },
+        { MDV_FLD_TYPE_CHAR,   0, mdv_str_static("col3") },
+        { MDV_FLD_TYPE_FLOAT,  2, mdv_str_static("col4") }
+    };
+
+    mdv_row_codec *codec = mdv_row_codec_create(fields, row.size);
+
+    mu_check(codec && mdv_row_codec_fields_count(codec) == row.size);
+
+    if (!codec)
+        return;
+
+    mdv_data packed;
+
+    mu_check(mdv_row_codec_pack(codec, (mdv_row_base const *)&row, &packed));
+
+    // Row packed into the given buffer is the same
+    uint32_t const size = mdv_row_codec_packed_size(codec, (mdv_row_base const *)&row);
+    uint64_t expected[16] = {};
+
+    mu_check(size == packed.size && size <= sizeof expected);
+    mu_check(mdv_row_codec_pack_to(codec, (mdv_row_base const *)&row, expected, size));
+    mu_check(memcmp(packed.ptr, expected, packed.size) == 0);
+    mu_check(mdv_row_codec_check(codec, &packed));
+
+    for(uint32_t i = 0; i < row.size; ++i)
+    {
+        mdv_data value;
+        mu_check(mdv_row_codec_field(codec, packed.ptr, i, &value));
+        mu_check(value.size == row.fields[i].size);
+        mu_check(memcmp(value.ptr, row.fields[i].ptr, row.fields[i].size) == 0);
+    }
+
+    mdv_row_base *unpacked = mdv_row_codec_unpack(codec, &packed);
+
+    mu_check(unpacked && unpacked->size == row.size);
+
+    for(uint32_t i = 0; unpacked && i < row.size; ++i)
+    {
+        mu_check(unpacked->fields[i].size == row.fields[i].size);
+        mu_check(memcmp(unpacked->fields[i].ptr, row.fields[i].ptr, row.fields[i].size) == 0);
+    }
+
+    mdv_free(unpacked, "row");
+    mdv_free(packed.ptr, "packed_row");
+
+    // Rows with other fields count aren't packed
+    row.size = 3;
+    mu_check(!mdv_row_codec_packed_size(codec, (mdv_row_base const *)&row));
+
+    mdv_row_codec_free(codec);
+}
+
+
+static void test_predicate_serialization()
+{
+    int32_t const i32 = 42;
+
+    mdv_predicate const args[] =
+    {
+        { .op = MDV_PRED_GE, .field = 0, .value = { sizeof i32, (void*)&i32 } },
+        { .op = MDV_PRED_EQ, .field = 2, .value = { 5, "hello" } }
+    };
+
+    mdv_predicate const not_arg = { .op = MDV_PRED_AND, .size = 2, .args = args };
+    mdv_predicate const predicate = { .op = MDV_PRED_NOT, .size = 1, .args = &not_arg };
+
+    binn obj;
+
+    mu_check(mdv_binn_predicate(&predicate, &obj));
+
+    mdv_predicate *deserialized = mdv_unbinn_predicate(&obj);
+
     binn_free(&obj);
-    mdv_free(deserialized_row, "row");
+
+    mu_check(deserialized);
+
+    if (!deserialized)
+        return;
+
+    mu_check(deserialized->op == MDV_PRED_NOT && deserialized->size == 1);
+
+    mdv_predicate const *and = deserialized->args;
+    mu_check(and->op == MDV_PRED_AND && and->size == 2);
+
+    for(uint32_t i = 0; i < 2; ++i)
+    {
+        mu_check(and->args[i].op == args[i].op);
+        mu_check(and->args[i].field == args[i].field);
+        mu_check(and->args[i].value.size == args[i].value.size);
+        mu_check(memcmp(and->args[i].value.ptr, args[i].value.ptr, args[i].value.size) == 0);
+    }
+
+    mdv_free(deserialized, "predicate");
 }
 
 
@@ -84,4 +348,8 @@ MU_TEST(core_serialization)
 {
     test_table_serialization();
     test_row_serialization();
+    test_row_serialization_mixed_fields();
+    test_packed_row();
+    test_row_codec();
+    test_predicate_serialization();
 }
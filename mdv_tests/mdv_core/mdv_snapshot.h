@@ -0,0 +1,88 @@
+#pragma once
+#include "../minunit.h"
+#include "mdv_rowdata.h"
+#include <storage/mdv_snapshot.h>
+
+
+static bool test_snapshot_count_fn(void *arg, uint64_t first_row, mdv_column const *columns)
+{
+    (void)first_row;
+    *(uint64_t*)arg += columns[0].count;
+    return true;
+}
+
+
+static uint64_t test_snapshot_count(mdv_rowdata *rowdata, mdv_transaction *transaction)
+{
+    uint32_t const columns[] = { 0 };
+    uint64_t count = 0;
+    return mdv_rowdata_scan(rowdata, transaction, 1, 1, columns, &count, test_snapshot_count_fn)
+            ? count
+            : ~0ull;
+}
+
+
+MU_TEST(core_snapshot)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./snapshot_test");
+
+    typedef mdv_table(3) test_table;
+
+    test_table table =
+    {
+        .name = mdv_str_static("snapshot"),
+        .id = mdv_uuid_generate(),
+        .size = 3,
+        .fields =
+        {
+            { MDV_FLD_TYPE_INT32,  1, mdv_str_static("i") },
+            { MDV_FLD_TYPE_CHAR,   3, mdv_str_static("s") },
+            { MDV_FLD_TYPE_DOUBLE, 1, mdv_str_static("d") }
+        }
+    };
+
+    mdv_rowdata *rowdata = mdv_rowdata_create((mdv_table_base const *)&table);
+    mu_check(rowdata);
+
+    mu_check(test_rowdata_add(rowdata, table.fields, 0, 100));
+
+    mdv_snapshot *snapshot = mdv_snapshot_create(1, 42);
+    mu_check(snapshot);
+    mu_check(mdv_snapshot_id(snapshot) == 1 && mdv_snapshot_epoch(snapshot) == 42);
+
+    mdv_uuid const trlog = mdv_uuid_generate();
+    mu_check(mdv_snapshot_position_add(snapshot, &trlog, 7));
+    mu_check(mdv_snapshot_table_add(snapshot, rowdata));
+    mu_check(mdv_snapshot_table_add(snapshot, rowdata));    // Already pinned
+
+    // Rows added after the snapshot creation aren't visible in the snapshot
+    mu_check(test_rowdata_add(rowdata, table.fields, 100, 150));
+
+    mdv_transaction *transaction = 0;
+
+    mu_check(mdv_snapshot_table_lock(snapshot, &table.id, &transaction) == rowdata);
+    mu_check(test_snapshot_count(rowdata, transaction) == 100);
+    mu_check(test_snapshot_count(rowdata, transaction) == 100);     // Transaction is reused by paged requests
+    mdv_snapshot_unlock(snapshot);
+
+    mu_check(test_snapshot_count(rowdata, 0) == 150);
+
+    mdv_uuid const unknown = mdv_uuid_generate();
+    mu_check(!mdv_snapshot_table_lock(snapshot, &unknown, &transaction));
+    mu_check(mdv_snapshot_position(snapshot, &trlog) == 7);
+    mu_check(mdv_snapshot_position(snapshot, &unknown) == 0);
+
+    mdv_snapshot_release(snapshot);
+
+    // Storage memory map can grow after the pinned transactions are finished
+    mu_check(test_rowdata_add(rowdata, table.fields, 150, 5000));
+    mu_check(test_snapshot_count(rowdata, 0) == 5000);
+
+    mdv_rowdata_release(rowdata);
+
+    mu_check(mdv_rmdir("./snapshot_test"));
+
+    MDV_CONFIG = config;
+}
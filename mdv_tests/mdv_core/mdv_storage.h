@@ -0,0 +1,445 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_storage.h>
+#include <mdv_config.h>
+#include <mdv_filesystem.h>
+#include <mdv_threads.h>
+#include <mdv_time.h>
+#include <string.h>
+
+
+/**
+ * @brief Writes values until the memory map is full and grown.
+ */
+static bool test_storage_fill(mdv_storage *storage, uint64_t n)
+{
+    static char value_data[64 * 1024];
+    memset(value_data, 'x', sizeof value_data);
+
+    mdv_transaction transaction = mdv_transaction_start(storage);
+
+    if (!mdv_transaction_ok(transaction))
+        return false;
+
+    mdv_map map = mdv_map_open(&transaction, "data", MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+    bool ret = mdv_map_ok(map);
+
+    for(uint64_t i = 0; ret && i < n; ++i)
+    {
+        mdv_data const key = { sizeof i, (void*)&i };
+        mdv_data const value = { sizeof value_data, value_data };
+        ret = mdv_map_put(&map, &transaction, &key, &value);
+    }
+
+    mdv_map_close(&map);
+
+    if (ret)
+        ret = mdv_transaction_commit(&transaction);
+    else
+        mdv_transaction_abort(&transaction);
+
+    return ret;
+}
+
+
+MU_TEST(core_storage_map_grow)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.map_size = 1024 * 1024;
+    MDV_CONFIG.storage.map_grow = 1024 * 1024;
+
+    mdv_storage *storage = mdv_storage_open("./storage_test", "test", 1, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    uint64_t const N = 64;      // 4 MB in total
+
+    // Map is grown in advance by one step, so the transaction isn't journaled and it fails.
+    // The next transaction is journaled and it is replayed after the map growth.
+    mu_check(!test_storage_fill(storage, N));
+    mu_check(test_storage_fill(storage, N));
+
+    static char value_data[64 * 1024];
+    memset(value_data, 'x', sizeof value_data);
+
+    mdv_transaction transaction = mdv_transaction_start(storage);
+    mu_check(mdv_transaction_ok(transaction));
+
+    mdv_map map = mdv_map_open(&transaction, "data", MDV_MAP_INTEGERKEY);
+    mu_check(mdv_map_ok(map));
+
+    for(uint64_t i = 0; i < N; ++i)
+    {
+        mdv_data const key = { sizeof i, (void*)&i };
+        mdv_data value = {};
+        mu_check(mdv_map_get(&map, &transaction, &key, &value));
+        mu_check(value.size == sizeof value_data && memcmp(value.ptr, value_data, value.size) == 0);
+    }
+
+    mu_check(mdv_transaction_abort(&transaction));
+
+    mdv_map_close(&map);
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+
+    MDV_CONFIG = config;
+}
+
+
+MU_TEST(core_storage_map_grow_reader)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.map_size = 1024 * 1024;
+    MDV_CONFIG.storage.map_grow = 1024 * 1024;
+    MDV_CONFIG.storage.map_grow_wait = 100;
+
+    mdv_storage *storage = mdv_storage_open("./storage_test", "test", 1, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    uint64_t const N = 64;      // 4 MB in total
+
+    // Map isn't grown while the current thread holds the read-only transaction, so the writer fails instead of waiting forever
+    mdv_transaction reader = mdv_transaction_start_read(storage);
+    mu_check(mdv_transaction_ok(reader));
+
+    mu_check(!test_storage_fill(storage, N));
+    mu_check(!test_storage_fill(storage, N));
+
+    mu_check(mdv_transaction_abort(&reader));
+
+    mu_check(test_storage_fill(storage, N));
+
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+
+    MDV_CONFIG = config;
+}
+
+
+typedef struct
+{
+    mdv_transaction *snapshot;
+    size_t           delay;
+} test_storage_snapshot_release;
+
+
+static void * test_storage_snapshot_release_fn(void *arg)
+{
+    test_storage_snapshot_release *release = arg;
+    mdv_sleep(release->delay);
+    mdv_transaction_abort(release->snapshot);
+    return 0;
+}
+
+
+typedef struct
+{
+    mdv_storage     *storage;
+    size_t           delay;
+    size_t           duration;
+} test_storage_reader;
+
+
+static void * test_storage_reader_fn(void *arg)
+{
+    test_storage_reader *reader = arg;
+    mdv_sleep(reader->delay);
+    size_t const start = mdv_gettime();
+    mdv_transaction transaction = mdv_transaction_start_read(reader->storage);
+    reader->duration = mdv_gettime() - start;
+    if (mdv_transaction_ok(transaction))
+        mdv_transaction_abort(&transaction);
+    return 0;
+}
+
+
+MU_TEST(core_storage_map_grow_pinned)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.map_size = 1024 * 1024;
+    MDV_CONFIG.storage.map_grow = 1024 * 1024;
+    MDV_CONFIG.storage.map_grow_wait = 200;
+
+    mdv_storage *storage = mdv_storage_open("./storage_test", "test", 1, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    // Map growth doesn't wait for the pinned snapshot forever
+    mdv_transaction snapshot = mdv_transaction_start_snapshot(storage);
+    mu_check(mdv_transaction_ok(snapshot));
+
+    size_t const start = mdv_gettime();
+    mu_check(!test_storage_fill(storage, 32));
+    mu_check(mdv_gettime() - start < 5000);
+
+    mu_check(mdv_transaction_abort(&snapshot));
+
+    // Map is grown when the snapshot is released during the waiting
+    MDV_CONFIG.storage.map_grow_wait = 10000;
+
+    snapshot = mdv_transaction_start_snapshot(storage);
+    mu_check(mdv_transaction_ok(snapshot));
+
+    test_storage_snapshot_release release = { &snapshot, 300 };
+
+    // Readers aren't blocked while the map growth waits for the pinned snapshot
+    test_storage_reader reader = { storage, 100, ~0ul };
+
+    mdv_thread thread, reader_thread;
+    mdv_thread_attrs const attrs = { .stack_size = MDV_THREAD_STACK_SIZE };
+    mu_check(mdv_thread_create(&thread, &attrs, test_storage_snapshot_release_fn, &release) == MDV_OK);
+    mu_check(mdv_thread_create(&reader_thread, &attrs, test_storage_reader_fn, &reader) == MDV_OK);
+
+    mu_check(test_storage_fill(storage, 32));
+
+    mu_check(mdv_thread_join(thread) == MDV_OK);
+    mu_check(mdv_thread_join(reader_thread) == MDV_OK);
+
+    mu_check(reader.duration < 100);
+
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+
+    MDV_CONFIG = config;
+}
+
+
+MU_TEST(core_storage_map_cache)
+{
+    mdv_storage *storage = mdv_storage_open("./storage_test", "test", 2, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    mdv_map_handle const h1 = mdv_storage_map(storage, "m1", MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mdv_map_handle const h2 = mdv_storage_map(storage, "m2", MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+
+    mu_check(h1 && h2 && h1 != h2);
+    mu_check(mdv_storage_map(storage, "m1", MDV_MAP_CREATE | MDV_MAP_INTEGERKEY) == h1);
+
+    uint64_t const k = 42, v = 24;
+    mdv_data const key = { sizeof k, (void*)&k };
+    mdv_data value = { sizeof v, (void*)&v };
+
+    mdv_transaction transaction = mdv_transaction_start(storage);
+    mu_check(mdv_transaction_ok(transaction));
+
+    mdv_map map = mdv_map_bind(&transaction, h1);
+    mu_check(mdv_map_ok(map));
+    mu_check(mdv_map_put(&map, &transaction, &key, &value));
+    mdv_map_close(&map);
+
+    mu_check(mdv_transaction_commit(&transaction));
+
+    transaction = mdv_transaction_start(storage);
+    mu_check(mdv_transaction_ok(transaction));
+
+    map = mdv_map_open(&transaction, "m1", MDV_MAP_INTEGERKEY);
+    mu_check(mdv_map_ok(map) && map.dbmap == h1);
+
+    value = (mdv_data){};
+    mu_check(mdv_map_get(&map, &transaction, &key, &value));
+    mu_check(value.size == sizeof v && *(uint64_t*)value.ptr == v);
+    mdv_map_close(&map);
+
+    mu_check(mdv_transaction_abort(&transaction));
+
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+}
+
+
+MU_TEST(core_storage_cursor_range)
+{
+    mdv_storage *storage = mdv_storage_open("./storage_test", "test", 1, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    mdv_transaction transaction = mdv_transaction_start(storage);
+    mu_check(mdv_transaction_ok(transaction));
+
+    mdv_map map = mdv_map_open(&transaction, "data", MDV_MAP_CREATE);
+    mu_check(mdv_map_ok(map));
+
+    char const *keys[] = { "aa", "ab", "b" };
+
+    for(size_t i = 0; i < sizeof keys / sizeof *keys; ++i)
+    {
+        mdv_data const key = { strlen(keys[i]), (void*)keys[i] };
+        mdv_data const value = { sizeof i, (void*)&i };
+        mu_check(mdv_map_put(&map, &transaction, &key, &value));
+    }
+
+    mu_check(mdv_transaction_commit(&transaction));
+
+    transaction = mdv_transaction_start_read(storage);
+    mu_check(mdv_transaction_ok(transaction));
+
+    // Padding bytes of the key don't affect the search
+    mdv_data key, value;
+    memset(&key, 0x7F, sizeof key);
+    memset(&value, 0x7F, sizeof value);
+    key.size = 2;
+    key.ptr = "ab";
+
+    mdv_cursor cursor = mdv_cursor_open_explicit(&map, &transaction, &key, &value, MDV_SET_RANGE);
+    mu_check(mdv_cursor_ok(cursor));
+    mu_check(key.size == 2 && memcmp(key.ptr, "ab", 2) == 0);
+    mu_check(value.size == sizeof(size_t) && *(size_t*)value.ptr == 1);
+    mdv_cursor_close(&cursor);
+
+    mu_check(mdv_transaction_abort(&transaction));
+
+    mdv_map_close(&map);
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+}
+
+
+MU_TEST(core_storage_read_transaction)
+{
+    mdv_storage *storage = mdv_storage_open("./storage_test", "test", 1, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    mdv_map_handle const h = mdv_storage_map(storage, "data", MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mu_check(h);
+
+    uint64_t const k = 1, v = 42;
+    mdv_data const key = { sizeof k, (void*)&k };
+    mdv_data value = { sizeof v, (void*)&v };
+
+    mdv_transaction transaction = mdv_transaction_start_read(storage);
+    mu_check(mdv_transaction_ok(transaction) && transaction.rdonly);
+
+    void *const txn = transaction.ptransaction;
+
+    mdv_map map = mdv_map_bind(&transaction, h);
+    mu_check(mdv_map_ok(map));
+    mu_check(!mdv_map_put(&map, &transaction, &key, &value));   // Read-only transaction
+    mdv_map_close(&map);
+
+    mu_check(mdv_transaction_abort(&transaction));
+
+    transaction = mdv_transaction_start(storage);
+    map = mdv_map_bind(&transaction, h);
+    mu_check(mdv_map_put(&map, &transaction, &key, &value));
+    mdv_map_close(&map);
+    mu_check(mdv_transaction_commit(&transaction));
+
+    // Pooled transaction is renewed and sees the new snapshot
+    transaction = mdv_transaction_start_read(storage);
+    mu_check(mdv_transaction_ok(transaction) && transaction.ptransaction == txn);
+
+    map = mdv_map_bind(&transaction, h);
+    value = (mdv_data){};
+    mu_check(mdv_map_get(&map, &transaction, &key, &value));
+    mu_check(value.size == sizeof v && *(uint64_t*)value.ptr == v);
+    mdv_map_close(&map);
+
+    mu_check(mdv_transaction_commit(&transaction));
+
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+}
+
+
+MU_TEST(core_storage_map_append)
+{
+    mdv_storage *storage = mdv_storage_open("./storage_test", "test", 1, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    mdv_map_handle const h = mdv_storage_map(storage, "log", MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mu_check(h);
+
+    mdv_transaction transaction = mdv_transaction_start(storage);
+    mdv_map map = mdv_map_bind(&transaction, h);
+
+    uint64_t const ids[] = { 1, 2, 3, 5, 4, 6 };     // 4 is out of order
+
+    for(size_t i = 0; i < sizeof ids / sizeof *ids; ++i)
+    {
+        mdv_data const key = { sizeof *ids, (void*)(ids + i) };
+        mu_check(mdv_map_append(&map, &transaction, &key, &key));
+    }
+
+    mdv_data const dup = { sizeof *ids, (void*)ids };
+    mu_check(!mdv_map_append(&map, &transaction, &dup, &dup));   // Key already exists
+
+    mu_check(mdv_transaction_commit(&transaction));
+
+    transaction = mdv_transaction_start_read(storage);
+
+    uint64_t id = 0;
+
+    mdv_map_foreach(transaction, map, entry)
+    {
+        uint64_t key;
+        memcpy(&key, entry.key.ptr, sizeof key);
+        mu_check(key == ++id);
+    }
+
+    mu_check(id == 6);
+
+    mdv_map_close(&map);
+    mu_check(mdv_transaction_abort(&transaction));
+
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+}
+
+
+MU_TEST(core_storage_durable_mark)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.flush_interval = 10;
+
+    // Each commit is flushed
+    mdv_storage *storage = mdv_storage_open("./storage_test", "sync", 1, MDV_STRG_NOSUBDIR);
+    mu_check(storage);
+
+    mdv_storage_mark(storage, 1);
+    mu_check(mdv_storage_durable_mark(storage) == 1);
+
+    mdv_storage_release(storage);
+
+    // Commits are flushed by background flusher
+    storage = mdv_storage_open("./storage_test", "async", 1, MDV_STRG_NOSUBDIR | MDV_STRG_NOSYNC | MDV_STRG_FLUSHER);
+    mu_check(storage);
+
+    mdv_map_handle const h = mdv_storage_map(storage, "log", MDV_MAP_CREATE | MDV_MAP_INTEGERKEY);
+    mu_check(h);
+
+    mdv_transaction transaction = mdv_transaction_start(storage);
+    mdv_map map = mdv_map_bind(&transaction, h);
+
+    uint64_t const id = 42;
+    mdv_data const key = { sizeof id, (void*)&id };
+    mu_check(mdv_map_append(&map, &transaction, &key, &key));
+
+    mdv_map_close(&map);
+    mu_check(mdv_transaction_commit(&transaction));
+
+    mdv_storage_mark(storage, id);
+
+    for(int i = 0; i < 100 && mdv_storage_durable_mark(storage) != id; ++i)
+        mdv_sleep(10);
+
+    mu_check(mdv_storage_durable_mark(storage) == id);
+
+    mdv_storage_mark(storage, id + 1);
+    mu_check(mdv_storage_sync(storage));
+    mu_check(mdv_storage_durable_mark(storage) == id + 1);
+
+    mdv_storage_release(storage);
+
+    mu_check(mdv_rmdir("./storage_test"));
+
+    MDV_CONFIG = config;
+}
@@ -0,0 +1,557 @@
+#pragma once
+#include "../minunit.h"
+#include "mdv_filter.h"
+#include <storage/mdv_tablespace.h>
+#include <storage/mdv_rowdata.h>
+#include <event/mdv_types.h>
+#include <event/mdv_table.h>
+#include <mdv_serialization.h>
+#include <mdv_packed_row.h>
+#include <mdv_config.h>
+#include <mdv_filesystem.h>
+#include <mdv_threads.h>
+#include <mdv_alloc.h>
+#include <string.h>
+
+
+typedef test_filter_table test_tablespace_table;
+
+
+static mdv_ebus * test_tablespace_ebus_create()
+{
+    mdv_ebus_config const config =
+    {
+        .threadpool =
+        {
+            .size = 2,
+            .thread_attrs =
+            {
+                .stack_size = MDV_THREAD_STACK_SIZE
+            }
+        },
+        .event =
+        {
+            .queues_count = 1,
+            .max_id = MDV_EVT_COUNT
+        }
+    };
+
+    return mdv_ebus_create(&config);
+}
+
+
+static mdv_tablespace * test_tablespace_open(mdv_uuid const *uuid, mdv_ebus *ebus)
+{
+    mdv_jobber_config const config =
+    {
+        .threadpool =
+        {
+            .size = 1,
+            .thread_attrs =
+            {
+                .stack_size = MDV_THREAD_STACK_SIZE
+            }
+        },
+        .queue =
+        {
+            .count = 1
+        }
+    };
+
+    return mdv_tablespace_open(uuid, ebus, &config);
+}
+
+
+/**
+ * @brief Creates the table with two fields: int32 'i' and unlimited char 's'. Table identifier is assigned by the tablespace.
+ */
+static bool test_tablespace_table_create(mdv_ebus *ebus, char const *name, test_tablespace_table *table)
+{
+    *table = (test_tablespace_table)
+    {
+        .name = mdv_str((char *)name),
+        .size = 2,
+        .fields =
+        {
+            { MDV_FLD_TYPE_INT32, 1, mdv_str_static("i") },
+            { MDV_FLD_TYPE_CHAR,  0, mdv_str_static("s") }
+        }
+    };
+
+    binn obj;
+
+    if (!mdv_binn_table((mdv_table_base const *)table, &obj))
+        return false;
+
+    mdv_table_base *desc = mdv_unbinn_table(&obj);
+
+    binn_free(&obj);
+
+    if (!desc)
+        return false;
+
+    mdv_evt_create_table *evt = mdv_evt_create_table_create(&desc);
+
+    if (!evt)
+    {
+        mdv_free(desc, "table");
+        return false;
+    }
+
+    bool const ret = mdv_ebus_publish(ebus, &evt->base, MDV_EVT_SYNC) == MDV_OK;
+
+    table->id = evt->table->id;
+
+    mdv_evt_create_table_release(evt);
+
+    return ret;
+}
+
+
+/**
+ * @brief Inserts the rows [first, last) into the transaction log. Field 'i' contains the row number.
+ */
+static bool test_tablespace_rows_insert(mdv_ebus *ebus, test_tablespace_table const *table, uint32_t first, uint32_t last, uint32_t size)
+{
+    char *s = mdv_alloc(size, "test_row");
+
+    if (!s)
+        return false;
+
+    mdv_row_codec *codec = mdv_row_codec_create(table->fields, table->size);
+
+    if (!codec)
+    {
+        mdv_free(s, "test_row");
+        return false;
+    }
+
+    bool ret = true;
+
+    for(uint32_t n = first; ret && n < last; ++n)
+    {
+        int32_t const i = (int32_t)n;
+
+        // Rows are poorly compressible
+        uint32_t seed = n * 2654435761u + 1;
+
+        for(uint32_t j = 0; j < size; ++j)
+        {
+            seed = seed * 1103515245u + 12345u;
+            s[j] = (char)(seed >> 24);
+        }
+
+        mdv_row(2) row =
+        {
+            .size = 2,
+            .fields =
+            {
+                { sizeof i, (void*)&i },
+                { size, s }
+            }
+        };
+
+        mdv_data packed;
+
+        ret = mdv_row_codec_pack(codec, (mdv_row_base const *)&row, &packed);
+
+        if (!ret)
+            break;
+
+        mdv_evt_insert_row *evt = mdv_evt_insert_row_create(&table->id, &packed);
+
+        mdv_free(packed.ptr, "packed_row");
+
+        ret = evt
+                && mdv_ebus_publish(ebus, &evt->base, MDV_EVT_SYNC) == MDV_OK;
+
+        if (evt)
+            mdv_evt_insert_row_release(evt);
+    }
+
+    mdv_row_codec_free(codec);
+    mdv_free(s, "test_row");
+
+    return ret;
+}
+
+
+/**
+ * @brief Selects the table rows and checks that the rows [0, count) are stored exactly once in the insertion order.
+ *
+ * @return number of rows or ~0u if the rows are duplicated, lost or reordered
+ */
+static uint32_t test_tablespace_rows_count(mdv_ebus *ebus, test_tablespace_table const *table)
+{
+    uint32_t const fields[] = { 0 };
+
+    // Rows contain only the requested field
+    mdv_row_codec *codec = mdv_row_codec_create(table->fields, 1);
+
+    if (!codec)
+        return ~0u;
+
+    uint32_t count = 0;
+
+    for(uint64_t first = 0;;)
+    {
+        mdv_predicate *predicate = 0;
+
+        mdv_evt_select *evt = mdv_evt_select_create(&table->id, first, 0, 1, fields, &predicate, 0);
+
+        if (!evt)
+        {
+            mdv_row_codec_free(codec);
+            return ~0u;
+        }
+
+        if (mdv_ebus_publish(ebus, &evt->base, MDV_EVT_SYNC) != MDV_OK)
+        {
+            mdv_evt_select_release(evt);
+            mdv_row_codec_free(codec);
+            return ~0u;
+        }
+
+        int const size = binn_count(evt->rows);
+
+        for(int n = 1; n <= size; ++n)
+        {
+            int row_size = 0;
+            void *row = binn_list_blob(evt->rows, n, &row_size);
+
+            mdv_data i;
+
+            if (!row
+                || !mdv_row_codec_field(codec, row, 0, &i)
+                || i.size != sizeof(int32_t)
+                || *(int32_t const *)i.ptr != (int32_t)count)
+            {
+                mdv_evt_select_release(evt);
+                mdv_row_codec_free(codec);
+                return ~0u;
+            }
+
+            ++count;
+        }
+
+        first = evt->next;
+
+        mdv_evt_select_release(evt);
+
+        if (!first)
+            break;
+    }
+
+    mdv_row_codec_free(codec);
+
+    return count;
+}
+
+
+static uint64_t test_tablespace_applied_pos(test_tablespace_table const *table, mdv_uuid const *trlog)
+{
+    mdv_rowdata *rowdata = mdv_rowdata_open(&table->id);
+
+    if (!rowdata)
+        return ~0ull;
+
+    uint64_t const pos = mdv_rowdata_applied_pos(rowdata, trlog);
+
+    mdv_rowdata_release(rowdata);
+
+    return pos;
+}
+
+
+MU_TEST(core_tablespace_pipeline)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./tablespace_test");
+    MDV_CONFIG.committer.batch_size = 8;
+    MDV_CONFIG.committer.partitions = 0;
+    MDV_CONFIG.committer.pipeline = 1;          // Decoders wait for the reader, so the writer decodes the batches by itself
+
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_ebus *ebus = test_tablespace_ebus_create();
+    mu_check(ebus);
+
+    mdv_tablespace *tablespace = test_tablespace_open(&uuid, ebus);
+    mu_check(tablespace);
+
+    test_tablespace_table a, b;
+
+    // Record 1 creates the table 'a' and records 2-21 are its rows
+    mu_check(test_tablespace_table_create(ebus, "a", &a));
+    mu_check(test_tablespace_rows_insert(ebus, &a, 0, 20, 16));
+
+    // Table 'b' is created in the third batch and its rows are inserted in the following batches
+    mu_check(test_tablespace_table_create(ebus, "b", &b));
+
+    for(uint32_t n = 0; n < 20; ++n)
+    {
+        mu_check(test_tablespace_rows_insert(ebus, &b, n, n + 1, 16));
+        mu_check(test_tablespace_rows_insert(ebus, &a, 20 + n, 21 + n, 16));
+    }
+
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+
+    mu_check(test_tablespace_rows_count(ebus, &a) == 40);
+    mu_check(test_tablespace_rows_count(ebus, &b) == 20);
+
+    // Writer doesn't wait for the reader job, so the reader is usually cancelled and the log is applied sequentially
+    MDV_CONFIG.committer.pipeline_wait = 0;
+
+    for(uint32_t n = 0; n < 5; ++n)
+    {
+        mu_check(test_tablespace_rows_insert(ebus, &a, 40 + n * 10, 50 + n * 10, 16));
+        mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+        mu_check(test_tablespace_rows_count(ebus, &a) == 50 + n * 10);
+    }
+
+    MDV_CONFIG.committer.pipeline_wait = config.committer.pipeline_wait;
+
+    // Nothing is changed
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+    mu_check(test_tablespace_rows_count(ebus, &a) == 90);
+    mu_check(test_tablespace_rows_count(ebus, &b) == 20);
+
+    mdv_tablespace_close(tablespace);
+    mdv_ebus_release(ebus);
+
+    // 2 tables, 90 rows of 'a' and 20 rows of 'b'. The last row of 'b' is the record 61.
+    mu_check(test_tablespace_applied_pos(&a, &uuid) == 112);
+    mu_check(test_tablespace_applied_pos(&b, &uuid) == 61);
+
+    mu_check(mdv_rmdir("./tablespace_test"));
+
+    MDV_CONFIG = config;
+}
+
+
+MU_TEST(core_tablespace_pipeline_commit_failure)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./tablespace_test");
+    MDV_CONFIG.storage.map_size = 1024 * 1024;
+    MDV_CONFIG.storage.map_grow = 1024 * 1024;
+    MDV_CONFIG.committer.batch_size = 16;
+    MDV_CONFIG.committer.partitions = 0;
+    MDV_CONFIG.committer.pipeline = 2;
+
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_ebus *ebus = test_tablespace_ebus_create();
+    mu_check(ebus);
+
+    mdv_tablespace *tablespace = test_tablespace_open(&uuid, ebus);
+    mu_check(tablespace);
+
+    test_tablespace_table table;
+
+    mu_check(test_tablespace_table_create(ebus, "big", &table));
+    mu_check(test_tablespace_rows_insert(ebus, &table, 0, 1000, 2048));
+
+    // Table storage can't grow, so the batches are committed until the map is full
+    MDV_CONFIG.storage.map_grow = 0;
+
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+
+    uint32_t const count = test_tablespace_rows_count(ebus, &table);
+    mu_check(count > 0 && count < 1000);
+
+    // Failed batch is applied again from the same position
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+    mu_check(test_tablespace_rows_count(ebus, &table) == count);
+
+    // Rows committed before the failure aren't duplicated
+    MDV_CONFIG.storage.map_grow = 1024 * 1024;
+
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+    mu_check(test_tablespace_rows_count(ebus, &table) == 1000);
+
+    mdv_tablespace_close(tablespace);
+    mdv_ebus_release(ebus);
+
+    mu_check(test_tablespace_applied_pos(&table, &uuid) == 1001);
+
+    mu_check(mdv_rmdir("./tablespace_test"));
+
+    MDV_CONFIG = config;
+}
+
+
+MU_TEST(core_tablespace_partitioned_commit)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./tablespace_test");
+    MDV_CONFIG.storage.map_size = 1024 * 1024;
+    MDV_CONFIG.storage.map_grow = 1024 * 1024;
+    MDV_CONFIG.committer.batch_size = 32;
+    MDV_CONFIG.committer.partitions = 2;
+    MDV_CONFIG.committer.pipeline = 0;
+
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_ebus *ebus = test_tablespace_ebus_create();
+    mu_check(ebus);
+
+    mdv_tablespace *tablespace = test_tablespace_open(&uuid, ebus);
+    mu_check(tablespace);
+
+    test_tablespace_table a, b, big;
+
+    mu_check(test_tablespace_table_create(ebus, "a", &a));
+    mu_check(test_tablespace_table_create(ebus, "b", &b));
+    mu_check(test_tablespace_table_create(ebus, "big", &big));
+
+    // Each batch contains the rows of three tables
+    for(uint32_t n = 0; n < 600; ++n)
+    {
+        mu_check(test_tablespace_rows_insert(ebus, &a, n, n + 1, 16));
+        mu_check(test_tablespace_rows_insert(ebus, &b, n, n + 1, 16));
+        mu_check(test_tablespace_rows_insert(ebus, &big, n, n + 1, 2048));
+    }
+
+    // Only the partition of the big table fails when its storage is full
+    MDV_CONFIG.storage.map_grow = 0;
+
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+
+    uint32_t const count_a = test_tablespace_rows_count(ebus, &a);
+    uint32_t const count_b = test_tablespace_rows_count(ebus, &b);
+    uint32_t const count_big = test_tablespace_rows_count(ebus, &big);
+
+    // Other partitions of the failed batch might be committed. Batch contains up to 11 rows of each table
+    // and the batch boundary might split the rows of three tables.
+    mu_check(count_big > 0 && count_big < 600);
+    mu_check(count_a >= count_big && count_a <= count_big + 12);
+    mu_check(count_b >= count_big && count_b <= count_big + 12);
+
+    // Failed batch is applied again from the same position. Partitions skipped after the failure might be committed now.
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+    mu_check(test_tablespace_rows_count(ebus, &big) == count_big);
+
+    uint32_t const retry_a = test_tablespace_rows_count(ebus, &a);
+    uint32_t const retry_b = test_tablespace_rows_count(ebus, &b);
+
+    mu_check(retry_a >= count_a && retry_a <= count_big + 12);
+    mu_check(retry_b >= count_b && retry_b <= count_big + 12);
+
+    // Rows of the committed partitions aren't duplicated
+    MDV_CONFIG.storage.map_grow = 1024 * 1024;
+
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+    mu_check(test_tablespace_rows_count(ebus, &a) == 600);
+    mu_check(test_tablespace_rows_count(ebus, &b) == 600);
+    mu_check(test_tablespace_rows_count(ebus, &big) == 600);
+
+    mdv_tablespace_close(tablespace);
+    mdv_ebus_release(ebus);
+
+    // Records 1-3 create the tables and the rows are inserted by the records 4-1803
+    mu_check(test_tablespace_applied_pos(&a, &uuid) == 1801);
+    mu_check(test_tablespace_applied_pos(&b, &uuid) == 1802);
+    mu_check(test_tablespace_applied_pos(&big, &uuid) == 1803);
+
+    mu_check(mdv_rmdir("./tablespace_test"));
+
+    MDV_CONFIG = config;
+}
+
+
+/**
+ * @brief Publishes the row insertion event for the packed row.
+ */
+static bool test_tablespace_row_publish(mdv_ebus *ebus, mdv_uuid const *table, mdv_data const *packed)
+{
+    mdv_evt_insert_row *evt = mdv_evt_insert_row_create(table, packed);
+
+    if (!evt)
+        return false;
+
+    bool const ret = mdv_ebus_publish(ebus, &evt->base, MDV_EVT_SYNC) == MDV_OK;
+
+    mdv_evt_insert_row_release(evt);
+
+    return ret;
+}
+
+
+MU_TEST(core_tablespace_invalid_rows)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.storage.path = mdv_str_static("./tablespace_test");
+    MDV_CONFIG.committer.batch_size = 8;
+    MDV_CONFIG.committer.partitions = 0;
+    MDV_CONFIG.committer.pipeline = 0;
+
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_ebus *ebus = test_tablespace_ebus_create();
+    mu_check(ebus);
+
+    mdv_tablespace *tablespace = test_tablespace_open(&uuid, ebus);
+    mu_check(tablespace);
+
+    test_tablespace_table a;
+
+    mu_check(test_tablespace_table_create(ebus, "a", &a));
+    mu_check(test_tablespace_rows_insert(ebus, &a, 0, 10, 16));
+
+    int32_t const i = 10;
+
+    mdv_row(2) row =
+    {
+        .size = 2,
+        .fields =
+        {
+            { sizeof i, (void*)&i },
+            { 5, "hello" }
+        }
+    };
+
+    mdv_row_codec *codec = mdv_row_codec_create(a.fields, a.size);
+    mu_check(codec);
+
+    mdv_data packed;
+
+    mu_check(mdv_row_codec_pack(codec, (mdv_row_base const *)&row, &packed));
+
+    mdv_row_codec_free(codec);
+
+    // Rows of unknown tables are rejected
+    mdv_uuid const unknown = mdv_uuid_generate();
+    mu_check(!test_tablespace_row_publish(ebus, &unknown, &packed));
+
+    // Truncated rows are rejected
+    mdv_data const truncated = { packed.size - 1, packed.ptr };
+    mu_check(!test_tablespace_row_publish(ebus, &a.id, &truncated));
+
+    // Empty single values are rejected. Null bitmap is placed after the header (4 bytes).
+    uint8_t *bitmap = (uint8_t *)packed.ptr + 4;
+    *bitmap |= 1u;
+    mu_check(!test_tablespace_row_publish(ebus, &a.id, &packed));
+    *bitmap &= ~1u;
+
+    mu_check(test_tablespace_row_publish(ebus, &a.id, &packed));
+
+    mdv_free(packed.ptr, "packed_row");
+
+    // Rejected rows aren't logged, so all logged rows are stored
+    mu_check(mdv_tablespace_log_apply(tablespace, &uuid));
+    mu_check(test_tablespace_rows_count(ebus, &a) == 11);
+
+    mdv_tablespace_close(tablespace);
+    mdv_ebus_release(ebus);
+
+    mu_check(test_tablespace_applied_pos(&a, &uuid) == 12);
+
+    mu_check(mdv_rmdir("./tablespace_test"));
+
+    MDV_CONFIG = config;
+}
@@ -0,0 +1,350 @@
+#pragma once
+#include "../minunit.h"
+#include <storage/mdv_trlog.h>
+#include <mdv_config.h>
+#include <mdv_filesystem.h>
+#include <mdv_threads.h>
+#include <stddef.h>
+#include <string.h>
+
+
+typedef struct
+{
+    size_t       count;
+    uint64_t     ids[4];
+    mdv_trlog_op *copy;
+} test_trlog_batch;
+
+
+static void test_trlog_batch_fn(void *arg, mdv_trlog_view const *ops, size_t count)
+{
+    test_trlog_batch *batch = arg;
+
+    batch->count = count;
+
+    for(size_t i = 0; i < count && i < 4; ++i)
+        batch->ids[i] = ops[i].id;
+
+    batch->copy = mdv_trlog_op_copy(ops[count - 1].op);
+}
+
+
+MU_TEST(core_trlog_read_batch)
+{
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_trlog *trlog = mdv_trlog_open(&uuid, "./trlog_test");
+    mu_check(trlog);
+
+    union
+    {
+        mdv_trlog_op op;
+        uint8_t      buf[64];
+    } data;
+
+    for(uint32_t i = 0; i < 3; ++i)
+    {
+        data.op.size = offsetof(mdv_trlog_op, payload) + sizeof i;
+        data.op.type = i;
+        memcpy(data.op.payload, &i, sizeof i);
+
+        uint64_t id = 0;
+        mu_check(mdv_trlog_add_op(trlog, &data.op, &id));
+        mu_check(id == i + 1);
+    }
+
+    test_trlog_batch batch = {};
+
+    mu_check(mdv_trlog_read_batch(trlog, 2, 4, &batch, test_trlog_batch_fn) == 2);
+    mu_check(batch.count == 2);
+    mu_check(batch.ids[0] == 2 && batch.ids[1] == 3);
+
+    mu_check(batch.copy);
+    mu_check(batch.copy->type == 2);
+    mu_check(memcmp(batch.copy, &data.op, data.op.size) == 0);
+
+    mdv_trlog_op_free(batch.copy);
+
+    mu_check(mdv_trlog_release(trlog) == 0);
+
+    mu_check(mdv_rmdir("./trlog_test"));
+}
+
+
+enum { TEST_TRLOG_THREADS = 4, TEST_TRLOG_OPS = 64 };
+
+
+typedef struct
+{
+    mdv_trlog  *trlog;
+    uint64_t    ids[TEST_TRLOG_OPS];
+    bool        ok;
+} test_trlog_writer;
+
+
+static void * test_trlog_writer_fn(void *arg)
+{
+    test_trlog_writer *writer = arg;
+
+    union
+    {
+        mdv_trlog_op op;
+        uint8_t      buf[64];
+    } data;
+
+    writer->ok = true;
+
+    for(uint32_t i = 0; i < TEST_TRLOG_OPS; ++i)
+    {
+        data.op.size = offsetof(mdv_trlog_op, payload) + sizeof i;
+        data.op.type = i;
+        memcpy(data.op.payload, &i, sizeof i);
+
+        if (!mdv_trlog_add_op(writer->trlog, &data.op, writer->ids + i))
+            writer->ok = false;
+    }
+
+    return 0;
+}
+
+
+MU_TEST(core_trlog_group_commit)
+{
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_trlog *trlog = mdv_trlog_open(&uuid, "./trlog_test");
+    mu_check(trlog);
+
+    static test_trlog_writer writers[TEST_TRLOG_THREADS];
+    mdv_thread threads[TEST_TRLOG_THREADS];
+
+    mdv_thread_attrs const attrs = { .stack_size = MDV_THREAD_STACK_SIZE };
+
+    for(size_t i = 0; i < TEST_TRLOG_THREADS; ++i)
+    {
+        writers[i].trlog = trlog;
+        mu_check(mdv_thread_create(threads + i, &attrs, test_trlog_writer_fn, writers + i) == MDV_OK);
+    }
+
+    for(size_t i = 0; i < TEST_TRLOG_THREADS; ++i)
+        mu_check(mdv_thread_join(threads[i]) == MDV_OK);
+
+    static bool used[TEST_TRLOG_THREADS * TEST_TRLOG_OPS + 1];
+
+    bool unique = true;
+
+    for(size_t i = 0; i < TEST_TRLOG_THREADS; ++i)
+    {
+        mu_check(writers[i].ok);
+
+        for(size_t j = 0; j < TEST_TRLOG_OPS; ++j)
+        {
+            uint64_t const id = writers[i].ids[j];
+
+            if (!id || id > TEST_TRLOG_THREADS * TEST_TRLOG_OPS || used[id])
+                unique = false;
+            else
+                used[id] = true;
+
+            // Each writer gets increasing identifiers
+            if (j && writers[i].ids[j - 1] >= id)
+                unique = false;
+        }
+    }
+
+    mu_check(unique);
+
+    test_trlog_batch batch = {};
+
+    mu_check(mdv_trlog_read_batch(trlog, 1, TEST_TRLOG_THREADS * TEST_TRLOG_OPS, &batch, test_trlog_batch_fn) == TEST_TRLOG_THREADS * TEST_TRLOG_OPS);
+    mdv_trlog_op_free(batch.copy);
+
+    mu_check(mdv_trlog_release(trlog) == 0);
+
+    mu_check(mdv_rmdir("./trlog_test"));
+}
+
+
+static bool test_trlog_apply_fn(void *arg, uint64_t id, mdv_trlog_op const *op)
+{
+    (void)id;
+    (void)op;
+    ++*(size_t*)arg;
+    return true;
+}
+
+
+static bool test_trlog_commit_fn(void *arg)
+{
+    (void)arg;
+    return true;
+}
+
+
+typedef struct
+{
+    bool    ok;
+    size_t  calls;
+} test_trlog_flush;
+
+
+static bool test_trlog_flush_fn(void *arg)
+{
+    test_trlog_flush *flush = arg;
+    ++flush->calls;
+    return flush->ok;
+}
+
+
+MU_TEST(core_trlog_checkpoint)
+{
+    mdv_uuid const uuid = mdv_uuid_generate();
+    mdv_uuid const peer = mdv_uuid_generate();
+
+    mdv_trlog *trlog = mdv_trlog_open(&uuid, "./trlog_test");
+    mu_check(trlog);
+
+    union
+    {
+        mdv_trlog_op op;
+        uint8_t      buf[64];
+    } data;
+
+    for(uint32_t i = 0; i < 10; ++i)
+    {
+        data.op.size = offsetof(mdv_trlog_op, payload) + sizeof i;
+        data.op.type = i;
+        memcpy(data.op.payload, &i, sizeof i);
+        mu_check(mdv_trlog_add_op(trlog, &data.op, 0));
+    }
+
+    size_t applied = 0;
+
+    mdv_trlog_applier const applier =
+    {
+        .arg = &applied,
+        .apply = test_trlog_apply_fn,
+        .commit = test_trlog_commit_fn
+    };
+
+    mu_check(mdv_trlog_apply(trlog, 16, &applier) == 10);
+    mu_check(applied == 10);
+
+    // Peer hasn't acknowledged any position
+    mu_check(!mdv_trlog_checkpoint_due(trlog, 1, 4));
+    mu_check(mdv_trlog_checkpoint(trlog, 1, 4, 0, 0) == 0);
+
+    // Nothing is deleted if the applied data isn't flushed
+    test_trlog_flush flush = { .ok = false };
+
+    mu_check(mdv_trlog_ack(trlog, &peer, 6));
+
+    // Checkpoint is scheduled once until it is performed
+    mu_check(mdv_trlog_checkpoint_due(trlog, 1, 4));
+    mu_check(!mdv_trlog_checkpoint_due(trlog, 1, 4));
+
+    mu_check(mdv_trlog_checkpoint(trlog, 1, 4, &flush, test_trlog_flush_fn) == 0);
+    mu_check(flush.calls == 1);
+
+    flush.ok = true;
+    mu_check(mdv_trlog_checkpoint_due(trlog, 1, 4));
+    mu_check(mdv_trlog_checkpoint(trlog, 1, 4, &flush, test_trlog_flush_fn) == 4);
+    mu_check(flush.calls == 2);
+
+    // Flush isn't required if there is nothing to delete
+    mu_check(mdv_trlog_checkpoint(trlog, 1, 4, &flush, test_trlog_flush_fn) == 4);
+    mu_check(flush.calls == 2);
+    mu_check(!mdv_trlog_checkpoint_due(trlog, 1, 4));
+
+    mu_check(mdv_trlog_ack(trlog, &peer, 10));
+    mu_check(mdv_trlog_checkpoint(trlog, 1, 4, 0, 0) == 8);
+    mu_check(mdv_trlog_low_water(trlog) == 8);
+
+    test_trlog_batch batch = {};
+
+    mu_check(mdv_trlog_read_batch(trlog, 1, 10, &batch, test_trlog_batch_fn) == 2);
+    mu_check(batch.ids[0] == 9 && batch.ids[1] == 10);
+    mdv_trlog_op_free(batch.copy);
+
+    mu_check(mdv_trlog_release(trlog) == 0);
+
+    // Low-water mark and applied position are restored after reopening
+    trlog = mdv_trlog_open(&uuid, "./trlog_test");
+    mu_check(trlog);
+
+    mu_check(mdv_trlog_low_water(trlog) == 8);
+    mu_check(mdv_trlog_applied_pos(trlog) == 10);
+
+    mu_check(mdv_trlog_release(trlog) == 0);
+
+    mu_check(mdv_rmdir("./trlog_test"));
+}
+
+
+MU_TEST(core_trlog_compression)
+{
+    mdv_config const config = MDV_CONFIG;
+
+    MDV_CONFIG.trlog.compression = 64;
+
+    mdv_uuid const uuid = mdv_uuid_generate();
+
+    mdv_trlog *trlog = mdv_trlog_open(&uuid, "./trlog_test");
+    mu_check(trlog);
+
+    union
+    {
+        mdv_trlog_op op;
+        uint8_t      buf[1024];
+    } data;
+
+    // Small operation is stored as is, large one is compressed
+    data.op.size = offsetof(mdv_trlog_op, payload) + 16;
+    data.op.type = 1;
+    memset(data.op.payload, 'a', 16);
+    mu_check(mdv_trlog_add_op(trlog, &data.op, 0));
+
+    data.op.size = sizeof data.buf;
+    data.op.type = 2;
+
+    for(size_t i = 0; i < sizeof data.buf - offsetof(mdv_trlog_op, payload); ++i)
+        data.op.payload[i] = "trlog"[i % 5];
+
+    mu_check(mdv_trlog_add_op(trlog, &data.op, 0));
+
+    test_trlog_batch batch = {};
+
+    mu_check(mdv_trlog_read_batch(trlog, 1, 4, &batch, test_trlog_batch_fn) == 2);
+
+    mu_check(batch.copy);
+    mu_check(batch.copy->size == data.op.size);
+    mu_check(batch.copy->type == 2);
+    mu_check(memcmp(batch.copy, &data.op, data.op.size) == 0);
+
+    mdv_trlog_op_free(batch.copy);
+
+    // Peer operations with the compressed record flag are rejected
+    mdv_trlog_data peer_op =
+    {
+        .id = 3,
+        .op =
+        {
+            .size = offsetof(mdv_trlog_op, payload) + 1,
+            .type = 3u | (1u << 31)
+        }
+    };
+
+    mdv_list peer_ops = {};
+    mu_check(mdv_list_push_back_ptr(&peer_ops, &peer_op, sizeof peer_op));
+    mu_check(mdv_trlog_add(trlog, &peer_ops));
+    mdv_list_clear(&peer_ops);
+
+    mu_check(mdv_trlog_read_batch(trlog, 1, 4, &batch, test_trlog_batch_fn) == 2);
+    mdv_trlog_op_free(batch.copy);
+
+    mu_check(mdv_trlog_release(trlog) == 0);
+
+    mu_check(mdv_rmdir("./trlog_test"));
+
+    MDV_CONFIG = config;
+}
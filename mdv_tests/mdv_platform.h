@@ -22,6 +22,7 @@
 #include "mdv_platform/mdv_router.h"
 #include "mdv_platform/mdv_mst.h"
 #include "mdv_platform/mdv_bitset.h"
+#include "mdv_platform/mdv_lz.h"
 
 
 MU_TEST_SUITE(platform)
@@ -35,7 +36,9 @@ MU_TEST_SUITE(platform)
     MU_RUN_TEST(platform_list);
     MU_RUN_TEST(platform_string);
     MU_RUN_TEST(platform_bloom);
+    MU_RUN_TEST(platform_bloom_serialize);
     MU_RUN_TEST(platform_bitset);
+    MU_RUN_TEST(platform_lz);
     MU_RUN_TEST(platform_socket);
     MU_RUN_TEST(platform_eventfd);
     MU_RUN_TEST(platform_condvar);
@@ -19,5 +19,26 @@ MU_TEST(platform_bitset)
     mdv_bitset_reset(bitset, 15);
     mu_check(!mdv_bitset_test(bitset, 15));
 
+    mu_check(mdv_bitset_count(bitset) == 2);
+
+    mdv_bitset *other = mdv_bitset_create(33, &mdv_stallocator);
+
+    mdv_bitset_fill(other, true);
+    mu_check(mdv_bitset_count(other) == 33);
+    mu_check(mdv_bitset_data(other)[1] == 1);
+
+    mdv_bitset_reset(other, 0);
+    mdv_bitset_and(other, bitset);
+    mu_check(mdv_bitset_count(other) == 1 && mdv_bitset_test(other, 32));
+
+    mdv_bitset_set(other, 7);
+    mdv_bitset_or(bitset, other);
+    mu_check(mdv_bitset_count(bitset) == 3 && mdv_bitset_test(bitset, 7));
+
+    mdv_bitset_invert(bitset);
+    mu_check(mdv_bitset_count(bitset) == 30);
+    mu_check(!mdv_bitset_test(bitset, 0) && !mdv_bitset_test(bitset, 32) && mdv_bitset_test(bitset, 1));
+
+    mdv_bitset_free(other);
     mdv_bitset_free(bitset);
 }
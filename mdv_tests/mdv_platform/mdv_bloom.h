@@ -21,4 +21,62 @@ MU_TEST(platform_bloom)
     mu_check(!mdv_bloom_contains(bloom, "1234567894", 10));
 
     mdv_bloom_free(bloom);
+
+    // Probability is clamped, so the bits count is finite
+    bloom = mdv_bloom_create(10, 0.0);
+    mu_check(bloom);
+    mu_check(mdv_bloom_insert(bloom, "1234567890", 10));
+    mu_check(mdv_bloom_contains(bloom, "1234567890", 10));
+    mdv_bloom_free(bloom);
+
+    bloom = mdv_bloom_create(10, 2.0);
+    mu_check(bloom);
+    mu_check(mdv_bloom_insert(bloom, "1234567890", 10));
+    mu_check(mdv_bloom_contains(bloom, "1234567890", 10));
+    mdv_bloom_free(bloom);
+}
+
+
+MU_TEST(platform_bloom_serialize)
+{
+    mdv_bloom *bloom = mdv_bloom_create(100, 0.01);
+
+    char key[] = "key_00";
+
+    for(int i = 0; i < 50; ++i)
+    {
+        key[4] = '0' + i / 10;
+        key[5] = '0' + i % 10;
+        mdv_bloom_insert(bloom, key, sizeof key);
+    }
+
+    size_t const size = mdv_bloom_serialized_size(bloom);
+
+    char buf[size];
+    mdv_bloom_serialize(bloom, buf);
+
+    mdv_bloom *copy = mdv_bloom_deserialize(buf, size);
+    mu_check(copy);
+    mu_check(mdv_bloom_size(copy) == mdv_bloom_size(bloom));
+    mu_check(mdv_bloom_capacity(copy) == 100);
+
+    int false_positives = 0;
+
+    for(int i = 0; i < 100; ++i)
+    {
+        key[4] = '0' + i / 10;
+        key[5] = '0' + i % 10;
+
+        if (i < 50)
+            mu_check(mdv_bloom_contains(copy, key, sizeof key));
+        else if (mdv_bloom_contains(copy, key, sizeof key))
+            ++false_positives;
+    }
+
+    mu_check(false_positives < 5);
+
+    mu_check(!mdv_bloom_deserialize(buf, size - 1));
+
+    mdv_bloom_free(copy);
+    mdv_bloom_free(bloom);
 }
@@ -0,0 +1,54 @@
+#pragma once
+#include "../minunit.h"
+#include <mdv_lz.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+MU_TEST(platform_lz)
+{
+    enum { SIZE = 4096 };
+
+    static uint8_t data[SIZE];
+    static uint8_t packed[SIZE + SIZE / 255 + 16];
+    static uint8_t unpacked[SIZE];
+
+    mu_check(mdv_lz_bound(SIZE) <= sizeof packed);
+
+    // Compressible data
+    for(size_t i = 0; i < SIZE; ++i)
+        data[i] = "Medved DB row "[i % 14] + (uint8_t)(i / 512);
+
+    size_t size = mdv_lz_compress(data, SIZE, packed, sizeof packed);
+    mu_check(size && size < SIZE / 4);
+    mu_check(mdv_lz_decompress(packed, size, unpacked, sizeof unpacked) == SIZE);
+    mu_check(memcmp(data, unpacked, SIZE) == 0);
+
+    // Truncated and corrupted blocks are rejected
+    mu_check(mdv_lz_decompress(packed, size - 1, unpacked, sizeof unpacked) != SIZE);
+    mu_check(mdv_lz_decompress(packed, size, unpacked, SIZE - 1) == 0);
+    packed[1] ^= 0xFF;
+    packed[2] ^= 0xFF;
+    mu_check(mdv_lz_decompress(packed, size, unpacked, sizeof unpacked) != SIZE
+             || memcmp(data, unpacked, SIZE) != 0);
+
+    // Buffer is too small
+    mu_check(mdv_lz_compress(data, SIZE, packed, 16) == 0);
+
+    // Incompressible data
+    srand(42);
+
+    for(size_t i = 0; i < SIZE; ++i)
+        data[i] = (uint8_t)rand();
+
+    size = mdv_lz_compress(data, SIZE, packed, sizeof packed);
+    mu_check(size >= SIZE && size <= mdv_lz_bound(SIZE));
+    mu_check(mdv_lz_decompress(packed, size, unpacked, sizeof unpacked) == SIZE);
+    mu_check(memcmp(data, unpacked, SIZE) == 0);
+
+    // Short data
+    size = mdv_lz_compress("abc", 3, packed, sizeof packed);
+    mu_check(size == 4);
+    mu_check(mdv_lz_decompress(packed, size, unpacked, sizeof unpacked) == 3);
+    mu_check(memcmp(unpacked, "abc", 3) == 0);
+}
@@ -0,0 +1,456 @@
+#include "mdv_packed_row.h"
+#include <mdv_alloc.h>
+#include <mdv_log.h>
+#include <stddef.h>
+#include <string.h>
+
+
+/// Packed row header
+typedef struct
+{
+    uint32_t count;     ///< Number of fields
+} mdv_packed_row_hdr;
+
+
+typedef struct mdv_row_codec_step mdv_row_codec_step;
+
+
+/// Adds the field size to the packed row size. Returns false if the field doesn't match the field description.
+typedef bool (*mdv_row_codec_measure_fn)(mdv_row_codec_step const *step, mdv_data const *field, uint32_t *size);
+
+/// Writes the field into the packed row. Arrays data end is updated.
+typedef void (*mdv_row_codec_encode_fn)(mdv_row_codec_step const *step, mdv_data const *field, uint8_t *buf, uint32_t *data);
+
+/// Reads the field from the packed row. Returns false if the packed row is invalid.
+typedef bool (*mdv_row_codec_decode_fn)(mdv_row_codec_step const *step, uint8_t const *buf, uint32_t size, uint32_t *data, mdv_data *field);
+
+
+/// Compiled field codec
+struct mdv_row_codec_step
+{
+    mdv_row_codec_measure_fn    measure;    ///< Field size calculation
+    mdv_row_codec_encode_fn     encode;     ///< Field encoder
+    mdv_row_codec_decode_fn     decode;     ///< Field decoder
+    uint32_t                    idx;        ///< Field index
+    uint32_t                    offset;     ///< Single value position or array end position in offsets table
+    uint32_t                    start;      ///< Previous array end position in offsets table (0 - array is the first one)
+    uint32_t                    limit;      ///< Maximum array size in bytes (0 - unlimited)
+};
+
+
+/// Compiled row codec
+struct mdv_row_codec
+{
+    uint32_t                    count;      ///< Number of fields
+    uint32_t                    data;       ///< Arrays data position
+    mdv_row_codec_step          steps[1];   ///< Fields codecs
+};
+
+
+static uint32_t mdv_packed_row_align(uint32_t offset, uint32_t alignment)
+{
+    return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+
+static void mdv_packed_row_empty_set(uint8_t *packed, uint32_t idx)
+{
+    uint8_t *bitmap = packed + sizeof(mdv_packed_row_hdr);
+    bitmap[idx / 8] |= 1u << (idx % 8);
+}
+
+
+static bool mdv_packed_row_empty(uint8_t const *packed, uint32_t idx)
+{
+    uint8_t const *bitmap = packed + sizeof(mdv_packed_row_hdr);
+    return (bitmap[idx / 8] & (1u << (idx % 8))) != 0;
+}
+
+
+static uint32_t mdv_packed_row_end(uint8_t const *packed, uint32_t offset)
+{
+    uint32_t end;
+    memcpy(&end, packed + offset, sizeof end);
+    return end;
+}
+
+
+/*
+ * Single value kernels
+ */
+#define MDV_CODEC_SINGLE(N)                                                                     \
+    static bool mdv_codec_single_measure_##N(mdv_row_codec_step const *step,                   \
+                                             mdv_data const *field, uint32_t *size)             \
+    {                                                                                           \
+        (void)step; (void)size;                                                                 \
+        return field->size == N;                                                                \
+    }                                                                                           \
+                                                                                                \
+    static void mdv_codec_single_encode_##N(mdv_row_codec_step const *step,                    \
+                                            mdv_data const *field, uint8_t *buf, uint32_t *data)\
+    {                                                                                           \
+        (void)data;                                                                             \
+        memcpy(buf + step->offset, field->ptr, N);                                              \
+    }                                                                                           \
+                                                                                                \
+    static bool mdv_codec_single_decode_##N(mdv_row_codec_step const *step, uint8_t const *buf, \
+                                            uint32_t size, uint32_t *data, mdv_data *field)     \
+    {                                                                                           \
+        (void)size; (void)data;                                                                 \
+        if (mdv_packed_row_empty(buf, step->idx))                                               \
+            return false;                                                                       \
+        field->size = N;                                                                        \
+        field->ptr = (void *)(buf + step->offset);                                              \
+        return true;                                                                            \
+    }
+
+
+/*
+ * Array kernels
+ */
+#define MDV_CODEC_ARRAY(N)                                                                      \
+    static bool mdv_codec_array_measure_##N(mdv_row_codec_step const *step,                    \
+                                            mdv_data const *field, uint32_t *size)              \
+    {                                                                                           \
+        if (field->size % N || (step->limit && field->size > step->limit))                     \
+            return false;                                                                       \
+        *size = mdv_packed_row_align(*size, N) + field->size;                                   \
+        return true;                                                                            \
+    }                                                                                           \
+                                                                                                \
+    static void mdv_codec_array_encode_##N(mdv_row_codec_step const *step,                     \
+                                           mdv_data const *field, uint8_t *buf, uint32_t *data) \
+    {                                                                                           \
+        uint32_t const offset = mdv_packed_row_align(*data, N);                                 \
+        memset(buf + *data, 0, offset - *data);                                                 \
+        if (field->size)                                                                        \
+            memcpy(buf + offset, field->ptr, field->size);                                      \
+        else                                                                                    \
+            mdv_packed_row_empty_set(buf, step->idx);                                           \
+        *data = offset + field->size;                                                           \
+        memcpy(buf + step->offset, data, sizeof *data);                                         \
+    }                                                                                           \
+                                                                                                \
+    static bool mdv_codec_array_decode_##N(mdv_row_codec_step const *step, uint8_t const *buf,  \
+                                           uint32_t size, uint32_t *data, mdv_data *field)      \
+    {                                                                                           \
+        uint32_t const offset = mdv_packed_row_align(*data, N);                                 \
+        uint32_t const end = mdv_packed_row_end(buf, step->offset);                             \
+        if (end < offset                                                                        \
+            || end > size                                                                       \
+            || (end - offset) % N                                                               \
+            || (step->limit && end - offset > step->limit)                                      \
+            || (end != offset && mdv_packed_row_empty(buf, step->idx)))                         \
+            return false;                                                                       \
+        field->size = end - offset;                                                             \
+        field->ptr = end != offset ? (void *)(buf + offset) : 0;                                \
+        *data = end;                                                                            \
+        return true;                                                                            \
+    }
+
+
+#define MDV_CODEC_KERNELS(N)                                                                    \
+    MDV_CODEC_SINGLE(N)                                                                         \
+    MDV_CODEC_ARRAY(N)
+
+MDV_CODEC_KERNELS(1)
+MDV_CODEC_KERNELS(2)
+MDV_CODEC_KERNELS(4)
+MDV_CODEC_KERNELS(8)
+
+#undef MDV_CODEC_KERNELS
+#undef MDV_CODEC_ARRAY
+#undef MDV_CODEC_SINGLE
+
+
+/// Field kernels
+typedef struct
+{
+    mdv_row_codec_measure_fn    measure;
+    mdv_row_codec_encode_fn     encode;
+    mdv_row_codec_decode_fn     decode;
+} mdv_row_codec_kernels;
+
+
+#define MDV_CODEC_KERNELS_ENTRY(kind, N)                                                        \
+    { mdv_codec_##kind##_measure_##N, mdv_codec_##kind##_encode_##N, mdv_codec_##kind##_decode_##N }
+
+
+/**
+ * @brief Returns the kernels for the field. Types with the same size share the kernels.
+ */
+static mdv_row_codec_kernels const * mdv_row_codec_kernels_get(mdv_field const *field)
+{
+    static mdv_row_codec_kernels const kernels[2][4] =
+    {
+        {
+            MDV_CODEC_KERNELS_ENTRY(array, 1),
+            MDV_CODEC_KERNELS_ENTRY(array, 2),
+            MDV_CODEC_KERNELS_ENTRY(array, 4),
+            MDV_CODEC_KERNELS_ENTRY(array, 8)
+        },
+        {
+            MDV_CODEC_KERNELS_ENTRY(single, 1),
+            MDV_CODEC_KERNELS_ENTRY(single, 2),
+            MDV_CODEC_KERNELS_ENTRY(single, 4),
+            MDV_CODEC_KERNELS_ENTRY(single, 8)
+        }
+    };
+
+    bool const single = field->limit == 1;
+
+    switch(mdv_field_type_size(field->type))
+    {
+        case 1: return &kernels[single][0];
+        case 2: return &kernels[single][1];
+        case 4: return &kernels[single][2];
+        case 8: return &kernels[single][3];
+    }
+
+    return 0;
+}
+
+#undef MDV_CODEC_KERNELS_ENTRY
+
+
+mdv_row_codec * mdv_row_codec_create(mdv_field const *fields, uint32_t count)
+{
+    mdv_row_codec *codec = mdv_alloc(offsetof(mdv_row_codec, steps) + (count ? count : 1) * sizeof(mdv_row_codec_step),
+                                     "row_codec");
+
+    if (!codec)
+    {
+        MDV_LOGE("No memory for row codec");
+        return 0;
+    }
+
+    codec->count = count;
+
+    uint32_t fixed = sizeof(mdv_packed_row_hdr) + (count + 7) / 8;
+    uint32_t arrays = 0;
+
+    // Single values positions and arrays indices
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        mdv_row_codec_kernels const *kernels = mdv_row_codec_kernels_get(fields + i);
+
+        if (!kernels)
+        {
+            MDV_LOGE("Row codec wasn't created. Invalid field type.");
+            mdv_free(codec, "row_codec");
+            return 0;
+        }
+
+        uint32_t const type_size = mdv_field_type_size(fields[i].type);
+
+        mdv_row_codec_step *step = codec->steps + i;
+
+        step->measure = kernels->measure;
+        step->encode = kernels->encode;
+        step->decode = kernels->decode;
+        step->idx = i;
+        step->start = 0;
+        step->limit = fields[i].limit * type_size;
+
+        if (fields[i].limit == 1)
+        {
+            fixed = mdv_packed_row_align(fixed, type_size);
+            step->offset = fixed;
+            fixed += type_size;
+        }
+        else
+            step->offset = arrays++;
+    }
+
+    // Arrays ends positions in offsets table
+    uint32_t const offsets = mdv_packed_row_align(fixed, sizeof(uint32_t));
+    uint32_t start = 0;
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        mdv_row_codec_step *step = codec->steps + i;
+
+        if (fields[i].limit != 1)
+        {
+            step->offset = offsets + step->offset * sizeof(uint32_t);
+            step->start = start;
+            start = step->offset;
+        }
+    }
+
+    codec->data = offsets + arrays * sizeof(uint32_t);
+
+    return codec;
+}
+
+
+void mdv_row_codec_free(mdv_row_codec *codec)
+{
+    mdv_free(codec, "row_codec");
+}
+
+
+uint32_t mdv_row_codec_fields_count(mdv_row_codec const *codec)
+{
+    return codec->count;
+}
+
+
+uint32_t mdv_row_codec_packed_size(mdv_row_codec const *codec, mdv_row_base const *row)
+{
+    if (row->size != codec->count)
+    {
+        MDV_LOGE("Row packing failed. Invalid fields count.");
+        return 0;
+    }
+
+    uint32_t size = codec->data;
+
+    for(uint32_t i = 0; i < codec->count; ++i)
+    {
+        mdv_row_codec_step const *step = codec->steps + i;
+
+        if (!step->measure(step, row->fields + i, &size))
+        {
+            MDV_LOGE("Row packing failed. Invalid field size.");
+            return 0;
+        }
+    }
+
+    return size;
+}
+
+
+bool mdv_row_codec_pack_to(mdv_row_codec const *codec, mdv_row_base const *row, void *buf, uint32_t size)
+{
+    if (row->size != codec->count || size < codec->data)
+        return false;
+
+    uint8_t *packed = buf;
+
+    memset(packed, 0, codec->data);
+
+    mdv_packed_row_hdr *hdr = buf;
+
+    hdr->count = row->size;
+
+    uint32_t data = codec->data;
+
+    for(uint32_t i = 0; i < codec->count; ++i)
+    {
+        mdv_row_codec_step const *step = codec->steps + i;
+        step->encode(step, row->fields + i, packed, &data);
+    }
+
+    return data == size;
+}
+
+
+bool mdv_row_codec_pack(mdv_row_codec const *codec, mdv_row_base const *row, mdv_data *packed)
+{
+    uint32_t const size = mdv_row_codec_packed_size(codec, row);
+
+    if (!size)
+        return false;
+
+    void *buf = mdv_alloc(size, "packed_row");
+
+    if (!buf)
+    {
+        MDV_LOGE("No memory for packed row");
+        return false;
+    }
+
+    if (!mdv_row_codec_pack_to(codec, row, buf, size))
+    {
+        MDV_LOGE("Row packing failed");
+        mdv_free(buf, "packed_row");
+        return false;
+    }
+
+    packed->size = size;
+    packed->ptr = buf;
+
+    return true;
+}
+
+
+/**
+ * @brief Decodes and checks the packed row fields.
+ * @details Fields values point into the packed row. If stride is zero, all fields are decoded into the same value.
+ */
+static bool mdv_row_codec_decode(mdv_row_codec const *codec, mdv_data const *packed, mdv_data *fields, uint32_t stride)
+{
+    if (packed->size < codec->data)
+        return false;
+
+    uint8_t const *buf = packed->ptr;
+
+    if (((mdv_packed_row_hdr const *)buf)->count != codec->count)
+        return false;
+
+    uint32_t data = codec->data;
+
+    for(uint32_t i = 0; i < codec->count; ++i, fields += stride)
+    {
+        mdv_row_codec_step const *step = codec->steps + i;
+
+        if (!step->decode(step, buf, packed->size, &data, fields))
+            return false;
+    }
+
+    return data == packed->size;
+}
+
+
+bool mdv_row_codec_check(mdv_row_codec const *codec, mdv_data const *packed)
+{
+    mdv_data field;
+    return mdv_row_codec_decode(codec, packed, &field, 0);
+}
+
+
+bool mdv_row_codec_field(mdv_row_codec const *codec, void const *packed, uint32_t idx, mdv_data *value)
+{
+    if (idx >= codec->count)
+        return false;
+
+    mdv_row_codec_step const *step = codec->steps + idx;
+
+    // Array starts at the previous array end
+    uint32_t data = step->start ? mdv_packed_row_end(packed, step->start) : codec->data;
+
+    return step->decode(step, packed, UINT32_MAX, &data, value);
+}
+
+
+mdv_row_base * mdv_row_codec_unpack(mdv_row_codec const *codec, mdv_data const *packed)
+{
+    uint32_t const header_size = mdv_packed_row_align(offsetof(mdv_row_base, fields) + codec->count * sizeof(mdv_data), 8);
+
+    mdv_row_base *row = mdv_alloc(header_size + packed->size, "row");
+
+    if (!row)
+    {
+        MDV_LOGE("No memory for row");
+        return 0;
+    }
+
+    // Packed row is copied, so the values are aligned
+    uint8_t *buf = (uint8_t *)row + header_size;
+
+    memcpy(buf, packed->ptr, packed->size);
+
+    mdv_data const copy = { packed->size, buf };
+
+    if (!mdv_row_codec_decode(codec, &copy, row->fields, 1))
+    {
+        MDV_LOGE("Invalid packed row");
+        mdv_free(row, "row");
+        return 0;
+    }
+
+    row->size = codec->count;
+
+    return row;
+}
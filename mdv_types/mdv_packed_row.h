@@ -0,0 +1,132 @@
+/**
+ * @file mdv_packed_row.h
+ * @brief Compact binary row format.
+ * @details Packed row layout (offsets are relative to the row start, values are in the host byte order):
+ *
+ *          | Section       | Size                          | Description                                       |
+ *          |---------------|-------------------------------|---------------------------------------------------|
+ *          | Header        | 4                             | Fields count (uint32)                             |
+ *          | Null bitmap   | (count + 7) / 8               | Bit is set for the empty arrays                   |
+ *          | Fixed section | depends on the fields types   | Single values (limit = 1) in the fields order     |
+ *          | Offsets table | 4 * number of arrays          | End offset (uint32) of each array field           |
+ *          | Arrays data   | depends on the arrays sizes   | Array fields items                                |
+ *
+ *          Fixed section layout depends only on the table fields, so the values are read in place
+ *          without decoding the whole row. Each value and array is aligned by the field type size,
+ *          so the array starts at the previous array end aligned by its type size.
+ *          Single values can't be empty, because the column segments store them without null markers.
+ *          Such rows aren't packed and are rejected by the decoding.
+ */
+#pragma once
+#include "mdv_types.h"
+#include <stdbool.h>
+
+
+/// Row codec compiled for the table fields
+typedef struct mdv_row_codec mdv_row_codec;
+
+
+/**
+ * @brief Compiles the row codec for the given fields.
+ * @details Fields positions are calculated once and each field gets the specialized
+ *          copy kernels for its type size, so packing and unpacking don't dispatch on the field types.
+ *          Codec is immutable and can be shared between threads.
+ *
+ * @param fields [in]   Table fields
+ * @param count [in]    Number of fields
+ *
+ * @return On success, returns new codec which should be freed by mdv_row_codec_free()
+ * @return On error (e.g. invalid field type), returns NULL
+ */
+mdv_row_codec * mdv_row_codec_create(mdv_field const *fields, uint32_t count);
+
+
+/**
+ * @brief Frees the row codec.
+ */
+void mdv_row_codec_free(mdv_row_codec *codec);
+
+
+/**
+ * @brief Returns the number of fields.
+ */
+uint32_t mdv_row_codec_fields_count(mdv_row_codec const *codec);
+
+
+/**
+ * @brief Returns the packed row size.
+ *
+ * @param codec [in]    Row codec
+ * @param row [in]      Row
+ *
+ * @return On success, returns nonzero packed row size
+ * @return On error (e.g. the row doesn't match the fields), returns zero
+ */
+uint32_t mdv_row_codec_packed_size(mdv_row_codec const *codec, mdv_row_base const *row);
+
+
+/**
+ * @brief Packs the row into the given buffer.
+ *
+ * @param codec [in]    Row codec
+ * @param row [in]      Row
+ * @param buf [out]     Buffer for the packed row. It should be aligned by 8 bytes.
+ * @param size [in]     Buffer size. It should be equal to mdv_row_codec_packed_size().
+ *
+ * @return true if the row was successfully packed
+ */
+bool mdv_row_codec_pack_to(mdv_row_codec const *codec, mdv_row_base const *row, void *buf, uint32_t size);
+
+
+/**
+ * @brief Packs the row.
+ * @details Packed row should be freed by mdv_free(packed->ptr, "packed_row").
+ *
+ * @param codec [in]    Row codec
+ * @param row [in]      Row
+ * @param packed [out]  Packed row
+ *
+ * @return true if the row was successfully packed
+ */
+bool mdv_row_codec_pack(mdv_row_codec const *codec, mdv_row_base const *row, mdv_data *packed);
+
+
+/**
+ * @brief Checks the packed row received from the untrusted source.
+ * @details Packed row should be aligned by 8 bytes.
+ *
+ * @param codec [in]    Row codec
+ * @param packed [in]   Packed row
+ *
+ * @return true if the packed row matches the codec fields
+ */
+bool mdv_row_codec_check(mdv_row_codec const *codec, mdv_data const *packed);
+
+
+/**
+ * @brief Reads the field value in place.
+ * @details Packed row should be checked by mdv_row_codec_check().
+ *          Field position is taken from the codec, so the other fields aren't visited.
+ *
+ * @param codec [in]    Row codec
+ * @param packed [in]   Packed row
+ * @param idx [in]      Field index
+ * @param value [out]   Field value. It points into the packed row. Empty fields have zero size.
+ *
+ * @return true if the field exists
+ */
+bool mdv_row_codec_field(mdv_row_codec const *codec, void const *packed, uint32_t idx, mdv_data *value);
+
+
+/**
+ * @brief Unpacks the row.
+ * @details Packed row is checked, it might be not aligned.
+ *          Row and its values are allocated by one block which should be freed by mdv_free(row, "row").
+ *
+ * @param codec [in]    Row codec
+ * @param packed [in]   Packed row
+ *
+ * @return On success, returns unpacked row
+ * @return On error, returns NULL
+ */
+mdv_row_base * mdv_row_codec_unpack(mdv_row_codec const *codec, mdv_data const *packed);
@@ -306,190 +306,253 @@ mdv_table_base * mdv_unbinn_table(binn const *obj)
 }
 
 
-bool mdv_binn_row(mdv_field const *fields, mdv_row_base const *row, binn *list)
+static bool mdv_predicate_is_cmp(mdv_predicate_op op)
 {
-    if (!binn_create_list(list))
+    return op <= MDV_PRED_GE;
+}
+
+
+static bool mdv_binn_predicate_node(mdv_predicate const *predicate, binn *obj, uint32_t depth)
+{
+    if (depth >= MDV_PREDICATE_DEPTH_MAX)
+    {
+        MDV_LOGE("binn_predicate failed. Predicate is too deep.");
+        return false;
+    }
+
+    if (!binn_create_object(obj))
     {
-        MDV_LOGE("binn_row failed");
+        MDV_LOGE("binn_predicate failed");
         return false;
     }
 
-    for(uint32_t i = 0; i < row->size; ++i)
+    if (!binn_object_set_uint32(obj, "O", predicate->op))
     {
-        uint32_t const field_type_size = mdv_field_type_size(fields[i].type);
+        MDV_LOGE("binn_predicate failed");
+        binn_free(obj);
+        return false;
+    }
 
-        if(!field_type_size)
+    if (mdv_predicate_is_cmp(predicate->op))
+    {
+        if (!binn_object_set_uint32(obj, "F", predicate->field)
+            || !binn_object_set_blob(obj, "V", predicate->value.ptr, predicate->value.size))
         {
-            MDV_LOGE("binn_row failed. Invalid field type size.");
-            binn_free(list);
+            MDV_LOGE("binn_predicate failed");
+            binn_free(obj);
             return false;
         }
 
-        if(row->fields[i].size % field_type_size)
+        return true;
+    }
+
+    if (predicate->op > MDV_PRED_NOT
+        || (predicate->op == MDV_PRED_NOT && predicate->size != 1))
+    {
+        MDV_LOGE("binn_predicate failed. Invalid operation.");
+        binn_free(obj);
+        return false;
+    }
+
+    binn args;
+
+    if (!binn_create_list(&args))
+    {
+        MDV_LOGE("binn_predicate failed");
+        binn_free(obj);
+        return false;
+    }
+
+    for(uint32_t i = 0; i < predicate->size; ++i)
+    {
+        binn arg;
+
+        if (!mdv_binn_predicate_node(predicate->args + i, &arg, depth + 1))
         {
-            MDV_LOGE("binn_row failed. Invalid field size.");
-            binn_free(list);
+            binn_free(&args);
+            binn_free(obj);
             return false;
         }
 
-        uint32_t const arr_size = row->fields[i].size / field_type_size;
-
-        if (fields[i].limit && fields[i].limit < arr_size)
+        if (!binn_list_add_object(&args, &arg))
         {
-            MDV_LOGE("binn_row failed. Field is too long.");
-            binn_free(list);
+            MDV_LOGE("binn_predicate failed");
+            binn_free(&arg);
+            binn_free(&args);
+            binn_free(obj);
             return false;
         }
 
-        BOOL res = true;
+        binn_free(&arg);
+    }
 
-        if(fields[i].limit == 1)
-            res = binn_add_to_list(list, fields[i].type, row->fields[i].ptr);
-        else if (field_type_size == 1)
-            res = binn_list_add_blob(list, row->fields[i].ptr, arr_size);
-        else
-        {
-            binn *field_items = binn_list();
-            if (!field_items)
-            {
-                MDV_LOGE("binn_row failed");
-                binn_free(list);
-                return false;
-            }
+    if (!binn_object_set_list(obj, "A", &args))
+    {
+        MDV_LOGE("binn_predicate failed");
+        binn_free(&args);
+        binn_free(obj);
+        return false;
+    }
 
-            for(uint32_t j = 0; res && j < arr_size; ++j)
-                res = binn_add_to_list(field_items, fields[i].type, (char const *)row->fields[i].ptr + j * field_type_size);
+    binn_free(&args);
 
-            if (res)
-                res = binn_list_add_list(list, field_items);
+    return true;
+}
 
-            binn_free(field_items);
-        }
 
-        if(!res)
-        {
-            MDV_LOGE("binn_row failed.");
-            binn_free(list);
+bool mdv_binn_predicate(mdv_predicate const *predicate, binn *obj)
+{
+    return mdv_binn_predicate_node(predicate, obj, 0);
+}
+
+
+/**
+ * @brief Calculates the number of predicate tree nodes and the values size.
+ */
+static bool mdv_unbinn_predicate_size(void *obj, uint32_t depth, uint32_t *nodes, uint32_t *size)
+{
+    uint32_t op = 0;
+
+    if (depth >= MDV_PREDICATE_DEPTH_MAX
+        || !binn_object_get_uint32(obj, "O", &op))
+        return false;
+
+    ++*nodes;
+
+    if (mdv_predicate_is_cmp(op))
+    {
+        void *value = 0;
+        int value_size = 0;
+
+        if (!binn_object_get_blob(obj, "V", &value, &value_size)
+            || value_size < 0)
+            return false;
+
+        *size += value_size;
+
+        return true;
+    }
+
+    void *args = 0;
+
+    if (op > MDV_PRED_NOT
+        || !binn_object_get_list(obj, "A", &args))
+        return false;
+
+    int const count = binn_count(args);
+
+    if (count < 0
+        || (op == MDV_PRED_NOT && count != 1))
+        return false;
+
+    for(int i = 1; i <= count; ++i)
+    {
+        void *arg = 0;
+
+        if (!binn_list_get_object(args, i, &arg)
+            || !mdv_unbinn_predicate_size(arg, depth + 1, nodes, size))
             return false;
-        }
     }
 
     return true;
 }
 
 
-static uint32_t binn_list_size(binn *obj)
+/// Memory for predicate tree deserialization
+typedef struct
 {
-    binn_iter iter;
-    binn value;
-    uint32_t n = 0;
-    binn_list_foreach(obj, value)
-        ++n;
-    return n;
-}
+    mdv_predicate *nodes;       ///< Free nodes
+    uint8_t       *values;      ///< Free space for values
+} mdv_predicate_buf;
 
 
-mdv_row_base * mdv_unbinn_row(binn const *obj, mdv_field const *fields)
+static bool mdv_unbinn_predicate_node(void *obj, mdv_predicate *node, mdv_predicate_buf *buf)
 {
-    binn_iter iter = {};
-    binn value = {};
+    uint32_t op = 0;
+
+    if (!binn_object_get_uint32(obj, "O", &op))
+        return false;
 
-    uint32_t size = offsetof(mdv_row_base, fields);
-    uint32_t fields_count = 0;
+    node->op = (mdv_predicate_op)op;
 
-    // Calculate necessary space for row
-    binn_list_foreach((void*)obj, value)
+    if (mdv_predicate_is_cmp(op))
     {
-        uint32_t const field_type_size = mdv_field_type_size(fields[fields_count].type);
+        void *value = 0;
+        int value_size = 0;
 
-        if(fields[fields_count].limit == 1)
-            size += sizeof(mdv_data) + field_type_size;
-        else if (field_type_size == 1)
-        {
-            int const blob_size = binn_size(&value);
-            if (blob_size < 0)
-            {
-                MDV_LOGE("blob size is negative: %d", blob_size);
-                return 0;
-            }
-            size += sizeof(mdv_data) + blob_size;
-        }
-        else
-            size += sizeof(mdv_data) + field_type_size * binn_list_size(&value);
+        if (!binn_object_get_uint32(obj, "F", &node->field)
+            || !binn_object_get_blob(obj, "V", &value, &value_size))
+            return false;
 
-        ++fields_count;
+        memcpy(buf->values, value, value_size);
+
+        node->value.size = value_size;
+        node->value.ptr = buf->values;
+
+        buf->values += value_size;
+
+        return true;
     }
 
-    mdv_row_base *row = (mdv_row_base *)mdv_alloc(size, "row");
-    if (!row)
+    void *args = 0;
+
+    if (!binn_object_get_list(obj, "A", &args))
+        return false;
+
+    // Arguments are placed contiguously
+    mdv_predicate *arg_nodes = buf->nodes;
+
+    node->size = binn_count(args);
+    node->args = arg_nodes;
+
+    buf->nodes += node->size;
+
+    for(uint32_t i = 0; i < node->size; ++i)
     {
-        MDV_LOGE("unbinn_table failed");
-        return 0;
+        void *arg = 0;
+
+        if (!binn_list_get_object(args, i + 1, &arg)
+            || !mdv_unbinn_predicate_node(arg, arg_nodes + i, buf))
+            return false;
     }
 
-    row->size = fields_count;
+    return true;
+}
 
-    fields_count = 0;
 
-    char *buff = (char *)(row->fields + row->size);
+mdv_predicate * mdv_unbinn_predicate(binn const *obj)
+{
+    uint32_t nodes = 0;
+    uint32_t size = 0;
 
-    // Deserialize row
-    binn_list_foreach((void*)obj, value)
+    if (!mdv_unbinn_predicate_size((void*)obj, 0, &nodes, &size))
     {
-        uint32_t const field_type_size = mdv_field_type_size(fields[fields_count].type);
-
-        if(fields[fields_count].limit == 1)
-        {
-            if (!binn_get(&value, fields[fields_count].type, buff))
-            {
-                MDV_LOGE("unbinn_table failed");
-                mdv_free(row, "row");
-                return 0;
-            }
-            row->fields[fields_count].size = field_type_size;
-            row->fields[fields_count].ptr = buff;
-            buff++;
+        MDV_LOGE("unbinn_predicate failed");
+        return 0;
+    }
 
-        }
-        else if (field_type_size == 1)
-        {
-            int const blob_size = binn_size(&value);
-            memcpy(buff, binn_ptr(&value), blob_size);
-            row->fields[fields_count].size = blob_size;
-            row->fields[fields_count].ptr = buff;
-            buff += blob_size;
-        }
-        else
-        {
-            binn_iter arr_iter = {};
-            binn arr_value = {};
-            uint32_t arr_len = 0;
-
-            row->fields[fields_count].ptr = buff;
-
-            binn_list_foreach(&value, arr_value)
-            {
-                if (!binn_get(&arr_value, fields[fields_count].type, buff))
-                {
-                    MDV_LOGE("unbinn_table failed");
-                    mdv_free(row, "row");
-                    return 0;
-                }
-
-                ++arr_len;
-                buff += field_type_size;
-            }
-
-            row->fields[fields_count].size = field_type_size * arr_len;
-        }
+    mdv_predicate *predicate = mdv_alloc(nodes * sizeof(mdv_predicate) + size, "predicate");
 
-        ++fields_count;
+    if (!predicate)
+    {
+        MDV_LOGE("unbinn_predicate failed");
+        return 0;
     }
 
-    if (buff - (char*)row != size)
-        MDV_LOGE("memory is corrupted: %p, %zu != %u", row, buff - (char*)row, size);
+    mdv_predicate_buf buf =
+    {
+        .nodes = predicate + 1,
+        .values = (uint8_t *)(predicate + nodes)
+    };
+
+    if (!mdv_unbinn_predicate_node((void*)obj, predicate, &buf))
+    {
+        MDV_LOGE("unbinn_predicate failed");
+        mdv_free(predicate, "predicate");
+        return 0;
+    }
 
-    return row;
+    return predicate;
 }
 
 
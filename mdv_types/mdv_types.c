@@ -43,3 +43,67 @@ uint32_t mdv_field_type_size(mdv_field_type t)
     MDV_LOGE("Unknown type: %u", t);
     return 0;
 }
+
+
+bool mdv_aggregate_field(mdv_table_base const *table, mdv_aggregate const *aggregate, mdv_field *field)
+{
+    if (aggregate->op == MDV_AGG_COUNT)
+    {
+        *field = (mdv_field) { MDV_FLD_TYPE_UINT64, 1, mdv_str_static("count") };
+        return true;
+    }
+
+    if (aggregate->field >= table->size
+        || table->fields[aggregate->field].limit != 1)
+        return false;
+
+    mdv_field const *src = table->fields + aggregate->field;
+
+    bool const numeric = src->type >= MDV_FLD_TYPE_INT8
+                         && src->type <= MDV_FLD_TYPE_DOUBLE;
+
+    bool const is_signed = src->type == MDV_FLD_TYPE_INT8
+                           || src->type == MDV_FLD_TYPE_INT16
+                           || src->type == MDV_FLD_TYPE_INT32
+                           || src->type == MDV_FLD_TYPE_INT64;
+
+    bool const is_float = src->type == MDV_FLD_TYPE_FLOAT
+                          || src->type == MDV_FLD_TYPE_DOUBLE;
+
+    field->limit = 1;
+    field->name = src->name;
+
+    switch(aggregate->op)
+    {
+        case MDV_AGG_SUM:
+        {
+            if (!numeric)
+                return false;
+
+            field->type = is_float
+                            ? MDV_FLD_TYPE_DOUBLE
+                            : is_signed
+                                ? MDV_FLD_TYPE_INT64
+                                : MDV_FLD_TYPE_UINT64;
+            return true;
+        }
+
+        case MDV_AGG_MIN:
+        case MDV_AGG_MAX:
+        {
+            field->type = src->type;
+            return mdv_field_type_size(src->type) != 0;
+        }
+
+        case MDV_AGG_AVG:
+        {
+            field->type = MDV_FLD_TYPE_DOUBLE;
+            return numeric;
+        }
+
+        default:
+            break;
+    }
+
+    return false;
+}
@@ -111,4 +111,89 @@ typedef mdv_table(0) mdv_table_base;
 typedef mdv_row(0) mdv_row_base;
 
 
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Predicate
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+typedef enum
+{
+    MDV_PRED_EQ     = 0,        // field == value
+    MDV_PRED_NE     = 1,        // field != value
+    MDV_PRED_LT     = 2,        // field < value
+    MDV_PRED_LE     = 3,        // field <= value
+    MDV_PRED_GT     = 4,        // field > value
+    MDV_PRED_GE     = 5,        // field >= value
+    MDV_PRED_AND    = 6,        // all arguments are true
+    MDV_PRED_OR     = 7,        // any argument is true
+    MDV_PRED_NOT    = 8         // single argument is false
+} mdv_predicate_op;
+
+
+/// Maximal predicate tree depth
+#define MDV_PREDICATE_DEPTH_MAX 32
+
+
+typedef struct mdv_predicate mdv_predicate;
+
+
+/*
+ * Predicate tree for rows filtering.
+ * Comparisons (MDV_PRED_EQ ... MDV_PRED_GE) compare the field with the value of the same type.
+ * Arrays are compared item by item and shorter arrays go before longer arrays with the same prefix.
+ * Logical operations (MDV_PRED_AND, MDV_PRED_OR, MDV_PRED_NOT) combine the arguments.
+ */
+struct mdv_predicate
+{
+    mdv_predicate_op op;                        // operation
+
+    union
+    {
+        struct
+        {
+            uint32_t             field;         // field index
+            mdv_data             value;         // value to compare with
+        };
+
+        struct
+        {
+            uint32_t             size;          // arguments count
+            mdv_predicate const *args;          // arguments
+        };
+    };
+};
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Aggregate
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+typedef enum
+{
+    MDV_AGG_COUNT   = 0,        // number of rows (field is ignored)
+    MDV_AGG_SUM     = 1,        // sum of field values
+    MDV_AGG_MIN     = 2,        // minimal field value
+    MDV_AGG_MAX     = 3,        // maximal field value
+    MDV_AGG_AVG     = 4         // average field value
+} mdv_aggregate_op;
+
+
+/*
+ * Aggregate function over the field values of the group.
+ * Only fields with single value (limit = 1) can be aggregated.
+ * SUM and AVG are calculated for numeric fields only.
+ */
+typedef struct
+{
+    mdv_aggregate_op    op;     // aggregate function
+    uint32_t            field;  // field index
+} mdv_aggregate;
+
+
 uint32_t mdv_field_type_size(mdv_field_type t);
+
+
+/*
+ * Returns the description of the aggregate function result.
+ * COUNT is UINT64, SUM is INT64, UINT64 or DOUBLE depending on the field type,
+ * MIN and MAX have the field type and AVG is DOUBLE.
+ * Returns false if the aggregate function isn't applicable to the field.
+ */
+bool mdv_aggregate_field(mdv_table_base const *table, mdv_aggregate const *aggregate, mdv_field *field);